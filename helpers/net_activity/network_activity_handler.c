@@ -39,6 +39,7 @@
 #include "cy_network_mw_core.h"
 
 #include "cy_OlmInterface.h"
+#include "cy_lpa_wifi_pf_ol.h"
 #include "whd_int.h"
 #ifndef COMPONENT_55900
 #include <cycfg_system.h>
@@ -105,8 +106,6 @@ typedef struct cylpa_rx_queue
 }cylpa_rx_queue_t;
 #endif
 
-extern whd_interface_t cy_olm_get_whd_interface ( void );
-
 /******************************************************
  *                   Enumerations
  ******************************************************/
@@ -177,6 +176,47 @@ static void cylpa_network_state_handler(cy_rslt_t state);
 *******************************************************************************/
 static void cylpa_network_act_handler_init(void);
 
+/*******************************************************************************
+* Function Name: cylpa_olm_dispatch_all
+********************************************************************************
+*
+* Summary: The host power mode applies to every interface; notify the Offload
+* Manager of each one (STA, softAP, ...).
+*
+* Parameters:
+* ol_pm_st_t st: new host power mode
+*
+*******************************************************************************/
+static void cylpa_olm_dispatch_all(ol_pm_st_t st);
+
+/*******************************************************************************
+* Function Name: cylpa_olm_of_netif
+********************************************************************************
+*
+* Summary: Find the Offload Manager of a network interface.
+*
+* Parameters:
+* void *iface: network stack interface given to cy_olm_init_ols(), or NULL
+*
+* Return:
+* olm_t *: the Offload Manager of iface; if iface is NULL or has none, the first
+* one created; NULL if there is no Offload Manager.
+*
+*******************************************************************************/
+static olm_t *cylpa_olm_of_netif(void *iface);
+
+/*******************************************************************************
+* Function Name: cylpa_olm_collect_all
+********************************************************************************
+*
+* Summary: List the sockets in use for the packet filter socket allow-list of
+* each Offload Manager. Called with the network stack suspended, before the
+* sleep is dispatched, so the offloads need not lock the network stack with
+* the OLM locks held.
+*
+*******************************************************************************/
+static void cylpa_olm_collect_all(void);
+
 /******************************************************
  *               Variable Definitions
  ******************************************************/
@@ -228,6 +268,7 @@ static void cylpa_print_whd_bus_stats(void *iface)
     UINT res;
     UINT status;
 #endif
+    olm_t *olm;
 
 #if defined(COMPONENT_LWIP)
     wifi = (struct netif *)iface;
@@ -238,11 +279,12 @@ static void cylpa_print_whd_bus_stats(void *iface)
     if(res == NX_SUCCESS)
 #endif
     {
-        ifp = cy_olm_get_whd_interface();
-        if (ifp == NULL)
+        olm = cylpa_olm_of_netif(iface);
+        if ( (olm == NULL) || (olm->ol_info.whd == NULL) )
         {
            return;
         }
+        ifp = (whd_interface_t)olm->ol_info.whd;
 
         NW_INFO(("\n=====================================================\n"));
         (void)whd_print_stats(ifp->whd_driver, WHD_FALSE);
@@ -409,6 +451,7 @@ int32_t cylpa_suspend_ns(void)
             }
         }
 #endif
+        cylpa_olm_collect_all();
         cylpa_s_ns_suspended = true;
         state = ST_SUCCESS;
     }
@@ -529,12 +572,14 @@ int32_t cylpa_wait_net_inactivity(uint32_t inactive_interval_ms, uint32_t inacti
 
 #ifdef CYCFG_ULP_SUPPORT_ENABLED
     whd_interface_t ifp = NULL;
+    olm_t *olm;
 
-    ifp = cy_olm_get_whd_interface();
-    if (ifp == NULL)
+    olm = cylpa_olm_of_netif(NULL);
+    if ( (olm == NULL) || (olm->ol_info.whd == NULL) )
     {
        return ST_BAD_STATE;
     }
+    ifp = (whd_interface_t)olm->ol_info.whd;
 #endif
 
     if (inactive_interval_ms > inactive_window_ms)
@@ -665,7 +710,7 @@ int32_t wait_net_suspend(void *net_intf, uint32_t wait_ms, uint32_t network_inac
 
             cy_rtos_clearbits_event(&cy_lp_wait_net_event, (uint32_t)(CY_LPA_TX_EVENT_FLAG | CY_LPA_RX_EVENT_FLAG), false);
 
-            cylpa_olm_dispatch_pm_notification(cy_get_olm_instance(), OL_PM_ST_GOING_TO_SLEEP);
+            cylpa_olm_dispatch_all(OL_PM_ST_GOING_TO_SLEEP);
             NW_INFO(("\nNetwork Stack Suspended, MCU can enter DeepSleep power mode\n"));
 
 #ifdef COMPONENT_MTB_HAL
@@ -737,7 +782,7 @@ int32_t wait_net_suspend(void *net_intf, uint32_t wait_ms, uint32_t network_inac
             }
             cylpa_network_state_handler(state);
             /* Call OLM API to reset back the configurations */
-            cylpa_olm_dispatch_pm_notification(cy_get_olm_instance(), OL_PM_ST_AWAKE);
+            cylpa_olm_dispatch_all(OL_PM_ST_AWAKE);
 #if defined(COMPONENT_LWIP)
             /* De-register the rx packet queue callback by passing NULL so that the packets from WHD
              * will be posted to lwip queue directly in cy_network_process_ethernet_data */
@@ -756,6 +801,58 @@ int32_t wait_net_suspend(void *net_intf, uint32_t wait_ms, uint32_t network_inac
     return state;
 }
 
+static void cylpa_olm_dispatch_all(ol_pm_st_t st)
+{
+    olm_t *olm;
+    uint32_t i;
+
+    for (i = 0; i < OLM_MAX_INSTANCES; i++)
+    {
+        olm = (olm_t *)cy_olm_get_instance_by_index(i);
+        if (olm != NULL)
+        {
+            cylpa_olm_dispatch_pm_notification(olm, st);
+        }
+    }
+}
+
+static void cylpa_olm_collect_all(void)
+{
+    olm_t *olm;
+    uint32_t i;
+
+    for (i = 0; i < OLM_MAX_INSTANCES; i++)
+    {
+        olm = (olm_t *)cy_olm_get_instance_by_index(i);
+        if (olm != NULL)
+        {
+            (void)cylpa_pf_ol_sock_collect(olm);
+        }
+    }
+}
+
+static olm_t *cylpa_olm_of_netif(void *iface)
+{
+    olm_t *first = NULL;
+    olm_t *olm;
+    uint32_t i;
+
+    for (i = 0; i < OLM_MAX_INSTANCES; i++)
+    {
+        olm = (olm_t *)cy_olm_get_instance_by_index(i);
+        if (olm == NULL)
+        {
+            continue;
+        }
+        if ( (iface != NULL) && (olm->ol_info.ip == iface) )
+        {
+            return olm;
+        }
+        first = (first == NULL) ? olm : first;
+    }
+    return first;
+}
+
 static void cylpa_network_state_handler(cy_rslt_t state)
 {
     switch(state)
@@ -933,8 +1030,13 @@ int cy_tcp_create_socket_connection( void *net_intf, void **global_socket_ptr, c
  */
 int cylpa_restart_olm( ol_desc_t *offload_list , void *net_intf )
 {
-    olm_t *olm_ptr = (olm_t *)cy_get_olm_instance();
+    olm_t *olm_ptr = cylpa_olm_of_netif(net_intf);
     const ol_desc_t *oflds_list = (const ol_desc_t *)offload_list;
+
+    if (olm_ptr == NULL)
+    {
+        return ST_BAD_STATE;
+    }
     cylpa_olm_deinit(olm_ptr);
     cylpa_olm_init(olm_ptr, oflds_list);
     return CY_RSLT_SUCCESS;
@@ -943,10 +1045,30 @@ int cylpa_restart_olm( ol_desc_t *offload_list , void *net_intf )
 /*-----------------------------------------------------------*/
 /*
  * Find the descriptor for the given filter.
+ * The OLM's own list is looked up in its registry first, which also holds the
+ * offloads registered at runtime; names that only match as a prefix are still
+ * found by the scan.
  */
 ol_desc_t *cylpa_find_my_descriptor(const char *name, ol_desc_t *offload_list )
 {
+    olm_t *olm_ptr;
     ol_desc_t *oflds_list = offload_list;
+    olm_handle_t handle;
+    uint32_t i;
+
+    for (i = 0; (i < OLM_MAX_INSTANCES) && (name != NULL); i++)
+    {
+        olm_ptr = (olm_t *)cy_olm_get_instance_by_index(i);
+        if ( (olm_ptr == NULL) || (olm_ptr->ol_list != (const ol_desc_t *)offload_list) )
+        {
+            continue;
+        }
+        handle = cylpa_olm_find(olm_ptr, name);
+        if (handle != OLM_HANDLE_INVALID)
+        {
+            return (ol_desc_t *)cylpa_olm_get_desc(olm_ptr, handle);
+        }
+    }
 
     if (oflds_list == NULL)
     {
@@ -233,7 +233,8 @@ extern int cy_tcp_create_socket_connection(void *net_intf, void **socket_handle,
  *  invoke this API
  *
  *  @param  offload_list           : Pointer to the user defined configuration list \ref ol_desc_t
- *  @param  net_intf               : Pointer to WLAN interface
+ *  @param  net_intf               : Pointer to WLAN interface whose OLM is restarted; with NULL, or an
+ *                                   interface without one, the first OLM created is restarted
  *  @return int                    : Returns CY_RSLT_SUCCESS if the restart is successful, otherwise it returns error.
  */
 extern int cylpa_restart_olm( ol_desc_t *offload_list, void *net_intf );
@@ -252,9 +253,12 @@ extern ol_desc_t *cylpa_find_my_descriptor(const char *name, ol_desc_t *offload_
 /*! \cond */
 /** Get OLM instance
  *
- *  This function returns OLM instance
+ *  This function returns the OLM instance of creation slot 0, the first interface
+ *  given to cy_olm_create(), whichever interface that is.
  *  @return  olm_t      : Return OLM structure pointer
  *
+ *  \deprecated With more than one interface, use cy_olm_get_instance() with the
+ *  interface, or cy_olm_get_instance_by_index() to visit all of them.
  */
 extern void *cy_get_olm_instance( void );
 /*! \endcond */
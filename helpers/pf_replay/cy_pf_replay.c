@@ -0,0 +1,666 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+/**
+* @file cy_pf_replay.c
+* @brief Packet filter wake predictor.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cy_pf_replay.h"
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CY_PF_REPLAY_ST_SLEEP           (0)     /* order[] of the host asleep */
+#define CY_PF_REPLAY_ST_WAKE            (1)     /* order[] of the host awake */
+
+#define CY_PF_REPLAY_ETHTYPE_IPV4       (0x0800)
+#define CY_PF_REPLAY_ETHTYPE_IPV6       (0x86DD)
+#define CY_PF_REPLAY_IP_PROTO_TCP       (6)
+#define CY_PF_REPLAY_IP_PROTO_UDP       (17)
+
+#define CY_PF_REPLAY_PCAP_HDR_LEN       (24)
+#define CY_PF_REPLAY_PCAP_REC_LEN       (16)
+#define CY_PF_REPLAY_PCAP_MAGIC_US      (0xa1b2c3d4)
+#define CY_PF_REPLAY_PCAP_MAGIC_NS      (0xa1b23c4d)
+#define CY_PF_REPLAY_LINKTYPE_ETHERNET  (1)
+#define CY_PF_REPLAY_LINKTYPE_MASK      (0x0fffffff)    /* upper bits carry FCS information */
+
+/* 16 byte vector; SSE2 on x86-64, NEON on AArch64 */
+typedef uint8_t cy_pf_replay_vec_t __attribute__( (vector_size(CY_PF_REPLAY_VEC_LEN) ) );
+
+/* The flow hash reads the key as 64-bit words */
+_Static_assert( (sizeof(cy_pf_replay_flow_key_t) % sizeof(uint64_t) ) == 0, "flow key size" );
+
+/* Stand-ins for the offloads' function tables, only their addresses identify an offload */
+__attribute__( (weak) ) const ol_fns_t pf_ol_fns = { .init = NULL };
+__attribute__( (weak) ) const ol_fns_t wowlpf_ol_fns = { .init = NULL };
+
+static int cy_pf_replay_add_pf(cy_pf_replay_t *rp, const cy_pf_ol_filter_t *f, bool preset);
+static int cy_pf_replay_add_wowl(cy_pf_replay_t *rp, const cy_wowlpf_ol_cfg_t *cfg);
+static void cy_pf_replay_index(cy_pf_replay_t *rp);
+static bool cy_pf_replay_flow_key(const uint8_t *frame, uint32_t len, cy_pf_replay_flow_key_t *key);
+static uint32_t cy_pf_replay_flow_hash(const cy_pf_replay_flow_key_t *key);
+static cy_pf_replay_flow_t *cy_pf_replay_flow_get(cy_pf_replay_report_t *report, const cy_pf_replay_flow_key_t *key,
+                                                  uint64_t ts_us);
+
+/*******************************************************************************
+* Rules
+*******************************************************************************/
+
+static int cy_pf_replay_hex(char c)
+{
+    if ( (c >= '0') && (c <= '9') )
+    {
+        return c - '0';
+    }
+    if ( (c >= 'a') && (c <= 'f') )
+    {
+        return c - 'a' + 10;
+    }
+    if ( (c >= 'A') && (c <= 'F') )
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/* "0x..." to bytes, as whd_wowl_set_pattern() converts them; returns the byte count or -1 */
+static int cy_pf_replay_unhex(const char *str, size_t max, uint8_t *out, uint32_t out_len)
+{
+    size_t len = strnlen(str, max);
+    uint32_t i;
+    int hi, lo;
+
+    if ( (len < 4) || ( (len % 2) != 0 ) || (str[0] != '0') || ( (str[1] != 'x') && (str[1] != 'X') ) ||
+         ( (len / 2 - 1) > out_len ) )
+    {
+        return -1;
+    }
+    for (i = 0; i < len / 2 - 1; i++)
+    {
+        hi = cy_pf_replay_hex(str[2 + 2 * i]);
+        lo = cy_pf_replay_hex(str[3 + 2 * i]);
+        if ( (hi < 0) || (lo < 0) )
+        {
+            return -1;
+        }
+        out[i] = (uint8_t)( (hi << 4) | lo );
+    }
+    return (int)i;
+}
+
+static cy_pf_replay_rule_t *cy_pf_replay_new_rule(cy_pf_replay_t *rp, uint16_t offset, uint32_t len)
+{
+    cy_pf_replay_rule_t *r;
+
+    if ( (rp->count >= CY_PF_REPLAY_MAX_RULES) || (len == 0) || (len > CY_PF_REPLAY_MAX_RULE_LEN) ||
+         ( (uint32_t)offset + CY_PF_REPLAY_MAX_RULE_LEN > CY_PF_REPLAY_MAX_SPAN) )
+    {
+        return NULL;
+    }
+    r = &rp->rules[rp->count++];
+    memset(r, 0, sizeof(*r) );
+    r->offset = offset;
+    r->end = (uint16_t)(offset + len);
+    r->vecs = (uint8_t)( (len + CY_PF_REPLAY_VEC_LEN - 1) / CY_PF_REPLAY_VEC_LEN );
+    return r;
+}
+
+static int cy_pf_replay_add_pf(cy_pf_replay_t *rp, const cy_pf_ol_filter_t *f, bool preset)
+{
+    cy_pf_replay_rule_t *r;
+    uint32_t i;
+
+    if ( (rp->pf_count >= CY_PF_REPLAY_MAX_PF) || ( (r = cy_pf_replay_new_rule(rp, f->offset, f->len) ) == NULL ) )
+    {
+        return RESULT_ERROR;
+    }
+    for (i = 0; i < f->len; i++)
+    {
+        r->mask[i] = f->mask[i];
+        r->pattern[i] = f->pattern[i] & f->mask[i];
+    }
+    r->id = f->id;
+    r->kind = (f->bits & CY_PF_ACTION_DISCARD) ? CY_PF_REPLAY_DISCARD : CY_PF_REPLAY_KEEP;
+    r->preset = preset;
+    r->bits = f->bits;
+    rp->pf_count++;
+    return RESULT_OK;
+}
+
+/* Pattern byte i is matched if bit i % 8 of byte i / 8 of the mask handed to the firmware
+ * is set; the offload reverses the bits of each byte of cfg->mask into that mask.
+ */
+static int cy_pf_replay_add_wowl(cy_pf_replay_t *rp, const cy_wowlpf_ol_cfg_t *cfg)
+{
+    uint8_t pattern[MAX_PATTERN_LEN];
+    uint8_t mask[MAX_MASK_LEN];
+    cy_pf_replay_rule_t *r;
+    int pattern_size, mask_size;
+    int i;
+
+    pattern_size = cy_pf_replay_unhex(cfg->pattern, sizeof(cfg->pattern), pattern, sizeof(pattern) );
+    mask_size = cy_pf_replay_unhex(cfg->mask, sizeof(cfg->mask), mask, sizeof(mask) );
+    if ( (pattern_size < 0) || (mask_size < 0) )
+    {
+        return RESULT_BADARGS;
+    }
+    if ( (rp->wowl_count >= CY_PF_REPLAY_MAX_WOWL) ||
+         ( (r = cy_pf_replay_new_rule(rp, cfg->offset, (uint32_t)pattern_size) ) == NULL ) )
+    {
+        return RESULT_ERROR;
+    }
+    for (i = 0; (i < pattern_size) && (i / 8 < mask_size); i++)
+    {
+        if (mask[i / 8] & (0x80 >> (i % 8) ) )
+        {
+            r->mask[i] = 0xff;
+            r->pattern[i] = pattern[i];
+        }
+    }
+    r->id = cfg->id;
+    r->kind = CY_PF_REPLAY_WOWL;
+    r->bits = CY_PF_ACTIVE_SLEEP;
+    rp->wowl[rp->wowl_count++] = (uint8_t)(r - rp->rules);
+    return RESULT_OK;
+}
+
+/* Lists the PF rules active in each power state, discards first, and the bytes they look at */
+static void cy_pf_replay_index(cy_pf_replay_t *rp)
+{
+    static const uint32_t active[2] = { CY_PF_ACTIVE_SLEEP, CY_PF_ACTIVE_WAKE };
+    static const uint8_t kinds[2] = { CY_PF_REPLAY_DISCARD, CY_PF_REPLAY_KEEP };
+    const cy_pf_replay_rule_t *r;
+    uint32_t st, k, i, end;
+
+    rp->span = 0;
+    for (st = 0; st < 2; st++)
+    {
+        rp->active[st] = 0;
+        for (k = 0; k < 2; k++)
+        {
+            for (i = 0; i < rp->count; i++)
+            {
+                r = &rp->rules[i];
+                if ( (r->kind == kinds[k]) && (r->bits & active[st]) )
+                {
+                    rp->order[st][rp->active[st]++] = (uint8_t)i;
+                }
+            }
+            if (kinds[k] == CY_PF_REPLAY_DISCARD)
+            {
+                rp->discards[st] = rp->active[st];
+            }
+        }
+    }
+    rp->reach = 0;
+    for (i = 0; i < rp->count; i++)
+    {
+        end = rp->rules[i].offset + (uint32_t)rp->rules[i].vecs * CY_PF_REPLAY_VEC_LEN;
+        if (end > rp->span)
+        {
+            rp->span = (uint16_t)end;
+        }
+        if (rp->rules[i].end > rp->reach)
+        {
+            rp->reach = rp->rules[i].end;
+        }
+    }
+}
+
+int cy_pf_replay_build(const ol_desc_t *list, cy_pf_replay_t *rp)
+{
+    cy_pf_ol_program_t prog;
+    const cy_wowlpf_ol_cfg_t *w;
+    const ol_desc_t *desc;
+    uint32_t i;
+    int result = RESULT_OK;
+
+    if ( (list == NULL) || (rp == NULL) )
+    {
+        return RESULT_BADARGS;
+    }
+    memset(rp, 0, sizeof(*rp) );
+
+    for (desc = list; (desc->fns != NULL) && (result == RESULT_OK); desc++)
+    {
+        if (desc->cfg == NULL)
+        {
+            continue;
+        }
+        if (desc->fns == &pf_ol_fns)
+        {
+            /* As the offload: what did not compile is not programmed */
+            if (cylpa_pf_ol_compile( (const cy_pf_ol_cfg_t *)desc->cfg, &prog ) != RESULT_OK)
+            {
+                rp->overflow = true;
+            }
+            for (i = 0; (i < prog.count) && (result == RESULT_OK); i++)
+            {
+                result = cy_pf_replay_add_pf(rp, &prog.filters[i], false);
+            }
+        }
+        else if (desc->fns == &wowlpf_ol_fns)
+        {
+            for (w = (const cy_wowlpf_ol_cfg_t *)desc->cfg; (w->feature != CY_WOWLPF_OL_FEAT_LAST) &&
+                 (result == RESULT_OK); w++)
+            {
+                result = cy_pf_replay_add_wowl(rp, w);
+            }
+        }
+    }
+    cy_pf_replay_index(rp);
+    return result;
+}
+
+int cy_pf_replay_add_preset(cy_pf_replay_t *rp, const char *name, uint32_t bits)
+{
+    cy_pf_ol_program_t prog;
+    const cy_pf_ol_preset_t *preset;
+    uint32_t i;
+    int result;
+
+    if ( (rp == NULL) || ( (preset = cylpa_pf_ol_preset_find(name, NULL) ) == NULL ) )
+    {
+        return RESULT_BADARGS;
+    }
+    result = cylpa_pf_ol_preset_compile(preset, bits, &prog);
+    for (i = 0; (i < prog.count) && (result == RESULT_OK); i++)
+    {
+        result = cy_pf_replay_add_pf(rp, &prog.filters[i], true);
+    }
+    cy_pf_replay_index(rp);
+    return result;
+}
+
+/*******************************************************************************
+* Matching
+*******************************************************************************/
+
+/* buf holds rp->span bytes of the frame, zero padded; the padding of a rule has a zero mask */
+static inline bool cy_pf_replay_rule_match(const cy_pf_replay_rule_t *r, const uint8_t *buf, uint32_t len)
+{
+    const cy_pf_replay_vec_t *mask = (const cy_pf_replay_vec_t *)r->mask;
+    const cy_pf_replay_vec_t *pattern = (const cy_pf_replay_vec_t *)r->pattern;
+    cy_pf_replay_vec_t diff;
+    cy_pf_replay_vec_t data;
+    uint64_t words[2];
+    uint32_t i;
+
+    if (len < r->end)
+    {
+        return false;
+    }
+    for (i = 0; i < r->vecs; i++)
+    {
+        memcpy(&data, &buf[r->offset + i * CY_PF_REPLAY_VEC_LEN], sizeof(data) );
+        diff = (data & mask[i]) ^ pattern[i];
+        memcpy(words, &diff, sizeof(words) );
+        if ( (words[0] | words[1]) != 0 )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void cy_pf_replay_match(const cy_pf_replay_t *rp, bool asleep, const uint8_t *frame, uint32_t len,
+                        cy_pf_replay_verdict_t *verdict)
+{
+    uint8_t buf[CY_PF_REPLAY_MAX_SPAN] __attribute__( (aligned(CY_PF_REPLAY_VEC_LEN) ) );
+    uint32_t st = asleep ? CY_PF_REPLAY_ST_SLEEP : CY_PF_REPLAY_ST_WAKE;
+    uint32_t n = (len < rp->span) ? len : rp->span;
+    uint32_t i;
+
+    memcpy(buf, frame, n);
+    memset(&buf[n], 0, rp->span - n);
+
+    verdict->asleep = asleep;
+    verdict->rule = -1;
+
+    /* Discards come first, so the first match decides */
+    for (i = 0; i < rp->active[st]; i++)
+    {
+        if (cy_pf_replay_rule_match(&rp->rules[rp->order[st][i]], buf, len) )
+        {
+            verdict->rule = rp->order[st][i];
+            break;
+        }
+    }
+    if (verdict->rule >= 0)
+    {
+        verdict->forwarded = (i >= rp->discards[st]);
+    }
+    else
+    {
+        verdict->forwarded = (rp->active[st] == rp->discards[st]);
+    }
+    verdict->wake = asleep && verdict->forwarded;
+
+    /* In WOWL only a pattern wakes the host, and nothing else reaches it */
+    if (asleep && (rp->wowl_count != 0) )
+    {
+        verdict->wake = false;
+        for (i = 0; i < rp->wowl_count; i++)
+        {
+            if (cy_pf_replay_rule_match(&rp->rules[rp->wowl[i]], buf, len) )
+            {
+                verdict->wake = true;
+                verdict->rule = rp->wowl[i];
+                break;
+            }
+        }
+        verdict->forwarded = verdict->wake;
+    }
+}
+
+/*******************************************************************************
+* Flows
+*******************************************************************************/
+
+static bool cy_pf_replay_flow_key(const uint8_t *frame, uint32_t len, cy_pf_replay_flow_key_t *key)
+{
+    uint32_t l4 = 0;
+
+    memset(key, 0, sizeof(*key) );
+    if (len < 14)
+    {
+        return false;
+    }
+    key->eth_type = (uint16_t)( (frame[12] << 8) | frame[13] );
+    if ( (key->eth_type == CY_PF_REPLAY_ETHTYPE_IPV4) && (len >= 14 + 20) )
+    {
+        key->ip_type = frame[14 + 9];
+        key->addr_len = CY_PF_OL_IPV4_ADDR_LEN;
+        memcpy(key->src, &frame[14 + 12], CY_PF_OL_IPV4_ADDR_LEN);
+        memcpy(key->dst, &frame[14 + 16], CY_PF_OL_IPV4_ADDR_LEN);
+        /* Ports are only in the first fragment */
+        if ( ( ( (frame[14 + 6] << 8) | frame[14 + 7] ) & 0x1fff ) == 0 )
+        {
+            l4 = 14 + (frame[14] & 0x0f) * 4u;
+        }
+    }
+    else if ( (key->eth_type == CY_PF_REPLAY_ETHTYPE_IPV6) && (len >= 14 + 40) )
+    {
+        key->ip_type = frame[14 + 6];
+        key->addr_len = CY_PF_OL_IPV6_ADDR_LEN;
+        memcpy(key->src, &frame[14 + 8], CY_PF_OL_IPV6_ADDR_LEN);
+        memcpy(key->dst, &frame[14 + 24], CY_PF_OL_IPV6_ADDR_LEN);
+        l4 = 14 + 40;
+    }
+    else
+    {
+        key->addr_len = CY_PF_OL_MAC_ADDR_LEN;
+        memcpy(key->src, &frame[6], CY_PF_OL_MAC_ADDR_LEN);
+        memcpy(key->dst, &frame[0], CY_PF_OL_MAC_ADDR_LEN);
+    }
+    if ( (l4 != 0) && (len >= l4 + 4) &&
+         ( (key->ip_type == CY_PF_REPLAY_IP_PROTO_TCP) || (key->ip_type == CY_PF_REPLAY_IP_PROTO_UDP) ) )
+    {
+        key->src_port = (uint16_t)( (frame[l4] << 8) | frame[l4 + 1] );
+        key->dst_port = (uint16_t)( (frame[l4 + 2] << 8) | frame[l4 + 3] );
+    }
+    return true;
+}
+
+static uint32_t cy_pf_replay_flow_hash(const cy_pf_replay_flow_key_t *key)
+{
+    uint64_t words[sizeof(*key) / sizeof(uint64_t)];
+    uint64_t hash = 0;
+    uint32_t i;
+
+    memcpy(words, key, sizeof(words) );
+    for (i = 0; i < sizeof(words) / sizeof(words[0]); i++)
+    {
+        hash = (hash ^ words[i]) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 29;
+    }
+    return (uint32_t)(hash ^ (hash >> 32) );
+}
+
+static cy_pf_replay_flow_t *cy_pf_replay_flow_slot(cy_pf_replay_flow_t *flows, uint32_t max,
+                                                   const cy_pf_replay_flow_key_t *key)
+{
+    uint32_t i = cy_pf_replay_flow_hash(key) & (max - 1);
+
+    while ( (flows[i].packets != 0) && (memcmp(&flows[i].key, key, sizeof(*key) ) != 0) )
+    {
+        i = (i + 1) & (max - 1);
+    }
+    return &flows[i];
+}
+
+static cy_pf_replay_flow_t *cy_pf_replay_flow_get(cy_pf_replay_report_t *report, const cy_pf_replay_flow_key_t *key,
+                                                  uint64_t ts_us)
+{
+    cy_pf_replay_flow_t *flows;
+    cy_pf_replay_flow_t *flow;
+    uint32_t i;
+
+    flow = cy_pf_replay_flow_slot(report->flows, report->flow_max, key);
+    if (flow->packets != 0)
+    {
+        return flow;
+    }
+
+    /* A new flow; keep the table at most 3/4 full */
+    if ( (report->flow_count + 1) * 4 > report->flow_max * 3 )
+    {
+        flows = calloc(report->flow_max * 2, sizeof(*flows) );
+        if (flows == NULL)
+        {
+            return NULL;
+        }
+        for (i = 0; i < report->flow_max; i++)
+        {
+            if (report->flows[i].packets != 0)
+            {
+                *cy_pf_replay_flow_slot(flows, report->flow_max * 2, &report->flows[i].key) = report->flows[i];
+            }
+        }
+        free(report->flows);
+        report->flows = flows;
+        report->flow_max *= 2;
+        flow = cy_pf_replay_flow_slot(report->flows, report->flow_max, key);
+    }
+    flow->key = *key;
+    flow->wake_rule = -1;
+    flow->first_us = ts_us;
+    report->flow_count++;
+    return flow;
+}
+
+/*******************************************************************************
+* Replay
+*******************************************************************************/
+
+int cy_pf_replay_report_init(cy_pf_replay_report_t *report)
+{
+    memset(report, 0, sizeof(*report) );
+    report->flows = calloc(CY_PF_REPLAY_FLOWS_INIT, sizeof(*report->flows) );
+    if (report->flows == NULL)
+    {
+        return RESULT_ERROR;
+    }
+    report->flow_max = CY_PF_REPLAY_FLOWS_INIT;
+    return RESULT_OK;
+}
+
+void cy_pf_replay_report_free(cy_pf_replay_report_t *report)
+{
+    free(report->flows);
+    report->flows = NULL;
+    report->flow_max = 0;
+    report->flow_count = 0;
+}
+
+void cy_pf_replay_feed(const cy_pf_replay_t *rp, const cy_pf_replay_opts_t *opts, cy_pf_replay_report_t *report,
+                       uint64_t ts_us, const uint8_t *frame, uint32_t len, uint32_t orig_len)
+{
+    cy_pf_replay_verdict_t verdict;
+    cy_pf_replay_flow_key_t key;
+    cy_pf_replay_flow_t *flow = NULL;
+    bool asleep = (opts->hold_ms == 0) || (ts_us >= report->awake_until_us);
+
+    cy_pf_replay_match(rp, asleep, frame, len, &verdict);
+
+    if (report->packets == 0)
+    {
+        report->first_us = ts_us;
+    }
+    report->last_us = ts_us;
+    report->packets++;
+    report->bytes += orig_len;
+    report->asleep += asleep ? 1 : 0;
+    report->forwarded += verdict.forwarded ? 1 : 0;
+    report->wakes += verdict.wake ? 1 : 0;
+    if ( (len < orig_len) && (len < rp->reach) )
+    {
+        report->truncated++;
+    }
+    if (verdict.rule >= 0)
+    {
+        report->hits[verdict.rule]++;
+        report->wake_hits[verdict.rule] += verdict.wake ? 1 : 0;
+    }
+
+    /* The host goes back to sleep hold_ms after the last frame it received */
+    if ( (opts->hold_ms != 0) && verdict.forwarded )
+    {
+        report->awake_until_us = ts_us + (uint64_t)opts->hold_ms * 1000u;
+    }
+
+    if ( opts->flows && (report->flows != NULL) && cy_pf_replay_flow_key(frame, len, &key) )
+    {
+        flow = cy_pf_replay_flow_get(report, &key, ts_us);
+        if (flow != NULL)
+        {
+            flow->packets++;
+            flow->forwarded += verdict.forwarded ? 1 : 0;
+            if (verdict.wake)
+            {
+                flow->wakes++;
+                flow->wake_rule = verdict.rule;
+                flow->last_wake_us = ts_us;
+            }
+        }
+    }
+
+    if (opts->cb != NULL)
+    {
+        opts->cb(report->packets - 1, ts_us, frame, len, &verdict, flow, opts->arg);
+    }
+}
+
+static uint32_t cy_pf_replay_rd32(const uint8_t *p, bool swap)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v) );
+    return swap ? __builtin_bswap32(v) : v;
+}
+
+int cy_pf_replay_pcap(const cy_pf_replay_t *rp, const char *path, const cy_pf_replay_opts_t *opts,
+                      cy_pf_replay_report_t *report)
+{
+    const uint8_t *base;
+    struct stat st;
+    uint64_t pos, ts_us;
+    uint32_t magic, sec, frac, len, orig_len;
+    bool swap, ns;
+    int fd;
+    int result = RESULT_OK;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return RESULT_BADARGS;
+    }
+    if ( (fstat(fd, &st) != 0) || (st.st_size < CY_PF_REPLAY_PCAP_HDR_LEN) )
+    {
+        close(fd);
+        return RESULT_BADARGS;
+    }
+    base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        return RESULT_BADARGS;
+    }
+    madvise( (void *)base, (size_t)st.st_size, MADV_SEQUENTIAL );
+
+    magic = cy_pf_replay_rd32(base, false);
+    swap = (magic == __builtin_bswap32(CY_PF_REPLAY_PCAP_MAGIC_US) ) ||
+           (magic == __builtin_bswap32(CY_PF_REPLAY_PCAP_MAGIC_NS) );
+    magic = swap ? __builtin_bswap32(magic) : magic;
+    ns = (magic == CY_PF_REPLAY_PCAP_MAGIC_NS);
+
+    if ( (magic != CY_PF_REPLAY_PCAP_MAGIC_US) && !ns )
+    {
+        result = RESULT_BADARGS;
+    }
+    else if ( (cy_pf_replay_rd32(&base[20], swap) & CY_PF_REPLAY_LINKTYPE_MASK) != CY_PF_REPLAY_LINKTYPE_ETHERNET )
+    {
+        result = RESULT_UNSUPPORTED;
+    }
+
+    /* A record cut short at the end of the file is left out */
+    for (pos = CY_PF_REPLAY_PCAP_HDR_LEN; (result == RESULT_OK) && (pos + CY_PF_REPLAY_PCAP_REC_LEN <= (uint64_t)st.st_size);
+         pos += len)
+    {
+        sec = cy_pf_replay_rd32(&base[pos], swap);
+        frac = cy_pf_replay_rd32(&base[pos + 4], swap);
+        len = cy_pf_replay_rd32(&base[pos + 8], swap);
+        orig_len = cy_pf_replay_rd32(&base[pos + 12], swap);
+        pos += CY_PF_REPLAY_PCAP_REC_LEN;
+        if (len > (uint64_t)st.st_size - pos)
+        {
+            break;
+        }
+        ts_us = (uint64_t)sec * 1000000u + (ns ? frac / 1000u : frac);
+        cy_pf_replay_feed(rp, opts, report, ts_us, &base[pos], len, (orig_len < len) ? len : orig_len);
+    }
+
+    munmap( (void *)base, (size_t)st.st_size );
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
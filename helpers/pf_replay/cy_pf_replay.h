@@ -0,0 +1,316 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+/**
+* @file cy_pf_replay.h
+* @brief Packet filter wake predictor.
+*
+* Builds the pattern/mask filters the packet filter (PF) and WOWL offloads of
+* an ol_desc_t list would program, and replays captured frames through them to
+* tell which frames would have woken the host. The rules are the same bytes the
+* offloads hand to WHD: PF entries go through cylpa_pf_ol_compile(), presets
+* through cylpa_pf_ol_preset_compile() and WOWL patterns through the same hex
+* and bit mask conversion as the WOWL offload.
+*
+* Frames are decided as the firmware does (see cy_lpa_wifi_pf_compile.c):
+* - a frame matching an active discard (negative matching) filter is dropped;
+* - otherwise, if keep (positive matching) filters are active, only a frame
+*   matching one of them is forwarded;
+* - with no filter active every frame is forwarded.
+* While the host sleeps, a forwarded frame wakes it. If WOWL patterns are
+* configured the host is in WOWL instead and only a frame matching one of the
+* patterns wakes it. A filter only matches a frame that holds all of its bytes.
+*
+* Each rule is compared 16 bytes at a time with the GCC/Clang vector
+* extension, which becomes SSE2 on x86-64 and NEON on AArch64, and the capture
+* is read through mmap(), so hours of traffic replay in seconds.
+*
+* The predictor is not part of a target build; the directory is listed in
+* .cyignore. It defines weak stand-ins for pf_ol_fns and wowlpf_ol_fns so an
+* ol_desc_t list written for the target links on the host. Build the command
+* line tool with a file defining cy_pf_replay_candidates[], for example
+* cy_pf_replay_example.c:
+*
+*   gcc -O2 -I<whd>/inc -Iinclude -Isource -Ihelpers/pf_replay \
+*       helpers/pf_replay/cy_pf_replay.c helpers/pf_replay/cy_pf_replay_main.c \
+*       helpers/pf_replay/cy_pf_replay_example.c source/cy_lpa_wifi_pf_compile.c \
+*       source/cy_lpa_wifi_pf_preset.c -o cy_pf_replay
+*
+*   ./cy_pf_replay -p mdns -H 2000 capture.pcap
+*
+* Captures must be classic pcap with Ethernet framing (LINKTYPE_ETHERNET), as
+* taken on the host's interface or on a wired port of the AP. Filters the
+* offload builds at run time (adaptive and socket allow-list filters) are not
+* modelled.
+*/
+
+#ifndef CY_PF_REPLAY_H__
+#define CY_PF_REPLAY_H__  (1)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_ol_common.h"
+#include "cy_lpa_wifi_pf_ol.h"
+#include "cy_lpa_wifi_wowlpf_ol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* Predictor limits
+*******************************************************************************/
+
+/** Maximum number of WOWL patterns taken from a configuration */
+#ifndef CY_PF_REPLAY_MAX_WOWL
+#define CY_PF_REPLAY_MAX_WOWL           (8)
+#endif
+
+/** Maximum number of PF filters, configured and from presets */
+#ifndef CY_PF_REPLAY_MAX_PF
+#define CY_PF_REPLAY_MAX_PF             (CY_PF_OL_MAX_FILTERS + CY_PF_OL_PRESET_MAX_SLOTS)
+#endif
+
+/** Maximum number of rules of a predictor */
+#define CY_PF_REPLAY_MAX_RULES          (CY_PF_REPLAY_MAX_PF + CY_PF_REPLAY_MAX_WOWL)
+
+/** Bytes compared at a time */
+#define CY_PF_REPLAY_VEC_LEN            (16)
+
+/** Longest rule, a WOWL pattern, rounded up to CY_PF_REPLAY_VEC_LEN */
+#define CY_PF_REPLAY_MAX_RULE_LEN       (MAX_PATTERN_LEN)
+
+/** Bytes from the start of a frame any rule may look at */
+#define CY_PF_REPLAY_MAX_SPAN           (1536 + CY_PF_REPLAY_MAX_RULE_LEN)
+
+/** Initial number of flow slots of a report; the table doubles when 3/4 full */
+#ifndef CY_PF_REPLAY_FLOWS_INIT
+#define CY_PF_REPLAY_FLOWS_INIT         (1024)
+#endif
+
+/*******************************************************************************
+* Predictor Data Structures
+*******************************************************************************/
+
+/** What a matching frame does */
+typedef enum cy_pf_replay_kind
+{
+    CY_PF_REPLAY_KEEP    = 0,                   /**< PF positive matching: forwarded                           */
+    CY_PF_REPLAY_DISCARD = 1,                   /**< PF negative matching: dropped                             */
+    CY_PF_REPLAY_WOWL    = 2,                   /**< WOWL net pattern: wakes the host                          */
+} cy_pf_replay_kind_t;
+
+/** One pattern/mask rule, zero padded to a multiple of CY_PF_REPLAY_VEC_LEN */
+typedef struct cy_pf_replay_rule
+{
+    uint8_t  pattern[CY_PF_REPLAY_MAX_RULE_LEN] __attribute__( (aligned(CY_PF_REPLAY_VEC_LEN) ) ); /**< Masked pattern */
+    uint8_t  mask[CY_PF_REPLAY_MAX_RULE_LEN] __attribute__( (aligned(CY_PF_REPLAY_VEC_LEN) ) );    /**< Bits to match  */
+    uint16_t offset;                            /**< Offset of the first byte from the Ethernet header         */
+    uint16_t end;                               /**< Bytes a frame must hold to match                          */
+    uint8_t  vecs;                              /**< CY_PF_REPLAY_VEC_LEN byte blocks compared                 */
+    uint8_t  id;                                /**< Firmware filter id or WOWL configuration id               */
+    uint8_t  kind;                              /**< \ref cy_pf_replay_kind_t                                  */
+    bool     preset;                            /**< Added by \ref cy_pf_replay_add_preset                     */
+    uint32_t bits;                              /**< CY_PF_ACTIVE_SLEEP, CY_PF_ACTIVE_WAKE, CY_PF_ACTION_DISCARD */
+} cy_pf_replay_rule_t;
+
+/** Rules of one configuration */
+typedef struct cy_pf_replay
+{
+    cy_pf_replay_rule_t rules[CY_PF_REPLAY_MAX_RULES]; /**< Rules in the order they were built            */
+    uint8_t  count;                             /**< Rules in use                                              */
+    uint8_t  pf_count;                          /**< PF rules                                                  */
+    uint8_t  wowl_count;                        /**< WOWL rules                                                */
+    uint8_t  wowl[CY_PF_REPLAY_MAX_WOWL];       /**< Index in rules[] of each WOWL rule                        */
+    bool     overflow;                          /**< Some PF entries did not compile and are not modelled      */
+    uint16_t span;                              /**< Bytes of a frame the rules look at, with padding          */
+    uint16_t reach;                             /**< Bytes of a frame the rules match                          */
+    uint8_t  order[2][CY_PF_REPLAY_MAX_RULES];  /**< Active PF rules asleep [0] and awake [1], discards first  */
+    uint8_t  discards[2];                       /**< Discard rules at the head of order[]                      */
+    uint8_t  active[2];                         /**< Rules in order[]                                          */
+} cy_pf_replay_t;
+
+/** How one frame is decided */
+typedef struct cy_pf_replay_verdict
+{
+    bool    asleep;                             /**< Decided with the host asleep                              */
+    bool    forwarded;                          /**< The frame is passed up; asleep in WOWL, only a wake frame */
+    bool    wake;                               /**< The frame wakes the host                                  */
+    int16_t rule;                               /**< Index in rules[] of the deciding rule, -1 for none        */
+} cy_pf_replay_verdict_t;
+
+/** A flow: TCP/UDP 5-tuple, IP protocol and addresses, or EtherType and MAC addresses */
+typedef struct cy_pf_replay_flow_key
+{
+    uint16_t eth_type;                          /**< EtherType                                                 */
+    uint8_t  ip_type;                           /**< IP protocol or IPv6 Next Header, 0 for non-IP             */
+    uint8_t  addr_len;                          /**< Bytes of src and dst: 4, 16, or 6 for MAC addresses       */
+    uint8_t  src[CY_PF_OL_IPV6_ADDR_LEN];       /**< Source address                                            */
+    uint8_t  dst[CY_PF_OL_IPV6_ADDR_LEN];       /**< Destination address                                       */
+    uint16_t src_port;                          /**< TCP/UDP source port                                       */
+    uint16_t dst_port;                          /**< TCP/UDP destination port                                  */
+} cy_pf_replay_flow_key_t;
+
+/** Counters of one flow */
+typedef struct cy_pf_replay_flow
+{
+    cy_pf_replay_flow_key_t key;                /**< Flow                                                      */
+    uint64_t packets;                           /**< Frames, 0 for a free slot                                 */
+    uint64_t forwarded;                         /**< Frames passed up to the host                              */
+    uint64_t wakes;                             /**< Frames that woke the host                                 */
+    int16_t  wake_rule;                         /**< Rule of the last wake, -1 for none                        */
+    uint64_t first_us;                          /**< Capture time of the first frame                           */
+    uint64_t last_wake_us;                      /**< Capture time of the last wake                             */
+} cy_pf_replay_flow_t;
+
+/** Called for every replayed frame */
+typedef void (*cy_pf_replay_packet_cb_t)(uint64_t index, uint64_t ts_us, const uint8_t *frame, uint32_t len,
+                                         const cy_pf_replay_verdict_t *verdict, const cy_pf_replay_flow_t *flow,
+                                         void *arg);
+
+/** Replay options */
+typedef struct cy_pf_replay_opts
+{
+    uint32_t                 hold_ms;           /**< Time the host stays awake after the last frame passed up
+                                                 *   to it; 0 decides every frame with the host asleep          */
+    bool                     flows;             /**< Count frames per flow                                     */
+    cy_pf_replay_packet_cb_t cb;                /**< Per frame callback, may be NULL                           */
+    void                     *arg;              /**< Passed back to cb                                         */
+} cy_pf_replay_opts_t;
+
+/** Result of a replay */
+typedef struct cy_pf_replay_report
+{
+    uint64_t            packets;                /**< Frames replayed                                           */
+    uint64_t            bytes;                  /**< Bytes of the frames as sent                               */
+    uint64_t            asleep;                 /**< Frames that arrived with the host asleep                  */
+    uint64_t            forwarded;              /**< Frames passed up to the host                              */
+    uint64_t            wakes;                  /**< Frames that woke the host                                 */
+    uint64_t            truncated;              /**< Frames captured shorter than the rules look at            */
+    uint64_t            hits[CY_PF_REPLAY_MAX_RULES]; /**< Frames each rule decided                           */
+    uint64_t            wake_hits[CY_PF_REPLAY_MAX_RULES]; /**< Wakes each rule decided                        */
+    uint64_t            first_us;               /**< Capture time of the first frame                           */
+    uint64_t            last_us;                /**< Capture time of the last frame                            */
+    uint64_t            awake_until_us;         /**< End of the current hold_ms window                         */
+    cy_pf_replay_flow_t *flows;                 /**< Flow table, flow_max slots; free slots have no packets    */
+    uint32_t            flow_max;               /**< Slots of flows, a power of two                            */
+    uint32_t            flow_count;             /**< Slots in use                                              */
+} cy_pf_replay_report_t;
+
+/** A named configuration for the command line tool */
+typedef struct cy_pf_replay_candidate
+{
+    const char      *name;                      /**< Name to select it with -c, NULL ends the list             */
+    const ol_desc_t *list;                      /**< Offload list as handed to the OLM, ends with a NULL fns   */
+} cy_pf_replay_candidate_t;
+
+/** Configurations the command line tool compares, supplied by the user */
+extern const cy_pf_replay_candidate_t cy_pf_replay_candidates[];
+
+/*******************************************************************************
+* Predictor Functions
+*******************************************************************************/
+
+/** Build the rules the PF and WOWL offloads of an offload list would program.
+ *
+ * PF entries that do not compile are left out, as the offload leaves them out, and flagged
+ * in rp->overflow.
+ *
+ * @param[in]  list     : Offload list, ends with an entry whose fns is NULL
+ * @param[out] rp       : Rules
+ *
+ * @return RESULT_OK, RESULT_BADARGS for a malformed WOWL pattern, or RESULT_ERROR if there
+ *         are more rules than the predictor holds
+ */
+int cy_pf_replay_build(const ol_desc_t *list, cy_pf_replay_t *rp);
+
+/** Add the filters of a preset, as cylpa_pf_ol_preset_enable() would.
+ *
+ * @param[in,out] rp    : Rules
+ * @param[in]  name     : Preset name, see \ref cylpa_pf_ol_preset_get
+ * @param[in]  bits     : CY_PF_ACTIVE_SLEEP and/or CY_PF_ACTIVE_WAKE
+ *
+ * @return RESULT_OK, RESULT_BADARGS for an unknown preset, or RESULT_ERROR if it does not fit
+ */
+int cy_pf_replay_add_preset(cy_pf_replay_t *rp, const char *name, uint32_t bits);
+
+/** Decide one frame.
+ *
+ * @param[in]  rp       : Rules
+ * @param[in]  asleep   : The host is asleep
+ * @param[in]  frame    : Ethernet frame
+ * @param[in]  len      : Bytes of frame
+ * @param[out] verdict  : How the frame is decided
+ */
+void cy_pf_replay_match(const cy_pf_replay_t *rp, bool asleep, const uint8_t *frame, uint32_t len,
+                        cy_pf_replay_verdict_t *verdict);
+
+/** Start a replay.
+ *
+ * @param[out] report   : Cleared report
+ *
+ * @return RESULT_OK, or RESULT_ERROR if the flow table cannot be allocated
+ */
+int cy_pf_replay_report_init(cy_pf_replay_report_t *report);
+
+/** Release the flow table of a report. */
+void cy_pf_replay_report_free(cy_pf_replay_report_t *report);
+
+/** Replay one frame, in capture order.
+ *
+ * @param[in]     rp    : Rules
+ * @param[in]     opts  : Options
+ * @param[in,out] report: Counters
+ * @param[in]     ts_us : Capture time
+ * @param[in]     frame : Ethernet frame as captured
+ * @param[in]     len   : Bytes captured
+ * @param[in]     orig_len : Bytes of the frame as sent
+ */
+void cy_pf_replay_feed(const cy_pf_replay_t *rp, const cy_pf_replay_opts_t *opts, cy_pf_replay_report_t *report,
+                       uint64_t ts_us, const uint8_t *frame, uint32_t len, uint32_t orig_len);
+
+/** Replay a pcap capture.
+ *
+ * @param[in]     rp    : Rules
+ * @param[in]     path  : Capture file
+ * @param[in]     opts  : Options
+ * @param[in,out] report: Counters, see \ref cy_pf_replay_report_init
+ *
+ * @return RESULT_OK, RESULT_BADARGS if the file cannot be read or is not a pcap capture,
+ *         or RESULT_UNSUPPORTED for a capture without Ethernet framing
+ */
+int cy_pf_replay_pcap(const cy_pf_replay_t *rp, const char *path, const cy_pf_replay_opts_t *opts,
+                      cy_pf_replay_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !CY_PF_REPLAY_H__ */
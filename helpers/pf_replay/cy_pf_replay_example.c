@@ -0,0 +1,107 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+/**
+* @file cy_pf_replay_example.c
+* @brief Example configurations for the packet filter wake predictor.
+*
+* Replace this file with one holding the ol_desc_t lists of the application,
+* or copy them here, to compare the candidates on a capture of its network.
+*/
+
+#include <stddef.h>
+#include "cy_pf_replay.h"
+
+/* Asleep, keep only ARP, DHCP replies and the MQTT broker; everything else is dropped */
+static const cy_pf_ol_cfg_t cy_pf_replay_example_keep[] =
+{
+    { .feature = CY_PF_OL_FEAT_ETHTYPE, .bits = CY_PF_ACTIVE_SLEEP, .id = 1,
+      .u.eth = { .eth_type = 0x0806 } },
+    { .feature = CY_PF_OL_FEAT_PORTNUM, .bits = CY_PF_ACTIVE_SLEEP, .id = 2,
+      .u.pf = { .portnum = { .portnum = 68, .range = 0, .direction = PF_PN_PORT_DEST },
+                .proto = CY_PF_PROTOCOL_UDP } },
+    { .feature = CY_PF_OL_FEAT_PORTNUM, .bits = CY_PF_ACTIVE_SLEEP, .id = 3,
+      .u.pf = { .portnum = { .portnum = 8883, .range = 0, .direction = PF_PN_PORT_SOURCE },
+                .proto = CY_PF_PROTOCOL_TCP } },
+    { .feature = CY_PF_OL_FEAT_LAST },
+};
+
+/* Asleep, drop multicast discovery traffic and keep everything else */
+static const cy_pf_ol_cfg_t cy_pf_replay_example_discard[] =
+{
+    { .feature = CY_PF_OL_FEAT_PORTNUM, .bits = CY_PF_ACTIVE_SLEEP | CY_PF_ACTION_DISCARD | CY_PF_IPV4_IPV6,
+      .id = 1, .u.pf = { .portnum = { .portnum = 5353, .range = 0, .direction = PF_PN_PORT_DEST },
+                         .proto = CY_PF_PROTOCOL_UDP } },
+    { .feature = CY_PF_OL_FEAT_PORTNUM, .bits = CY_PF_ACTIVE_SLEEP | CY_PF_ACTION_DISCARD | CY_PF_IPV4_IPV6,
+      .id = 2, .u.pf = { .portnum = { .portnum = 1900, .range = 0, .direction = PF_PN_PORT_DEST },
+                         .proto = CY_PF_PROTOCOL_UDP } },
+    { .feature = CY_PF_OL_FEAT_LAST },
+};
+
+/* WOWL: wake on a TCP segment to port 80 in an IPv4 packet without options; the mask has
+ * one bit per pattern byte, most significant first: EtherType, protocol, destination port
+ */
+static const cy_wowlpf_ol_cfg_t cy_pf_replay_example_wowl[] =
+{
+    { .feature = CY_WOWLPF_OL_FEAT_WAKE, .pattern = "0x0800000000000000000000060000000000000000000000000050",
+      .pattern_size = 26, .mask = "0xc01000c0", .mask_size = 4, .offset = 12, .id = 1 },
+    { .feature = CY_WOWLPF_OL_FEAT_LAST },
+};
+
+static const ol_desc_t cy_pf_replay_example_none_list[] =
+{
+    { NULL, NULL, NULL, NULL, NULL },
+};
+
+static const ol_desc_t cy_pf_replay_example_keep_list[] =
+{
+    { "Pkt_Filter", cy_pf_replay_example_keep, &pf_ol_fns, NULL, NULL },
+    { NULL, NULL, NULL, NULL, NULL },
+};
+
+static const ol_desc_t cy_pf_replay_example_discard_list[] =
+{
+    { "Pkt_Filter", cy_pf_replay_example_discard, &pf_ol_fns, NULL, NULL },
+    { NULL, NULL, NULL, NULL, NULL },
+};
+
+static const ol_desc_t cy_pf_replay_example_wowl_list[] =
+{
+    { "WOWLPF", cy_pf_replay_example_wowl, &wowlpf_ol_fns, NULL, NULL },
+    { NULL, NULL, NULL, NULL, NULL },
+};
+
+const cy_pf_replay_candidate_t cy_pf_replay_candidates[] =
+{
+    { "none",    cy_pf_replay_example_none_list    },
+    { "keep",    cy_pf_replay_example_keep_list    },
+    { "discard", cy_pf_replay_example_discard_list },
+    { "wowl",    cy_pf_replay_example_wowl_list    },
+    { NULL,      NULL                              },
+};
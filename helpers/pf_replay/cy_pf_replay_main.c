@@ -0,0 +1,372 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+/**
+* @file cy_pf_replay_main.c
+* @brief Command line front end of the packet filter wake predictor.
+*
+* Replays a capture through every configuration of cy_pf_replay_candidates[]
+* (or the ones picked with -c) and prints, for each, the wakes it predicts per
+* rule and per flow, then a side by side comparison.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "cy_pf_replay.h"
+#include "cy_lpa_wifi_result.h"
+
+#define CY_PF_REPLAY_MAIN_MAX_PICKS     (16)
+#define CY_PF_REPLAY_MAIN_FLOWS         (10)
+
+typedef struct cy_pf_replay_main_row
+{
+    const char *name;
+    uint32_t   rules;
+    uint64_t   forwarded;
+    uint64_t   wakes;
+    double     hours;
+} cy_pf_replay_main_row_t;
+
+static const char *const cy_pf_replay_kinds[] = { "keep", "discard", "wowl" };
+
+static void cy_pf_replay_usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [-c name]... [-p preset]... [-H hold_ms] [-f flows] [-v] [-l] capture.pcap\n"
+            "  -c name    replay only this configuration (default: all)\n"
+            "  -p preset  add the sleep discard filters of a preset to each configuration\n"
+            "  -H ms      host stays awake ms after the last frame it received (default 0:\n"
+            "             every frame is decided with the host asleep)\n"
+            "  -f flows   flows to list per configuration, by wakes (default %u)\n"
+            "  -v         print the verdict of every frame\n"
+            "  -l         list the configurations and the rules they build\n",
+            prog, CY_PF_REPLAY_MAIN_FLOWS);
+}
+
+static const char *cy_pf_replay_addr(const cy_pf_replay_flow_key_t *key, const uint8_t *addr, char *buf,
+                                     size_t len)
+{
+    if (key->addr_len == CY_PF_OL_IPV4_ADDR_LEN)
+    {
+        return inet_ntop(AF_INET, addr, buf, (socklen_t)len);
+    }
+    if (key->addr_len == CY_PF_OL_IPV6_ADDR_LEN)
+    {
+        return inet_ntop(AF_INET6, addr, buf, (socklen_t)len);
+    }
+    snprintf(buf, len, "%02x:%02x:%02x:%02x:%02x:%02x", addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]);
+    return buf;
+}
+
+static void cy_pf_replay_print_flow(const cy_pf_replay_flow_key_t *key)
+{
+    char src[64], dst[64];
+
+    cy_pf_replay_addr(key, key->src, src, sizeof(src) );
+    cy_pf_replay_addr(key, key->dst, dst, sizeof(dst) );
+    if (key->addr_len == CY_PF_OL_MAC_ADDR_LEN)
+    {
+        printf("eth 0x%04x %s > %s", key->eth_type, src, dst);
+    }
+    else if ( (key->src_port != 0) || (key->dst_port != 0) )
+    {
+        printf("%s %s:%u > %s:%u", (key->ip_type == 6) ? "tcp" : "udp", src, key->src_port, dst, key->dst_port);
+    }
+    else
+    {
+        printf("ip %u %s > %s", key->ip_type, src, dst);
+    }
+}
+
+static void cy_pf_replay_print_rule(const cy_pf_replay_t *rp, int16_t index)
+{
+    const cy_pf_replay_rule_t *r;
+
+    if (index < 0)
+    {
+        printf("-");
+        return;
+    }
+    r = &rp->rules[index];
+    printf("%s %u", cy_pf_replay_kinds[r->kind], r->id);
+}
+
+static void cy_pf_replay_packet(uint64_t index, uint64_t ts_us, const uint8_t *frame, uint32_t len,
+                                const cy_pf_replay_verdict_t *verdict, const cy_pf_replay_flow_t *flow, void *arg)
+{
+    const cy_pf_replay_t *rp = (const cy_pf_replay_t *)arg;
+
+    (void)frame;
+    printf("%8llu %llu.%06llu %5u %-6s %-5s %-4s ", (unsigned long long)index + 1,
+           (unsigned long long)(ts_us / 1000000u), (unsigned long long)(ts_us % 1000000u), len,
+           verdict->asleep ? "asleep" : "awake", verdict->wake ? "WAKE" : "", verdict->forwarded ? "up" : "drop");
+    cy_pf_replay_print_rule(rp, verdict->rule);
+    if (flow != NULL)
+    {
+        printf("  ");
+        cy_pf_replay_print_flow(&flow->key);
+    }
+    printf("\n");
+}
+
+static void cy_pf_replay_list(const char *name, const cy_pf_replay_t *rp)
+{
+    const cy_pf_replay_rule_t *r;
+    uint32_t i, j;
+
+    printf("%s: %u rules (%u PF, %u WOWL)%s\n", name, rp->count, rp->pf_count, rp->wowl_count,
+           rp->overflow ? ", some PF entries not compiled" : "");
+    for (i = 0; i < rp->count; i++)
+    {
+        r = &rp->rules[i];
+        printf("  %-7s %3u %s%s%s offset %4u len %3u ", cy_pf_replay_kinds[r->kind], r->id,
+               (r->bits & CY_PF_ACTIVE_SLEEP) ? "S" : "-", (r->bits & CY_PF_ACTIVE_WAKE) ? "W" : "-",
+               r->preset ? " preset" : "       ", r->offset, r->end - r->offset);
+        for (j = 0; j < (uint32_t)(r->end - r->offset); j++)
+        {
+            printf("%02x", r->pattern[j]);
+        }
+        printf("/");
+        for (j = 0; j < (uint32_t)(r->end - r->offset); j++)
+        {
+            printf("%02x", r->mask[j]);
+        }
+        printf("\n");
+    }
+}
+
+static int cy_pf_replay_by_wakes(const void *a, const void *b)
+{
+    const cy_pf_replay_flow_t *fa = (const cy_pf_replay_flow_t *)a;
+    const cy_pf_replay_flow_t *fb = (const cy_pf_replay_flow_t *)b;
+
+    if (fa->wakes != fb->wakes)
+    {
+        return (fa->wakes < fb->wakes) ? 1 : -1;
+    }
+    if (fa->packets != fb->packets)
+    {
+        return (fa->packets < fb->packets) ? 1 : -1;
+    }
+    return 0;
+}
+
+static void cy_pf_replay_summary(const char *name, const cy_pf_replay_t *rp, const cy_pf_replay_report_t *report,
+                                 uint32_t max_flows, double elapsed)
+{
+    cy_pf_replay_flow_t *flows;
+    double hours = (double)(report->last_us - report->first_us) / 3.6e9;
+    uint32_t i, n = 0;
+
+    printf("\n== %s\n", name);
+    printf("%llu frames, %.2f h, %llu asleep, %llu passed up, %llu wakes",
+           (unsigned long long)report->packets, hours, (unsigned long long)report->asleep,
+           (unsigned long long)report->forwarded, (unsigned long long)report->wakes);
+    if (hours > 0)
+    {
+        printf(" (%.1f/h)", (double)report->wakes / hours);
+    }
+    printf("\n");
+    if (report->truncated != 0)
+    {
+        printf("%llu frames captured too short for the rules; verdicts may be off\n",
+               (unsigned long long)report->truncated);
+    }
+    printf("replayed in %.3f s (%.1f Mframes/s)\n", elapsed,
+           (elapsed > 0) ? (double)report->packets / elapsed / 1e6 : 0.0);
+
+    for (i = 0; i < rp->count; i++)
+    {
+        printf("  %-7s %3u%s: decided %llu, woke %llu\n", cy_pf_replay_kinds[rp->rules[i].kind], rp->rules[i].id,
+               rp->rules[i].preset ? " preset" : "", (unsigned long long)report->hits[i],
+               (unsigned long long)report->wake_hits[i]);
+    }
+
+    flows = malloc( (report->flow_count + 1) * sizeof(*flows) );
+    if (flows == NULL)
+    {
+        return;
+    }
+    for (i = 0; i < report->flow_max; i++)
+    {
+        if (report->flows[i].packets != 0)
+        {
+            flows[n++] = report->flows[i];
+        }
+    }
+    qsort(flows, n, sizeof(*flows), cy_pf_replay_by_wakes);
+    printf("%u flows; by wakes:\n", n);
+    for (i = 0; (i < n) && (i < max_flows) && (flows[i].wakes != 0); i++)
+    {
+        printf("  %8llu wakes %10llu frames  ", (unsigned long long)flows[i].wakes,
+               (unsigned long long)flows[i].packets);
+        cy_pf_replay_print_flow(&flows[i].key);
+        printf("  (");
+        cy_pf_replay_print_rule(rp, flows[i].wake_rule);
+        printf(")\n");
+    }
+    free(flows);
+}
+
+int main(int argc, char **argv)
+{
+    static cy_pf_replay_t rp;
+    const char *picks[CY_PF_REPLAY_MAIN_MAX_PICKS];
+    const char *presets[CY_PF_OL_MAX_PRESETS];
+    cy_pf_replay_main_row_t rows[CY_PF_REPLAY_MAIN_MAX_PICKS];
+    const cy_pf_replay_candidate_t *c;
+    cy_pf_replay_report_t report;
+    cy_pf_replay_opts_t opts;
+    struct timespec t0, t1;
+    uint32_t npicks = 0, npresets = 0, nrows = 0, max_flows = CY_PF_REPLAY_MAIN_FLOWS;
+    uint32_t i;
+    bool verbose = false, list = false, picked;
+    double elapsed;
+    int opt, result;
+
+    memset(&opts, 0, sizeof(opts) );
+    while ( (opt = getopt(argc, argv, "c:p:H:f:vlh") ) != -1 )
+    {
+        switch (opt)
+        {
+            case 'c':
+                if (npicks < CY_PF_REPLAY_MAIN_MAX_PICKS)
+                {
+                    picks[npicks++] = optarg;
+                }
+                break;
+            case 'p':
+                if (npresets < CY_PF_OL_MAX_PRESETS)
+                {
+                    presets[npresets++] = optarg;
+                }
+                break;
+            case 'H':
+                opts.hold_ms = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'f':
+                max_flows = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case 'l':
+                list = true;
+                break;
+            default:
+                cy_pf_replay_usage(argv[0]);
+                return 2;
+        }
+    }
+    if ( !list && (optind != argc - 1) )
+    {
+        cy_pf_replay_usage(argv[0]);
+        return 2;
+    }
+
+    for (c = cy_pf_replay_candidates; c->name != NULL; c++)
+    {
+        for (i = 0, picked = (npicks == 0); (i < npicks) && !picked; i++)
+        {
+            picked = (strcmp(picks[i], c->name) == 0);
+        }
+        if (!picked)
+        {
+            continue;
+        }
+
+        result = cy_pf_replay_build(c->list, &rp);
+        for (i = 0; (i < npresets) && (result == RESULT_OK); i++)
+        {
+            result = cy_pf_replay_add_preset(&rp, presets[i], CY_PF_ACTIVE_SLEEP);
+        }
+        if (result != RESULT_OK)
+        {
+            fprintf(stderr, "%s: cannot build the rules (%d)\n", c->name, result);
+            return 1;
+        }
+        if (list)
+        {
+            cy_pf_replay_list(c->name, &rp);
+            continue;
+        }
+
+        if (cy_pf_replay_report_init(&report) != RESULT_OK)
+        {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        opts.flows = true;
+        opts.cb = verbose ? cy_pf_replay_packet : NULL;
+        opts.arg = &rp;
+        if (verbose)
+        {
+            printf("\n== %s: frames\n", c->name);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        result = cy_pf_replay_pcap(&rp, argv[optind], &opts, &report);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        if (result != RESULT_OK)
+        {
+            fprintf(stderr, "%s: %s\n", argv[optind],
+                    (result == RESULT_UNSUPPORTED) ? "not an Ethernet capture" : "not a readable pcap file");
+            cy_pf_replay_report_free(&report);
+            return 1;
+        }
+        elapsed = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+        cy_pf_replay_summary(c->name, &rp, &report, max_flows, elapsed);
+
+        if (nrows < CY_PF_REPLAY_MAIN_MAX_PICKS)
+        {
+            rows[nrows].name = c->name;
+            rows[nrows].rules = rp.count;
+            rows[nrows].forwarded = report.forwarded;
+            rows[nrows].wakes = report.wakes;
+            rows[nrows].hours = (double)(report.last_us - report.first_us) / 3.6e9;
+            nrows++;
+        }
+        cy_pf_replay_report_free(&report);
+    }
+
+    if (nrows > 1)
+    {
+        printf("\n%-20s %6s %12s %12s %10s\n", "configuration", "rules", "passed up", "wakes", "wakes/h");
+        for (i = 0; i < nrows; i++)
+        {
+            printf("%-20s %6u %12llu %12llu %10.1f\n", rows[i].name, rows[i].rules,
+                   (unsigned long long)rows[i].forwarded, (unsigned long long)rows[i].wakes,
+                   (rows[i].hours > 0) ? (double)rows[i].wakes / rows[i].hours : 0.0);
+        }
+    }
+    return 0;
+}
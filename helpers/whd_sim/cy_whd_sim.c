@@ -0,0 +1,1478 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+/**
+* @file cy_whd_sim.c
+* @brief Host-side simulated WHD backend.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "cy_whd_sim.h"
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol_priv.h"
+#include "whd_int.h"
+#include "whd_wifi_api.h"
+#include "whd_proto.h"
+#include "whd_endian.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Defaults used until cy_whd_sim_set_latency_model() is called. These are in
+ * the range measured for a 4-bit SDIO bus at 50 MHz including the dongle turn
+ * around time.
+ */
+#define CY_WHD_SIM_DEFAULT_BASE_US          (250)
+#define CY_WHD_SIM_DEFAULT_PER_BYTE_NS      (40)
+
+#define CY_WHD_SIM_MAX_LATENCY_OVERRIDES    (16)
+#define CY_WHD_SIM_MAX_FAULTS               (8)
+
+/* Firmware power-on value of pm2_sleep_ret */
+#define CY_WHD_SIM_DEFAULT_PM2_SLEEP_RET    (200)
+
+/* Sizes of the firmware control structures as they cross the bus */
+#define CY_WHD_SIM_PKT_FILTER_HDR_LEN       (5 * sizeof(uint32_t))
+#define CY_WHD_SIM_PKT_FILTER_STATS_LEN     (3 * sizeof(uint32_t))
+#define CY_WHD_SIM_MKEEP_ALIVE_HDR_LEN      (12)
+#define CY_WHD_SIM_TKO_HDR_LEN              (2 * sizeof(uint16_t))
+#define CY_WHD_SIM_WOWL_OPT_LEN             (4)
+#define CY_WHD_SIM_EVENT_MSGS_LEN           (26)
+
+#define CY_WHD_SIM_BUF_MAGIC                (0x53494d42)
+
+typedef struct cy_whd_sim_buffer
+{
+    uint32_t magic;
+    char     name[CY_WHD_SIM_IOVAR_NAME_LEN];
+    uint16_t len;
+    uint8_t  data[WHD_PAYLOAD_MTU];
+} cy_whd_sim_buffer_t;
+
+typedef struct cy_whd_sim_fault
+{
+    char         iovar[CY_WHD_SIM_IOVAR_NAME_LEN];
+    whd_result_t result;
+} cy_whd_sim_fault_t;
+
+typedef struct cy_whd_sim_event_handler
+{
+    bool                  in_use;
+    whd_event_num_t       events[16];
+    whd_event_handler_t   handler;
+    void                  *arg;
+} cy_whd_sim_event_handler_t;
+
+typedef struct cy_whd_sim
+{
+    pthread_mutex_t             lock;
+    struct whd_driver           driver;
+    struct whd_interface        iface;
+    struct whd_proto            proto;
+    cy_whd_sim_buffer_t         buffer;
+    cy_whd_sim_fw_state_t       fw;
+    cy_whd_sim_latency_t        latency;
+    cy_whd_sim_iovar_latency_t  overrides[CY_WHD_SIM_MAX_LATENCY_OVERRIDES];
+    uint32_t                    override_count;
+    cy_whd_sim_fault_t          faults[CY_WHD_SIM_MAX_FAULTS];
+    cy_whd_sim_stats_t          stats;
+    cy_whd_sim_call_t           log[CY_WHD_SIM_CALL_LOG_SIZE];
+    uint32_t                    log_head;
+    uint32_t                    log_count;
+    uint64_t                    now_us;
+    cy_whd_sim_call_cb_t        call_cb;
+    void                        *call_cb_arg;
+    cy_whd_sim_event_handler_t  handlers[CY_WHD_SIM_MAX_EVENT_HANDLERS];
+    bool                        batch;
+} cy_whd_sim_t;
+
+static cy_whd_sim_t cy_whd_sim =
+{
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .latency = { CY_WHD_SIM_DEFAULT_BASE_US, CY_WHD_SIM_DEFAULT_PER_BYTE_NS },
+};
+
+static void *cy_whd_sim_get_ioctl_buffer(whd_driver_t whd_driver, whd_buffer_t *buffer, uint16_t data_length);
+static void *cy_whd_sim_get_iovar_buffer(whd_driver_t whd_driver, whd_buffer_t *buffer, uint16_t data_length,
+                                         const char *name);
+static whd_result_t cy_whd_sim_set_ioctl(whd_interface_t ifp, uint32_t command, whd_buffer_t send_buffer_hnd,
+                                         whd_buffer_t *response_buffer_hnd);
+static whd_result_t cy_whd_sim_get_ioctl(whd_interface_t ifp, uint32_t command, whd_buffer_t send_buffer_hnd,
+                                         whd_buffer_t *response_buffer_hnd);
+static whd_result_t cy_whd_sim_set_iovar(whd_interface_t ifp, whd_buffer_t send_buffer_hnd,
+                                         whd_buffer_t *response_buffer_hnd);
+static whd_result_t cy_whd_sim_get_iovar(whd_interface_t ifp, whd_buffer_t send_buffer_hnd,
+                                         whd_buffer_t *response_buffer_hnd);
+static void cy_whd_sim_tko_subcmd(const uint8_t *data, uint16_t len);
+
+/*******************************************************************************
+* Accounting
+*******************************************************************************/
+
+static const cy_whd_sim_latency_t *cy_whd_sim_latency_for(const char *iovar)
+{
+    uint32_t i;
+
+    for (i = 0; i < cy_whd_sim.override_count; i++)
+    {
+        if (strncmp(cy_whd_sim.overrides[i].iovar, iovar, CY_WHD_SIM_IOVAR_NAME_LEN) == 0)
+        {
+            return &cy_whd_sim.overrides[i].latency;
+        }
+    }
+    return &cy_whd_sim.latency;
+}
+
+static whd_result_t cy_whd_sim_fault_for(const char *iovar)
+{
+    uint32_t i;
+
+    for (i = 0; i < CY_WHD_SIM_MAX_FAULTS; i++)
+    {
+        if ( (cy_whd_sim.faults[i].iovar[0] != '\0') &&
+             (strncmp(cy_whd_sim.faults[i].iovar, iovar, CY_WHD_SIM_IOVAR_NAME_LEN) == 0) )
+        {
+            return cy_whd_sim.faults[i].result;
+        }
+    }
+    return WHD_SUCCESS;
+}
+
+/*
+ * Account one control transaction. Must be called with the lock held.
+ * tx_len / rx_len are payload lengths; the IOVAR name and bus framing are
+ * added here. Returns the injected fault for this IOVAR, if any.
+ */
+static whd_result_t cy_whd_sim_xfer(const char *api, const char *iovar, bool set, uint32_t tx_len, uint32_t rx_len)
+{
+    const cy_whd_sim_latency_t *lat = cy_whd_sim_latency_for(iovar);
+    cy_whd_sim_call_t *call = &cy_whd_sim.log[cy_whd_sim.log_head];
+    uint32_t name_len = (uint32_t)strlen(iovar) + 1;
+
+    memset(call, 0, sizeof(*call) );
+    call->api = api;
+    strncpy(call->iovar, iovar, CY_WHD_SIM_IOVAR_NAME_LEN - 1);
+    call->set = set;
+    call->tx_bytes = CY_WHD_SIM_BUS_HEADER_LEN + name_len + tx_len;
+    call->rx_bytes = CY_WHD_SIM_BUS_HEADER_LEN + (set ? 0 : rx_len);
+    call->latency_us = lat->base_us +
+                       (uint32_t)( ( (uint64_t)(call->tx_bytes + call->rx_bytes) * lat->per_byte_ns ) / 1000 );
+    call->result = cy_whd_sim_fault_for(iovar);
+
+    cy_whd_sim.now_us += call->latency_us;
+    call->timestamp_us = cy_whd_sim.now_us;
+
+    cy_whd_sim.stats.transactions++;
+    if (set)
+    {
+        cy_whd_sim.stats.sets++;
+    }
+    else
+    {
+        cy_whd_sim.stats.gets++;
+    }
+    if (call->result != WHD_SUCCESS)
+    {
+        cy_whd_sim.stats.failures++;
+    }
+    cy_whd_sim.stats.tx_bytes += call->tx_bytes;
+    cy_whd_sim.stats.rx_bytes += call->rx_bytes;
+    cy_whd_sim.stats.bus_time_us += call->latency_us;
+
+    cy_whd_sim.log_head = (cy_whd_sim.log_head + 1) % CY_WHD_SIM_CALL_LOG_SIZE;
+    if (cy_whd_sim.log_count < CY_WHD_SIM_CALL_LOG_SIZE)
+    {
+        cy_whd_sim.log_count++;
+    }
+
+    if (cy_whd_sim.call_cb != NULL)
+    {
+        cy_whd_sim.call_cb(call, cy_whd_sim.call_cb_arg);
+    }
+    return call->result;
+}
+
+static void cy_whd_sim_lock(void)
+{
+    pthread_mutex_lock(&cy_whd_sim.lock);
+}
+
+static void cy_whd_sim_unlock(void)
+{
+    pthread_mutex_unlock(&cy_whd_sim.lock);
+}
+
+/*******************************************************************************
+* Firmware state helpers
+*******************************************************************************/
+
+static cy_whd_sim_iovar_t *cy_whd_sim_find_iovar(const char *name, bool create)
+{
+    cy_whd_sim_iovar_t *free_slot = NULL;
+    uint32_t i;
+
+    for (i = 0; i < CY_WHD_SIM_MAX_IOVARS; i++)
+    {
+        cy_whd_sim_iovar_t *v = &cy_whd_sim.fw.iovars[i];
+        if (v->in_use)
+        {
+            if (strncmp(v->name, name, CY_WHD_SIM_IOVAR_NAME_LEN) == 0)
+            {
+                return v;
+            }
+        }
+        else if (free_slot == NULL)
+        {
+            free_slot = v;
+        }
+    }
+    if (create && (free_slot != NULL) )
+    {
+        free_slot->in_use = true;
+        strncpy(free_slot->name, name, CY_WHD_SIM_IOVAR_NAME_LEN - 1);
+        free_slot->value = 0;
+        return free_slot;
+    }
+    return NULL;
+}
+
+static void cy_whd_sim_store_iovar(const char *name, uint32_t value)
+{
+    cy_whd_sim_iovar_t *v = cy_whd_sim_find_iovar(name, true);
+
+    if (v != NULL)
+    {
+        v->value = value;
+    }
+}
+
+static cy_whd_sim_pkt_filter_t *cy_whd_sim_find_filter(uint32_t id)
+{
+    uint32_t i;
+
+    for (i = 0; i < CY_WHD_SIM_MAX_PKT_FILTERS; i++)
+    {
+        if (cy_whd_sim.fw.filters[i].in_use && (cy_whd_sim.fw.filters[i].id == id) )
+        {
+            return &cy_whd_sim.fw.filters[i];
+        }
+    }
+    return NULL;
+}
+
+static void cy_whd_sim_fw_reset(void)
+{
+    uint32_t fwcap = cy_whd_sim.fw.fwcap;
+
+    memset(&cy_whd_sim.fw, 0, sizeof(cy_whd_sim.fw) );
+    cy_whd_sim.fw.fwcap = fwcap;
+    cy_whd_sim.fw.tko_max = CY_WHD_SIM_MAX_TKO_SLOTS;
+    cy_whd_sim.fw.pm2_sleep_ret = CY_WHD_SIM_DEFAULT_PM2_SLEEP_RET;
+    cy_whd_sim_store_iovar("pm2_sleep_ret", CY_WHD_SIM_DEFAULT_PM2_SLEEP_RET);
+}
+
+/* Apply a SET of a raw IOVAR buffer to the firmware state */
+static void cy_whd_sim_apply_set(const char *name, const uint8_t *data, uint16_t len)
+{
+    cy_whd_sim_pkt_filter_t *filter;
+    uint32_t value, enable;
+
+    if (strcmp(name, IOVAR_STR_TKO) == 0)
+    {
+        cy_whd_sim_tko_subcmd(data, len);
+    }
+    else if ( (strcmp(name, "pkt_filter_enable") == 0) && (len >= 2 * sizeof(uint32_t) ) )
+    {
+        memcpy(&value, data, sizeof(value) );
+        memcpy(&enable, data + sizeof(value), sizeof(enable) );
+        filter = cy_whd_sim_find_filter(dtoh32(value) );
+        if (filter != NULL)
+        {
+            filter->enabled = (dtoh32(enable) != 0);
+        }
+    }
+    else if (len == sizeof(uint32_t) )
+    {
+        memcpy(&value, data, sizeof(value) );
+        value = dtoh32(value);
+        cy_whd_sim_store_iovar(name, value);
+        if (strcmp(name, "arpoe") == 0)
+        {
+            cy_whd_sim.fw.arpoe = value;
+        }
+        else if (strcmp(name, "arp_ol") == 0)
+        {
+            cy_whd_sim.fw.arp_features = value;
+        }
+    }
+}
+
+/*******************************************************************************
+* Simulator API
+*******************************************************************************/
+
+whd_interface_t cy_whd_sim_init(void)
+{
+    cy_whd_sim_lock();
+
+    memset(&cy_whd_sim.driver, 0, sizeof(cy_whd_sim.driver) );
+    memset(&cy_whd_sim.iface, 0, sizeof(cy_whd_sim.iface) );
+    memset(&cy_whd_sim.proto, 0, sizeof(cy_whd_sim.proto) );
+
+    cy_whd_sim.proto.get_ioctl_buffer = cy_whd_sim_get_ioctl_buffer;
+    cy_whd_sim.proto.get_iovar_buffer = cy_whd_sim_get_iovar_buffer;
+    cy_whd_sim.proto.set_ioctl = cy_whd_sim_set_ioctl;
+    cy_whd_sim.proto.get_ioctl = cy_whd_sim_get_ioctl;
+    cy_whd_sim.proto.set_iovar = cy_whd_sim_set_iovar;
+    cy_whd_sim.proto.get_iovar = cy_whd_sim_get_iovar;
+
+    cy_whd_sim.driver.proto = &cy_whd_sim.proto;
+    cy_whd_sim.iface.whd_driver = &cy_whd_sim.driver;
+    cy_whd_sim.iface.role = WHD_STA_ROLE;
+
+    cy_whd_sim_fw_reset();
+    memset(cy_whd_sim.faults, 0, sizeof(cy_whd_sim.faults) );
+    memset(cy_whd_sim.handlers, 0, sizeof(cy_whd_sim.handlers) );
+    memset(&cy_whd_sim.stats, 0, sizeof(cy_whd_sim.stats) );
+    cy_whd_sim.log_head = 0;
+    cy_whd_sim.log_count = 0;
+    cy_whd_sim.now_us = 0;
+
+    cy_whd_sim_unlock();
+    return &cy_whd_sim.iface;
+}
+
+void cy_whd_sim_reload_firmware(void)
+{
+    cy_whd_sim_lock();
+    cy_whd_sim_fw_reset();
+    cy_whd_sim_unlock();
+}
+
+void cy_whd_sim_set_latency_model(const cy_whd_sim_latency_t *dflt,
+                                  const cy_whd_sim_iovar_latency_t *overrides, uint32_t count)
+{
+    cy_whd_sim_lock();
+    if (dflt != NULL)
+    {
+        cy_whd_sim.latency = *dflt;
+    }
+    if (count > CY_WHD_SIM_MAX_LATENCY_OVERRIDES)
+    {
+        count = CY_WHD_SIM_MAX_LATENCY_OVERRIDES;
+    }
+    if (overrides == NULL)
+    {
+        count = 0;
+    }
+    memcpy(cy_whd_sim.overrides, overrides, count * sizeof(overrides[0]) );
+    cy_whd_sim.override_count = count;
+    cy_whd_sim_unlock();
+}
+
+void cy_whd_sim_set_fwcap(uint32_t fwcap)
+{
+    cy_whd_sim_lock();
+    cy_whd_sim.fw.fwcap = fwcap;
+    cy_whd_sim_unlock();
+}
+
+void cy_whd_sim_set_batch_support(bool enable)
+{
+    cy_whd_sim_lock();
+    cy_whd_sim.batch = enable;
+    cy_whd_sim_unlock();
+}
+
+void cy_whd_sim_set_fault(const char *iovar, whd_result_t result)
+{
+    cy_whd_sim_fault_t *free_slot = NULL;
+    uint32_t i;
+
+    cy_whd_sim_lock();
+    for (i = 0; i < CY_WHD_SIM_MAX_FAULTS; i++)
+    {
+        cy_whd_sim_fault_t *f = &cy_whd_sim.faults[i];
+        if (strncmp(f->iovar, iovar, CY_WHD_SIM_IOVAR_NAME_LEN) == 0)
+        {
+            free_slot = f;
+            break;
+        }
+        if ( (free_slot == NULL) && (f->iovar[0] == '\0') )
+        {
+            free_slot = f;
+        }
+    }
+    if (free_slot != NULL)
+    {
+        if (result == WHD_SUCCESS)
+        {
+            memset(free_slot, 0, sizeof(*free_slot) );
+        }
+        else
+        {
+            strncpy(free_slot->iovar, iovar, CY_WHD_SIM_IOVAR_NAME_LEN - 1);
+            free_slot->result = result;
+        }
+    }
+    cy_whd_sim_unlock();
+}
+
+void cy_whd_sim_get_stats(cy_whd_sim_stats_t *stats)
+{
+    cy_whd_sim_lock();
+    *stats = cy_whd_sim.stats;
+    cy_whd_sim_unlock();
+}
+
+void cy_whd_sim_reset_stats(void)
+{
+    cy_whd_sim_lock();
+    memset(&cy_whd_sim.stats, 0, sizeof(cy_whd_sim.stats) );
+    cy_whd_sim.log_head = 0;
+    cy_whd_sim.log_count = 0;
+    cy_whd_sim_unlock();
+}
+
+uint32_t cy_whd_sim_get_calls(cy_whd_sim_call_t *calls, uint32_t max)
+{
+    uint32_t first, n, i;
+
+    cy_whd_sim_lock();
+    n = (cy_whd_sim.log_count < max) ? cy_whd_sim.log_count : max;
+    first = (cy_whd_sim.log_head + CY_WHD_SIM_CALL_LOG_SIZE - n) % CY_WHD_SIM_CALL_LOG_SIZE;
+    for (i = 0; i < n; i++)
+    {
+        calls[i] = cy_whd_sim.log[(first + i) % CY_WHD_SIM_CALL_LOG_SIZE];
+    }
+    cy_whd_sim_unlock();
+    return n;
+}
+
+void cy_whd_sim_set_call_callback(cy_whd_sim_call_cb_t cb, void *arg)
+{
+    cy_whd_sim_lock();
+    cy_whd_sim.call_cb = cb;
+    cy_whd_sim.call_cb_arg = arg;
+    cy_whd_sim_unlock();
+}
+
+const cy_whd_sim_fw_state_t *cy_whd_sim_get_fw_state(void)
+{
+    return &cy_whd_sim.fw;
+}
+
+uint64_t cy_whd_sim_get_time_us(void)
+{
+    uint64_t now;
+
+    cy_whd_sim_lock();
+    now = cy_whd_sim.now_us;
+    cy_whd_sim_unlock();
+    return now;
+}
+
+void cy_whd_sim_inject_event(const whd_event_header_t *event, const uint8_t *data)
+{
+    cy_whd_sim_event_handler_t handlers[CY_WHD_SIM_MAX_EVENT_HANDLERS];
+    uint32_t i, j;
+
+    /* Handlers may call back into the simulator, so run them unlocked */
+    cy_whd_sim_lock();
+    memcpy(handlers, cy_whd_sim.handlers, sizeof(handlers) );
+    cy_whd_sim_unlock();
+
+    for (i = 0; i < CY_WHD_SIM_MAX_EVENT_HANDLERS; i++)
+    {
+        if (!handlers[i].in_use)
+        {
+            continue;
+        }
+        for (j = 0; (j < 16) && (handlers[i].events[j] != WLC_E_NONE); j++)
+        {
+            if (handlers[i].events[j] == event->event_type)
+            {
+                handlers[i].handler(&cy_whd_sim.iface, event, data, handlers[i].arg);
+                break;
+            }
+        }
+    }
+}
+
+void cy_whd_sim_dump(void)
+{
+    static cy_whd_sim_call_t calls[CY_WHD_SIM_CALL_LOG_SIZE];
+    cy_whd_sim_stats_t stats;
+    uint32_t n, i, j;
+
+    cy_whd_sim_get_stats(&stats);
+    n = cy_whd_sim_get_calls(calls, CY_WHD_SIM_CALL_LOG_SIZE);
+
+    printf("WHD sim: %u transactions (%u set, %u get, %u failed), tx %llu B, rx %llu B, bus %llu us\n",
+           (unsigned)stats.transactions, (unsigned)stats.sets, (unsigned)stats.gets, (unsigned)stats.failures,
+           (unsigned long long)stats.tx_bytes, (unsigned long long)stats.rx_bytes,
+           (unsigned long long)stats.bus_time_us);
+
+    /* Per-IOVAR breakdown of what is still in the call log */
+    for (i = 0; i < n; i++)
+    {
+        uint32_t count = 0, bytes = 0, us = 0;
+
+        for (j = 0; j < i; j++)
+        {
+            if (strcmp(calls[j].iovar, calls[i].iovar) == 0)
+            {
+                break;
+            }
+        }
+        if (j != i)
+        {
+            continue;
+        }
+        for (j = i; j < n; j++)
+        {
+            if (strcmp(calls[j].iovar, calls[i].iovar) == 0)
+            {
+                count++;
+                bytes += calls[j].tx_bytes + calls[j].rx_bytes;
+                us += calls[j].latency_us;
+            }
+        }
+        printf("  %-24s %5u calls %7u B %8u us\n", calls[i].iovar, (unsigned)count, (unsigned)bytes, (unsigned)us);
+    }
+}
+
+/*******************************************************************************
+* Simulated proto layer
+*******************************************************************************/
+
+static void *cy_whd_sim_get_ioctl_buffer(whd_driver_t whd_driver, whd_buffer_t *buffer, uint16_t data_length)
+{
+    return cy_whd_sim_get_iovar_buffer(whd_driver, buffer, data_length, "ioctl");
+}
+
+static void *cy_whd_sim_get_iovar_buffer(whd_driver_t whd_driver, whd_buffer_t *buffer, uint16_t data_length,
+                                         const char *name)
+{
+    cy_whd_sim_buffer_t *buf = &cy_whd_sim.buffer;
+
+    if (data_length > sizeof(buf->data) )
+    {
+        return NULL;
+    }
+    memset(buf, 0, sizeof(*buf) );
+    buf->magic = CY_WHD_SIM_BUF_MAGIC;
+    strncpy(buf->name, name, CY_WHD_SIM_IOVAR_NAME_LEN - 1);
+    buf->len = data_length;
+    *buffer = (whd_buffer_t)buf;
+    return buf->data;
+}
+
+static whd_result_t cy_whd_sim_set_ioctl(whd_interface_t ifp, uint32_t command, whd_buffer_t send_buffer_hnd,
+                                         whd_buffer_t *response_buffer_hnd)
+{
+    cy_whd_sim_buffer_t *buf = (cy_whd_sim_buffer_t *)send_buffer_hnd;
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "ioctl", true, buf->len, 0);
+    cy_whd_sim_unlock();
+    return result;
+}
+
+static whd_result_t cy_whd_sim_get_ioctl(whd_interface_t ifp, uint32_t command, whd_buffer_t send_buffer_hnd,
+                                         whd_buffer_t *response_buffer_hnd)
+{
+    cy_whd_sim_buffer_t *buf = (cy_whd_sim_buffer_t *)send_buffer_hnd;
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "ioctl", false, buf->len, buf->len);
+    if (response_buffer_hnd != NULL)
+    {
+        *response_buffer_hnd = send_buffer_hnd;
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+/* TKO CONNECT records arrive through the raw proto interface (whd_tko_activate) */
+static void cy_whd_sim_tko_subcmd(const uint8_t *data, uint16_t len)
+{
+    const wl_tko_t *tko = (const wl_tko_t *)data;
+    const wl_tko_connect_t *connect;
+    uint16_t sub_len;
+
+    if (len < offsetof(wl_tko_t, data) )
+    {
+        return;
+    }
+    sub_len = dtoh16(tko->len);
+    if ( (dtoh16(tko->subcmd_id) != WL_TKO_SUBCMD_CONNECT) || (sub_len > len) )
+    {
+        return;
+    }
+    connect = (const wl_tko_connect_t *)tko->data;
+    if (connect->index < CY_WHD_SIM_MAX_TKO_SLOTS)
+    {
+        cy_whd_sim_tko_slot_t *slot = &cy_whd_sim.fw.tko[connect->index];
+        slot->in_use = true;
+        slot->len = (uint16_t)(sub_len - offsetof(wl_tko_t, data) );
+        memcpy(slot->data, connect, slot->len);
+    }
+}
+
+static whd_result_t cy_whd_sim_set_iovar(whd_interface_t ifp, whd_buffer_t send_buffer_hnd,
+                                         whd_buffer_t *response_buffer_hnd)
+{
+    cy_whd_sim_buffer_t *buf = (cy_whd_sim_buffer_t *)send_buffer_hnd;
+    whd_result_t result;
+
+    if ( (buf == NULL) || (buf->magic != CY_WHD_SIM_BUF_MAGIC) )
+    {
+        return WHD_BADARG;
+    }
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, buf->name, true, buf->len, 0);
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim_apply_set(buf->name, buf->data, buf->len);
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+static whd_result_t cy_whd_sim_get_iovar(whd_interface_t ifp, whd_buffer_t send_buffer_hnd,
+                                         whd_buffer_t *response_buffer_hnd)
+{
+    cy_whd_sim_buffer_t *buf = (cy_whd_sim_buffer_t *)send_buffer_hnd;
+    cy_whd_sim_iovar_t *v;
+    whd_result_t result;
+
+    if ( (buf == NULL) || (buf->magic != CY_WHD_SIM_BUF_MAGIC) )
+    {
+        return WHD_BADARG;
+    }
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, buf->name, false, 0, buf->len);
+    v = cy_whd_sim_find_iovar(buf->name, false);
+    if ( (result == WHD_SUCCESS) && (v != NULL) && (buf->len >= sizeof(uint32_t) ) )
+    {
+        uint32_t value = htod32(v->value);
+        memcpy(buf->data, &value, sizeof(value) );
+    }
+    if (response_buffer_hnd != NULL)
+    {
+        *response_buffer_hnd = send_buffer_hnd;
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+/*******************************************************************************
+* Simulated WHD API: generic
+*******************************************************************************/
+
+whd_result_t whd_wifi_set_iovar_value(whd_interface_t ifp, const char *iovar, uint32_t value)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, iovar, true, sizeof(uint32_t), 0);
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim_store_iovar(iovar, value);
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_wifi_get_iovar_value(whd_interface_t ifp, const char *iovar, uint32_t *value)
+{
+    cy_whd_sim_iovar_t *v;
+    whd_result_t result;
+
+    if (value == NULL)
+    {
+        return WHD_BADARG;
+    }
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, iovar, false, 0, sizeof(uint32_t) );
+    if (result == WHD_SUCCESS)
+    {
+        v = cy_whd_sim_find_iovar(iovar, false);
+        *value = (v != NULL) ? v->value : 0;
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_wifi_set_iovar_buffer(whd_interface_t ifp, const char *iovar, void *buffer, uint16_t len)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, iovar, true, len, 0);
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim_apply_set(iovar, (const uint8_t *)buffer, len);
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_wifi_get_iovar_buffer(whd_interface_t ifp, const char *iovar_name, uint8_t *out_buffer,
+                                       uint16_t out_length)
+{
+    cy_whd_sim_iovar_t *v;
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, iovar_name, false, 0, out_length);
+    v = cy_whd_sim_find_iovar(iovar_name, false);
+    memset(out_buffer, 0, out_length);
+    if ( (result == WHD_SUCCESS) && (v != NULL) && (out_length >= sizeof(uint32_t) ) )
+    {
+        memcpy(out_buffer, &v->value, sizeof(v->value) );
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_wifi_get_fwcap(whd_interface_t ifp, uint32_t *value)
+{
+    /* WHD reports the capabilities it cached at firmware download; no bus traffic */
+    *value = cy_whd_sim.fw.fwcap;
+    return WHD_SUCCESS;
+}
+
+whd_result_t whd_wifi_enable_powersave_with_throughput(whd_interface_t ifp, uint16_t return_to_sleep_delay)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "pm2_sleep_ret", true, sizeof(uint32_t), 0);
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim.fw.pm2_sleep_ret = return_to_sleep_delay;
+        cy_whd_sim_store_iovar("pm2_sleep_ret", return_to_sleep_delay);
+        result = cy_whd_sim_xfer(__func__, "PM", true, sizeof(uint32_t), 0);
+    }
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim.fw.powersave = true;
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_wifi_get_mac_address(whd_interface_t ifp, whd_mac_t *mac)
+{
+    static const whd_mac_t sim_mac = { { 0x02, 0x00, 0x5e, 0x10, 0x00, 0x01 } };
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "cur_etheraddr", false, 0, sizeof(whd_mac_t) );
+    if (result == WHD_SUCCESS)
+    {
+        *mac = sim_mac;
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_wifi_is_ready_to_transceive(whd_interface_t ifp)
+{
+    return WHD_SUCCESS;
+}
+
+whd_result_t whd_wifi_config_ulp_mode(whd_interface_t ifp, uint32_t *mode, uint32_t *wait_time)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "ulp", true, sizeof(uint32_t), 0);
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim_store_iovar("ulp", *mode);
+        result = cy_whd_sim_xfer(__func__, "ulp_wait", true, sizeof(uint32_t), 0);
+        cy_whd_sim_store_iovar("ulp_wait", *wait_time);
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_management_set_event_handler(whd_interface_t ifp, const whd_event_num_t *type,
+                                              whd_event_handler_t handler_func, void *handler_user_data,
+                                              uint16_t *event_index)
+{
+    whd_result_t result;
+    uint16_t i, j;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "event_msgs", true, CY_WHD_SIM_EVENT_MSGS_LEN, 0);
+    for (i = 0; (result == WHD_SUCCESS) && (i < CY_WHD_SIM_MAX_EVENT_HANDLERS); i++)
+    {
+        cy_whd_sim_event_handler_t *h = &cy_whd_sim.handlers[i];
+        if (h->in_use)
+        {
+            continue;
+        }
+        for (j = 0; j < 15 && type[j] != WLC_E_NONE; j++)
+        {
+            h->events[j] = type[j];
+        }
+        h->events[j] = WLC_E_NONE;
+        h->handler = handler_func;
+        h->arg = handler_user_data;
+        h->in_use = true;
+        *event_index = i;
+        break;
+    }
+    if ( (result == WHD_SUCCESS) && (i == CY_WHD_SIM_MAX_EVENT_HANDLERS) )
+    {
+        result = WHD_WLAN_NORESOURCE;
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_wifi_deregister_event_handler(whd_interface_t ifp, uint16_t event_index)
+{
+    whd_result_t result;
+
+    if (event_index >= CY_WHD_SIM_MAX_EVENT_HANDLERS)
+    {
+        return WHD_BADARG;
+    }
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "event_msgs", true, CY_WHD_SIM_EVENT_MSGS_LEN, 0);
+    memset(&cy_whd_sim.handlers[event_index], 0, sizeof(cy_whd_sim.handlers[event_index]) );
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_print_stats(whd_driver_t whd_drv, whd_bool_t reset_after_print)
+{
+    cy_whd_sim_dump();
+    if (reset_after_print == WHD_TRUE)
+    {
+        cy_whd_sim_reset_stats();
+    }
+    return WHD_SUCCESS;
+}
+
+/*******************************************************************************
+* Simulated WHD API: packet filters
+*******************************************************************************/
+
+whd_result_t whd_pf_add_packet_filter(whd_interface_t ifp, const whd_packet_filter_t *settings)
+{
+    cy_whd_sim_pkt_filter_t *slot = NULL;
+    whd_result_t result;
+    uint32_t i;
+
+    if ( (settings == NULL) || (settings->mask_size > CY_WHD_SIM_MAX_FILTER_LEN) )
+    {
+        return WHD_BADARG;
+    }
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "pkt_filter_add", true,
+                             CY_WHD_SIM_PKT_FILTER_HDR_LEN + 2u * settings->mask_size, 0);
+    if (result == WHD_SUCCESS)
+    {
+        if (cy_whd_sim_find_filter(settings->id) != NULL)
+        {
+            result = WHD_BADARG;
+        }
+        for (i = 0; (result == WHD_SUCCESS) && (i < CY_WHD_SIM_MAX_PKT_FILTERS); i++)
+        {
+            if (!cy_whd_sim.fw.filters[i].in_use)
+            {
+                slot = &cy_whd_sim.fw.filters[i];
+                break;
+            }
+        }
+        if ( (result == WHD_SUCCESS) && (slot == NULL) )
+        {
+            result = WHD_WLAN_NORESOURCE;
+        }
+    }
+    if (result == WHD_SUCCESS)
+    {
+        memset(slot, 0, sizeof(*slot) );
+        slot->in_use = true;
+        slot->id = settings->id;
+        slot->rule = (uint32_t)settings->rule;
+        slot->offset = settings->offset;
+        slot->mask_size = settings->mask_size;
+        memcpy(slot->mask, settings->mask, settings->mask_size);
+        memcpy(slot->pattern, settings->pattern, settings->mask_size);
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+static whd_result_t cy_whd_sim_pf_enable(const char *api, uint8_t filter_id, bool enable)
+{
+    cy_whd_sim_pkt_filter_t *filter;
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(api, "pkt_filter_enable", true, 2 * sizeof(uint32_t), 0);
+    filter = cy_whd_sim_find_filter(filter_id);
+    if ( (result == WHD_SUCCESS) && (filter == NULL) )
+    {
+        result = WHD_BADARG;
+    }
+    if (result == WHD_SUCCESS)
+    {
+        filter->enabled = enable;
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_pf_enable_packet_filter(whd_interface_t ifp, uint8_t filter_id)
+{
+    return cy_whd_sim_pf_enable(__func__, filter_id, true);
+}
+
+whd_result_t whd_pf_disable_packet_filter(whd_interface_t ifp, uint8_t filter_id)
+{
+    return cy_whd_sim_pf_enable(__func__, filter_id, false);
+}
+
+whd_result_t whd_pf_remove_packet_filter(whd_interface_t ifp, uint8_t filter_id)
+{
+    cy_whd_sim_pkt_filter_t *filter;
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "pkt_filter_delete", true, sizeof(uint32_t), 0);
+    filter = cy_whd_sim_find_filter(filter_id);
+    if ( (result == WHD_SUCCESS) && (filter == NULL) )
+    {
+        result = WHD_BADARG;
+    }
+    if (result == WHD_SUCCESS)
+    {
+        memset(filter, 0, sizeof(*filter) );
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_pf_get_packet_filter_stats(whd_interface_t ifp, uint8_t filter_id, wl_pkt_filter_stats_t *stats)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "pkt_filter_stats", false, sizeof(uint32_t), CY_WHD_SIM_PKT_FILTER_STATS_LEN);
+    if ( (result == WHD_SUCCESS) && (cy_whd_sim_find_filter(filter_id) == NULL) )
+    {
+        result = WHD_BADARG;
+    }
+    if (result == WHD_SUCCESS)
+    {
+        memset(stats, 0, sizeof(*stats) );
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+/*******************************************************************************
+* Simulated WHD API: ARP offload
+*******************************************************************************/
+
+whd_result_t whd_arp_arpoe_set(whd_interface_t ifp, uint32_t value)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "arpoe", true, sizeof(uint32_t), 0);
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim.fw.arpoe = value;
+        cy_whd_sim_store_iovar("arpoe", value);
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_arp_features_set(whd_interface_t ifp, uint32_t features)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "arp_ol", true, sizeof(uint32_t), 0);
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim.fw.arp_features = features;
+        cy_whd_sim_store_iovar("arp_ol", features);
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_arp_cache_clear(whd_interface_t ifp)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "arp_table_clear", true, 0, 0);
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_arp_stats_clear(whd_interface_t ifp)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "arp_stats_clear", true, 0, 0);
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_arp_hostip_list_clear(whd_interface_t ifp)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "arp_hostip_clear", true, 0, 0);
+    if (result == WHD_SUCCESS)
+    {
+        memset(cy_whd_sim.fw.hostip, 0, sizeof(cy_whd_sim.fw.hostip) );
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+static whd_result_t cy_whd_sim_hostip_add_locked(const char *api, uint32_t ip)
+{
+    whd_result_t result;
+    uint32_t i;
+
+    result = cy_whd_sim_xfer(api, "arp_hostip", true, sizeof(uint32_t), 0);
+    if (result != WHD_SUCCESS)
+    {
+        return result;
+    }
+    for (i = 0; i < ARP_MULTIHOMING_MAX; i++)
+    {
+        if (cy_whd_sim.fw.hostip[i] == ip)
+        {
+            return WHD_SUCCESS;
+        }
+    }
+    for (i = 0; i < ARP_MULTIHOMING_MAX; i++)
+    {
+        if (cy_whd_sim.fw.hostip[i] == 0)
+        {
+            cy_whd_sim.fw.hostip[i] = ip;
+            return WHD_SUCCESS;
+        }
+    }
+    return WHD_WLAN_NORESOURCE;
+}
+
+whd_result_t whd_arp_hostip_list_add(whd_interface_t ifp, uint32_t *host_ipv4_list, uint32_t count)
+{
+    whd_result_t result = WHD_SUCCESS;
+    uint32_t i;
+
+    cy_whd_sim_lock();
+    /* WHD adds one address per IOVAR */
+    for (i = 0; (result == WHD_SUCCESS) && (i < count); i++)
+    {
+        result = cy_whd_sim_hostip_add_locked(__func__, host_ipv4_list[i]);
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_arp_hostip_list_clear_id(whd_interface_t ifp, uint32_t ipv4_address)
+{
+    uint32_t keep[ARP_MULTIHOMING_MAX];
+    whd_result_t result;
+    uint32_t i;
+
+    cy_whd_sim_lock();
+    /* WHD reads the list, clears it and re-adds every other address */
+    result = cy_whd_sim_xfer(__func__, "arp_hostip", false, 0, sizeof(cy_whd_sim.fw.hostip) );
+    if (result == WHD_SUCCESS)
+    {
+        result = cy_whd_sim_xfer(__func__, "arp_hostip_clear", true, 0, 0);
+    }
+    if (result == WHD_SUCCESS)
+    {
+        memcpy(keep, cy_whd_sim.fw.hostip, sizeof(keep) );
+        memset(cy_whd_sim.fw.hostip, 0, sizeof(cy_whd_sim.fw.hostip) );
+        for (i = 0; (result == WHD_SUCCESS) && (i < ARP_MULTIHOMING_MAX); i++)
+        {
+            if ( (keep[i] != 0) && (keep[i] != ipv4_address) )
+            {
+                result = cy_whd_sim_hostip_add_locked(__func__, keep[i]);
+            }
+        }
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_arp_peerage_set(whd_interface_t ifp, uint32_t peerage)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "arp_peerage", true, sizeof(uint32_t), 0);
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim.fw.arp_peerage = peerage;
+        cy_whd_sim_store_iovar("arp_peerage", peerage);
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+/*******************************************************************************
+* Simulated WHD API: TCP keepalive offload
+*******************************************************************************/
+
+whd_result_t whd_tko_max_assoc(whd_interface_t ifp, uint8_t *max)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, IOVAR_STR_TKO, false, CY_WHD_SIM_TKO_HDR_LEN,
+                             CY_WHD_SIM_TKO_HDR_LEN + sizeof(uint8_t) );
+    if (result == WHD_SUCCESS)
+    {
+        *max = cy_whd_sim.fw.tko_max;
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_tko_param(whd_interface_t ifp, whd_tko_retry_t *whd_retry, uint8_t set)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, IOVAR_STR_TKO, (set != 0),
+                             CY_WHD_SIM_TKO_HDR_LEN + (set ? sizeof(*whd_retry) : 0),
+                             CY_WHD_SIM_TKO_HDR_LEN + sizeof(*whd_retry) );
+    if (result == WHD_SUCCESS)
+    {
+        if (set)
+        {
+            cy_whd_sim.fw.tko_param = *whd_retry;
+        }
+        else
+        {
+            *whd_retry = cy_whd_sim.fw.tko_param;
+        }
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_tko_toggle(whd_interface_t ifp, whd_bool_t enable)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, IOVAR_STR_TKO, true, CY_WHD_SIM_TKO_HDR_LEN + sizeof(uint32_t), 0);
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim.fw.tko_enabled = (enable == WHD_TRUE);
+        if (enable != WHD_TRUE)
+        {
+            memset(cy_whd_sim.fw.tko, 0, sizeof(cy_whd_sim.fw.tko) );
+        }
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+/*******************************************************************************
+* Simulated WHD API: keepalives
+*******************************************************************************/
+
+whd_result_t whd_wifi_keepalive_config(whd_interface_t ifp, whd_keep_alive_t *packet, whd_keep_alive_type_t flag)
+{
+    cy_whd_sim_keepalive_t *ka;
+    const char *iovar;
+    whd_result_t result;
+
+    if ( (packet == NULL) || (packet->len_bytes > CY_WHD_SIM_MAX_KEEPALIVE_LEN) )
+    {
+        return WHD_BADARG;
+    }
+    if (flag == WHD_KEEPALIVE_NAT)
+    {
+        ka = &cy_whd_sim.fw.nat_ka;
+        iovar = "nat_keepalive";
+    }
+    else
+    {
+        ka = &cy_whd_sim.fw.null_ka;
+        iovar = "mkeep_alive";
+    }
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, iovar, true, CY_WHD_SIM_MKEEP_ALIVE_HDR_LEN + packet->len_bytes, 0);
+    if (result == WHD_SUCCESS)
+    {
+        ka->configured = (packet->period_msec != 0);
+        ka->period_msec = packet->period_msec;
+        ka->len_bytes = packet->len_bytes;
+        if ( (packet->data != NULL) && (packet->len_bytes != 0) )
+        {
+            memcpy(ka->data, packet->data, packet->len_bytes);
+        }
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+/*******************************************************************************
+* Simulated WHD API: WOWL
+*******************************************************************************/
+
+whd_result_t whd_configure_wowl(whd_interface_t ifp, uint32_t set_wowl)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "wowl", true, sizeof(uint32_t), 0);
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim.fw.wowl_cap = set_wowl;
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_get_wowl_cap(whd_interface_t ifp, uint32_t *value)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "wowl", false, 0, sizeof(uint32_t) );
+    if (result == WHD_SUCCESS)
+    {
+        *value = cy_whd_sim.fw.wowl_cap;
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_set_wowl_cap(whd_interface_t ifp, uint32_t value)
+{
+    return whd_configure_wowl(ifp, value);
+}
+
+whd_result_t whd_wowl_clear(whd_interface_t ifp)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "wowl_clear", true, 0, 0);
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim.fw.wowl_active = false;
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_wowl_activate(whd_interface_t ifp, uint32_t value)
+{
+    whd_result_t result;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "wowl_activate", true, sizeof(uint32_t), 0);
+    if (result == WHD_SUCCESS)
+    {
+        cy_whd_sim.fw.wowl_active = (value != 0);
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+static bool cy_whd_sim_wowl_match(const cy_whd_sim_wowl_pattern_t *p, uint32_t offset, uint8_t mask_size,
+                                  const uint8_t *mask, uint8_t pattern_size, const uint8_t *pattern)
+{
+    return (p->in_use && (p->offset == offset) && (p->mask_size == mask_size) &&
+            (p->pattern_size == pattern_size) && (memcmp(p->mask, mask, mask_size) == 0) &&
+            (memcmp(p->pattern, pattern, pattern_size) == 0) );
+}
+
+whd_result_t whd_set_wowl_pattern(whd_interface_t ifp, char *opt, uint32_t offset, uint8_t mask_size,
+                                  uint8_t *mask, uint8_t pattern_size, uint8_t *pattern, uint8_t rule)
+{
+    whd_result_t result;
+    uint32_t i;
+
+    if ( (mask_size > sizeof(cy_whd_sim.fw.wowl[0].mask) ) || (pattern_size > CY_WHD_SIM_MAX_WOWL_LEN) )
+    {
+        return WHD_BADARG;
+    }
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "wowl_pattern", true,
+                             CY_WHD_SIM_WOWL_OPT_LEN + sizeof(wl_wowl_pattern_t) + mask_size + pattern_size, 0);
+    if (result == WHD_SUCCESS)
+    {
+        if (strcmp(opt, "clr") == 0)
+        {
+            memset(cy_whd_sim.fw.wowl, 0, sizeof(cy_whd_sim.fw.wowl) );
+        }
+        else if (strcmp(opt, "del") == 0)
+        {
+            for (i = 0; i < CY_WHD_SIM_MAX_WOWL_PATTERNS; i++)
+            {
+                if (cy_whd_sim_wowl_match(&cy_whd_sim.fw.wowl[i], offset, mask_size, mask, pattern_size, pattern) )
+                {
+                    memset(&cy_whd_sim.fw.wowl[i], 0, sizeof(cy_whd_sim.fw.wowl[i]) );
+                    break;
+                }
+            }
+            if (i == CY_WHD_SIM_MAX_WOWL_PATTERNS)
+            {
+                result = WHD_WLAN_NOTFOUND;
+            }
+        }
+        else
+        {
+            for (i = 0; i < CY_WHD_SIM_MAX_WOWL_PATTERNS; i++)
+            {
+                cy_whd_sim_wowl_pattern_t *p = &cy_whd_sim.fw.wowl[i];
+                if (!p->in_use)
+                {
+                    p->in_use = true;
+                    p->offset = offset;
+                    p->mask_size = mask_size;
+                    p->pattern_size = pattern_size;
+                    p->type = rule;
+                    memcpy(p->mask, mask, mask_size);
+                    memcpy(p->pattern, pattern, pattern_size);
+                    break;
+                }
+            }
+            if (i == CY_WHD_SIM_MAX_WOWL_PATTERNS)
+            {
+                result = WHD_WLAN_NORESOURCE;
+            }
+        }
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+whd_result_t whd_get_wowl_pattern(whd_interface_t ifp, uint32_t pattern_num, wl_wowl_pattern_t *pattern)
+{
+    const cy_whd_sim_wowl_pattern_t *p;
+    whd_result_t result;
+    uint32_t i, n = 0;
+
+    cy_whd_sim_lock();
+    result = cy_whd_sim_xfer(__func__, "wowl_pattern", false, 0, sizeof(wl_wowl_pattern_t) );
+    for (i = 0; (result == WHD_SUCCESS) && (i < CY_WHD_SIM_MAX_WOWL_PATTERNS); i++)
+    {
+        p = &cy_whd_sim.fw.wowl[i];
+        if (p->in_use && (n++ == pattern_num) )
+        {
+            memset(pattern, 0, sizeof(*pattern) );
+            pattern->masksize = p->mask_size;
+            pattern->offset = p->offset;
+            pattern->patternsize = p->pattern_size;
+            pattern->id = i;
+            pattern->type = p->type;
+            break;
+        }
+    }
+    if ( (result == WHD_SUCCESS) && (i == CY_WHD_SIM_MAX_WOWL_PATTERNS) )
+    {
+        result = WHD_WLAN_NOTFOUND;
+    }
+    cy_whd_sim_unlock();
+    return result;
+}
+
+/*******************************************************************************
+* Firmware batch command
+*******************************************************************************/
+
+/* Overrides the weak OLM hook; models a firmware that accepts several IOVAR
+ * sets in one control message when enabled with cy_whd_sim_set_batch_support().
+ */
+int cylpa_olm_txn_submit_batch(void *whd, const olm_txn_iovar_t *iovars, uint32_t count, uint32_t *results)
+{
+    whd_result_t result = WHD_SUCCESS;
+    uint32_t len = 0;
+    uint32_t i;
+
+    cy_whd_sim_lock();
+    if (!cy_whd_sim.batch)
+    {
+        cy_whd_sim_unlock();
+        return RESULT_UNSUPPORTED;
+    }
+    for (i = 0; i < count; i++)
+    {
+        /* name, payload length and payload of each sub-command */
+        len += (uint32_t)strlen(iovars[i].name) + 1 + sizeof(uint16_t) + iovars[i].len;
+        if (cy_whd_sim_fault_for(iovars[i].name) != WHD_SUCCESS)
+        {
+            result = cy_whd_sim_fault_for(iovars[i].name);
+        }
+    }
+    if (cy_whd_sim_xfer(__func__, "batch", true, len, 0) != WHD_SUCCESS)
+    {
+        result = WHD_WLAN_ERROR;
+    }
+    for (i = 0; i < count; i++)
+    {
+        results[i] = (result == WHD_SUCCESS) ? cy_whd_sim_fault_for(iovars[i].name) : result;
+        if (results[i] == WHD_SUCCESS)
+        {
+            cy_whd_sim_apply_set(iovars[i].name, (const uint8_t *)iovars[i].data, iovars[i].len);
+        }
+    }
+    cy_whd_sim_unlock();
+    return RESULT_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
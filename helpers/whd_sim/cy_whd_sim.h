@@ -0,0 +1,336 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+/**
+* @file cy_whd_sim.h
+* @brief Host-side simulated WHD backend.
+*
+* Replaces the WHD driver at link time on a Linux host so the offload manager
+* and all offloads can run without a board. Every whd_* call and every
+* proto->set_iovar / proto->get_iovar issued through the simulated driver is
+* recorded with the number of bytes that would cross the bus and the time the
+* transaction would take according to a configurable latency model. The
+* firmware side state written by the offloads (packet filters, ARP host IP
+* list, TKO slots, WOWL patterns, keepalives and plain IOVAR values) is kept
+* so it can be inspected after a sleep/wake cycle.
+*
+* The simulator is not part of a target build; the directory is listed in
+* .cyignore. Build it together with the LPA sources and the WHD public headers
+* on the host, for example:
+*
+*   gcc -DCY_WHD_SIM -I<whd>/inc -I<whd>/src/include -Iinclude -Isource \
+*       -Ihelpers/whd_sim helpers/whd_sim/cy_whd_sim.c source/...c -lpthread
+*/
+
+#ifndef CY_WHD_SIM_H__
+#define CY_WHD_SIM_H__  (1)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "whd.h"
+#include "whd_wlioctl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* Simulator limits
+*******************************************************************************/
+
+/** Maximum number of packet filters the simulated firmware accepts */
+#ifndef CY_WHD_SIM_MAX_PKT_FILTERS
+#define CY_WHD_SIM_MAX_PKT_FILTERS      (16)
+#endif
+
+/** Maximum mask/pattern length of a simulated packet filter */
+#ifndef CY_WHD_SIM_MAX_FILTER_LEN
+#define CY_WHD_SIM_MAX_FILTER_LEN       (64)
+#endif
+
+/** Maximum number of WOWL net patterns the simulated firmware accepts */
+#ifndef CY_WHD_SIM_MAX_WOWL_PATTERNS
+#define CY_WHD_SIM_MAX_WOWL_PATTERNS    (8)
+#endif
+
+/** Maximum length of a WOWL net pattern */
+#ifndef CY_WHD_SIM_MAX_WOWL_LEN
+#define CY_WHD_SIM_MAX_WOWL_LEN         (128)
+#endif
+
+/** Maximum number of TCP keepalive slots */
+#ifndef CY_WHD_SIM_MAX_TKO_SLOTS
+#define CY_WHD_SIM_MAX_TKO_SLOTS        (MAX_TKO_CONN)
+#endif
+
+/** Maximum size of a keepalive payload */
+#ifndef CY_WHD_SIM_MAX_KEEPALIVE_LEN
+#define CY_WHD_SIM_MAX_KEEPALIVE_LEN    (256)
+#endif
+
+/** Number of plain uint32_t IOVARs the simulated firmware can hold */
+#ifndef CY_WHD_SIM_MAX_IOVARS
+#define CY_WHD_SIM_MAX_IOVARS           (48)
+#endif
+
+/** Number of calls kept in the call log (oldest entries are overwritten) */
+#ifndef CY_WHD_SIM_CALL_LOG_SIZE
+#define CY_WHD_SIM_CALL_LOG_SIZE        (512)
+#endif
+
+/** Maximum number of registered WHD event handlers */
+#ifndef CY_WHD_SIM_MAX_EVENT_HANDLERS
+#define CY_WHD_SIM_MAX_EVENT_HANDLERS   (8)
+#endif
+
+/** Length of an IOVAR name including the terminating NUL */
+#define CY_WHD_SIM_IOVAR_NAME_LEN       (32)
+
+/** Bytes of SDPCM + CDC/BDC framing added to every control transaction */
+#define CY_WHD_SIM_BUS_HEADER_LEN       (12 + 16)
+
+/*******************************************************************************
+* Simulator Data Structures
+*******************************************************************************/
+
+/** Bus cost of one control transaction */
+typedef struct cy_whd_sim_latency
+{
+    uint32_t base_us;                           /**< Fixed round-trip cost of one transaction in microseconds  */
+    uint32_t per_byte_ns;                       /**< Additional cost per byte on the bus in nanoseconds        */
+} cy_whd_sim_latency_t;
+
+/** Per-IOVAR override of the default latency model */
+typedef struct cy_whd_sim_iovar_latency
+{
+    const char           *iovar;                /**< IOVAR name the override applies to                       */
+    cy_whd_sim_latency_t latency;               /**< Latency used instead of the default                       */
+} cy_whd_sim_iovar_latency_t;
+
+/** One recorded bus transaction */
+typedef struct cy_whd_sim_call
+{
+    const char   *api;                          /**< whd_* entry point that issued the transaction             */
+    char         iovar[CY_WHD_SIM_IOVAR_NAME_LEN]; /**< IOVAR (or ioctl) name                                 */
+    bool         set;                           /**< true for a SET, false for a GET                           */
+    uint32_t     tx_bytes;                      /**< Bytes sent to the dongle including framing                */
+    uint32_t     rx_bytes;                      /**< Bytes received from the dongle including framing          */
+    uint32_t     latency_us;                    /**< Simulated duration of the transaction                     */
+    uint64_t     timestamp_us;                  /**< Simulated clock when the transaction completed            */
+    whd_result_t result;                        /**< Result returned to the caller                             */
+} cy_whd_sim_call_t;
+
+/** Aggregate counters since the last \ref cy_whd_sim_reset_stats */
+typedef struct cy_whd_sim_stats
+{
+    uint32_t transactions;                      /**< Number of bus transactions                                */
+    uint32_t sets;                              /**< Number of SET transactions                                */
+    uint32_t gets;                              /**< Number of GET transactions                                */
+    uint32_t failures;                          /**< Transactions that returned an error                       */
+    uint64_t tx_bytes;                          /**< Bytes sent to the dongle                                  */
+    uint64_t rx_bytes;                          /**< Bytes received from the dongle                            */
+    uint64_t bus_time_us;                       /**< Accumulated simulated bus time                            */
+} cy_whd_sim_stats_t;
+
+/** Simulated packet filter */
+typedef struct cy_whd_sim_pkt_filter
+{
+    bool     in_use;                            /**< Slot holds a filter                                       */
+    bool     enabled;                           /**< Filter is enabled                                         */
+    uint32_t id;                                /**< Filter id                                                 */
+    uint32_t rule;                              /**< whd_packet_filter_rule_t                                  */
+    uint16_t offset;                            /**< Offset into the packet                                    */
+    uint16_t mask_size;                         /**< Length of mask and pattern                                */
+    uint8_t  mask[CY_WHD_SIM_MAX_FILTER_LEN];   /**< Mask bytes                                                */
+    uint8_t  pattern[CY_WHD_SIM_MAX_FILTER_LEN];/**< Pattern bytes                                             */
+} cy_whd_sim_pkt_filter_t;
+
+/** Simulated WOWL net pattern */
+typedef struct cy_whd_sim_wowl_pattern
+{
+    bool     in_use;                            /**< Slot holds a pattern                                      */
+    uint32_t offset;                            /**< Offset into the packet                                    */
+    uint8_t  mask_size;                         /**< Length of the bit mask in bytes                           */
+    uint8_t  pattern_size;                      /**< Length of the pattern in bytes                            */
+    uint8_t  type;                              /**< WOWL pattern type                                         */
+    uint8_t  mask[CY_WHD_SIM_MAX_WOWL_LEN / 8]; /**< One bit per pattern byte                                  */
+    uint8_t  pattern[CY_WHD_SIM_MAX_WOWL_LEN];  /**< Pattern bytes                                             */
+} cy_whd_sim_wowl_pattern_t;
+
+/** Simulated keepalive */
+typedef struct cy_whd_sim_keepalive
+{
+    bool     configured;                        /**< Keepalive has been programmed                             */
+    uint32_t period_msec;                       /**< Keepalive period                                          */
+    uint16_t len_bytes;                         /**< Payload length                                            */
+    uint8_t  data[CY_WHD_SIM_MAX_KEEPALIVE_LEN];/**< Payload                                                   */
+} cy_whd_sim_keepalive_t;
+
+/** Simulated TKO connection slot */
+typedef struct cy_whd_sim_tko_slot
+{
+    bool     in_use;                            /**< Slot has been programmed by a TKO CONNECT                 */
+    uint16_t len;                               /**< Length of the stored connect record                       */
+    uint8_t  data[WHD_PAYLOAD_MTU];             /**< wl_tko_connect_t as sent by the host                      */
+} cy_whd_sim_tko_slot_t;
+
+/** Plain uint32_t IOVAR held by the simulated firmware */
+typedef struct cy_whd_sim_iovar
+{
+    char     name[CY_WHD_SIM_IOVAR_NAME_LEN];   /**< IOVAR name                                                */
+    uint32_t value;                             /**< Last value written                                        */
+    bool     in_use;                            /**< Entry is valid                                            */
+} cy_whd_sim_iovar_t;
+
+/** Complete simulated firmware state */
+typedef struct cy_whd_sim_fw_state
+{
+    uint32_t                  fwcap;                                    /**< Value returned by whd_wifi_get_fwcap   */
+    uint16_t                  pm2_sleep_ret;                            /**< Return to sleep delay in ms            */
+    bool                      powersave;                                /**< PM2 enabled                            */
+    cy_whd_sim_iovar_t        iovars[CY_WHD_SIM_MAX_IOVARS];            /**< Generic IOVAR values                   */
+    cy_whd_sim_pkt_filter_t   filters[CY_WHD_SIM_MAX_PKT_FILTERS];      /**< Packet filters                         */
+    uint32_t                  hostip[ARP_MULTIHOMING_MAX];              /**< ARP host IP list, 0 = free             */
+    uint32_t                  arpoe;                                    /**< ARP offload enable                     */
+    uint32_t                  arp_features;                             /**< ARP offload feature flags              */
+    uint32_t                  arp_peerage;                              /**< ARP peer cache age                     */
+    uint8_t                   tko_max;                                  /**< Value returned by whd_tko_max_assoc    */
+    bool                      tko_enabled;                              /**< TKO toggled on                         */
+    whd_tko_retry_t           tko_param;                                /**< TKO retry parameters                   */
+    cy_whd_sim_tko_slot_t     tko[CY_WHD_SIM_MAX_TKO_SLOTS];            /**< TKO connection slots                   */
+    uint32_t                  wowl_cap;                                 /**< WOWL capability flags                  */
+    bool                      wowl_active;                              /**< WOWL activated                         */
+    cy_whd_sim_wowl_pattern_t wowl[CY_WHD_SIM_MAX_WOWL_PATTERNS];       /**< WOWL net patterns                      */
+    cy_whd_sim_keepalive_t    null_ka;                                  /**< NULL keepalive                         */
+    cy_whd_sim_keepalive_t    nat_ka;                                   /**< NAT keepalive                          */
+} cy_whd_sim_fw_state_t;
+
+/** Called after every recorded transaction */
+typedef void (*cy_whd_sim_call_cb_t)(const cy_whd_sim_call_t *call, void *arg);
+
+/*******************************************************************************
+* Simulator Functions
+*******************************************************************************/
+
+/** Reset the simulated firmware, the counters and the call log, and return the
+ *  simulated STA interface to hand to cy_olm_create() / cylpa_olm_init().
+ *
+ * @return Simulated interface
+ */
+whd_interface_t cy_whd_sim_init(void);
+
+/** Simulate a firmware reload: all firmware state is lost, counters and the
+ *  latency model are kept.
+ */
+void cy_whd_sim_reload_firmware(void);
+
+/** Set the latency model.
+ *
+ * @param[in] dflt      : Cost used for any IOVAR without an override
+ * @param[in] overrides : Per-IOVAR overrides, may be NULL
+ * @param[in] count     : Number of entries in overrides
+ */
+void cy_whd_sim_set_latency_model(const cy_whd_sim_latency_t *dflt,
+                                  const cy_whd_sim_iovar_latency_t *overrides, uint32_t count);
+
+/** Set the capability bits reported by whd_wifi_get_fwcap().
+ *
+ * @param[in] fwcap     : Capability bits, e.g. (1 << WHD_FWCAP_OFFLOADS) for the new offload infra
+ */
+void cy_whd_sim_set_fwcap(uint32_t fwcap);
+
+/** Accept batched IOVAR sets from the Offload Manager transaction
+ *  (cylpa_olm_txn_submit_batch()) as a single bus transaction. Disabled by
+ *  default, i.e. the firmware behaves like current releases.
+ *
+ * @param[in] enable    : true to model a firmware batch command
+ */
+void cy_whd_sim_set_batch_support(bool enable);
+
+/** Make every subsequent transaction on an IOVAR return the given result.
+ *
+ * @param[in] iovar     : IOVAR name
+ * @param[in] result    : Result to return, WHD_SUCCESS to clear the fault
+ */
+void cy_whd_sim_set_fault(const char *iovar, whd_result_t result);
+
+/** Get the counters since the last reset.
+ *
+ * @param[out] stats    : Counters
+ */
+void cy_whd_sim_get_stats(cy_whd_sim_stats_t *stats);
+
+/** Reset counters and the call log; firmware state is kept. */
+void cy_whd_sim_reset_stats(void);
+
+/** Copy the most recent calls, oldest first.
+ *
+ * @param[out] calls    : Destination array
+ * @param[in]  max      : Number of entries in calls
+ *
+ * @return Number of entries copied
+ */
+uint32_t cy_whd_sim_get_calls(cy_whd_sim_call_t *calls, uint32_t max);
+
+/** Install a callback invoked after every transaction.
+ *
+ * @param[in] cb        : Callback, NULL to remove
+ * @param[in] arg       : Passed back to the callback
+ */
+void cy_whd_sim_set_call_callback(cy_whd_sim_call_cb_t cb, void *arg);
+
+/** Get the simulated firmware state. The pointer stays valid until
+ *  cy_whd_sim_init() is called again.
+ *
+ * @return Firmware state
+ */
+const cy_whd_sim_fw_state_t *cy_whd_sim_get_fw_state(void);
+
+/** Get the simulated clock, which advances by the latency of every transaction.
+ *
+ * @return Simulated time in microseconds
+ */
+uint64_t cy_whd_sim_get_time_us(void);
+
+/** Deliver a firmware event to the handlers registered with
+ *  whd_management_set_event_handler().
+ *
+ * @param[in] event     : Event header
+ * @param[in] data      : Event payload, may be NULL
+ */
+void cy_whd_sim_inject_event(const whd_event_header_t *event, const uint8_t *data);
+
+/** Print the counters and a per-IOVAR breakdown of the call log. */
+void cy_whd_sim_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !CY_WHD_SIM_H__ */
@@ -0,0 +1,466 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+/**
+* @file cy_whd_sim_test.c
+* @brief Host checks of the packet filter compiler, the OLM transaction and the
+* sleep policy verifier, run against the simulated WHD backend.
+*
+* Like the simulator, not part of a target build. Build and run on the host:
+*
+*   gcc -DCY_WHD_SIM -I<whd>/inc -I<whd>/src/include -Iinclude -Isource \
+*       -Ihelpers/whd_sim helpers/whd_sim/cy_whd_sim_test.c helpers/whd_sim/cy_whd_sim.c \
+*       source/cy_lpa_wifi_olm_txn.c source/cy_lpa_wifi_olm_shadow.c \
+*       source/cy_lpa_wifi_pf_compile.c source/cy_lpa_wifi_pf_adapt.c source/cy_lpa_wifi_pf_policy.c \
+*       -lpthread
+*
+* The exit status is the number of failed checks.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "cy_whd_sim.h"
+#include "cyabs_rtos.h"
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_ol_common.h"
+#include "cy_lpa_wifi_ol_priv.h"
+#include "cy_lpa_wifi_pf_ol.h"
+
+#define CY_WHD_SIM_TEST_CHECK(cond)     cy_whd_sim_test_check( (cond), #cond, __func__, __LINE__ )
+#define CY_WHD_SIM_TEST_MAX_CALLS       (16)
+#define CY_WHD_SIM_TEST_MAX_CBS         (8)
+
+typedef struct cy_whd_sim_test_cb
+{
+    uint32_t tag;
+    uint32_t result;
+} cy_whd_sim_test_cb_t;
+
+static uint32_t cy_whd_sim_test_failures;
+static cy_whd_sim_test_cb_t cy_whd_sim_test_cbs[CY_WHD_SIM_TEST_MAX_CBS];
+static uint32_t cy_whd_sim_test_cb_count;
+static uint32_t cy_whd_sim_test_call_runs;
+
+/* Single threaded; the shadow is used without cylpa_olm_shadow_init() and never takes its mutex */
+cy_rslt_t cy_rtos_init_mutex(cy_mutex_t *mutex)
+{
+    (void)mutex;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_get_mutex(cy_mutex_t *mutex, cy_time_t timeout_ms)
+{
+    (void)mutex;
+    (void)timeout_ms;
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_rtos_set_mutex(cy_mutex_t *mutex)
+{
+    (void)mutex;
+    return CY_RSLT_SUCCESS;
+}
+
+static void cy_whd_sim_test_check(bool ok, const char *cond, const char *func, int line)
+{
+    if (!ok)
+    {
+        printf("FAIL %s:%d: %s\n", func, line, cond);
+        cy_whd_sim_test_failures++;
+    }
+}
+
+static void cy_whd_sim_test_cb(void *arg, uint32_t result)
+{
+    if (cy_whd_sim_test_cb_count < CY_WHD_SIM_TEST_MAX_CBS)
+    {
+        cy_whd_sim_test_cbs[cy_whd_sim_test_cb_count].tag = (uint32_t)(uintptr_t)arg;
+        cy_whd_sim_test_cbs[cy_whd_sim_test_cb_count].result = result;
+    }
+    cy_whd_sim_test_cb_count++;
+}
+
+static uint32_t cy_whd_sim_test_call(void *whd, void *arg, uint32_t param)
+{
+    (void)whd;
+    (void)arg;
+    (void)param;
+    cy_whd_sim_test_call_runs++;
+    return WHD_SUCCESS;
+}
+
+static void cy_whd_sim_test_port(cy_pf_ol_cfg_t *cfg, uint8_t id, uint32_t bits, cy_pf_proto_t proto,
+                                 uint16_t port, uint16_t range)
+{
+    memset(cfg, 0, sizeof(*cfg) );
+    cfg->feature = CY_PF_OL_FEAT_PORTNUM;
+    cfg->id = id;
+    cfg->bits = bits;
+    cfg->u.pf.proto = proto;
+    cfg->u.pf.portnum.portnum = port;
+    cfg->u.pf.portnum.range = range;
+    cfg->u.pf.portnum.direction = PF_PN_PORT_DEST;
+}
+
+static uint8_t cy_whd_sim_test_lookup(const cy_pf_ol_program_t *prog, uint8_t cfg_id)
+{
+    uint8_t filter_id = 0xff;
+
+    return (cylpa_pf_ol_lookup(prog, cfg_id, &filter_id, 1) == 1) ? filter_id : 0xff;
+}
+
+static const cy_pf_ol_map_t *cy_whd_sim_test_map(const cy_pf_ol_program_t *prog, uint8_t cfg_id)
+{
+    uint32_t i;
+
+    for (i = 0; i < prog->map_count; i++)
+    {
+        if (prog->map[i].cfg_id == cfg_id)
+        {
+            return &prog->map[i];
+        }
+    }
+    return NULL;
+}
+
+/* Add the filters of a program to the simulated firmware, as the offload does */
+static uint32_t cy_whd_sim_test_program(whd_interface_t whd, cy_pf_ol_program_t *prog)
+{
+    whd_packet_filter_t filter;
+    uint32_t failed = 0;
+    uint32_t i;
+
+    for (i = 0; i < prog->count; i++)
+    {
+        filter.id = prog->filters[i].id;
+        filter.offset = prog->filters[i].offset;
+        filter.mask_size = prog->filters[i].len;
+        filter.mask = prog->filters[i].mask;
+        filter.pattern = prog->filters[i].pattern;
+        filter.rule = (prog->filters[i].bits & CY_PF_ACTION_DISCARD) ? WHD_PACKET_FILTER_RULE_NEGATIVE_MATCHING :
+                      WHD_PACKET_FILTER_RULE_POSITIVE_MATCHING;
+        if (whd_pf_add_packet_filter(whd, &filter) != WHD_SUCCESS)
+        {
+            failed++;
+        }
+    }
+    return failed;
+}
+
+/* Duplicates, shadowed and merged entries are dropped, each mapped to the filter that implements it */
+static void cy_whd_sim_test_compile(whd_interface_t whd)
+{
+    static cy_pf_ol_program_t prog;
+    const cy_whd_sim_fw_state_t *fw;
+    cy_pf_ol_cfg_t cfg[8];
+    uint32_t in_use = 0;
+    uint32_t i, j;
+
+    memset(cfg, 0, sizeof(cfg) );
+    cfg[0].feature = CY_PF_OL_FEAT_ETHTYPE;
+    cfg[0].id = 1;
+    cfg[0].bits = CY_PF_ACTIVE_WAKE;
+    cfg[0].u.eth.eth_type = 0x0806;
+    cfg[1] = cfg[0];
+    cfg[1].id = 2;
+    cy_whd_sim_test_port(&cfg[2], 3, CY_PF_ACTIVE_WAKE, CY_PF_PROTOCOL_TCP, 80, 0);
+    cy_whd_sim_test_port(&cfg[3], 4, CY_PF_ACTIVE_WAKE, CY_PF_PROTOCOL_TCP, 81, 0);
+    cfg[4].feature = CY_PF_OL_FEAT_IPTYPE;
+    cfg[4].id = 5;
+    cfg[4].bits = CY_PF_ACTIVE_WAKE;
+    cfg[4].u.ip.ip_type = 17;
+    cy_whd_sim_test_port(&cfg[5], 6, CY_PF_ACTIVE_WAKE, CY_PF_PROTOCOL_UDP, 5353, 0);
+    cy_whd_sim_test_port(&cfg[6], 7, 0, CY_PF_PROTOCOL_UDP, 1900, 0);
+    cfg[7].feature = CY_PF_OL_FEAT_LAST;
+
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_compile(cfg, &prog) == RESULT_OK);
+    CY_WHD_SIM_TEST_CHECK(prog.count == 3);
+    CY_WHD_SIM_TEST_CHECK( (prog.duplicates == 1) && (prog.shadowed == 1) && (prog.merged == 1) );
+    CY_WHD_SIM_TEST_CHECK( (prog.split == 0) && !prog.overflow );
+
+    CY_WHD_SIM_TEST_CHECK(cy_whd_sim_test_map(&prog, 2)->kind == CY_PF_OL_MAP_DUPLICATE);
+    CY_WHD_SIM_TEST_CHECK(cy_whd_sim_test_lookup(&prog, 2) == 1);
+    CY_WHD_SIM_TEST_CHECK(cy_whd_sim_test_map(&prog, 4)->kind == CY_PF_OL_MAP_MERGED);
+    CY_WHD_SIM_TEST_CHECK(cy_whd_sim_test_lookup(&prog, 4) == 3);
+    CY_WHD_SIM_TEST_CHECK(cy_whd_sim_test_map(&prog, 6)->kind == CY_PF_OL_MAP_SHADOWED);
+    CY_WHD_SIM_TEST_CHECK(cy_whd_sim_test_lookup(&prog, 6) == 5);
+    CY_WHD_SIM_TEST_CHECK(cy_whd_sim_test_map(&prog, 7)->kind == CY_PF_OL_MAP_INACTIVE);
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_lookup(&prog, 7, NULL, 0) == 0);
+
+    /* Surviving filters keep the ids of their first entries, and the firmware takes them all */
+    for (i = 0; i < prog.count; i++)
+    {
+        for (j = i + 1; j < prog.count; j++)
+        {
+            CY_WHD_SIM_TEST_CHECK(prog.filters[i].id != prog.filters[j].id);
+        }
+        CY_WHD_SIM_TEST_CHECK( (prog.filters[i].id == 1) || (prog.filters[i].id == 3) || (prog.filters[i].id == 5) );
+    }
+    CY_WHD_SIM_TEST_CHECK(cy_whd_sim_test_program(whd, &prog) == 0);
+    fw = cy_whd_sim_get_fw_state();
+    for (i = 0; i < CY_WHD_SIM_MAX_PKT_FILTERS; i++)
+    {
+        in_use += fw->filters[i].in_use ? 1 : 0;
+    }
+    CY_WHD_SIM_TEST_CHECK(in_use == prog.count);
+}
+
+/* A port range takes one filter per power-of-two aligned block of its cover */
+static void cy_whd_sim_test_cover(void)
+{
+    static cy_pf_ol_program_t prog;
+    cy_pf_ol_cfg_t cfg[2];
+    uint8_t ids[CY_PF_OL_MAX_FILTERS];
+    uint32_t i;
+
+    memset(cfg, 0, sizeof(cfg) );
+    cfg[1].feature = CY_PF_OL_FEAT_LAST;
+
+    /* 16384-17407 and 49152-65535 are single blocks */
+    cy_whd_sim_test_port(&cfg[0], 1, CY_PF_ACTIVE_SLEEP, CY_PF_PROTOCOL_UDP, 16384, 1023);
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_compile(cfg, &prog) == RESULT_OK);
+    CY_WHD_SIM_TEST_CHECK( (prog.count == 1) && (prog.split == 0) );
+    cy_whd_sim_test_port(&cfg[0], 1, CY_PF_ACTIVE_SLEEP, CY_PF_PROTOCOL_UDP, 49152, 16383);
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_compile(cfg, &prog) == RESULT_OK);
+    CY_WHD_SIM_TEST_CHECK( (prog.count == 1) && (prog.split == 0) );
+
+    /* 32768-60999 is 32768 + 16384, 49152 + 8192, 57344 + 2048, 59392 + 1024, 60416 + 512, 60928 + 64, 60992 + 8 */
+    cy_whd_sim_test_port(&cfg[0], 1, CY_PF_ACTIVE_SLEEP, CY_PF_PROTOCOL_UDP, 32768, 28231);
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_compile(cfg, &prog) == RESULT_OK);
+    CY_WHD_SIM_TEST_CHECK( (prog.count == 7) && (prog.split == 6) );
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_lookup(&prog, 1, ids, CY_PF_OL_MAX_FILTERS) == 7);
+    CY_WHD_SIM_TEST_CHECK(ids[0] == 1);
+    for (i = 1; i < 7; i++)
+    {
+        CY_WHD_SIM_TEST_CHECK( (ids[i] != 1) && (ids[i] != ids[i - 1]) );
+    }
+
+    /* Every pair of source and destination blocks: 49 filters do not fit, the entry is left out whole */
+    cfg[0].u.pf.portnum.direction = PF_PN_PORT_SOURCE_DEST;
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_compile(cfg, &prog) == RESULT_ERROR);
+    CY_WHD_SIM_TEST_CHECK(prog.overflow && (prog.count == 0) );
+}
+
+/* A pattern longer than 32 bytes takes one filter, up to CY_PF_OL_MAX_PATTERN_LEN */
+static void cy_whd_sim_test_pattern(void)
+{
+    static cy_pf_ol_program_t prog;
+    uint8_t pattern[UINT8_MAX];
+    cy_pf_ol_cfg_t cfg[2];
+    uint32_t i;
+
+    for (i = 0; i < sizeof(pattern); i++)
+    {
+        pattern[i] = (uint8_t)(i + 1);
+    }
+    memset(cfg, 0, sizeof(cfg) );
+    cfg[0].feature = CY_PF_OL_FEAT_PATTERN;
+    cfg[0].id = 1;
+    cfg[0].bits = CY_PF_ACTIVE_SLEEP;
+    cfg[0].u.pat.offset = 42;
+    cfg[0].u.pat.len = 40;
+    cfg[0].u.pat.pattern = pattern;
+    cfg[1].feature = CY_PF_OL_FEAT_LAST;
+
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_compile(cfg, &prog) == RESULT_OK);
+    CY_WHD_SIM_TEST_CHECK( (prog.count == 1) && (prog.filters[0].len == 40) && (prog.filters[0].offset == 42) );
+    CY_WHD_SIM_TEST_CHECK(memcmp(prog.filters[0].pattern, pattern, 40) == 0);
+
+    cfg[0].u.pat.len = CY_PF_OL_MAX_PATTERN_LEN;
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_compile(cfg, &prog) == RESULT_OK);
+    CY_WHD_SIM_TEST_CHECK( (prog.count == 1) && (prog.filters[0].len == CY_PF_OL_MAX_PATTERN_LEN) );
+
+    cfg[0].u.pat.len = CY_PF_OL_MAX_PATTERN_LEN + 1;
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_compile(cfg, &prog) == RESULT_ERROR);
+    CY_WHD_SIM_TEST_CHECK(prog.count == 0);
+}
+
+/* Superseded entries are dropped within a run, CALLs run in order, every callback gets its result */
+static void cy_whd_sim_test_txn(whd_interface_t whd)
+{
+    static olm_txn_t txn;
+    cy_whd_sim_call_t calls[CY_WHD_SIM_TEST_MAX_CALLS];
+    const cy_whd_sim_fw_state_t *fw = cy_whd_sim_get_fw_state();
+    uint32_t count;
+    uint32_t i;
+
+    cylpa_olm_shadow_invalidate();
+    cy_whd_sim_reset_stats();
+    cy_whd_sim_test_cb_count = 0;
+    cy_whd_sim_test_call_runs = 0;
+
+    cylpa_olm_txn_begin(&txn, whd);
+    cylpa_olm_txn_set_iovar_value(&txn, whd, "bcn_li_dtim", 1, cy_whd_sim_test_cb, (void *)1);
+    cylpa_olm_txn_set_iovar_value(&txn, whd, "bcn_li_dtim", 3, cy_whd_sim_test_cb, (void *)2);
+    cylpa_olm_txn_pf_enable(&txn, whd, 1, true, cy_whd_sim_test_cb, (void *)3);
+    cylpa_olm_txn_call(&txn, whd, cy_whd_sim_test_call, NULL, 0, cy_whd_sim_test_cb, (void *)4);
+    cylpa_olm_txn_pf_enable(&txn, whd, 3, false, cy_whd_sim_test_cb, (void *)5);
+    cylpa_olm_txn_pf_enable(&txn, whd, 3, true, cy_whd_sim_test_cb, (void *)6);
+    CY_WHD_SIM_TEST_CHECK(cy_whd_sim_get_calls(calls, CY_WHD_SIM_TEST_MAX_CALLS) == 0);
+    cylpa_olm_txn_flush(&txn);
+
+    count = cy_whd_sim_get_calls(calls, CY_WHD_SIM_TEST_MAX_CALLS);
+    CY_WHD_SIM_TEST_CHECK(count == 3);
+    CY_WHD_SIM_TEST_CHECK( (count > 0) && (strcmp(calls[0].iovar, "bcn_li_dtim") == 0) );
+    CY_WHD_SIM_TEST_CHECK( (count > 2) && (strcmp(calls[1].iovar, "pkt_filter_enable") == 0) &&
+                           (strcmp(calls[2].iovar, "pkt_filter_enable") == 0) );
+    CY_WHD_SIM_TEST_CHECK(cy_whd_sim_test_call_runs == 1);
+    CY_WHD_SIM_TEST_CHECK(txn.dropped == 2);
+    for (i = 0; i < CY_WHD_SIM_MAX_IOVARS; i++)
+    {
+        if (fw->iovars[i].in_use && (strcmp(fw->iovars[i].name, "bcn_li_dtim") == 0) )
+        {
+            CY_WHD_SIM_TEST_CHECK(fw->iovars[i].value == 3);
+        }
+    }
+    for (i = 0; i < CY_WHD_SIM_MAX_PKT_FILTERS; i++)
+    {
+        if (fw->filters[i].in_use && ( (fw->filters[i].id == 1) || (fw->filters[i].id == 3) ) )
+        {
+            CY_WHD_SIM_TEST_CHECK(fw->filters[i].enabled);
+        }
+    }
+
+    /* Superseded entries share the result of the entry that replaced them, in queue order */
+    CY_WHD_SIM_TEST_CHECK(cy_whd_sim_test_cb_count == 6);
+    for (i = 0; (i < cy_whd_sim_test_cb_count) && (i < CY_WHD_SIM_TEST_MAX_CBS); i++)
+    {
+        CY_WHD_SIM_TEST_CHECK(cy_whd_sim_test_cbs[i].tag == i + 1);
+        CY_WHD_SIM_TEST_CHECK(cy_whd_sim_test_cbs[i].result == WHD_SUCCESS);
+    }
+
+    /* Values the firmware holds are not sent again */
+    cy_whd_sim_reset_stats();
+    cylpa_olm_txn_begin(&txn, whd);
+    cylpa_olm_txn_set_iovar_value(&txn, whd, "bcn_li_dtim", 3, NULL, NULL);
+    cylpa_olm_txn_pf_enable(&txn, whd, 1, true, NULL, NULL);
+    cylpa_olm_txn_flush(&txn);
+    CY_WHD_SIM_TEST_CHECK(cy_whd_sim_get_calls(calls, CY_WHD_SIM_TEST_MAX_CALLS) == 0);
+
+    /* A failed entry reports its own result */
+    cy_whd_sim_test_cb_count = 0;
+    cy_whd_sim_set_fault("mpc", WHD_BADARG);
+    cylpa_olm_txn_begin(&txn, whd);
+    cylpa_olm_txn_set_iovar_value(&txn, whd, "mpc", 0, cy_whd_sim_test_cb, (void *)1);
+    cylpa_olm_txn_set_iovar_value(&txn, whd, "bcn_li_dtim", 1, cy_whd_sim_test_cb, (void *)2);
+    cylpa_olm_txn_flush(&txn);
+    cy_whd_sim_set_fault("mpc", WHD_SUCCESS);
+    CY_WHD_SIM_TEST_CHECK( (cy_whd_sim_test_cb_count == 2) && (cy_whd_sim_test_cbs[0].result == WHD_BADARG) &&
+                           (cy_whd_sim_test_cbs[1].result == WHD_SUCCESS) );
+
+    /* With a firmware batch command, a run is one bus transaction */
+    cy_whd_sim_set_batch_support(true);
+    cy_whd_sim_reset_stats();
+    cylpa_olm_txn_begin(&txn, whd);
+    cylpa_olm_txn_set_iovar_value(&txn, whd, "bcn_li_dtim", 2, NULL, NULL);
+    cylpa_olm_txn_pf_enable(&txn, whd, 1, false, NULL, NULL);
+    cylpa_olm_txn_pf_enable(&txn, whd, 3, false, NULL, NULL);
+    cylpa_olm_txn_flush(&txn);
+    cy_whd_sim_set_batch_support(false);
+    count = cy_whd_sim_get_calls(calls, CY_WHD_SIM_TEST_MAX_CALLS);
+    CY_WHD_SIM_TEST_CHECK( (count == 1) && (strcmp(calls[0].iovar, "batch") == 0) );
+    for (i = 0; i < CY_WHD_SIM_MAX_PKT_FILTERS; i++)
+    {
+        if (fw->filters[i].in_use && ( (fw->filters[i].id == 1) || (fw->filters[i].id == 3) ) )
+        {
+            CY_WHD_SIM_TEST_CHECK(!fw->filters[i].enabled);
+        }
+    }
+}
+
+/* The verifier accepts the filters of a policy alone and flags those that disagree with it */
+static void cy_whd_sim_test_policy(void)
+{
+    static cy_pf_ol_program_t policy;
+    static cy_pf_ol_program_t extra;
+    static const cy_pf_ol_flow_t flows[] =
+    {
+        { 0x0806, 0,  0,    0 },
+        { 0,      17, 5683, 0 },
+        { 0x0800, 6,  8000, 8100 },
+    };
+    cy_pf_ol_cfg_t cfg[sizeof(flows) / sizeof(flows[0]) + 1];
+    cylpa_pf_policy_view_t view;
+    cy_pf_ol_policy_report_t report;
+
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_policy_build(flows, sizeof(flows) / sizeof(flows[0]), cfg) == RESULT_OK);
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_compile(cfg, &policy) == RESULT_OK);
+
+    memset(&view, 0, sizeof(view) );
+    view.filters[0] = policy.filters;
+    view.counts[0] = policy.count;
+    view.sets = 1;
+    memset(&report, 0, sizeof(report) );
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_policy_verify(flows, sizeof(flows) / sizeof(flows[0]), &view, &report) ==
+                          RESULT_OK);
+    CY_WHD_SIM_TEST_CHECK( (report.probes > 0) && (report.mismatches == 0) );
+
+    /* A sleep keep filter for TCP 80 lets through what the policy does not allow */
+    memset(cfg, 0, sizeof(cfg) );
+    cy_whd_sim_test_port(&cfg[0], 40, CY_PF_ACTIVE_SLEEP, CY_PF_PROTOCOL_TCP, 80, 0);
+    cfg[1].feature = CY_PF_OL_FEAT_LAST;
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_compile(cfg, &extra) == RESULT_OK);
+    view.filters[1] = extra.filters;
+    view.counts[1] = extra.count;
+    view.sets = 2;
+    memset(&report, 0, sizeof(report) );
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_policy_verify(flows, sizeof(flows) / sizeof(flows[0]), &view, &report) ==
+                          RESULT_ERROR);
+    CY_WHD_SIM_TEST_CHECK( (report.count > 0) && !report.errors[0].allowed && (report.errors[0].filter_id == 40) );
+
+    /* A sleep discard filter for UDP 5683 drops an allowed flow */
+    cy_whd_sim_test_port(&cfg[0], 41, CY_PF_ACTIVE_SLEEP | CY_PF_ACTION_DISCARD, CY_PF_PROTOCOL_UDP, 5683, 0);
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_ol_compile(cfg, &extra) == RESULT_OK);
+    view.counts[1] = extra.count;
+    memset(&report, 0, sizeof(report) );
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_policy_verify(flows, sizeof(flows) / sizeof(flows[0]), &view, &report) ==
+                          RESULT_ERROR);
+    CY_WHD_SIM_TEST_CHECK( (report.count > 0) && report.errors[0].allowed && (report.errors[0].filter_id == 41) );
+
+    /* Filters active only awake are not held asleep */
+    extra.filters[0].bits = CY_PF_ACTIVE_WAKE | CY_PF_ACTION_DISCARD;
+    memset(&report, 0, sizeof(report) );
+    CY_WHD_SIM_TEST_CHECK(cylpa_pf_policy_verify(flows, sizeof(flows) / sizeof(flows[0]), &view, &report) ==
+                          RESULT_OK);
+}
+
+int main(void)
+{
+    whd_interface_t whd = cy_whd_sim_init();
+
+    cy_whd_sim_test_compile(whd);
+    cy_whd_sim_test_cover();
+    cy_whd_sim_test_pattern();
+    cy_whd_sim_test_txn(whd);
+    cy_whd_sim_test_policy();
+
+    printf("%s: %u failed\n", (cy_whd_sim_test_failures == 0) ? "PASS" : "FAIL", cy_whd_sim_test_failures);
+    return (int)cy_whd_sim_test_failures;
+}
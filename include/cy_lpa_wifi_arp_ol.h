@@ -37,6 +37,8 @@
 #define ARP_OL_H__  (1)
 
 #include "cy_lpa_wifi_ol_common.h"
+#include "cy_nw_lpa_helper.h"
+#include "cy_lpa_wifi_olm.h"   /* for olm_exec_item_t */
 #include "whd.h"
 #include "whd_wlioctl.h"
 
@@ -116,6 +118,9 @@ typedef struct arp_ol_s
     ol_info_t               *ol_info_ptr;       /**< Offload Manager Info structure  \ref ol_info_t */
     uint32_t ip_address;                        /**< IP Address for this interface */
     arp_ol_config_state_t state;                /**< Currently written state in Device \ref arp_ol_config_state_t */
+    cylpa_nw_ip_status_change_callback_t ip_change_cb; /**< IP change callback registered with the network stack */
+    olm_exec_item_t ip_change_work;             /**< Checks the IP address; delayed to give DHCP time after a link up */
+    int dhcp_retry_count;                       /**< Remaining checks for an IP address from DHCP */
 } arp_ol_t;
 
 /** \} */
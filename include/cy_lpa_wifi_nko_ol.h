@@ -38,6 +38,7 @@
 #include <stdint.h>
 #include "cy_lpa_compat.h"
 #include "cy_lpa_wifi_ol_common.h"
+#include "cy_nw_lpa_helper.h"
 #include "whd.h"
 #include "whd_wlioctl.h"
 
@@ -72,6 +73,7 @@ typedef struct nko_ol
     cy_lpa_nko_ol_cfg_t  *cfg;                          /**< Pointer to config space                        */
     void                 *whd;                          /**< Pointer to system handle                       */
     ol_info_t            *ol_info_ptr;                  /**< Offload Manager Info structure  \ref ol_info_t */
+    cylpa_nw_ip_status_change_callback_t ip_change_cb;  /**< IP change callback registered with the network stack */
 } nko_ol_t;
 
 
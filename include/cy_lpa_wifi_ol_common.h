@@ -2858,17 +2858,17 @@
  *   <tr><td>Packet Filter Configuration \<N\></td>
  *       <td>Port Number</td>
  *       <td>Either the single port to be filtered or the beginning of
- *           the block of contiguous numbers. When using a block, the
- *           starting port must be a power of 2.</td>
+ *           the block of contiguous numbers.</td>
  *       <td>
  *             * 1024 for Packet filter (default)
  *             * 0-65535</td></tr>
  *   <tr><td>Packet Filter Configuration \<N\></td>
  *       <td>Range</td>
- *       <td>Indicates the size of the block of port numbers, must be of
- *           the form (2^y - 1) and less than Port Number
- *           (Filter Type = Port Filter Block).
- *           0 indicates just a single port.</td>
+ *       <td>Indicates the size of the block of port numbers
+ *           (Filter Type = Port Filter Block): Port Number thru
+ *           Port Number + Range. 0 indicates just a single port.
+ *           A block takes one firmware filter per power-of-2 aligned
+ *           sub-block, e.g. 1024 thru 2047 takes one, 1000 thru 2000 eight.</td>
  *       <td>
  *             * 1023 (default)
  *             * 0-65535</td></tr>
@@ -3241,6 +3241,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -3257,6 +3258,43 @@ typedef void whd_t;
 /** \addtogroup group_lpa_structures *//** \{ */
 /******************************************************************************/
 
+struct olm_txn;
+
+/** Firmware capability bits of \ref ol_caps_t::features */
+#define OL_CAP_OFFLOADS         (1UL << 0)  /**< Offload infrastructure in firmware (WHD_FWCAP_OFFLOADS) */
+#define OL_CAP_ARP              (1UL << 1)  /**< ARP offload */
+#define OL_CAP_TKO              (1UL << 2)  /**< TCP keepalive offload */
+#define OL_CAP_WOWL             (1UL << 3)  /**< Wake on wireless LAN */
+#define OL_CAP_PF               (1UL << 4)  /**< Packet filters */
+
+/** Firmware resources whose size is learned by \ref ol_caps_t */
+typedef enum ol_caps_slot
+{
+    OL_CAPS_SLOT_PF = 0,                /**< Packet filters */
+    OL_CAPS_SLOT_WOWL_PATTERN,          /**< WOWL net patterns */
+    OL_CAPS_SLOT_MAX                    /**< Number of resources */
+} ol_caps_slot_t;
+
+/** Slot count not known yet */
+#define OL_CAPS_SLOTS_UNKNOWN   (0xFF)
+
+/** Firmware capabilities
+ *
+ * Probed once per firmware load by the Offload Manager, so offloads can skip what
+ * the firmware does not support without issuing an IOVAR. The firmware reports no
+ * packet filter or WOWL pattern limit; each is learned the first time the firmware
+ * runs out, and further adds are refused until a slot is released. */
+typedef struct ol_caps
+{
+    bool     valid;                             /**< Probed on ol_info_t::whd */
+    uint32_t fwcap;                             /**< whd_wifi_get_fwcap() bits */
+    uint32_t features;                          /**< OL_CAP_* supported by the firmware */
+    uint32_t wowl;                              /**< WOWL wake flags (WL_WOWL_*) held by the firmware */
+    uint8_t  tko_max_assoc;                     /**< TCP keepalive connections, 0 if unknown */
+    uint8_t  slots_max[OL_CAPS_SLOT_MAX];       /**< Slots of each resource, OL_CAPS_SLOTS_UNKNOWN until learned */
+    uint8_t  slots_used[OL_CAPS_SLOT_MAX];      /**< Slots of each resource in use */
+} ol_caps_t;
+
 /** Offload information
  *
  * Context pointers that an offload may use to accomplish its function. */
@@ -3264,8 +3302,10 @@ typedef struct ol_info
 {
     whd_t   *whd;            /**< Wireless Host Driver pointer. */
     void    *ip;             /**< IP network stack pointer. */
-    void    *worker;         /**< Worker Thread info pointer */
+    void    *worker;         /**< OLM deferred-work executor, NULL if none */
     uint32_t fw_new_infra;   /**< new infra supported */
+    struct olm_txn *txn;     /**< IOVAR transaction open during a power-mode transition, NULL otherwise */
+    ol_caps_t caps;          /**< Firmware capabilities */
 } ol_info_t;
 
 /** \} */
@@ -66,6 +66,83 @@ extern "C" {
  */
 #define LPA_PM2_SLEEP_RET_TIME  10
 
+/* Maximum number of IOVAR operations queued during one power-mode transition.
+ * Operations queued beyond this are issued immediately.
+ */
+#ifndef OLM_TXN_MAX_ENTRIES
+#define OLM_TXN_MAX_ENTRIES     (32)
+#endif
+
+/* Bytes available for IOVAR buffer payloads queued during one transition */
+#ifndef OLM_TXN_BUF_SIZE
+#define OLM_TXN_BUF_SIZE        (256)
+#endif
+
+/* Number of IOVAR values remembered by the firmware state shadow */
+#ifndef OLM_SHADOW_MAX_ENTRIES
+#define OLM_SHADOW_MAX_ENTRIES  (32)
+#endif
+
+/* Largest IOVAR value held by the firmware state shadow, in bytes */
+#ifndef OLM_SHADOW_DATA_SIZE
+#define OLM_SHADOW_DATA_SIZE    (8)
+#endif
+
+/* Maximum number of offloads registered with one Offload Manager, from the list
+ * given to cylpa_olm_init() and cylpa_olm_register(); at most 254.
+ */
+#ifndef OLM_MAX_OFFLOADS
+#define OLM_MAX_OFFLOADS        (16)
+#endif
+
+/* Maximum number of Offload Managers running at once, one per WHD interface
+ * (e.g. STA and softAP). They share the OLM deferred-work executor.
+ */
+#ifndef OLM_MAX_INSTANCES
+#define OLM_MAX_INSTANCES       (2)
+#endif
+
+/* Set to 1 to run the OLM deferred work from a thread of its own, with a stack
+ * of OLM_EXEC_STACK_SIZE. By default the work that is due is run by the thread
+ * dispatching the power-mode notifications, after each dispatch, by any
+ * application thread that calls cylpa_olm_exec_run(), and otherwise by one RTOS
+ * timer, on the RTOS timer service, when the first delayed item is due. Set it
+ * if that service cannot block or has no stack to spare for the offload work,
+ * and to have independent offloads initialized concurrently.
+ */
+#ifndef OLM_EXEC_THREAD
+#define OLM_EXEC_THREAD         (0)
+#endif
+
+/* Stack of the OLM executor thread; >4k needed for printf() calls in deferred work */
+#ifndef OLM_EXEC_STACK_SIZE
+#define OLM_EXEC_STACK_SIZE     (6 * 1024)
+#endif
+
+/* Maximum number of non-critical operations deferred to the first sleep transition */
+#ifndef OLM_MAX_DEFERRED
+#define OLM_MAX_DEFERRED        (8)
+#endif
+
+/* Set to 0 to apply the WLAN low power configuration (cylpa_olm_init_wlan_config())
+ * at initialization instead of at the first sleep transition.
+ */
+#ifndef OLM_DEFER_WLAN_CONFIG
+#define OLM_DEFER_WLAN_CONFIG   (1)
+#endif
+
+/* Set to 0 to compile out the per-offload init and power-mode transition latency histograms */
+#ifndef OLM_LATENCY_STATS
+#define OLM_LATENCY_STATS       (1)
+#endif
+
+/* Number of log2 histogram buckets; bucket b counts latencies of [2^(b-1), 2^b) us,
+ * the last bucket everything above.
+ */
+#ifndef OLM_LATENCY_BUCKETS
+#define OLM_LATENCY_BUCKETS     (16)
+#endif
+
 /*******************************************************************************
 * LPA Data Structures
 *******************************************************************************/
@@ -76,6 +153,214 @@ extern "C" {
 
 /** Offload Manager API (integrated into the platform/system). */
 struct ol_desc;
+struct ol_fns;
+
+/** Kind of operation queued in an OLM transaction */
+typedef enum olm_txn_op
+{
+    OLM_TXN_OP_SET_VALUE = 0,   /**< uint32_t IOVAR set, batchable */
+    OLM_TXN_OP_SET_BUFFER,      /**< IOVAR set with a byte buffer, batchable */
+    OLM_TXN_OP_PF_ENABLE,       /**< Packet filter enable / disable, batchable */
+    OLM_TXN_OP_CALL,            /**< Arbitrary WHD sequence; run in order, never batched */
+} olm_txn_op_t;
+
+/** Completion callback of a queued operation; result is a whd_result_t */
+typedef void (olm_txn_cb_t)(void *arg, uint32_t result);
+
+/** Function run by an \ref OLM_TXN_OP_CALL operation; returns a whd_result_t */
+typedef uint32_t (olm_txn_fn_t)(void *whd, void *arg, uint32_t param);
+
+/** One queued operation.
+ * Private structure; visible to allow for static definition. */
+typedef struct olm_txn_entry
+{
+    const char   *iovar;                /**< IOVAR name (SET_VALUE, SET_BUFFER) */
+    olm_txn_cb_t *cb;                   /**< Completion callback, may be NULL */
+    void         *cb_arg;               /**< Argument passed to cb */
+    union
+    {
+        uint32_t value;                 /**< SET_VALUE: value to write */
+        struct
+        {
+            uint16_t offset;            /**< Offset of the payload in the transaction buffer */
+            uint16_t len;               /**< Payload length */
+        } buf;                          /**< SET_BUFFER payload */
+        struct
+        {
+            uint8_t id;                 /**< Filter id */
+            uint8_t enable;             /**< 1 to enable, 0 to disable */
+        } pf;                           /**< PF_ENABLE arguments */
+        struct
+        {
+            olm_txn_fn_t *fn;           /**< Function to run */
+            void         *arg;          /**< First argument */
+            uint32_t     param;         /**< Second argument */
+        } call;                         /**< CALL arguments */
+    } u;                                /**< Operation arguments */
+    uint32_t     result;                /**< whd_result_t once flushed */
+    uint8_t      op;                    /**< \ref olm_txn_op_t */
+    uint8_t      superseded;            /**< A later entry writes the same state */
+    uint8_t      done;                  /**< Result is valid */
+} olm_txn_entry_t;
+
+/** One IOVAR of a batch handed to cylpa_olm_txn_submit_batch() */
+typedef struct olm_txn_iovar
+{
+    const char *name;                   /**< IOVAR name */
+    const void *data;                   /**< Payload, little endian as sent to the dongle */
+    uint16_t   len;                     /**< Payload length */
+} olm_txn_iovar_t;
+
+/** Payload of a batched operation, as sent to the dongle */
+typedef union olm_txn_payload
+{
+    uint32_t value;                     /**< SET_VALUE value */
+    struct
+    {
+        uint32_t id;                    /**< Filter id */
+        uint32_t enable;                /**< 1 to enable, 0 to disable */
+    } pf;                               /**< pkt_filter_enable payload */
+} olm_txn_payload_t;
+
+/** IOVAR operations collected during one power-mode transition.
+ * Private structure; visible to allow for static definition. */
+typedef struct olm_txn
+{
+    void            *whd;                           /**< Interface the operations are issued on */
+    uint32_t        count;                          /**< Number of queued entries */
+    uint32_t        buf_used;                       /**< Bytes used in buf */
+    uint32_t        queued;                         /**< Operations queued since init */
+    uint32_t        dropped;                        /**< Operations dropped as superseded since init */
+    uint32_t        submits;                        /**< Bus submissions (single IOVARs or batches) since init */
+    olm_txn_entry_t entries[OLM_TXN_MAX_ENTRIES];   /**< Queued operations */
+    uint8_t         buf[OLM_TXN_BUF_SIZE];          /**< Storage for SET_BUFFER payloads */
+    olm_txn_iovar_t   iovars[OLM_TXN_MAX_ENTRIES];  /**< Flush scratch: batch being submitted */
+    olm_txn_payload_t payload[OLM_TXN_MAX_ENTRIES]; /**< Flush scratch: payloads of iovars */
+    uint32_t          results[OLM_TXN_MAX_ENTRIES]; /**< Flush scratch: results of iovars */
+    uint16_t          index[OLM_TXN_MAX_ENTRIES];   /**< Flush scratch: entry of each of iovars */
+} olm_txn_t;
+
+/** Non-critical operation deferred to the next sleep transition */
+typedef struct olm_deferred
+{
+    olm_txn_fn_t    *fn;                            /**< Called in the sleep transition */
+    void            *arg;                           /**< First argument of fn */
+    uint32_t        param;                          /**< Second argument of fn */
+} olm_deferred_t;
+
+/** WLAN power profile: the low power IOVAR values applied as a set */
+typedef struct olm_wlan_profile
+{
+    const char      *name;                          /**< Profile name */
+    uint32_t        bcntrim;                        /**< Beacons that may be missed, 1 to 10 */
+    uint32_t        bcn_wait_period;                /**< Beacon wait period in ms */
+    uint32_t        bcn_reacquire_start;            /**< Time for beacon reacquire in seconds */
+    uint32_t        roam_time_threshold;            /**< Roam time threshold in seconds; higher than bcn_reacquire_start */
+    uint32_t        pm2_sleep_ret;                  /**< PM2 return to sleep time in ms while the host sleeps, 10 to 2000 */
+} olm_wlan_profile_t;
+
+/** Index of the built-in profiles in \ref cy_olm_wlan_profiles */
+typedef enum olm_wlan_profile_id
+{
+    OLM_WLAN_PROFILE_DEFAULT = 0,       /**< Steady-state telemetry; the LPA_* values */
+    OLM_WLAN_PROFILE_COMMISSIONING,     /**< Latency sensitive, e.g. while commissioning */
+    OLM_WLAN_PROFILE_BATTERY_CRITICAL,  /**< Lowest power, at the cost of latency and roaming */
+    OLM_WLAN_PROFILE_MAX                /**< Number of built-in profiles */
+} olm_wlan_profile_id_t;
+
+/** Operation timed by the latency histograms */
+typedef enum olm_latency_id
+{
+    OLM_LATENCY_INIT = 0,               /**< Offload init function in cylpa_olm_init_ols() */
+    OLM_LATENCY_SLEEP,                  /**< Going-to-sleep handler */
+    OLM_LATENCY_WAKE,                   /**< Awake handler */
+    OLM_LATENCY_MAX                     /**< Number of timed operations */
+} olm_latency_id_t;
+
+/** Latency histogram of one operation; times in microseconds */
+typedef struct olm_latency
+{
+    uint32_t        count;                          /**< Samples since reset */
+    uint32_t        min_us;                         /**< Shortest sample */
+    uint32_t        max_us;                         /**< Longest sample */
+    uint32_t        last_us;                        /**< Most recent sample */
+    uint16_t        buckets[OLM_LATENCY_BUCKETS];   /**< Log2 buckets, saturating */
+} olm_latency_t;
+
+/** Priority of deferred work; among the items that are due, the highest runs first */
+typedef enum olm_exec_prio
+{
+    OLM_EXEC_PRIO_LOW = 0,              /**< Housekeeping */
+    OLM_EXEC_PRIO_NORMAL,               /**< Offload event handling */
+    OLM_EXEC_PRIO_HIGH,                 /**< Someone is waiting for the result */
+} olm_exec_prio_t;
+
+/** Deferred work function */
+typedef void (olm_exec_fn_t)(void *arg);
+
+/** Deferred work item.
+ * Owned by the submitter, typically embedded in an offload context; submitting an
+ * item that is already pending does not queue it twice. */
+typedef struct olm_exec_item
+{
+    struct olm_exec_item *next;         /**< Next pending item, by due time */
+    olm_exec_fn_t   *fn;                /**< Called from the executor */
+    void            *arg;               /**< Argument of fn */
+    uint32_t        due;                /**< RTOS time (ms) from which the item may run */
+    uint8_t         priority;           /**< \ref olm_exec_prio_t */
+    volatile bool   pending;            /**< Submitted and not yet run or cancelled */
+    volatile bool   running;            /**< fn is being called */
+} olm_exec_item_t;
+
+/** Deferred-work executor counters */
+typedef struct olm_exec_stats
+{
+    uint32_t        submitted;          /**< Submissions */
+    uint32_t        coalesced;          /**< Submissions merged into an item already pending */
+    uint32_t        runs;               /**< Items run */
+    uint32_t        cancelled;          /**< Pending items cancelled */
+} olm_exec_stats_t;
+
+/** Handle of a registered offload; slot and generation, never 0 */
+typedef uint32_t olm_handle_t;
+
+/** No offload */
+#define OLM_HANDLE_INVALID      (0)
+
+/** Name and type hash buckets of the offload registry */
+#define OLM_REG_HASH_SIZE       (OLM_MAX_OFFLOADS * 2)
+
+/** Registry slot */
+typedef struct olm_reg_entry
+{
+    const struct ol_desc *desc;         /**< NULL if the slot is free */
+    uint16_t        gen;                /**< Bumped when the slot is freed */
+    bool            active;             /**< Initialized and not yet deinitialized */
+} olm_reg_entry_t;
+
+/** Lookup and dispatch arrays derived from the registry; slot indices */
+typedef struct olm_reg_view
+{
+    uint8_t         pm_count;                       /**< Entries in pm */
+    uint8_t         deinit_count;                   /**< Entries in deinit */
+    uint8_t         pm[OLM_MAX_OFFLOADS];           /**< Offloads with a pm handler, in registration order */
+    uint8_t         deinit[OLM_MAX_OFFLOADS];       /**< Offloads with a deinit function, in registration order */
+    uint8_t         by_name[OLM_REG_HASH_SIZE];     /**< Open-addressed name hash; slot + 1, 0 if empty */
+    uint8_t         by_type[OLM_REG_HASH_SIZE];     /**< Open-addressed ol_fns_t hash; slot + 1, 0 if empty */
+} olm_reg_view_t;
+
+/** Offload registry.
+ * The views are rebuilt on every register/unregister; the one not in use is
+ * written and then published, so a power-mode dispatch never sees a partial one. */
+typedef struct olm_reg
+{
+    olm_reg_entry_t entries[OLM_MAX_OFFLOADS];      /**< Registered offloads by slot */
+    uint8_t         order[OLM_MAX_OFFLOADS];        /**< Slots in registration order */
+    uint8_t         count;                          /**< Entries in order */
+    bool            overflow;                       /**< ol_list had more than OLM_MAX_OFFLOADS entries */
+    volatile uint8_t view;                          /**< Index of the published view */
+    olm_reg_view_t  views[2];                       /**< Published and spare view */
+} olm_reg_t;
 
 /** Offload Manager context.
  * Private structure; visible to allow for static definition. */
@@ -83,8 +368,23 @@ typedef struct olm
 {
     const struct ol_desc *ol_list;      /**< Offload Assist list */
     ol_info_t ol_info;                  /**< Offload info */
+    olm_reg_t reg;                      /**< Registered offloads; ol_list plus those added at runtime */
+    bool ols_up;                        /**< cylpa_olm_init_ols() succeeded and cylpa_olm_deinit_ols() not called */
+    olm_txn_t txn;                      /**< IOVAR transaction used by power-mode transitions */
+    uint32_t deferred_count;            /**< Number of entries in deferred */
+    uint32_t deferred_base;             /**< Entries below this index were deferred by the OLM itself */
+    olm_deferred_t deferred[OLM_MAX_DEFERRED]; /**< Operations run at the next sleep transition */
+    const olm_wlan_profile_t *wlan_profile;    /**< WLAN power profile in effect; NULL for the default */
+    bool wlan_configured;               /**< WLAN low power configuration applied to ol_info.whd */
+    uint32_t pm2_sleep_ret;             /**< PM2 sleep return time (ms) in effect before the last sleep transition */
+#if (OLM_LATENCY_STATS != 0)
+    olm_latency_t latency[OLM_MAX_OFFLOADS + 1][OLM_LATENCY_MAX]; /**< Per registry slot, then the whole OLM */
+#endif
 } olm_t;
 
+/** Built-in WLAN power profiles, indexed by \ref olm_wlan_profile_id_t */
+extern const olm_wlan_profile_t cy_olm_wlan_profiles[OLM_WLAN_PROFILE_MAX];
+
 /** \} */
 
 
@@ -151,6 +451,179 @@ extern void cylpa_olm_configure_wlan_pmode ( void *whd , uint32_t value, bool mi
  * *****************************************************************************/
 extern void cylpa_olm_init_wlan_config ( void *whd );
 
+/** Switch the WLAN power profile.
+ *
+ * Only the IOVARs whose value differs from what the firmware holds are sent.
+ * The PM2 return to sleep time takes effect at the next sleep transition.
+ * The profile must stay valid while it is in effect.
+ *
+ * @param olm        : The pointer to the olm structure @ref olm_t.
+ * @param profile    : The profile to apply, e.g. &cy_olm_wlan_profiles[OLM_WLAN_PROFILE_COMMISSIONING]
+ *
+ * @return RESULT_OK, RESULT_BADARGS if a value is out of range, RESULT_ERROR if an IOVAR failed
+ *
+ * *****************************************************************************/
+extern int cylpa_olm_set_wlan_profile(olm_t *olm, const olm_wlan_profile_t *profile);
+
+/** Return the WLAN power profile in effect.
+ *
+ * @param olm        : The pointer to the olm structure @ref olm_t.
+ *
+ * *****************************************************************************/
+extern const olm_wlan_profile_t *cylpa_olm_get_wlan_profile(const olm_t *olm);
+
+/** Look up a built-in WLAN power profile by name; NULL if there is none.
+ *
+ * @param name       : Profile name, e.g. "commissioning"
+ *
+ * *****************************************************************************/
+extern const olm_wlan_profile_t *cylpa_olm_find_wlan_profile(const char *name);
+
+/** Register an offload.
+ *
+ * If the offloads are up (cylpa_olm_init_ols() has run) the offload is initialized
+ * now; its dependencies must be initialized already. Otherwise it is initialized by
+ * the next cylpa_olm_init_ols(). The other offloads are not disturbed.
+ * Call from the application while the host is awake, not concurrently with
+ * cylpa_olm_init() or cylpa_olm_unregister().
+ *
+ * @param olm        : The pointer to the olm structure @ref olm_t.
+ * @param desc       : The offload; must stay valid until unregistered
+ * @param handle     : Filled in with the handle of the offload, may be NULL
+ *
+ * @return RESULT_OK, RESULT_BADARGS if the registry is full or a dependency is not
+ *         initialized, or the result of the offload init function
+ *
+ * *****************************************************************************/
+extern int cylpa_olm_register(olm_t *olm, const struct ol_desc *desc, olm_handle_t *handle);
+
+/** Unregister an offload, deinitializing it if it is initialized.
+ *
+ * @param olm        : The pointer to the olm structure @ref olm_t.
+ * @param handle     : Handle from cylpa_olm_register() or a lookup
+ *
+ * @return RESULT_OK, RESULT_BADARGS if the handle is stale or an initialized
+ *         offload depends on this one
+ *
+ * *****************************************************************************/
+extern int cylpa_olm_unregister(olm_t *olm, olm_handle_t handle);
+
+/** Change the configuration of a registered offload.
+ *
+ * desc replaces the descriptor of the offload and must name the same offload type
+ * and instance; usually only cfg differs. If the offload is initialized, its
+ * reconfiguration function moves the firmware to the new configuration, issuing
+ * only the IOVARs for what changed; the configuration in use is what it compares
+ * against, so desc->cfg must not be the same storage modified in place. An
+ * offload without a reconfiguration function is deinitialized and
+ * initialized again with desc, unless another initialized offload depends on it.
+ * Call from the application while the host is awake, like cylpa_olm_register().
+ *
+ * @param olm        : The pointer to the olm structure @ref olm_t.
+ * @param handle     : The offload
+ * @param desc       : The new descriptor; must stay valid until unregistered
+ *
+ * @return RESULT_OK, RESULT_BADARGS if the handle is stale or desc is for another
+ *         offload, RESULT_UNSUPPORTED if the offload must be reinitialized but is
+ *         needed by another offload, or the result of the offload function
+ *
+ * *****************************************************************************/
+extern int cylpa_olm_reconfigure(olm_t *olm, olm_handle_t handle, const struct ol_desc *desc);
+
+/** Find a registered offload by name.
+ *
+ * @param olm        : The pointer to the olm structure @ref olm_t.
+ * @param name       : Offload name as in @ref ol_desc_t
+ *
+ * @return The handle, or OLM_HANDLE_INVALID
+ *
+ * *****************************************************************************/
+extern olm_handle_t cylpa_olm_find(const olm_t *olm, const char *name);
+
+/** Find the first registered offload of a type.
+ *
+ * @param olm        : The pointer to the olm structure @ref olm_t.
+ * @param fns        : The offload type, e.g. &arp_ol_fns
+ *
+ * @return The handle, or OLM_HANDLE_INVALID
+ *
+ * *****************************************************************************/
+extern olm_handle_t cylpa_olm_find_type(const olm_t *olm, const struct ol_fns *fns);
+
+/** Return the descriptor of a registered offload.
+ *
+ * @param olm        : The pointer to the olm structure @ref olm_t.
+ * @param handle     : The offload
+ *
+ * @return The descriptor, or NULL if the handle is stale
+ *
+ * *****************************************************************************/
+extern const struct ol_desc *cylpa_olm_get_desc(const olm_t *olm, olm_handle_t handle);
+
+/** Read the latency histogram of an offload.
+ *
+ * Offloads whose power-mode handler queues its IOVARs on the OLM transaction are
+ * timed while queueing; the IOVARs themselves are in the whole-OLM histogram
+ * (name NULL), which covers cylpa_olm_init_ols() and the complete transitions.
+ *
+ * @param olm        : The pointer to the olm structure @ref olm_t.
+ * @param name       : Offload name as in @ref ol_desc_t, or NULL for the whole OLM
+ * @param id         : The timed operation
+ * @param latency    : Filled in with a copy of the histogram
+ *
+ * @return RESULT_OK, RESULT_BADARGS if there is no such offload, RESULT_UNSUPPORTED
+ *         if OLM_LATENCY_STATS is 0
+ *
+ * *****************************************************************************/
+extern int cylpa_olm_get_latency(const olm_t *olm, const char *name, olm_latency_id_t id, olm_latency_t *latency);
+
+/** Clear all latency histograms.
+ *
+ * @param olm        : The pointer to the olm structure @ref olm_t.
+ *
+ * *****************************************************************************/
+extern void cylpa_olm_reset_latency(olm_t *olm);
+
+/** Firmware capabilities probed by the Offload Manager.
+ *
+ * @param olm        : The pointer to the olm structure @ref olm_t.
+ *
+ * @return The capabilities; ol_caps_t::valid is false until the WHD interface is known
+ *
+ * *****************************************************************************/
+extern const ol_caps_t *cylpa_olm_get_caps(const olm_t *olm);
+
+/** Run the OLM deferred work that is due, highest priority first.
+ *
+ * With OLM_EXEC_THREAD set to 0 the Offload Managers have no thread of their own
+ * and run the due work after each power-mode notification, or from an RTOS timer
+ * when the first delayed item is due. An application that wants it run on a
+ * thread of its own calls this whenever \ref cylpa_olm_exec_notify is called
+ * and at the latest when the returned time has passed. With OLM_EXEC_THREAD set
+ * to 1 the executor thread does this and the application need not call it.
+ * Must not be called from an interrupt or with an OLM lock held.
+ *
+ * @return Milliseconds until the next pending item is due, CY_RTOS_NEVER_TIMEOUT if none
+ *
+ * *****************************************************************************/
+extern uint32_t cylpa_olm_exec_run(void);
+
+/** Called when deferred work was submitted that is due before anything pending.
+ *
+ * Weak; the default does nothing. With OLM_EXEC_THREAD set to 0 the application
+ * may override this to wake a thread that calls \ref cylpa_olm_exec_run. It may be
+ * called from any thread that submits work, with no OLM lock held.
+ *
+ * *****************************************************************************/
+extern void cylpa_olm_exec_notify(void);
+
+/** Read the deferred-work executor counters.
+ *
+ * @param stats      : Filled in with a copy of the counters
+ *
+ * *****************************************************************************/
+extern void cylpa_olm_exec_get_stats(olm_exec_stats_t *stats);
+
 /** \} */
 
 
@@ -196,6 +669,63 @@ typedef enum
 /*
  * OL_LOG Debug verbosity settings
  */
+
+/* ol_logging() prints directly. Define OLM_LOG_RING to store records other than
+ * errors in binary form in a lock-free ring instead; they are formatted later by
+ * ol_log_drain(), which the application calls from a low-priority task, or by a
+ * host decoder from ol_log_read().
+ */
+
+/* Number of records in the trace ring; a power of 2 */
+#ifndef OL_LOG_RING_SIZE
+#define OL_LOG_RING_SIZE        (64)
+#endif
+
+/* 32-bit words of argument storage per record; strings (e.g. __func__) are copied inline */
+#ifndef OL_LOG_ARG_WORDS
+#define OL_LOG_ARG_WORDS        (16)
+#endif
+
+/* Size of a line formatted by ol_log_drain() */
+#ifndef OL_LOG_LINE_SIZE
+#define OL_LOG_LINE_SIZE        (160)
+#endif
+
+/** Facility bit of @ref ol_log_set_mask */
+#define OL_LOG_MASK(assist)     (1UL << (assist))
+
+/** All facilities */
+#define OL_LOG_MASK_ALL         ( (1UL << LOG_OLA_MAX_INDEX) - 1 )
+
+/** Record flag: arguments did not fit in args[] and were cut */
+#define OL_LOG_REC_F_TRUNCATED  (1U << 0)
+
+/** One binary log record.
+ *
+ * args[] holds the arguments in format order, each in as many 32-bit words as
+ * its C type needs (int, long, long long, size_t, pointers and double);
+ * %s strings are copied NUL-terminated and padded to a word.
+ */
+typedef struct ol_log_record
+{
+    const char  *fmt;                       /**< Format string; stays in the image */
+    uint32_t    timestamp_us;               /**< cylpa_olm_latency_now_us() when logged */
+    uint8_t     assist;                     /**< @ref LOG_OFFLOAD_ASSIST_T */
+    uint8_t     level;                      /**< @ref LOG_OFFLOAD_ASSIST_LEVEL_T */
+    uint8_t     nwords;                     /**< Used words of args */
+    uint8_t     flags;                      /**< OL_LOG_REC_F_* */
+    uint32_t    args[OL_LOG_ARG_WORDS];     /**< Raw arguments */
+} ol_log_record_t;
+
+/** Trace ring counters */
+typedef struct ol_log_stats
+{
+    uint32_t    recorded;                   /**< Records stored */
+    uint32_t    dropped;                    /**< Records lost because the ring was full */
+    uint32_t    truncated;                  /**< Records stored with OL_LOG_REC_F_TRUNCATED */
+    uint32_t    dropped_assist[LOG_OLA_MAX_INDEX]; /**< dropped, per facility */
+} ol_log_stats_t;
+
 /**
  * This function gets log level for a facility
  *
@@ -230,6 +760,51 @@ extern int ol_log_set_level(LOG_OFFLOAD_ASSIST_T assist, LOG_OFFLOAD_ASSIST_LEVE
  */
 extern int ol_logging(LOG_OFFLOAD_ASSIST_T assist, LOG_OFFLOAD_ASSIST_LEVEL_T level, const char *fmt, ...);
 
+/**
+ * This function selects the facilities that are logged, on top of their level
+ *
+ * @param mask   : OR of OL_LOG_MASK(assist); OL_LOG_MASK_ALL by default
+ *
+ */
+extern void ol_log_set_mask(uint32_t mask);
+
+/**
+ * This function gets the facility mask
+ *
+ * @return       : OR of OL_LOG_MASK(assist)
+ *
+ */
+extern uint32_t ol_log_get_mask(void);
+
+/**
+ * This function takes the oldest record out of the trace ring, unformatted
+ *
+ * @param rec    : Filled in with the record
+ *
+ * @return       : true if a record was read, false if the ring is empty
+ *
+ */
+extern bool ol_log_read(ol_log_record_t *rec);
+
+/**
+ * This function formats and prints records from the trace ring.
+ * Call it from a low-priority task, or when the host is awake anyway.
+ *
+ * @param max    : Maximum number of records to print, 0 for all
+ *
+ * @return       : # records printed
+ *
+ */
+extern uint32_t ol_log_drain(uint32_t max);
+
+/**
+ * This function gets the trace ring counters
+ *
+ * @param stats  : Filled in with the counters
+ *
+ */
+extern void ol_log_get_stats(ol_log_stats_t *stats);
+
 /** \} */
 
 /**< Offload Logging Macros */
@@ -248,6 +823,10 @@ extern int ol_logging(LOG_OFFLOAD_ASSIST_T assist, LOG_OFFLOAD_ASSIST_LEVEL_T le
 
 #define ol_log_get_level(assist)            - 1
 #define ol_log_set_level(assist, level)     - 1
+#define ol_log_set_mask(mask)
+#define ol_log_get_mask()                   0
+#define ol_log_read(rec)                    false
+#define ol_log_drain(max)                   0
 
 /* No log printing when we are not building for TEST_CONSOLE */
 #define OL_LOG(...)
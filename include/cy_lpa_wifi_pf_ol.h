@@ -37,7 +37,9 @@
 #define PF_OL_H__  (1)
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "cy_lpa_compat.h"
+#include "cy_lpa_wifi_olm.h"   /* for olm_t, olm_exec_item_t */
 
 #ifdef __cplusplus
 extern "C" {
@@ -57,8 +59,11 @@ typedef enum cy_pf_feature
     CY_PF_OL_FEAT_PORTNUM    = 1,        /**< Filter based on port numbers */
     CY_PF_OL_FEAT_ETHTYPE    = 2,        /**< Filter based on ethernet_type */
     CY_PF_OL_FEAT_IPTYPE     = 3,        /**< Filter based on IP type */
+    CY_PF_OL_FEAT_IPADDR     = 4,        /**< Filter based on IPv4 address or subnet */
+    CY_PF_OL_FEAT_MAC        = 5,        /**< Filter based on destination MAC address */
+    CY_PF_OL_FEAT_PATTERN    = 6,        /**< Filter based on a pattern at any offset */
                                          /**< Add new filter types here. do not alter previous types (breaks backward compatibilty) */
-    CY_PF_OL_FEAT_LAST       = 4,        /**< Number of offload features (invalid feature id). */
+    CY_PF_OL_FEAT_LAST       = 7,        /**< Number of offload features (invalid feature id). */
 } cy_pf_feature_t;
 
 /** Port numbers are a feature of both TCP and UDP protocols. Each filter can only support one or the other.  */
@@ -75,6 +80,16 @@ typedef enum cy_pn_direction
     PF_PN_PORT_SOURCE      = 2,        /**< Filter Source Port */
     PF_PN_PORT_SOURCE_DEST = 3,        /**< Filter Source Destination Port */
 } cy_pn_direction_t;
+
+/** How a configuration entry is implemented by the compiled firmware filters, see \ref cy_pf_ol_map_t */
+typedef enum cy_pf_ol_map_kind
+{
+    CY_PF_OL_MAP_EMITTED   = 0,        /**< Programmed as the filter */
+    CY_PF_OL_MAP_MERGED    = 1,        /**< Merged with other entries into the filter */
+    CY_PF_OL_MAP_DUPLICATE = 2,        /**< Same as the filter; not programmed */
+    CY_PF_OL_MAP_SHADOWED  = 3,        /**< Decides no packet the filter does not already decide; not programmed */
+    CY_PF_OL_MAP_INACTIVE  = 4,        /**< Active neither asleep nor awake; not programmed */
+} cy_pf_ol_map_kind_t;
 /** \} */
 
 
@@ -95,12 +110,13 @@ typedef struct cy_pn_port
     uint16_t portnum;            /**< Port number.  Any 16 bit port number can be specified.
                                      For a description and list of port numbers see: https://en.wikipedia.org/wiki/List_of_TCP_and_UDP_port_numbers
                                   */
-    uint16_t range;               /**< Range: Allows a block of portnumbers to be filtered.
-                                   *   Range must be of the form 2^y - 1 (511, 1023, etc) and must be less than portnum.
-                                   *   When using range, portnum must be of the form 2^x (256, 512, etc).
+    uint16_t range;               /**< Range: Allows a block of portnumbers to be filtered, portnum thru portnum + range
+                                   *   (at most 65535).
                                    *   Example: portnum == 16384, range = 1023 will filter ports 16384-17407
                                    *
-                                   *   If any of these checks for using ranges fails, fallback to filtering for just 'portnum'.
+                                   *   The block is split into the fewest power-of-two aligned sub-blocks, each taking a
+                                   *   firmware filter: 16384-17407 takes one, 49152-65535 one, 32768-60999 seven.
+                                   *   With PF_PN_PORT_SOURCE_DEST every pair of sub-blocks takes a filter.
                                    */
 
     cy_pn_direction_t direction; /**< Source or Destination port. Dest is default unless source port override is on */
@@ -119,12 +135,61 @@ typedef struct cy_pf_ethtype_cfg
     uint16_t eth_type;        /**< 16 bit value in bytes 13 & 14 of Ethernet header. For description and list of ethertypes see https://en.wikipedia.org/wiki/EtherType */
 } cy_pf_ethtype_cfg_t;
 
-/** Describes an IP type filter (type CY_PF_OL_FEAT_IPTYPE) */
+/** Describes an IP type filter (type CY_PF_OL_FEAT_IPTYPE). For IPv6 packets this is the Next Header of the
+ * IPv6 header; packets with extension headers are not matched. */
 typedef struct cy_pf_ip_cfg
 {
     uint8_t ip_type;           /**< 8 bit value in byte 10 of ipv4 header. For a list of IP protocol numbers see https://en.wikipedia.org/wiki/List_of_IP_protocol_numbers */
 } cy_pf_ip_cfg_t;
 
+#define CY_PF_OL_IPV4_ADDR_LEN   (4)        /**< Bytes in an IPv4 address */
+#define CY_PF_OL_IPV6_ADDR_LEN   (16)       /**< Bytes in an IPv6 address */
+
+/** Describes an IP address filter (type CY_PF_OL_FEAT_IPADDR).
+ * Matches IPv4 packets whose source and/or destination address is in ip_addr/prefix_len,
+ * e.g. {192, 168, 1, 0}/24, optionally only for one IP protocol and port or range of ports.
+ * With CY_PF_IPV6 or CY_PF_IPV4_IPV6, IPv6 packets are matched against ip6_addr/prefix6_len.
+ */
+typedef struct cy_pf_ipaddr_cfg
+{
+    uint8_t ip_addr[CY_PF_OL_IPV4_ADDR_LEN]; /**< Address or subnet, in network order (first byte most significant) */
+    uint8_t prefix_len;                     /**< Leading bits of ip_addr to match, 0-32. 32 matches a single host */
+    cy_pn_direction_t direction;            /**< Match the destination address, the source address, or both */
+    uint8_t ip_type;                        /**< IP protocol number to match, 0 for any */
+    cy_pf_port_t port;                      /**< Port or range of ports to match, ip_type must be TCP (6) or UDP (17).
+                                             *   portnum 0 and range 0 match any port */
+    uint8_t ip6_addr[CY_PF_OL_IPV6_ADDR_LEN]; /**< IPv6 address or prefix, in network order */
+    uint8_t prefix6_len;                    /**< Leading bits of ip6_addr to match, 0-128 */
+} cy_pf_ipaddr_cfg_t;
+
+#define CY_PF_OL_MAC_ADDR_LEN    (6)        /**< Bytes in a MAC address */
+
+/** Describes a destination MAC address filter (type CY_PF_OL_FEAT_MAC).
+ * Matches frames whose destination address has the bits of mac set in mac_mask, e.g.
+ * - one address: 01:00:5e:00:00:fb (mDNS), mask ff:ff:ff:ff:ff:ff;
+ * - every multicast and broadcast address: 01:00:00:00:00:00, mask 01:00:00:00:00:00;
+ * - an OUI prefix: 33:33:00:00:00:00 (IPv6 multicast), mask ff:ff:00:00:00:00.
+ */
+typedef struct cy_pf_mac_cfg
+{
+    uint8_t  mac[CY_PF_OL_MAC_ADDR_LEN];      /**< Destination address bits to match */
+    uint8_t  mac_mask[CY_PF_OL_MAC_ADDR_LEN]; /**< Bits of mac to match */
+    uint16_t eth_type;                        /**< EtherType to match as well, 0 for any */
+} cy_pf_mac_cfg_t;
+
+/** Describes a pattern filter (type CY_PF_OL_FEAT_PATTERN).
+ * Matches frames where the len bytes from offset, with the bits of mask set, equal pattern, e.g.
+ * a message type in a UDP payload. The frame must hold all len bytes. pattern and mask are not
+ * copied and must stay valid as long as the configuration is in use.
+ */
+typedef struct cy_pf_pattern_cfg
+{
+    uint16_t offset;                /**< Offset of pattern[0] from the start of the Ethernet header */
+    uint8_t len;                    /**< Bytes of pattern and mask, 1 to CY_PF_OL_MAX_PATTERN_LEN */
+    const uint8_t *pattern;         /**< Bytes to match */
+    const uint8_t *mask;            /**< Bits of pattern to match, NULL to match all bits */
+} cy_pf_pattern_cfg_t;
+
 /** Single union to describe all packet filters */
 typedef struct cy_pf_ol_cfg
 {
@@ -133,6 +198,8 @@ typedef struct cy_pf_ol_cfg
 #define CY_PF_ACTIVE_SLEEP       (1 << 0)     /**< Filter is active only when Host is asleep */
 #define CY_PF_ACTIVE_WAKE        (1 << 1)     /**< Filter is active only when Host is awake */
 #define CY_PF_ACTION_DISCARD     (1 << 2)     /**< Packets that match filter are dropped and NOT passed to host, else they are passed up. */
+#define CY_PF_IPV6               (1 << 3)     /**< Port, IP type and address filters match IPv6 instead of IPv4 packets */
+#define CY_PF_IPV4_IPV6          (1 << 4)     /**< Port, IP type and address filters match IPv4 and IPv6 packets, one firmware filter each */
 
     uint32_t bits;                  /**< Various on/off options applicable to all types of packet filters */
     uint8_t id;                     /**< Each filter is given a unique 8 bit identifier. */
@@ -142,21 +209,708 @@ typedef struct cy_pf_ol_cfg
         cy_pf_pn_cfg_t pf;          /**< Port filter */
         cy_pf_ethtype_cfg_t eth;    /**< Eth_type filter */
         cy_pf_ip_cfg_t ip;          /**< IP type filter */
+        cy_pf_ipaddr_cfg_t addr;    /**< IPv4 address filter */
+        cy_pf_mac_cfg_t mac;        /**< Destination MAC address filter */
+        cy_pf_pattern_cfg_t pat;    /**< Pattern filter */
     } u;                            /**< Individual filter types  */
 } cy_pf_ol_cfg_t;
 
 
+/* Each packet filter offload holds two programs, the one in the firmware and pf_ol_t::scratch,
+ * and the counters of CY_PF_OL_MAX_FILTERS filters. A program takes about
+ * CY_PF_OL_MAX_FILTERS * (2 * CY_PF_OL_MAX_PATTERN_LEN + 12) bytes, so pf_ol_t is about 5 KB
+ * with the defaults. Lower them to save RAM; below CY_PF_OL_IPV6_PATTERN_LEN, a configuration
+ * with an IPv6 port or address entry is refused.
+ */
+#ifndef CY_PF_OL_MAX_FILTERS
+#define CY_PF_OL_MAX_FILTERS        (16)        /**< Firmware filters one packet filter offload may program */
+#endif
+#ifndef CY_PF_OL_MAX_MAP
+#define CY_PF_OL_MAX_MAP            (24)        /**< Configuration entry to firmware filter pairs of a program */
+#endif
+#ifndef CY_PF_OL_MAX_PATTERN_LEN
+#define CY_PF_OL_MAX_PATTERN_LEN    (64)        /**< Bytes matched by one firmware filter */
+#endif
+#define CY_PF_OL_IPV6_PATTERN_LEN   (46)        /**< Bytes an IPv6 port or address filter matches */
+
+/* Filters added on top of the configured ones, each set to 1 to build it in. An API of a
+ * feature left out returns RESULT_UNSUPPORTED.
+ */
+#ifndef CY_PF_OL_ADAPT
+#define CY_PF_OL_ADAPT              (0)         /**< Adaptive sleep filters, see \ref cylpa_pf_ol_adapt */
+#endif
+#ifndef CY_PF_OL_SOCK
+#define CY_PF_OL_SOCK               (0)         /**< Socket allow-list, see \ref cylpa_pf_ol_sock_mode */
+#endif
+#ifndef CY_PF_OL_PRESETS
+#define CY_PF_OL_PRESETS            (0)         /**< Presets, see \ref cylpa_pf_ol_preset_enable */
+#endif
+#ifndef CY_PF_OL_RULES
+#define CY_PF_OL_RULES              (0)         /**< Rules added at run time, see \ref cylpa_pf_ol_rule_add */
+#endif
+#ifndef CY_PF_OL_POLICY
+#define CY_PF_OL_POLICY             (0)         /**< Default-deny sleep policy, see \ref cylpa_pf_ol_policy */
+#endif
+
+/** One firmware packet filter compiled from \ref cy_pf_ol_cfg_t entries.
+ * Offsets count from the start of the Ethernet header; multi-byte fields are in network order.
+ */
+typedef struct cy_pf_ol_filter
+{
+    uint8_t  id;                                /**< Firmware filter id */
+    uint8_t  len;                               /**< Bytes of pattern and mask */
+    uint16_t offset;                            /**< Offset of the first matched byte */
+    uint32_t bits;                              /**< CY_PF_ACTIVE_SLEEP, CY_PF_ACTIVE_WAKE, CY_PF_ACTION_DISCARD */
+    uint32_t weight;                            /**< Expected hit rate; filters are programmed highest first */
+    uint8_t  pattern[CY_PF_OL_MAX_PATTERN_LEN]; /**< Value of the matched bits */
+    uint8_t  mask[CY_PF_OL_MAX_PATTERN_LEN];    /**< Bits to match */
+} cy_pf_ol_filter_t;
+
+/** Which firmware filter implements a configuration entry */
+typedef struct cy_pf_ol_map
+{
+    uint8_t cfg_id;                             /**< \ref cy_pf_ol_cfg_t::id */
+    uint8_t filter_id;                          /**< \ref cy_pf_ol_filter_t::id; the entry id if CY_PF_OL_MAP_INACTIVE */
+    uint8_t kind;                               /**< \ref cy_pf_ol_map_kind_t */
+} cy_pf_ol_map_t;
+
+/** The firmware filters that implement a packet filter configuration, see \ref cylpa_pf_ol_compile */
+typedef struct cy_pf_ol_program
+{
+    cy_pf_ol_filter_t filters[CY_PF_OL_MAX_FILTERS]; /**< Filters, in programming order */
+    cy_pf_ol_map_t    map[CY_PF_OL_MAX_MAP];         /**< Configuration entries to filters */
+    uint8_t           count;                         /**< Filters in use */
+    uint8_t           map_count;                     /**< Map entries in use */
+    uint8_t           duplicates;                    /**< Entries dropped as duplicates */
+    uint8_t           shadowed;                      /**< Entries dropped as shadowed */
+    uint8_t           merged;                        /**< Filters saved by merging */
+    uint8_t           split;                         /**< Filters added for port ranges and IP families */
+    bool              overflow;                      /**< Some entries did not fit and are not implemented */
+} cy_pf_ol_program_t;
+
+/** Firmware counters of one programmed filter, see \ref cylpa_pf_ol_get_stats */
+typedef struct cy_pf_ol_stats
+{
+    uint8_t  filter_id;             /**< \ref cy_pf_ol_filter_t::id */
+    uint8_t  cfg_id;                /**< \ref cy_pf_ol_cfg_t::id of the first entry the filter implements */
+    bool     valid;                 /**< Counters were read; false if the firmware refused */
+    uint32_t bits;                  /**< CY_PF_ACTIVE_SLEEP, CY_PF_ACTIVE_WAKE, CY_PF_ACTION_DISCARD */
+    uint32_t matched;               /**< Packets matched since the filter was added */
+    uint32_t forwarded;             /**< Packets sent up to the host */
+    uint32_t discarded;             /**< Packets dropped */
+    uint32_t matched_delta;         /**< matched since the previous snapshot */
+    uint32_t forwarded_delta;       /**< forwarded since the previous snapshot */
+    uint32_t discarded_delta;       /**< discarded since the previous snapshot */
+} cy_pf_ol_stats_t;
+
+#ifndef CY_PF_OL_ADAPT_MAX_CLASSES
+#define CY_PF_OL_ADAPT_MAX_CLASSES  (16)        /**< Classes of wake traffic the adaptive filters track */
+#endif
+#ifndef CY_PF_OL_ADAPT_MAX_SLOTS
+#define CY_PF_OL_ADAPT_MAX_SLOTS    (4)         /**< Firmware filters the adaptive filters may take */
+#endif
+
+/** A class of received traffic, see \ref cylpa_pf_ol_classify.
+ * In an allow-list entry a field of 0 matches any value.
+ */
+typedef struct cy_pf_ol_class
+{
+    uint16_t eth_type;              /**< EtherType */
+    uint8_t  ip_type;               /**< IP protocol of an IPv4 or IPv6 packet, 0 for other frames */
+    uint16_t port;                  /**< TCP or UDP destination port, 0 for other packets */
+} cy_pf_ol_class_t;
+
+/** Adaptive sleep filter settings, see \ref cylpa_pf_ol_adapt */
+typedef struct cy_pf_ol_adapt_cfg
+{
+    uint8_t  slots;                 /**< Firmware filters the adaptive filters may take, 1 to CY_PF_OL_ADAPT_MAX_SLOTS */
+    uint32_t window_ms;             /**< Frames received this long after a wake are charged to it */
+    uint32_t threshold;             /**< Wakes a class is received in, and not consumed, before it is discarded */
+    uint32_t expiry_ms;             /**< Lifetime of an adaptive filter */
+    const cy_pf_ol_class_t *allow;  /**< Classes never discarded; not copied, must stay valid while enabled */
+    uint32_t allow_count;           /**< Entries in allow */
+} cy_pf_ol_adapt_cfg_t;
+
+/** One class tracked by the adaptive filters */
+typedef struct cy_pf_ol_adapt_class
+{
+    cy_pf_ol_class_t cls;           /**< The class */
+    uint32_t score;                 /**< Wakes the class was received in since it was last consumed */
+    uint32_t wakes;                 /**< Wakes the class was received in */
+    uint32_t last_wake;             /**< Wake the class was last charged to */
+    uint32_t expires;               /**< Time the discard filter lapses, ms */
+    bool     filtered;              /**< Discarded asleep by the filter filter_id */
+    bool     blocked;               /**< Cannot be discarded: allowed by a keep filter or not expressible */
+    uint8_t  filter_id;             /**< \ref cy_pf_ol_filter_t::id if filtered */
+} cy_pf_ol_adapt_class_t;
+
+/** State of the adaptive sleep filters */
+typedef struct cy_pf_ol_adapt
+{
+    cy_pf_ol_adapt_cfg_t   cfg;                                  /**< Settings */
+    bool                   on;                                   /**< Enabled */
+    uint32_t               wake;                                 /**< Wakes since enabled */
+    uint32_t               wake_ms;                              /**< Time of the last wake */
+    cy_pf_ol_adapt_class_t classes[CY_PF_OL_ADAPT_MAX_CLASSES];  /**< Tracked classes */
+    uint8_t                class_count;                          /**< Entries of classes in use */
+    cy_pf_ol_filter_t      filters[CY_PF_OL_ADAPT_MAX_SLOTS];    /**< Discard filters programmed */
+    uint8_t                filter_count;                         /**< Entries of filters in use */
+    uint32_t               installed;                            /**< Filters added since enabled */
+    uint32_t               expired;                              /**< Filters removed since enabled */
+} cy_pf_ol_adapt_t;
+
+#ifndef CY_PF_OL_SOCK_MAX_SLOTS
+#define CY_PF_OL_SOCK_MAX_SLOTS     (16)        /**< Firmware filters the socket allow-list may take */
+#endif
+#ifndef CY_PF_OL_SOCK_MAX_PORTS
+#define CY_PF_OL_SOCK_MAX_PORTS     (32)        /**< Ports and keep classes the socket allow-list collects, one per
+                                                 *   IP family with ipv6 */
+#endif
+
+/** Socket allow-list settings, see \ref cylpa_pf_ol_sock_mode */
+typedef struct cy_pf_ol_sock_cfg
+{
+    uint8_t  slots;                 /**< Firmware filters the allow-list may take, 1 to CY_PF_OL_SOCK_MAX_SLOTS */
+    bool     tcp;                   /**< Keep the ports of listening, bound and connected TCP sockets */
+    bool     udp;                   /**< Keep the ports of bound UDP sockets */
+    bool     ipv6;                  /**< Keep the ports for IPv6 as well, a filter more each */
+    const cy_pf_ol_class_t *keep;   /**< Classes kept as well, e.g. {0x0806, 0, 0} for ARP; eth_type must be set.
+                                     *   Not copied, must stay valid while enabled */
+    uint32_t keep_count;            /**< Entries in keep */
+} cy_pf_ol_sock_cfg_t;
+
+/** State of the socket allow-list */
+typedef struct cy_pf_ol_sock
+{
+    cy_pf_ol_sock_cfg_t cfg;                                /**< Settings */
+    bool                on;                                 /**< Enabled */
+    bool                failed;                             /**< An add failed this cycle; the allow-list is off */
+    bool                live[CY_PF_OL_SOCK_MAX_SLOTS];      /**< The slot holds a filter added to the firmware */
+    cy_pf_ol_filter_t   filters[CY_PF_OL_SOCK_MAX_SLOTS];   /**< Keep filters, by slot */
+    uint32_t            cycles;                             /**< Sleeps the allow-list was built for */
+    uint32_t            added;                              /**< Filters added since enabled */
+    uint32_t            removed;                            /**< Filters removed since enabled */
+    uint32_t            overflows;                          /**< Sleeps the sockets did not fit; the allow-list was off */
+    uint32_t            missed;                             /**< Sleeps without collected ports; the allow-list was off */
+    bool                collected;                          /**< classes holds the ports for the next sleep */
+    bool                truncated;                          /**< Some ports did not fit in classes */
+    uint32_t            class_count;                        /**< Entries of classes in use */
+    cy_pf_ol_class_t    classes[CY_PF_OL_SOCK_MAX_PORTS];   /**< Ports collected for a sleep */
+    cy_pf_ol_cfg_t      entries[CY_PF_OL_SOCK_MAX_PORTS + 1]; /**< Keep entries of the ports, for the compiler */
+} cy_pf_ol_sock_t;
+
+#define CY_PF_OL_PRESETS_VERSION    (1)         /**< Version of the preset library, see \ref cylpa_pf_ol_preset_get */
+#ifndef CY_PF_OL_MAX_PRESETS
+#define CY_PF_OL_MAX_PRESETS        (16)        /**< Presets one offload can track */
+#endif
+#ifndef CY_PF_OL_PRESET_MAX_SLOTS
+#define CY_PF_OL_PRESET_MAX_SLOTS   (12)        /**< Firmware filters the enabled presets may take; "noise" takes 9 */
+#endif
+
+/** A named bundle of discard filters for common protocol noise, see \ref cylpa_pf_ol_preset_enable */
+typedef struct cy_pf_ol_preset
+{
+    const char *name;               /**< Name to enable it by, e.g. "mdns" */
+    uint16_t version;               /**< Changes whenever the traffic it matches changes */
+    const char *description;        /**< What it discards */
+    const cy_pf_ol_cfg_t *entries;  /**< Discard entries, terminated by CY_PF_OL_FEAT_LAST */
+} cy_pf_ol_preset_t;
+
+/** Presets enabled in an offload */
+typedef struct cy_pf_ol_presets
+{
+    uint8_t             bits[CY_PF_OL_MAX_PRESETS];         /**< CY_PF_ACTIVE_SLEEP and/or CY_PF_ACTIVE_WAKE of each
+                                                             *   enabled preset, by index; 0 if not enabled */
+    cy_pf_ol_filter_t   filters[CY_PF_OL_PRESET_MAX_SLOTS]; /**< Filters in the firmware */
+    uint8_t             owner[CY_PF_OL_PRESET_MAX_SLOTS];   /**< Preset index of each filter */
+    uint8_t             count;                              /**< Entries of filters in use */
+} cy_pf_ol_presets_t;
+
+#ifndef CY_PF_OL_MAX_RULES
+#define CY_PF_OL_MAX_RULES          (16)        /**< Rules one offload can hold, see \ref cylpa_pf_ol_rule_add */
+#endif
+#ifndef CY_PF_OL_RULE_MAX_SLOTS
+#define CY_PF_OL_RULE_MAX_SLOTS     (16)        /**< Firmware filters the rules may take */
+#endif
+
+/** A filter added at run time, see \ref cylpa_pf_ol_rule_add */
+typedef struct cy_pf_ol_rule
+{
+    cy_pf_ol_cfg_t  cfg;            /**< The rule; cfg.id is the id it was given */
+    bool            in_use;         /**< Entry holds a rule */
+    bool            pending;        /**< Filters are added at the next power mode transition */
+} cy_pf_ol_rule_t;
+
+/** Rules added at run time to an offload */
+typedef struct cy_pf_ol_rules
+{
+    cy_pf_ol_rule_t     rules[CY_PF_OL_MAX_RULES];          /**< Rules, by index */
+    cy_pf_ol_filter_t   filters[CY_PF_OL_RULE_MAX_SLOTS];   /**< Filters in the firmware */
+    uint8_t             owner[CY_PF_OL_RULE_MAX_SLOTS];     /**< Rule index of each filter */
+    uint8_t             count;                              /**< Entries of filters in use */
+    bool                asleep;                             /**< Host state of the last transition */
+} cy_pf_ol_rules_t;
+
+#ifndef CY_PF_OL_POLICY_MAX_FLOWS
+#define CY_PF_OL_POLICY_MAX_FLOWS   (16)        /**< Flows a sleep policy may allow, see \ref cylpa_pf_ol_policy */
+#endif
+#ifndef CY_PF_OL_POLICY_MAX_SLOTS
+#define CY_PF_OL_POLICY_MAX_SLOTS   (16)        /**< Firmware filters the sleep policy may take */
+#endif
+#ifndef CY_PF_OL_POLICY_MAX_ERRORS
+#define CY_PF_OL_POLICY_MAX_ERRORS  (4)         /**< Mismatches a verification report keeps */
+#endif
+
+/** A flow a default-deny sleep policy lets through, see \ref cylpa_pf_ol_policy.
+ * A field of 0 matches any value; a flow must not allow all IP traffic.
+ */
+typedef struct cy_pf_ol_flow
+{
+    uint16_t eth_type;              /**< 0x0800 or 0x86DD, 0 for both IP families, or another EtherType, e.g. 0x0806
+                                     *   for ARP, with no IP field */
+    uint8_t  ip_type;               /**< IP protocol; 6 (TCP) or 17 (UDP) if port is set */
+    uint16_t port;                  /**< TCP or UDP destination port */
+    uint16_t port_end;              /**< Last port of a range from port, 0 for port alone */
+} cy_pf_ol_flow_t;
+
+/** A probe frame on which the sleep filters and the policy disagree */
+typedef struct cy_pf_ol_policy_error
+{
+    cy_pf_ol_class_t cls;           /**< Class of the frame, see \ref cylpa_pf_ol_classify */
+    bool     allowed;               /**< The policy lets it through; the filters drop it, else they let it through */
+    int16_t  filter_id;             /**< Discard filter that drops it or keep filter that lets it through, -1 for none */
+} cy_pf_ol_policy_error_t;
+
+/** Result of checking a sleep policy against the filters the firmware would hold asleep */
+typedef struct cy_pf_ol_policy_report
+{
+    uint32_t probes;                /**< Frames checked */
+    uint32_t mismatches;            /**< Frames the filters and the policy disagree on */
+    cy_pf_ol_policy_error_t errors[CY_PF_OL_POLICY_MAX_ERRORS]; /**< First mismatches, one per class */
+    uint8_t  count;                 /**< Entries of errors in use */
+    uint8_t  slots;                 /**< Firmware filters the policy takes */
+} cy_pf_ol_policy_report_t;
+
+/** Default-deny sleep policy of an offload */
+typedef struct cy_pf_ol_policy
+{
+    cy_pf_ol_flow_t     flows[CY_PF_OL_POLICY_MAX_FLOWS];   /**< Flows allowed asleep */
+    uint8_t             flow_count;                         /**< Entries of flows in use, 0 without a policy */
+    cy_pf_ol_filter_t   filters[CY_PF_OL_POLICY_MAX_SLOTS]; /**< Keep filters in the firmware */
+    uint8_t             count;                              /**< Entries of filters in use */
+    cy_pf_ol_filter_t   staged[CY_PF_OL_POLICY_MAX_SLOTS];  /**< Keep filters of a policy being checked */
+    uint8_t             staged_count;                       /**< Entries of staged given an id */
+    cy_pf_ol_cfg_t      entries[CY_PF_OL_POLICY_MAX_FLOWS + 1]; /**< Entries of a policy being checked */
+#if (CY_PF_OL_RULES != 0)
+    cy_pf_ol_cfg_t      pending[CY_PF_OL_MAX_RULES + 1];    /**< Sleep rules not added yet, for the check */
+#endif
+} cy_pf_ol_policy_t;
+
 /** Keep pointers to config space, system handle, etc */
 typedef struct pf_ol
 {
-    cy_pf_ol_cfg_t   *cfg;   /**< Pointer to config space */
-    void             *whd;   /**< Pointer to system handle */
+    cy_pf_ol_cfg_t   *cfg;          /**< Pointer to config space */
+    void             *whd;          /**< Pointer to system handle */
+    ol_info_t        *ol_info_ptr;  /**< Offload Manager Info structure  \ref ol_info_t */
+    cy_pf_ol_program_t prog;        /**< Filters programmed in the firmware for cfg */
+    cy_pf_ol_stats_t stats[CY_PF_OL_MAX_FILTERS]; /**< Last snapshot, by index in prog.filters */
+    uint32_t         snapshots;     /**< Snapshots taken since init */
+    bool             stats_on_wake; /**< Take a snapshot after every wake */
+    olm_exec_item_t  stats_work;    /**< Takes the wake snapshot */
+    cy_pf_ol_program_t scratch;     /**< Program replaced by a reconfiguration, then compiled filters added on top */
+#if (CY_PF_OL_ADAPT != 0)
+    cy_pf_ol_adapt_t adapt;         /**< Adaptive sleep filters */
+    olm_exec_item_t  adapt_work;    /**< Updates the adaptive filters after a wake */
+#endif
+#if (CY_PF_OL_SOCK != 0)
+    cy_pf_ol_sock_t  sock;          /**< Socket allow-list */
+#endif
+#if (CY_PF_OL_PRESETS != 0)
+    cy_pf_ol_presets_t presets;     /**< Enabled presets */
+#endif
+#if (CY_PF_OL_RULES != 0)
+    cy_pf_ol_rules_t rules;         /**< Rules added at run time */
+#endif
+#if (CY_PF_OL_POLICY != 0)
+    cy_pf_ol_policy_t policy;       /**< Default-deny sleep policy */
+#endif
 } pf_ol_t;
 
 /** \} */
 
 extern const ol_fns_t pf_ol_fns;
 
+/** @addtogroup lpautilities LPA Utilities API
+ * \{
+ */
+
+/**
+ * Compile a packet filter configuration into the firmware filters that implement it.
+ *
+ * Each entry is turned into pattern/mask form; a port range takes one filter per aligned
+ * block of ports, and an entry for both IP families one filter per family, the extra
+ * ones with ids counting down from 255 that no entry uses.
+ * Entries that duplicate or are covered by another entry with the same action and
+ * activity are dropped, entries whose patterns differ in a single bit are merged, and
+ * the remaining filters are ordered by expected hit rate. prog->map tells which filters
+ * implement each entry; an entry that does not fit is left out whole.
+ *
+ * The compiler keeps no state, so configurations may be compiled from several threads
+ * or ahead of time.
+ *
+ * @param[in]  cfg         Configuration, terminated by CY_PF_OL_FEAT_LAST.
+ * @param[out] prog        Compiled filters.
+ *
+ * @return RESULT_OK, RESULT_BADARGS, or RESULT_ERROR if prog->overflow is set.
+ *
+ */
+int cylpa_pf_ol_compile(const cy_pf_ol_cfg_t *cfg, cy_pf_ol_program_t *prog);
+
+/**
+ * Find the firmware filters that implement a configuration entry.
+ *
+ * @param[in]  prog        Compiled filters.
+ * @param[in]  cfg_id      \ref cy_pf_ol_cfg_t::id of the entry.
+ * @param[out] filter_ids  Filled in with up to max filter ids, may be NULL.
+ * @param[in]  max         Entries in filter_ids.
+ *
+ * @return Number of filters implementing the entry; 0 if it is unknown or inactive.
+ *
+ */
+uint32_t cylpa_pf_ol_lookup(const cy_pf_ol_program_t *prog, uint8_t cfg_id, uint8_t *filter_ids, uint32_t max);
+
+/**
+ * Get the firmware counters of the packet filters of an Offload Manager.
+ *
+ * With refresh, the counters are read from the firmware now and the deltas are against
+ * the previous snapshot, which this one replaces. Without, the last snapshot is returned
+ * as is, e.g. the one taken at the last wake, and the firmware is not accessed.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[in]  refresh     Take a new snapshot.
+ * @param[out] stats       Counters, one entry per programmed filter.
+ * @param[in]  max         Entries in stats.
+ * @param[out] count       Entries written to stats, may be NULL.
+ *
+ * @return RESULT_OK, RESULT_BADARGS if olm has no packet filter offload, or RESULT_ERROR
+ *         if some counters could not be read (their entries are not valid).
+ *
+ */
+int cylpa_pf_ol_get_stats(olm_t *olm, bool refresh, cy_pf_ol_stats_t *stats, uint32_t max, uint32_t *count);
+
+/**
+ * Take a snapshot of the packet filter counters after every wake. The snapshot is taken
+ * from the OLM deferred-work executor, outside the power-mode transition; read it with
+ * cylpa_pf_ol_get_stats() without refresh.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[in]  enable      Sample on wake.
+ *
+ * @return RESULT_OK, or RESULT_BADARGS if olm has no packet filter offload.
+ *
+ */
+int cylpa_pf_ol_stats_on_wake(olm_t *olm, bool enable);
+
+/**
+ * Classify a received frame for the adaptive sleep filters: TCP and UDP packets by
+ * destination port, other IPv4 and IPv6 packets by IP protocol, other frames by EtherType.
+ * IPv4 packets with options or that are not a first fragment are not classified by port,
+ * as the firmware filters match fixed offsets.
+ *
+ * @param[in]  frame       Frame, from the start of the Ethernet header.
+ * @param[in]  len         Bytes in frame.
+ * @param[out] cls         Class of the frame.
+ *
+ * @return RESULT_OK, or RESULT_BADARGS if the frame is shorter than an Ethernet header.
+ *
+ */
+int cylpa_pf_ol_classify(const uint8_t *frame, uint32_t len, cy_pf_ol_class_t *cls);
+
+/**
+ * Describe the sleep discard filter of a class as a configuration entry.
+ *
+ * @param[in]  cls         Class, see \ref cylpa_pf_ol_classify.
+ * @param[in]  id          \ref cy_pf_ol_cfg_t::id of the entry.
+ * @param[out] cfg         The entry.
+ *
+ * @return RESULT_OK, or RESULT_UNSUPPORTED for a class that would discard a whole IP family.
+ *
+ */
+int cylpa_pf_ol_class_cfg(const cy_pf_ol_class_t *cls, uint8_t id, cy_pf_ol_cfg_t *cfg);
+
+/**
+ * Enable adaptive sleep filters on top of the configured ones.
+ *
+ * Frames the host receives within cfg->window_ms of a wake are reported with
+ * cylpa_pf_ol_adapt_observe(). A class of traffic that is received, and not consumed, after
+ * cfg->threshold wakes gets a CY_PF_ACTIVE_SLEEP | CY_PF_ACTION_DISCARD filter for
+ * cfg->expiry_ms, the highest scoring classes first, within cfg->slots firmware filters.
+ * Classes on cfg->allow, or that a configured filter keeps while asleep, are never discarded;
+ * e.g. allow {0x0806, 0, 0} to keep ARP. A consumed frame clears the score of its class and
+ * drops its filter.
+ *
+ * Filters are added and removed from the OLM deferred-work executor at the end of the window,
+ * never during a power-mode transition. A reconfiguration removes them; they come back as the
+ * classes score again.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[in]  cfg         Settings, copied; NULL disables and removes the adaptive filters.
+ *
+ * @return RESULT_OK, RESULT_BADARGS if olm has no packet filter offload or cfg is invalid,
+ *         or RESULT_UNSUPPORTED if CY_PF_OL_ADAPT is 0.
+ *
+ */
+int cylpa_pf_ol_adapt(olm_t *olm, const cy_pf_ol_adapt_cfg_t *cfg);
+
+/**
+ * Report a frame received by the host to the adaptive sleep filters. Call from the receive
+ * path of the network stack, not from an interrupt or a power-mode callback.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[in]  frame       Frame, from the start of the Ethernet header.
+ * @param[in]  len         Bytes in frame.
+ * @param[in]  consumed    The application used the frame, e.g. a socket received it.
+ *
+ * @return RESULT_OK, RESULT_BADARGS if olm has no packet filter offload or the frame is
+ *         too short, or RESULT_UNSUPPORTED if CY_PF_OL_ADAPT is 0.
+ *
+ */
+int cylpa_pf_ol_adapt_observe(olm_t *olm, const uint8_t *frame, uint32_t len, bool consumed);
+
+/**
+ * Get the classes tracked by the adaptive sleep filters, e.g. to build the allow-list.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[out] classes     Tracked classes.
+ * @param[in]  max         Entries in classes.
+ * @param[out] count       Entries written to classes, may be NULL.
+ *
+ * @return RESULT_OK, RESULT_BADARGS if olm has no packet filter offload, or
+ *         RESULT_UNSUPPORTED if CY_PF_OL_ADAPT is 0.
+ *
+ */
+int cylpa_pf_ol_adapt_get(olm_t *olm, cy_pf_ol_adapt_class_t *classes, uint32_t max, uint32_t *count);
+
+/**
+ * Keep only the traffic of the sockets in use while asleep.
+ *
+ * On every OL_PM_ST_GOING_TO_SLEEP a CY_PF_ACTIVE_SLEEP keep filter is built for each local
+ * port of the TCP and UDP sockets listed by cylpa_pf_ol_sock_collect(), plus one for each
+ * class of cfg->keep. As the firmware drops what no
+ * active keep filter matches, everything else is discarded. Only the filters that changed
+ * since the last sleep are removed and added; the others stay in the firmware, disabled while
+ * awake.
+ *
+ * If the ports were not collected for the sleep, there are more than CY_PF_OL_SOCK_MAX_PORTS
+ * ports and classes, the filters do not fit in cfg->slots or in the firmware, or an add fails,
+ * the allow-list stays off for that sleep
+ * rather than dropping traffic of a socket. Configured discard filters still apply. Not
+ * available with a sleep policy, see cylpa_pf_ol_policy(). Call while awake.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[in]  cfg         Settings, copied; NULL disables and removes the allow-list filters.
+ *
+ * @return RESULT_OK, RESULT_BADARGS if olm has no packet filter offload, cfg is invalid
+ *         or a sleep policy is in use, or RESULT_UNSUPPORTED if CY_PF_OL_SOCK is 0.
+ *
+ */
+int cylpa_pf_ol_sock_mode(olm_t *olm, const cy_pf_ol_sock_cfg_t *cfg);
+
+/**
+ * List the sockets in use for the socket allow-list of the next sleep.
+ *
+ * The local ports of the TCP and UDP sockets of the network stack the OLM was initialized
+ * with (lwIP or NetXDuo) are read and kept until the next OL_PM_ST_GOING_TO_SLEEP. Call
+ * with the network stack locked (the lwIP core lock or the NetXDuo IP mutex) and no OLM
+ * lock held, before dispatching the sleep, as the network activity handler does when it
+ * suspends the network stack. This way the sleep transition never waits for the network
+ * stack while it holds the OLM locks.
+ *
+ * @param[in]  olm         The Offload Manager.
+ *
+ * @return RESULT_OK, RESULT_BADARGS if olm has no packet filter offload or its allow-list
+ *         is off, or RESULT_UNSUPPORTED if CY_PF_OL_SOCK is 0.
+ *
+ */
+int cylpa_pf_ol_sock_collect(olm_t *olm);
+
+/**
+ * Get a preset of the library. Presets version 1 of the library (CY_PF_OL_PRESETS_VERSION),
+ * all UDP by destination port:
+ * - "mdns": multicast DNS, 5353, IPv4 and IPv6;
+ * - "ssdp": SSDP / UPnP discovery, 1900, IPv4 and IPv6;
+ * - "llmnr": link-local multicast name resolution, 5355, IPv4 and IPv6;
+ * - "netbios": NetBIOS name and datagram services, 137 and 138, IPv4;
+ * - "dhcpv6": DHCPv6 messages to servers and relays, 547, IPv6;
+ * - "wsd": WS-Discovery, 3702, IPv4 and IPv6;
+ * - "noise": all of the above.
+ *
+ * @param[in]  index       0 to the number of presets - 1.
+ *
+ * @return The preset, or NULL past the last one.
+ *
+ */
+const cy_pf_ol_preset_t *cylpa_pf_ol_preset_get(uint32_t index);
+
+/**
+ * Find a preset by name.
+ *
+ * @param[in]  name        Name of the preset.
+ * @param[out] index       Index of the preset, may be NULL.
+ *
+ * @return The preset, or NULL if there is none by that name.
+ *
+ */
+const cy_pf_ol_preset_t *cylpa_pf_ol_preset_find(const char *name, uint32_t *index);
+
+/**
+ * Compile a preset into the filters it takes; prog->count is the number of firmware slots
+ * it consumes. Presets are optimized like any configuration, e.g. a port for both IP
+ * families takes two filters and "noise" fewer than its parts.
+ *
+ * @param[in]  preset      The preset.
+ * @param[in]  bits        CY_PF_ACTIVE_SLEEP and/or CY_PF_ACTIVE_WAKE.
+ * @param[out] prog        Compiled filters, with ids from 0.
+ *
+ * @return RESULT_OK, RESULT_BADARGS, or RESULT_ERROR if the preset does not fit.
+ *
+ */
+int cylpa_pf_ol_preset_compile(const cy_pf_ol_preset_t *preset, uint32_t bits, cy_pf_ol_program_t *prog);
+
+/**
+ * Enable a preset on top of the configured filters, or change when it is active. Its
+ * filters are added now and take ids no configuration entry uses; wake filters are enabled
+ * now, sleep filters at the next sleep. Call while awake.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[in]  name        Name of the preset.
+ * @param[in]  bits        CY_PF_ACTIVE_SLEEP and/or CY_PF_ACTIVE_WAKE.
+ * @param[out] slots       Firmware slots the preset takes, may be NULL.
+ *
+ * @return RESULT_OK, RESULT_BADARGS if olm has no packet filter offload or the preset is
+ *         unknown, RESULT_ERROR if it does not fit in CY_PF_OL_PRESET_MAX_SLOTS or the
+ *         firmware (it is then not enabled), or RESULT_UNSUPPORTED if CY_PF_OL_PRESETS is 0.
+ *
+ */
+int cylpa_pf_ol_preset_enable(olm_t *olm, const char *name, uint32_t bits, uint32_t *slots);
+
+/**
+ * Disable a preset and remove its filters.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[in]  name        Name of the preset.
+ *
+ * @return RESULT_OK, RESULT_BADARGS if olm has no packet filter offload or the preset is
+ *         unknown, or RESULT_UNSUPPORTED if CY_PF_OL_PRESETS is 0.
+ *
+ */
+int cylpa_pf_ol_preset_disable(olm_t *olm, const char *name);
+
+/**
+ * Add a filter at run time, of any feature a configuration entry may have. The rule is
+ * given an id no configuration entry or other filter uses, which its first firmware filter
+ * also takes when free. Filters of a rule active in the current host state are added and
+ * enabled now; those of a sleep-only rule are added at the next sleep transition. The
+ * rule is kept across reconfigurations; pattern and mask must stay valid until it is
+ * removed. Safe against a concurrent power mode transition.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[in]  cfg         The rule; cfg->id is ignored.
+ * @param[out] id          Id of the rule.
+ *
+ * @return RESULT_OK, RESULT_BADARGS if olm has no packet filter offload or the feature is
+ *         not supported, RESULT_ERROR if there is no free rule, id or firmware slot, or
+ *         RESULT_UNSUPPORTED if CY_PF_OL_RULES is 0.
+ *
+ */
+int cylpa_pf_ol_rule_add(olm_t *olm, const cy_pf_ol_cfg_t *cfg, uint8_t *id);
+
+/**
+ * Change when a rule is active and whether it discards. Its filters are replaced, now
+ * or, for a sleep-only rule, at the next sleep transition.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[in]  id          Id of the rule.
+ * @param[in]  bits        CY_PF_ACTIVE_SLEEP, CY_PF_ACTIVE_WAKE and/or CY_PF_ACTION_DISCARD;
+ *                         the other bits of the rule are kept.
+ *
+ * @return RESULT_OK, RESULT_BADARGS if there is no such rule, RESULT_ERROR if the
+ *         filters do not fit; they are then retried at the next transition, or
+ *         RESULT_UNSUPPORTED if CY_PF_OL_RULES is 0.
+ *
+ */
+int cylpa_pf_ol_rule_set_bits(olm_t *olm, uint8_t id, uint32_t bits);
+
+/**
+ * Remove a rule and its filters.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[in]  id          Id of the rule.
+ *
+ * @return RESULT_OK, RESULT_BADARGS if there is no such rule, or RESULT_UNSUPPORTED if
+ *         CY_PF_OL_RULES is 0.
+ *
+ */
+int cylpa_pf_ol_rule_remove(olm_t *olm, uint8_t id);
+
+/**
+ * Build the configuration entries of a default-deny sleep policy: one CY_PF_ACTIVE_SLEEP
+ * keep entry per flow, with ids 0 to count - 1. As the firmware forwards only frames some
+ * keep filter matches once any is enabled, asleep only the flows get through.
+ *
+ * @param[in]  flows       Flows allowed asleep.
+ * @param[in]  count       Entries in flows, 1 to CY_PF_OL_POLICY_MAX_FLOWS.
+ * @param[out] cfg         count + 1 entries, terminated by CY_PF_OL_FEAT_LAST.
+ *
+ * @return RESULT_OK, or RESULT_BADARGS if a flow is invalid or allows all IP traffic.
+ *
+ */
+int cylpa_pf_ol_policy_build(const cy_pf_ol_flow_t *flows, uint32_t count, cy_pf_ol_cfg_t *cfg);
+
+/**
+ * Check a sleep policy without applying it. Probe frames, built from the flows, from the
+ * filters and from common traffic, are run through a model of the firmware holding every
+ * filter active asleep, the policy's included, and through the flows themselves. A
+ * configured or preset discard filter that drops an allowed flow, or a keep filter that lets
+ * more through, is a mismatch.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[in]  flows       Flows allowed asleep; NULL checks the policy in use.
+ * @param[in]  count       Entries in flows.
+ * @param[out] report      Result, may be NULL.
+ *
+ * @return RESULT_OK if the filters and the policy agree on every probe, RESULT_BADARGS if
+ *         olm has no packet filter offload, the socket allow-list is on or the flows are
+ *         invalid, RESULT_ERROR on a mismatch or if the policy does not fit, or
+ *         RESULT_UNSUPPORTED if CY_PF_OL_POLICY is 0.
+ *
+ */
+int cylpa_pf_ol_policy_verify(olm_t *olm, const cy_pf_ol_flow_t *flows, uint32_t count,
+                              cy_pf_ol_policy_report_t *report);
+
+/**
+ * Let only some flows wake the host. The policy is checked as cylpa_pf_ol_policy_verify()
+ * does and applied only if it passes: its keep filters replace those of the policy in use and
+ * are enabled at every sleep. Adaptive filters are dropped and never discard an allowed flow
+ * afterwards. The policy is kept across reconfigurations, dropped if it no longer fits, and
+ * checked again with mismatches logged; filters added later, e.g. presets or rules, are not
+ * checked until cylpa_pf_ol_policy_verify() is called. Not available with the socket
+ * allow-list. Call while awake.
+ *
+ * @param[in]  olm         The Offload Manager.
+ * @param[in]  flows       Flows allowed asleep, copied; NULL removes the policy.
+ * @param[in]  count       Entries in flows.
+ * @param[out] report      Result of the check, may be NULL.
+ *
+ * @return RESULT_OK, RESULT_BADARGS as for cylpa_pf_ol_policy_verify(), or RESULT_ERROR if
+ *         the check fails or the firmware does not take the filters; the policy in use is
+ *         then kept, or removed if the firmware failed. RESULT_UNSUPPORTED if CY_PF_OL_POLICY
+ *         is 0.
+ *
+ */
+int cylpa_pf_ol_policy(olm_t *olm, const cy_pf_ol_flow_t *flows, uint32_t count, cy_pf_ol_policy_report_t *report);
+/** \} */
+
 #define IS_POWER(x) ( (x) && !(x & (x - 1) ) )
 #define ETHER_ADDRESS_LEN      (6)
 CYPRESS_PACKED(struct) ether_header {
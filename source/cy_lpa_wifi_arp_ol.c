@@ -45,7 +45,6 @@
 #include "cy_nw_helper.h"
 #include "cy_nw_lpa_helper.h"
 #include "ip4string.h"
-#include "cy_worker_thread.h"
 #include "whd_wifi_api.h"
 #include "cyabs_rtos.h"
 
@@ -65,10 +64,13 @@ extern "C" {
 #define CY_ARPOL_SHORT_DELAY_FOR_DHCP_MS    (500UL)    /**< Delay (ms) wait after link is up for DHCP to start */
 #define CY_ARPOL_DELAY_FOR_DHCP_MS          (1000UL)    /**< Delay (ms) wait after link is up for DHCP to start */
 #define CY_ARPOL_DHCP_RETRY_COUNT           (25UL)    /**< Number of times to retry getting the IP address */
+#define ARP_OL_SUPPORTED(arp_ol)            ( cylpa_olm_caps_has( (arp_ol)->ol_info_ptr, OL_CAP_ARP ) ) /**< Firmware has ARP offload */
 
 static ol_init_t cylpa_arp_ol_init;            /**< Initialization of an arp_ol instance */
 static ol_deinit_t cylpa_arp_ol_deinit;        /**< Deinitialization of an arp_ol instance */
 static ol_pm_t cylpa_arp_ol_pm;                /**< Power manager change of power status */
+static ol_reconfig_t cylpa_arp_ol_reconfig;    /**< Change of configuration of an arp_ol instance */
+static olm_txn_cb_t cylpa_arp_ol_features_done; /**< Completion of the queued ARP feature set */
 
 /** \} */
 
@@ -84,26 +86,10 @@ const ol_fns_t arp_ol_fns =
     .init = cylpa_arp_ol_init,
     .deinit = cylpa_arp_ol_deinit,
     .pm = cylpa_arp_ol_pm,
+    .flags = OL_FNS_F_TXN,
+    .reconfig = cylpa_arp_ol_reconfig,
 };
 
-/******************************************************************************
- *
- *         Variables
- *
- *****************************************************************************/
-/* Structure for sal callback info */
-static cylpa_nw_ip_status_change_callback_t cy_arp_ol_cb;
-
-/* Timer for waiting for DHCP to get moving after a link up */
-static cy_timer_t cy_delay_dhcp_timer;
-
-/*******************************************************************************
-* Function Prototypes
-*******************************************************************************/
-
-static void cylpa_arp_ol_nw_ip_change_timer_callback(cy_timer_callback_arg_t arg);
-static int cy_dhcp_retry_count = CY_ARPOL_DHCP_RETRY_COUNT;
-
 /******************************************************************************/
 /** \cond SECTION_LPA_INTERNAL */
 /** \addtogroup group_lpa_internal *//** \{ */
@@ -113,8 +99,8 @@ static int cy_dhcp_retry_count = CY_ARPOL_DHCP_RETRY_COUNT;
 * Function Name: cylpa_arp_ol_nw_ip_change_work
 ****************************************************************************//**
 *
-* Called by the worker thread created in cylpa_olm_init() and stored as ol_info_ptr->worker
-* Deferred to the worker thread in cylpa_arp_ol_nw_ip_change_callback() below
+* Run by the OLM executor started in cylpa_olm_init() and stored as ol_info_ptr->worker
+* Deferred to the executor in cylpa_arp_ol_nw_ip_change_callback() below
 *
 * \param iface
 * Opaque sal pointer use for NetworkStack.
@@ -172,7 +158,7 @@ static void cylpa_arp_ol_nw_ip_change_work(void *arg)
         }
         arp_ol->ip_address = addr.ip.v4;
 
-        cy_dhcp_retry_count = CY_ARPOL_DHCP_RETRY_COUNT;
+        arp_ol->dhcp_retry_count = CY_ARPOL_DHCP_RETRY_COUNT;
     }
     else
     {
@@ -200,38 +186,23 @@ static void cylpa_arp_ol_nw_ip_change_work(void *arg)
         {
             if (arp_ol->ip_address == NULL_IP_ADDRESS)
             {
-                if (--cy_dhcp_retry_count > 0)
+                if (--arp_ol->dhcp_retry_count > 0)
                 {
-                    /* Start timer for future to handle timing of DHCP issue */
-                    cy_rtos_start_timer(&cy_delay_dhcp_timer, CY_ARPOL_DELAY_FOR_DHCP_MS);
+                    /* Check again later to handle timing of DHCP issue */
+                    cylpa_olm_exec_submit( (olm_exec_item_t *)&arp_ol->ip_change_work, CY_ARPOL_DELAY_FOR_DHCP_MS);
                 }
             }
         }
     }
 }
 
-/*******************************************************************************
- * Function Name: cylpa_arp_ol_nw_ip_change_timer_callback
- ****************************************************************************/
-
-static void cylpa_arp_ol_nw_ip_change_timer_callback(cy_timer_callback_arg_t arg)
-{
-    arp_ol_t *arp_ol = (arp_ol_t *)arg;
-    cy_rtos_timer_stop(&cy_delay_dhcp_timer);
-    if ( (arp_ol == NULL) || (arp_ol->ol_info_ptr == NULL) || (arp_ol->ol_info_ptr->worker == NULL) )
-    {
-        return;
-    }
-    cy_worker_thread_enqueue(arp_ol->ol_info_ptr->worker, cylpa_arp_ol_nw_ip_change_work, (void *)arg);
-}
-
 /*******************************************************************************
 * Function Name: cylpa_arp_ol_nw_ip_change_callback
 *
 * Initialize the callback with sal in cylpa_arp_ol_init()
 * Register/unregister the callback with sal in cylpa_arp_ol_pm() or cylpa_arp_ol_deinit()
 * Called by sal when sal receives a callback from the NetworkStack
-* We defer calls to the worker thread, if available.
+* We defer calls to the OLM executor, if available.
 *
 * \param iface
 * Opaque sal pointer use for NetworkStack.
@@ -249,8 +220,8 @@ static void cylpa_arp_ol_nw_ip_change_callback(cy_nw_ip_interface_t iface, void
         return;
     }
 
-    /* Start a timer to handle timing of DHCP */
-    cy_rtos_start_timer(&cy_delay_dhcp_timer, CY_ARPOL_SHORT_DELAY_FOR_DHCP_MS);
+    /* Give DHCP time to start; further changes before the check runs are covered by it */
+    cylpa_olm_exec_submit(&arp_ol->ip_change_work, CY_ARPOL_SHORT_DELAY_FOR_DHCP_MS);
     return;
 }
 
@@ -291,6 +262,9 @@ static int cylpa_arp_ol_init(void *ol, ol_info_t *ol_info, const void *cfg)
         return RESULT_BADARGS;
     }
 
+    /* An IP address check of a previous init may still be queued or running */
+    cylpa_olm_exec_cancel_wait(&arp_ol->ip_change_work);
+
     /* clear out structure */
     memset(arp_ol, 0x00, sizeof(arp_ol_t) );
 
@@ -299,6 +273,7 @@ static int cylpa_arp_ol_init(void *ol, ol_info_t *ol_info, const void *cfg)
     arp_ol->config  = (arp_ol_cfg_t *)cfg;
     arp_ol->ol_info_ptr = ol_info;
     arp_ol->state   = ARP_OL_STATE_UNINITIALIZED;
+    arp_ol->dhcp_retry_count = CY_ARPOL_DHCP_RETRY_COUNT;
 
     /* Do not configure ARP offload for new infra */
     if(arp_ol->ol_info_ptr->fw_new_infra)
@@ -308,24 +283,29 @@ static int cylpa_arp_ol_init(void *ol, ol_info_t *ol_info, const void *cfg)
         return RESULT_OK;
     }
 
-    /* Initialize the timer to handle DHCP timing */
-    cy_rtos_init_timer(&cy_delay_dhcp_timer, CY_TIMER_TYPE_ONCE, cylpa_arp_ol_nw_ip_change_timer_callback,
-                       (cy_timer_callback_arg_t)arp_ol);
+    if (!ARP_OL_SUPPORTED(arp_ol) )
+    {
+        OL_LOG_ARP(LOG_OLA_LVL_INFO, "ARP offload is not supported\n");
+        return RESULT_OK;
+    }
+
+    /* Initialize the deferred IP address check, delayed to handle DHCP timing */
+    cylpa_olm_exec_item_init(&arp_ol->ip_change_work, cylpa_arp_ol_nw_ip_change_work, arp_ol, OLM_EXEC_PRIO_NORMAL);
 
     /* Initialize the SAL IP change callback
      * - registered in the PM change callback below
      * - only used if SNOOP is off
      */
-    cylpa_nw_ip_initialize_status_change_callback(&cy_arp_ol_cb, cylpa_arp_ol_nw_ip_change_callback, arp_ol);
+    cylpa_nw_ip_initialize_status_change_callback(&arp_ol->ip_change_cb, cylpa_arp_ol_nw_ip_change_callback, arp_ol);
 
-    /* Clear out all ARP Offload features */
-    whd_arp_arpoe_set(arp_ol->ol_info_ptr->whd, 1);
-    whd_arp_features_set(arp_ol->ol_info_ptr->whd, 0);
+    /* Clear out all ARP Offload features (through the OLM shadow so it stays in sync) */
+    cylpa_olm_shadow_set_iovar_value(arp_ol->ol_info_ptr->whd, IOVAR_STR_ARPOE, 1);
+    cylpa_olm_shadow_set_iovar_value(arp_ol->ol_info_ptr->whd, IOVAR_STR_ARP_OL, 0);
     whd_arp_cache_clear(arp_ol->ol_info_ptr->whd);
     whd_arp_stats_clear(arp_ol->ol_info_ptr->whd);
     whd_arp_hostip_list_clear(arp_ol->ol_info_ptr->whd);
-    whd_arp_peerage_set(arp_ol->ol_info_ptr->whd, arp_ol->config->peerage);
-    whd_arp_arpoe_set(arp_ol->ol_info_ptr->whd, 0);
+    cylpa_olm_shadow_set_iovar_value(arp_ol->ol_info_ptr->whd, IOVAR_STR_ARP_PEERAGE, arp_ol->config->peerage);
+    cylpa_olm_shadow_set_iovar_value(arp_ol->ol_info_ptr->whd, IOVAR_STR_ARPOE, 0);
 
     /* TODO: We get here only if we are awake! Do we start up features as if we just woke up? */
     cylpa_arp_ol_pm(arp_ol, OL_PM_ST_AWAKE);
@@ -355,7 +335,7 @@ static void cylpa_arp_ol_deinit(void *ol)
         return;
     }
 
-    if(arp_ol->ol_info_ptr->fw_new_infra)
+    if( (arp_ol->ol_info_ptr->fw_new_infra) || !ARP_OL_SUPPORTED(arp_ol) )
     {
         return;
     }
@@ -363,12 +343,12 @@ static void cylpa_arp_ol_deinit(void *ol)
     arp_ol->state   = ARP_OL_STATE_UNINITIALIZED;
 
     /* Un-register the ip change callback with sal api */
-    cylpa_nw_ip_unregister_status_change_callback( (uintptr_t)arp_ol->ol_info_ptr->ip, &cy_arp_ol_cb );
-    /* deinit timer */
-    cy_rtos_deinit_timer(&cy_delay_dhcp_timer);
+    cylpa_nw_ip_unregister_status_change_callback( (uintptr_t)arp_ol->ol_info_ptr->ip, &arp_ol->ip_change_cb );
+    /* drop a pending IP address check */
+    cylpa_olm_exec_cancel_wait(&arp_ol->ip_change_work);
 
     /* Turn off ARP OL when we de-init ? */
-    whd_arp_arpoe_set(arp_ol->ol_info_ptr->whd, 0);
+    cylpa_olm_shadow_set_iovar_value(arp_ol->ol_info_ptr->whd, IOVAR_STR_ARPOE, 0);
 }
 
 /*******************************************************************************
@@ -401,6 +381,11 @@ static void cylpa_arp_ol_pm(void *ol, ol_pm_st_t st)
         return;
     }
 
+    if (!ARP_OL_SUPPORTED(arp_ol) )
+    {
+        return;
+    }
+
     if ( arp_ol->config == NULL )
     {
         OL_LOG_ARP(LOG_OLA_LVL_ERR, "cylpa_arp_ol_pm() Bad Args!\n");
@@ -429,7 +414,7 @@ static void cylpa_arp_ol_pm(void *ol, ol_pm_st_t st)
     if ( (arp_ol->state == ARP_OL_STATE_UNINITIALIZED) ||
          (arp_ol->config->awake_enable_mask != arp_ol->config->sleep_enable_mask) )
     {
-        cylpa_nw_ip_register_status_change_callback( (uintptr_t)arp_ol->ol_info_ptr->ip, &cy_arp_ol_cb );
+        cylpa_nw_ip_register_status_change_callback( (uintptr_t)arp_ol->ol_info_ptr->ip, &arp_ol->ip_change_cb );
 
         /* check that AGENT is on if HOST_AUTO_REPLY or PEER_AUTO_REPLY is on */
         if ( (enable_flags & (CY_ARP_OL_HOST_AUTO_REPLY_ENABLE | CY_ARP_OL_PEER_AUTO_REPLY_ENABLE) ) != 0 )
@@ -438,26 +423,97 @@ static void cylpa_arp_ol_pm(void *ol, ol_pm_st_t st)
         }
 
         /* enable ARP Offload */
-        whd_arp_arpoe_set(arp_ol->ol_info_ptr->whd, 1);
+        cylpa_olm_txn_set_iovar_value(arp_ol->ol_info_ptr->txn, arp_ol->ol_info_ptr->whd, IOVAR_STR_ARPOE, 1,
+                                      NULL, NULL);
 
         /* set the features */
         OL_LOG_ARP(LOG_OLA_LVL_DEBUG, "whd_arp_features_set(0x%x)!\n", enable_flags);
-        if (whd_arp_features_set(arp_ol->ol_info_ptr->whd, enable_flags) != WHD_SUCCESS)
-        {
-            OL_LOG_ARP(LOG_OLA_LVL_DEBUG, "cylpa_arp_ol_pm() whd_arp_features_set() Failed!\n");
-        }
+        cylpa_olm_txn_set_iovar_value(arp_ol->ol_info_ptr->txn, arp_ol->ol_info_ptr->whd, IOVAR_STR_ARP_OL,
+                                      enable_flags, cylpa_arp_ol_features_done, NULL);
     }
     else
     {
         /* disable features */
-        whd_arp_features_set(arp_ol->ol_info_ptr->whd, 0);
+        cylpa_olm_txn_set_iovar_value(arp_ol->ol_info_ptr->txn, arp_ol->ol_info_ptr->whd, IOVAR_STR_ARP_OL, 0,
+                                      NULL, NULL);
 
         /* disable ARP Offload */
-        whd_arp_arpoe_set(arp_ol->ol_info_ptr->whd, 0);
+        cylpa_olm_txn_set_iovar_value(arp_ol->ol_info_ptr->txn, arp_ol->ol_info_ptr->whd, IOVAR_STR_ARPOE, 0,
+                                      NULL, NULL);
     }
     arp_ol->state   = new_arp_ol_state;
 }
 
+/*******************************************************************************
+* Function Name: cylpa_arp_ol_reconfig
+****************************************************************************//**
+*
+* Change the configuration of an ARP OL instance while awake.
+* The host IP list and the SAL callback are kept; the peerage and the awake
+* features are written through the OLM shadow, so only what changed is sent.
+*
+* \param ol
+* Pointer to arp_ol_t structure.
+*
+* \param cfg
+* Pointer to the new arp_ol_cfg_t structure.
+*
+*******************************************************************************/
+static int cylpa_arp_ol_reconfig(void *ol, const void *cfg)
+{
+    arp_ol_t *arp_ol = (arp_ol_t *)ol;
+    arp_ol_enable_mask_t enable_flags;
+
+    if ( (arp_ol == NULL) || (arp_ol->ol_info_ptr == NULL) || (cfg == NULL) )
+    {
+        return RESULT_BADARGS;
+    }
+
+    arp_ol->config = (arp_ol_cfg_t *)cfg;
+    if ( (arp_ol->ol_info_ptr->fw_new_infra) || !ARP_OL_SUPPORTED(arp_ol) )
+    {
+        return RESULT_OK;
+    }
+
+    cylpa_olm_shadow_set_iovar_value(arp_ol->ol_info_ptr->whd, IOVAR_STR_ARP_PEERAGE, arp_ol->config->peerage);
+
+    if (arp_ol->state == ARP_OL_STATE_AWAKE)
+    {
+        /* As cylpa_arp_ol_pm() set it for the awake state */
+        enable_flags = arp_ol->config->awake_enable_mask;
+        if ( (enable_flags & (CY_ARP_OL_HOST_AUTO_REPLY_ENABLE | CY_ARP_OL_PEER_AUTO_REPLY_ENABLE) ) != 0 )
+        {
+            enable_flags |= CY_ARP_OL_AGENT_ENABLE;
+        }
+        cylpa_olm_txn_set_iovar_value(NULL, arp_ol->ol_info_ptr->whd, IOVAR_STR_ARPOE, 1, NULL, NULL);
+        cylpa_olm_txn_set_iovar_value(NULL, arp_ol->ol_info_ptr->whd, IOVAR_STR_ARP_OL, enable_flags,
+                                      cylpa_arp_ol_features_done, NULL);
+    }
+
+    return RESULT_OK;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_arp_ol_features_done
+****************************************************************************//**
+*
+* Completion of the ARP feature set queued by cylpa_arp_ol_pm().
+*
+* \param arg
+* Unused.
+*
+* \param result
+* whd_result_t of the IOVAR.
+*
+*******************************************************************************/
+static void cylpa_arp_ol_features_done(void *arg, uint32_t result)
+{
+    if (result != WHD_SUCCESS)
+    {
+        OL_LOG_ARP(LOG_OLA_LVL_DEBUG, "cylpa_arp_ol_pm() whd_arp_features_set() Failed!\n");
+    }
+}
+
 /** \} \endcond SECTION_LPA_INTERNAL */
 
 #ifdef __cplusplus
@@ -38,6 +38,7 @@
 #include "cy_lpa_wifi_ol.h"
 #include "cy_lpa_wifi_ol_priv.h"
 #include "cy_lpa_wifi_nko_ol.h"
+#include "cy_lpa_wifi_arp_ol.h"
 #include "cy_lpa_wifi_result.h"
 
 #include "whd_wifi_api.h"
@@ -116,15 +117,21 @@ static cy_lpa_nko_ol_cfg_t cy_nko_ol_cfg = {
     .payload  = "",
 };
 
+/* ARP and NKO both register the WCM IP change callback (cy_nw_lpa_helper), which
+ * is not safe to do from two threads at once; initialize NKO after ARP.
+ */
+static const ol_fns_t * const cylpa_nko_ol_deps[] = { &arp_ol_fns, NULL };
+
 const ol_fns_t nko_ol_fns =
 {
     .init   = cylpa_nko_ol_init,
     .deinit = cylpa_nko_ol_deinit,
     .pm     = cylpa_nko_ol_pm,
+    .deps   = cylpa_nko_ol_deps,
 };
 
+/* Instance changed by cylpa_nko_ol_update_config(); the last one initialized */
 static nko_ol_t *nko_ctx = NULL;
-static cylpa_nw_ip_status_change_callback_t cy_nko_ol_cb;
 
 /*******************************************************************************
 * Function Name: cylpa_nko_get_details
@@ -471,8 +478,8 @@ static int cylpa_nko_ol_init(void *ol, ol_info_t *info, const void *cfg)
     memcpy(&cy_nko_ol_cfg, ctxt->cfg, sizeof(cy_nko_ol_cfg));
 
     /* Register for IP change */
-    cylpa_nw_ip_initialize_status_change_callback(&cy_nko_ol_cb, cylpa_nko_ol_nw_ip_change_callback, ctxt);
-    cylpa_nw_ip_register_status_change_callback((uintptr_t)ctxt->ol_info_ptr->ip, &cy_nko_ol_cb);
+    cylpa_nw_ip_initialize_status_change_callback(&ctxt->ip_change_cb, cylpa_nko_ol_nw_ip_change_callback, ctxt);
+    cylpa_nw_ip_register_status_change_callback((uintptr_t)ctxt->ol_info_ptr->ip, &ctxt->ip_change_cb);
 
     nko_ctx = ctxt;
 
@@ -505,12 +512,15 @@ static void cylpa_nko_ol_deinit(void *ol)
     }
 
     /* Deregister IP change callback */
-    cylpa_nw_ip_unregister_status_change_callback((uintptr_t)ctxt->ol_info_ptr->ip, &cy_nko_ol_cb);
+    cylpa_nw_ip_unregister_status_change_callback((uintptr_t)ctxt->ol_info_ptr->ip, &ctxt->ip_change_cb);
 
     /* Disable NAT Keep Alive */
     cylpa_nko_ol_disable_nat_keep_alive(ctxt);
 
-    nko_ctx =  NULL;
+    if (nko_ctx == ctxt)
+    {
+        nko_ctx =  NULL;
+    }
 }
 
 /*******************************************************************************
@@ -41,6 +41,7 @@ extern "C" {
 #endif
 
 
+#include <stdarg.h>
 #include "cy_lpa_wifi_ol_common.h"  /* for ol_info_t */
 #include "cy_lpa_wifi_olm.h"        /* for olm_t */
 
@@ -83,6 +84,23 @@ typedef void (ol_deinit_t)(void *ol);
  */
 typedef void (ol_pm_t)(void *ol, ol_pm_st_t pm_state);
 
+/**< Offload reconfiguration function
+ *
+ * Offload moves from the configuration it was initialized (or last
+ * reconfigured) with to cfg, issuing only the IOVARs for what differs.
+ * Called with the host awake, outside the OLM transaction.
+ *
+ * Returns RESULT_UNSUPPORTED if the offload cannot be changed in place;
+ * the Offload Manager then deinitializes and initializes it with cfg.
+ */
+typedef int (ol_reconfig_t)(void *ol, const void *cfg);
+
+/**< The pm handler queues its IOVARs on ol_info_t::txn instead of issuing them.
+ * Handlers without this flag are run by the Offload Manager at their place in the
+ * transaction, after the IOVARs queued before them have been issued.
+ */
+#define OL_FNS_F_TXN        (1UL << 0)
+
 /**< Offload function pointer table
  *
  * Offload must define an implementation for each table entry.
@@ -92,11 +110,234 @@ struct ol_fns
     ol_init_t *init;        /**< Offload initialization function. */
     ol_deinit_t *deinit;    /**< Offload deinitialization function. */
     ol_pm_t *pm;            /**< Offload host power-mode changed handler function. */
+    uint32_t flags;         /**< OL_FNS_F_* */
+    const struct ol_fns * const *deps; /**< NULL-terminated offloads whose init must complete first, or NULL.
+                                        *   Offloads without a dependency between them may be
+                                        *   initialized concurrently. */
+    ol_reconfig_t *reconfig; /**< Offload reconfiguration function, or NULL to reinitialize instead. */
 };
 
 /**< Offload power management notification */
 void cylpa_olm_dispatch_pm_notification(olm_t *olm, ol_pm_st_t st);
 
+/**< Defer a non-critical operation to the next sleep transition.
+ *
+ * May be called from an offload init function. fn runs from the power-mode dispatch,
+ * in the OLM transaction, before the offloads are notified. If the deferred list is
+ * full, fn runs immediately.
+ */
+void cylpa_olm_defer(ol_info_t *ol_info, olm_txn_fn_t *fn, void *arg, uint32_t param);
+
+/**< Drop the deferred operations whose arg is arg (an offload being unregistered) */
+void cylpa_olm_defer_cancel(olm_t *olm, void *arg);
+
+/**< Empty the offload registry; called by cylpa_olm_init() */
+void cylpa_olm_reg_reset(olm_t *olm);
+
+/**< Register an offload without initializing it; OLM_HANDLE_INVALID if the registry is full */
+olm_handle_t cylpa_olm_reg_add(olm_t *olm, const struct ol_desc *desc);
+
+/**< Registry slot of a handle; OLM_MAX_OFFLOADS if the handle is stale */
+uint32_t cylpa_olm_reg_slot(const olm_t *olm, olm_handle_t handle);
+
+/**< Serialize with register, unregister, reconfigure and the PM dispatch of every OLM; recursive */
+void cylpa_olm_reg_lock(void);
+
+/**< Undo cylpa_olm_reg_lock() */
+void cylpa_olm_reg_unlock(void);
+
+/**< Open a transaction; operations queued on it are issued by cylpa_olm_txn_flush() */
+void cylpa_olm_txn_begin(olm_txn_t *txn, void *whd);
+
+/**< Issue all queued operations, hand each result to its callback and reset the transaction */
+void cylpa_olm_txn_flush(olm_txn_t *txn);
+
+/**< Queue a uint32_t IOVAR set.
+ *
+ * If txn is NULL or open on another interface, the IOVAR is issued immediately on whd
+ * and the callback runs before this function returns. If txn is full, the queued
+ * operations are flushed first. The same applies to all cylpa_olm_txn_* functions.
+ * Returns RESULT_OK when queued or issued successfully, RESULT_ERROR otherwise.
+ */
+int cylpa_olm_txn_set_iovar_value(olm_txn_t *txn, void *whd, const char *iovar, uint32_t value,
+                                  olm_txn_cb_t *cb, void *cb_arg);
+
+/**< Queue an IOVAR set with a buffer; the payload is copied */
+int cylpa_olm_txn_set_iovar_buffer(olm_txn_t *txn, void *whd, const char *iovar, const void *data, uint16_t len,
+                                   olm_txn_cb_t *cb, void *cb_arg);
+
+/**< Queue a packet filter enable or disable */
+int cylpa_olm_txn_pf_enable(olm_txn_t *txn, void *whd, uint8_t id, bool enable, olm_txn_cb_t *cb, void *cb_arg);
+
+/**< Queue a call into WHD that cannot be expressed as a single IOVAR; runs in queue order */
+int cylpa_olm_txn_call(olm_txn_t *txn, void *whd, olm_txn_fn_t *fn, void *arg, uint32_t param,
+                       olm_txn_cb_t *cb, void *cb_arg);
+
+/**< Submit several IOVAR sets in one bus transaction.
+ *
+ * Weak; the default returns RESULT_UNSUPPORTED and the transaction falls back to
+ * issuing each IOVAR on its own. A platform whose firmware accepts a batch command
+ * overrides this and fills results[] (whd_result_t) for each entry on RESULT_OK.
+ * No released firmware does, so on a target only the superseded IOVARs and those
+ * the shadow knows the firmware holds are saved; the rest cost one bus transaction each.
+ */
+int cylpa_olm_txn_submit_batch(void *whd, const olm_txn_iovar_t *iovars, uint32_t count, uint32_t *results);
+
+/**< IOVAR carrying packet filter enable/disable; shadow key of a filter's enable state (index = filter id) */
+#define OLM_TXN_IOVAR_PKT_FILTER_ENABLE     "pkt_filter_enable"
+
+/**< Firmware state shadow counters */
+typedef struct olm_shadow_stats
+{
+    uint32_t hits;          /**< IOVARs not sent because the firmware already holds the value */
+    uint32_t misses;        /**< IOVARs that had to be sent */
+    uint32_t invalidations; /**< Times the whole shadow was dropped */
+} olm_shadow_stats_t;
+
+/**< Prepare the shadow for use from several threads; called by cylpa_olm_init() */
+void cylpa_olm_shadow_init(void);
+
+/**< Forget everything known about the firmware state.
+ *
+ * Called on firmware (re)initialization and by the WHD event handler on
+ * disassociation or link change. Safe to call from any thread.
+ */
+void cylpa_olm_shadow_invalidate(void);
+
+/**< Forget one value, e.g. after a write that bypassed the shadow */
+void cylpa_olm_shadow_forget(void *whd, const char *iovar, uint32_t index);
+
+/**< Return true if the firmware is known to hold data for (whd, iovar, index).
+ * iovar must point to storage that outlives the entry (a string literal or IOVAR_STR_*).
+ */
+bool cylpa_olm_shadow_match(void *whd, const char *iovar, uint32_t index, const void *data, uint8_t len);
+
+/**< Copy the known value of (whd, iovar, index) into data; return false if unknown */
+bool cylpa_olm_shadow_read(void *whd, const char *iovar, uint32_t index, void *data, uint8_t len);
+
+/**< Record a value the firmware accepted */
+void cylpa_olm_shadow_store(void *whd, const char *iovar, uint32_t index, const void *data, uint8_t len);
+
+/**< whd_wifi_set_iovar_value() that is skipped when the firmware already holds value */
+uint32_t cylpa_olm_shadow_set_iovar_value(void *whd, const char *iovar, uint32_t value);
+
+/**< whd_wifi_get_iovar_value() answered from the shadow when the value is known */
+uint32_t cylpa_olm_shadow_get_iovar_value(void *whd, const char *iovar, uint32_t *value);
+
+/**< Register for the WHD events that invalidate the shadow on whd */
+void cylpa_olm_shadow_attach(void *whd);
+
+/**< Undo cylpa_olm_shadow_attach() for whd, or for every interface if whd is NULL */
+void cylpa_olm_shadow_detach(void *whd);
+
+/**< Read the shadow counters */
+void cylpa_olm_shadow_get_stats(olm_shadow_stats_t *stats);
+
+/**< Probe the firmware capabilities of ol_info->whd into ol_info->caps; sets ol_info->fw_new_infra */
+void cylpa_olm_caps_probe(ol_info_t *ol_info);
+
+/**< True if the firmware supports cap (OL_CAP_*); true as well if it could not be probed */
+bool cylpa_olm_caps_has(const ol_info_t *ol_info, uint32_t cap);
+
+/**< False if the firmware is known to have no free slot; the add would fail */
+bool cylpa_olm_caps_slot_available(const ol_info_t *ol_info, ol_caps_slot_t slot);
+
+/**< Account for the WHD result of an add: take a slot, or learn the slot count if the firmware is full */
+void cylpa_olm_caps_slot_added(ol_info_t *ol_info, ol_caps_slot_t slot, uint32_t whd_result);
+
+/**< Give back a slot after a successful remove */
+void cylpa_olm_caps_slot_removed(ol_info_t *ol_info, ol_caps_slot_t slot);
+
+/**< Give back every slot of a resource after the firmware list was cleared */
+void cylpa_olm_caps_slots_reset(ol_info_t *ol_info, ol_caps_slot_t slot);
+
+/**< Start the deferred-work executor for an Offload Manager; returns the value for ol_info_t::worker.
+ *
+ * worker is the current ol_info_t::worker; if it is already the executor it is returned
+ * unchanged. The executor thread (OLM_EXEC_THREAD) is created for the first user.
+ */
+void *cylpa_olm_exec_start(void *worker);
+
+/**< Undo cylpa_olm_exec_start(); returns NULL. The thread is deleted with the last user */
+void *cylpa_olm_exec_stop(void *worker);
+
+/**< Prepare an item for cylpa_olm_exec_submit() */
+void cylpa_olm_exec_item_init(olm_exec_item_t *item, olm_exec_fn_t *fn, void *arg, olm_exec_prio_t priority);
+
+/**< Run item->fn after delay_ms.
+ *
+ * If the item is already pending it is not queued again; it keeps its due time,
+ * unless delay_ms makes it due earlier. fn may submit its own item again.
+ * Not callable from an interrupt.
+ */
+int cylpa_olm_exec_submit(olm_exec_item_t *item, uint32_t delay_ms);
+
+/**< Remove a pending item; does not wait for a run already in progress */
+void cylpa_olm_exec_cancel(olm_exec_item_t *item);
+
+/**< Remove a pending item and wait for a run already in progress to return.
+ *
+ * Needed before the memory of the item is cleared or reused. The item is not
+ * accepted by cylpa_olm_exec_submit() until prepared again. Must not be called
+ * from the item's own function, nor while holding a lock that function takes.
+ */
+void cylpa_olm_exec_cancel_wait(olm_exec_item_t *item);
+
+/**< Microsecond timestamp of the latency histograms; wraps.
+ *
+ * Weak; the default is derived from the RTOS millisecond tick. A platform with a
+ * cycle counter or a free-running timer overrides this for sub-millisecond samples.
+ */
+uint32_t cylpa_olm_latency_now_us(void);
+
+/**< Add a sample to the histogram of registry slot idx (OLM_MAX_OFFLOADS for the whole OLM) */
+void cylpa_olm_latency_record(olm_t *olm, uint32_t idx, olm_latency_id_t id, uint32_t elapsed_us);
+
+struct cy_pf_ol_adapt;
+struct cy_pf_ol_adapt_class;
+struct cy_pf_ol_class;
+struct cy_pf_ol_filter;
+
+/**< Charge a frame received at now_ms to its class; the adaptive state of a packet filter offload */
+void cylpa_pf_adapt_charge(struct cy_pf_ol_adapt *ad, const struct cy_pf_ol_class *cls, bool consumed, uint32_t now_ms);
+
+/**< The class to discard next: highest score at or above the threshold, not allowed, filtered or blocked */
+struct cy_pf_ol_adapt_class *cylpa_pf_adapt_worst(struct cy_pf_ol_adapt *ad);
+
+/**< True if some frame matches both filters */
+bool cylpa_pf_adapt_overlaps(const struct cy_pf_ol_filter *a, const struct cy_pf_ol_filter *b);
+
+struct cy_pf_ol_flow;
+struct cy_pf_ol_policy_report;
+
+#define CYLPA_PF_POLICY_MAX_SETS    (6)
+
+/**< Filters a packet filter offload would hold asleep, by source, as checked by the policy verifier */
+typedef struct cylpa_pf_policy_view
+{
+    const struct cy_pf_ol_filter *filters[CYLPA_PF_POLICY_MAX_SETS];    /**< Filters of each source */
+    uint32_t counts[CYLPA_PF_POLICY_MAX_SETS];                          /**< Entries of each source */
+    uint32_t sets;                                                      /**< Sources in use */
+} cylpa_pf_policy_view_t;
+
+/**< Check the filters active asleep in view against the flows of a sleep policy */
+int cylpa_pf_policy_verify(const struct cy_pf_ol_flow *flows, uint32_t count, const cylpa_pf_policy_view_t *view,
+                           struct cy_pf_ol_policy_report *report);
+
+#if defined(OLM_LOG_ENABLED)
+/**< Store a log record in the trace ring; formatted later by ol_log_drain() */
+int ol_log_trace(LOG_OFFLOAD_ASSIST_T assist, LOG_OFFLOAD_ASSIST_LEVEL_T level, const char *fmt, va_list args);
+#endif
+
+#if (OLM_LATENCY_STATS != 0)
+#define OLM_LATENCY_NOW()                       cylpa_olm_latency_now_us()
+#define OLM_LATENCY_RECORD(olm, idx, id, start) \
+    cylpa_olm_latency_record( (olm), (idx), (id), cylpa_olm_latency_now_us() - (start) )
+#else
+#define OLM_LATENCY_NOW()                       (0)
+#define OLM_LATENCY_RECORD(olm, idx, id, start) ( (void)(olm), (void)(idx), (void)(id), (void)(start) )
+#endif
+
 /** \} */
 
 #ifdef __cplusplus
@@ -42,18 +42,49 @@
 #include "cy_lpa_wifi_ol_priv.h"
 #include "whd_int.h"
 
-#include "cy_worker_thread.h"
+#include "cyabs_rtos.h"
 
 #include <stdarg.h>
+#include <stddef.h>
 
-/* global flag to check for whd instance creation */
-bool cy_olm_whd_instance_created = false;
-
-/* pm2 sleep return value before going to sleep */
+/* pm2 sleep return value before going to sleep, as read by cylpa_olm_configure_wlan_pmode() */
 uint32_t cy_pm2_sleep_ret_value;
 
 static const ol_desc_t cy_null_ol_list = {NULL, NULL, NULL, NULL};
 
+const olm_wlan_profile_t cy_olm_wlan_profiles[OLM_WLAN_PROFILE_MAX] =
+{
+    [OLM_WLAN_PROFILE_DEFAULT] =
+    {
+        .name = "telemetry",
+        .bcntrim = LPA_BCNTRIM,
+        .bcn_wait_period = LPA_BCN_WAIT_PERIOD,
+        .bcn_reacquire_start = LPA_BCN_REACQUIRE_START,
+        .roam_time_threshold = LPA_ROAM_TIME_THRESHOLD,
+        .pm2_sleep_ret = LPA_PM2_SLEEP_RET_TIME,
+    },
+    /* Every beacon is received and the radio stays up between bursts of a handshake */
+    [OLM_WLAN_PROFILE_COMMISSIONING] =
+    {
+        .name = "commissioning",
+        .bcntrim = 1,
+        .bcn_wait_period = 20,
+        .bcn_reacquire_start = 2,
+        .roam_time_threshold = 3,
+        .pm2_sleep_ret = 200,
+    },
+    /* Longest beacon trim; loss of the AP is tolerated for longer before roaming */
+    [OLM_WLAN_PROFILE_BATTERY_CRITICAL] =
+    {
+        .name = "battery-critical",
+        .bcntrim = 10,
+        .bcn_wait_period = 8,
+        .bcn_reacquire_start = 6,
+        .roam_time_threshold = 8,
+        .pm2_sleep_ret = 10,
+    },
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -61,31 +92,66 @@ extern "C" {
 /*******************************************************************************
 * Local definition
 *******************************************************************************/
-#define OLM_WORKER_THREAD_STACK_SIZE    (6 * 1024)  /* >4k needed for printf()calls in worker thread */
-
-static cy_worker_thread_info_t cy_olm_worker_thread;
-
-/* Define a stack buffer so we don't require a malloc when creating our worker thread Aligned on 8-byte boundary! */
-__attribute__((aligned(CY_RTOS_ALIGNMENT))) static uint8_t cy_olm_worker_thread_stack[OLM_WORKER_THREAD_STACK_SIZE];
-
-static cy_worker_thread_params_t cy_olm_thread_params =
+#define OLM_IOVAR_PM2_SLEEP_RET         "pm2_sleep_ret"
+#define OLM_IOVAR_BCNTRIM               "bcntrim"
+#define OLM_IOVAR_BCN_WAIT_PRD          "bcn_wait_prd"
+#define OLM_IOVAR_BCN_REACQUIRE_START   "bcn_reacquire_start"
+#define OLM_IOVAR_ROAM_TIME_THRESH      "roam_time_thresh"
+
+/* Argument of cylpa_olm_txn_pm(): offload registry slot and power-mode state */
+#define OLM_TXN_PM_PARAM(idx, st)       ( ( (uint32_t)(idx) << 8 ) | (uint32_t)(st) )
+#define OLM_TXN_PM_PARAM_IDX(param)     ( (param) >> 8 )
+#define OLM_TXN_PM_PARAM_ST(param)      ( (ol_pm_st_t)( (param) & 0xFF ) )
+
+/* Initialization state of an offload in cylpa_olm_init_ols() */
+typedef enum olm_init_st
 {
-    /*
-     * CY_WORKER_THREAD_PRIORITY_BELOW_NORMAL does not work for EventQueue->dispatch()
-     * 1st deferred function is called, second is not called.
-     * EventQueue->time_left first call returns -1,  indicated completed
-     * EventQueue->time_left second call returns  0, indicating event is already due to be dispatched or is currently executing.
-     */
-    .priority = CY_RTOS_PRIORITY_NORMAL,
-    .stack_size = sizeof(cy_olm_worker_thread_stack),
-    .stack = cy_olm_worker_thread_stack,
-    .name = "OLM Worker",
-    .num_entries = 0
-};
+    OLM_INIT_ST_PENDING = 0,
+    OLM_INIT_ST_RUNNING,
+    OLM_INIT_ST_DONE,
+    OLM_INIT_ST_FAILED,
+} olm_init_st_t;
+
+/* One offload init, run on the calling thread or on the OLM executor thread */
+typedef struct olm_init_job
+{
+    const ol_desc_t *desc;
+    ol_info_t       *info;
+    olm_t           *olm;
+    uint32_t        slot;               /* registry slot */
+    cy_semaphore_t  *done;              /* set when run on the executor thread, else NULL */
+    olm_exec_item_t item;               /* submitted to the executor when done is set */
+    int             result;
+    volatile olm_init_st_t state;
+} olm_init_job_t;
+
+/* Shared by all Offload Managers; cylpa_olm_init_ols() runs one at a time */
+static olm_init_job_t cy_olm_init_jobs[OLM_MAX_OFFLOADS];
+static cy_mutex_t cy_olm_init_mutex;
+static bool cy_olm_init_mutex_init = false;
+
+#define OLM_PM2_SLEEP_RET_MIN           (10)    /* PM2_SLEEP_RET_TIME_MIN, WHD allowed */
+#define OLM_PM2_SLEEP_RET_MAX           (2000)  /* PM2_SLEEP_RET_TIME_MAX, WHD allowed */
+#define OLM_BCNTRIM_MAX                 (10)
+
+/* Guards olm_t::deferred; offload inits may defer concurrently */
+static cy_mutex_t cy_olm_defer_mutex;
+static bool cy_olm_defer_mutex_init = false;
 
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
+static uint32_t cylpa_olm_txn_configure_wlan_pmode(void *whd, void *arg, uint32_t value);
+static uint32_t cylpa_olm_txn_pm(void *whd, void *arg, uint32_t param);
+static uint32_t cylpa_olm_txn_init_wlan_config(void *whd, void *arg, uint32_t param);
+#if defined(OLM_LOG_ENABLED)
+static uint32_t cylpa_olm_txn_verify_wlan_config(void *whd, void *arg, uint32_t param);
+#endif
+static void cylpa_olm_config_wlan(olm_t *olm);
+static uint32_t cylpa_olm_apply_wlan_profile(void *whd, const olm_wlan_profile_t *profile);
+static void cylpa_olm_set_wlan_pmode(void *whd, uint32_t value, uint32_t *saved);
+static void cylpa_olm_init_job_run(void *arg);
+static bool cylpa_olm_init_job_ready(uint32_t count, uint32_t idx);
 
 /******************************************************************************/
 /** \addtogroup group_lpa_high_level *//** \{ */
@@ -113,7 +179,7 @@ void cylpa_olm_init(olm_t *olm, const ol_desc_t *ol_list)
 {
     whd_interface_t iface = NULL;
     ol_info_t *olm_info = NULL;
-    uint32_t value = 0;
+    const ol_desc_t *it;
 
     if (olm == NULL)
     {
@@ -126,36 +192,57 @@ void cylpa_olm_init(olm_t *olm, const ol_desc_t *ol_list)
 
     olm->ol_list = ol_list ? ol_list : &cy_null_ol_list;
 
-    if (whd_wifi_get_fwcap(olm_info->whd, &value) == WHD_SUCCESS)
+    /* The list is the initial content of the registry */
+    olm->ols_up = false;
+    cylpa_olm_reg_reset(olm);
+    for (it = olm->ol_list; it->fns; it++)
     {
-        if (value & (1 << WHD_FWCAP_OFFLOADS) )
-        {
-            olm->ol_info.fw_new_infra = 1;
-        }
-        else
+        if (cylpa_olm_reg_add(olm, it) == OLM_HANDLE_INVALID)
         {
-            olm->ol_info.fw_new_infra = 0;
+            OL_LOG_OLM(LOG_OLA_LVL_ERR, "cylpa_olm_init() more than OLM_MAX_OFFLOADS (%d) offloads\n", OLM_MAX_OFFLOADS);
+            olm->reg.overflow = true;
+            break;
         }
     }
 
-    /* Create worker thread only for old infra to handle callbacks */
-    if ( olm->ol_info.fw_new_infra == 0 )
+    /* Firmware was (re)loaded; nothing written before is known to be there */
+    cylpa_olm_shadow_init();
+    cylpa_olm_shadow_invalidate();
+
+    if (!cy_olm_defer_mutex_init)
     {
-        if (cy_olm_worker_thread.state != CY_WORKER_THREAD_VALID)
-        {
-            cy_worker_thread_create(&cy_olm_worker_thread, &cy_olm_thread_params);
-        }
-        olm->ol_info.worker = &cy_olm_worker_thread;
-        OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "cylpa_olm_init()  olm:%p ol_list:%p worker:%p state:0x%lx whd:%x\n", (void *)olm, (void *)ol_list,
-                   olm->ol_info.worker, cy_olm_worker_thread.state, olm->ol_info.whd);
+        cy_olm_defer_mutex_init = (cy_rtos_init_mutex(&cy_olm_defer_mutex) == CY_RSLT_SUCCESS);
+    }
+    if (!cy_olm_init_mutex_init)
+    {
+        cy_olm_init_mutex_init = (cy_rtos_init_mutex(&cy_olm_init_mutex) == CY_RSLT_SUCCESS);
+    }
+    olm->deferred_count = 0;
+    olm->deferred_base = 0;
+    if (olm->wlan_profile == NULL)
+    {
+        olm->wlan_profile = &cy_olm_wlan_profiles[OLM_WLAN_PROFILE_DEFAULT];
+    }
+
+    /* One probe per firmware load; the offloads consult the result instead of failing IOVARs */
+    cylpa_olm_caps_probe(olm_info);
+
+    /* Deferred work executor only for old infra to handle callbacks; shared by all Offload Managers */
+    if (olm->ol_info.fw_new_infra == 0)
+    {
+        olm->ol_info.worker = cylpa_olm_exec_start(olm->ol_info.worker);
+        OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "cylpa_olm_init()  olm:%p ol_list:%p worker:%p whd:%x\n", (void *)olm, (void *)ol_list,
+                   olm->ol_info.worker, olm->ol_info.whd);
     }
 
     iface = olm_info->whd;
 
+    olm->wlan_configured = false;
     if ( iface != NULL )
     {
-        cylpa_olm_init_wlan_config (iface );
-        cy_olm_whd_instance_created = true;
+        cylpa_olm_shadow_attach(iface);
+        cylpa_olm_config_wlan(olm);
+        olm->wlan_configured = true;
     }
     else
     {
@@ -184,13 +271,19 @@ void cylpa_olm_deinit(olm_t *olm)
 {
     OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "cylpa_olm_deinit() olm:%p\n", (void *)olm);
 
-    if ( olm->ol_info.fw_new_infra == 1 )
+    if (olm->ol_info.whd != NULL)
+    {
+        cylpa_olm_shadow_detach(olm->ol_info.whd);
+    }
+    olm->wlan_configured = false;
+
+    if ( (olm->ol_info.fw_new_infra == 1) || (olm->ol_info.worker == NULL) )
     {
         return;
     }
 
-    cy_worker_thread_delete(olm->ol_info.worker);
-    olm->ol_info.worker = NULL;
+    /* The other Offload Managers keep using it */
+    olm->ol_info.worker = cylpa_olm_exec_stop(olm->ol_info.worker);
 
     OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "cylpa_olm_deinit() Done\n");
 }
@@ -201,6 +294,19 @@ void cylpa_olm_deinit(olm_t *olm)
 *
 * This function initializes the Offload Manager.
 *
+* Offloads are initialized in dependency order (ol_fns_t::deps). Offloads whose
+* dependencies are met are initialized together, split between the calling
+* thread and the OLM executor thread when it exists. If an offload initialization
+* fails, the offloads already initialized are deinitialized (dependents first)
+* and the result code of the first failing offload in list order is returned.
+*
+* Only NKO depends on another offload (ARP: both register the WCM IP change
+* callback). The interface setup every offload relies on (capabilities, firmware
+* shadow, WLAN configuration) is done here before any offload init starts. The
+* other offloads program separate firmware state (PF filters, TKO, NULL and NAT
+* keepalive ids) through WHD, which serializes its ioctls, or, like TLS and WOWL,
+* only copy their configuration; the firmware shadow they share is locked.
+*
 * \param olm
 * The pointer to the olm structure \ref olm_t.
 *
@@ -213,7 +319,11 @@ void cylpa_olm_deinit(olm_t *olm)
 *******************************************************************************/
 int cylpa_olm_init_ols(olm_t *olm, void *whd, void *ip)
 {
-    const ol_desc_t *it0, *it1;
+    olm_init_job_t *job;
+    cy_semaphore_t done;
+    bool use_worker = false;
+    uint32_t count, remaining, ready, queued, i;
+    uint32_t start = OLM_LATENCY_NOW();
     int result = RESULT_OK;
 
     olm->ol_info.whd = whd;
@@ -226,40 +336,149 @@ int cylpa_olm_init_ols(olm_t *olm, void *whd, void *ip)
     }
 
     /* if whd instance is created after connect to an AP then call cylpa_olm_init_wlan_config */
-    if(  ( olm->ol_info.whd != NULL ) && ( cy_olm_whd_instance_created == false ) )
+    if(  ( olm->ol_info.whd != NULL ) && ( olm->wlan_configured == false ) )
     {
-         cylpa_olm_init_wlan_config (olm->ol_info.whd );
-         cy_olm_whd_instance_created = true;
+         if (!olm->ol_info.caps.valid)
+         {
+             cylpa_olm_caps_probe(&olm->ol_info);
+         }
+         cylpa_olm_shadow_attach(olm->ol_info.whd);
+         cylpa_olm_config_wlan(olm);
+         olm->wlan_configured = true;
     }
 
     OL_LOG_OLM(LOG_OLA_LVL_INFO, "%s\n", __func__);
 
-    for (it0 = olm->ol_list; it0->fns; it0++)
+    /* Anything deferred from here on belongs to the offloads */
+    olm->deferred_base = olm->deferred_count;
+
+    if (olm->reg.overflow)
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s more than OLM_MAX_OFFLOADS (%d) offloads\n", __func__, OLM_MAX_OFFLOADS);
+        return RESULT_BADARGS;
+    }
+
+    /* The init jobs are shared with the other Offload Managers */
+    if (cy_olm_init_mutex_init)
+    {
+        cy_rtos_get_mutex(&cy_olm_init_mutex, CY_RTOS_NEVER_TIMEOUT);
+    }
+
+    for (count = 0; count < olm->reg.count; count++)
+    {
+        cy_olm_init_jobs[count].slot = olm->reg.order[count];
+        cy_olm_init_jobs[count].desc = olm->reg.entries[olm->reg.order[count]].desc;
+        cy_olm_init_jobs[count].info = &olm->ol_info;
+        cy_olm_init_jobs[count].olm = olm;
+        cy_olm_init_jobs[count].done = NULL;
+        cy_olm_init_jobs[count].result = RESULT_OK;
+        cy_olm_init_jobs[count].state = OLM_INIT_ST_PENDING;
+    }
+
+    /* Independent offloads are split between this thread and the OLM executor thread. Without
+     * OLM_EXEC_THREAD the executor may be run by this very thread, so everything runs here.
+     */
+    if ( (OLM_EXEC_THREAD != 0) && (olm->ol_info.worker != NULL) &&
+         (count > 1) && (cy_rtos_init_semaphore(&done, OLM_MAX_OFFLOADS, 0) == CY_RSLT_SUCCESS) )
+    {
+        use_worker = true;
+    }
+
+    for (remaining = count; (remaining > 0) && (result == RESULT_OK); remaining -= ready)
     {
-        if (it0->fns->init != NULL)
+        /* Start every offload whose dependencies are initialized */
+        ready = 0;
+        queued = 0;
+        for (i = 0; i < count; i++)
+        {
+            job = &cy_olm_init_jobs[i];
+            if ( (job->state != OLM_INIT_ST_PENDING) || !cylpa_olm_init_job_ready(count, i) )
+            {
+                continue;
+            }
+            job->state = OLM_INIT_ST_RUNNING;
+            if ( use_worker && ( (ready & 1) != 0 ) )
+            {
+                job->done = &done;
+                cylpa_olm_exec_item_init(&job->item, cylpa_olm_init_job_run, job, OLM_EXEC_PRIO_HIGH);
+                if (cylpa_olm_exec_submit(&job->item, 0) == RESULT_OK)
+                {
+                    queued++;
+                }
+                else
+                {
+                    job->done = NULL;
+                }
+            }
+            ready++;
+        }
+        if (ready == 0)
+        {
+            OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s dependency cycle between offloads\n", __func__);
+            result = RESULT_BADARGS;
+            break;
+        }
+
+        /* Run the others here while the executor thread runs its share */
+        for (i = 0; i < count; i++)
         {
-            result = (*it0->fns->init)(it0->ol, &olm->ol_info, it0->cfg);
-            if ( result != RESULT_OK )
+            job = &cy_olm_init_jobs[i];
+            if ( (job->state == OLM_INIT_ST_RUNNING) && (job->done == NULL) )
             {
-                OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s offload %s fatal %d\n", __func__, it0->name, result);
-                break;
+                cylpa_olm_init_job_run(job);
             }
         }
+        for ( ; queued > 0; queued--)
+        {
+            cy_rtos_get_semaphore(&done, CY_RTOS_NEVER_TIMEOUT, false);
+        }
+
+        /* Report the first failure in list order */
+        for (i = 0; (i < count) && (result == RESULT_OK); i++)
+        {
+            job = &cy_olm_init_jobs[i];
+            if (job->state == OLM_INIT_ST_FAILED)
+            {
+                OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s offload %s fatal %d\n", __func__, job->desc->name, job->result);
+                result = job->result;
+            }
+        }
+    }
+
+    if (use_worker)
+    {
+        cy_rtos_deinit_semaphore(&done);
     }
 
     if ( result != RESULT_OK )
     {
         /* Failure */
-        /* Undo any initializations. */
-        for (it1 = olm->ol_list; it1 != it0; it1++)
+        /* Undo any initializations, dependents first. */
+        for (i = count; i > 0; i--)
         {
-            if (it1->fns->deinit != NULL)
+            job = &cy_olm_init_jobs[i - 1];
+            if ( (job->state == OLM_INIT_ST_DONE) && (job->desc->fns->deinit != NULL) )
             {
-                (*it1->fns->deinit)(it1->ol);
+                (*job->desc->fns->deinit)(job->desc->ol);
             }
         }
+        olm->deferred_count = olm->deferred_base;
+    }
+    else
+    {
+        for (i = 0; i < count; i++)
+        {
+            olm->reg.entries[cy_olm_init_jobs[i].slot].active = true;
+        }
+        olm->ols_up = true;
+    }
+
+    if (cy_olm_init_mutex_init)
+    {
+        cy_rtos_set_mutex(&cy_olm_init_mutex);
     }
 
+    OLM_LATENCY_RECORD(olm, OLM_MAX_OFFLOADS, OLM_LATENCY_INIT, start);
     OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "%s Done\n", __func__);
     return result;
 }
@@ -278,7 +497,9 @@ int cylpa_olm_init_ols(olm_t *olm, void *whd, void *ip)
 *******************************************************************************/
 void cylpa_olm_deinit_ols(olm_t *olm)
 {
+    const olm_reg_view_t *view;
     const ol_desc_t *it;
+    uint32_t i;
 
     OL_LOG_OLM(LOG_OLA_LVL_INFO, "%s olm:%p\n", __func__, (void *)olm);
 
@@ -288,13 +509,29 @@ void cylpa_olm_deinit_ols(olm_t *olm)
         return;
     }
 
-    for (it = olm->ol_list; it->fns; it++)
+    cylpa_olm_reg_lock();
+
+    /* Deferred operations may refer to the offloads */
+    olm->deferred_count = olm->deferred_base;
+
+    view = &olm->reg.views[olm->reg.view];
+    for (i = 0; i < view->deinit_count; i++)
     {
-        if (it->fns->deinit != NULL)
+        /* An offload whose init failed, e.g. in a reconfiguration, cleaned up after itself */
+        if (!olm->reg.entries[view->deinit[i]].active)
         {
-            (*it->fns->deinit)(it->ol);
+            continue;
         }
+        it = olm->reg.entries[view->deinit[i]].desc;
+        (*it->fns->deinit)(it->ol);
     }
+    for (i = 0; i < olm->reg.count; i++)
+    {
+        olm->reg.entries[olm->reg.order[i]].active = false;
+    }
+    olm->ols_up = false;
+
+    cylpa_olm_reg_unlock();
 
     OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "%s Done\n", __func__);
 }
@@ -303,7 +540,8 @@ void cylpa_olm_deinit_ols(olm_t *olm)
 * Function Name: cylpa_olm_dispatch_pm_notification
 ****************************************************************************//**
 *
-* This function dispatches pm notifications.
+* This function dispatches pm notifications. Without OLM_EXEC_THREAD the
+* deferred work that is due is run afterwards, on the calling thread.
 *
 * \param olm
 * The pointer to the olm structure \ref olm_t.
@@ -314,8 +552,14 @@ void cylpa_olm_deinit_ols(olm_t *olm)
 *******************************************************************************/
 void cylpa_olm_dispatch_pm_notification(olm_t *olm, ol_pm_st_t st)
 {
+    const olm_reg_view_t *view;
     const ol_desc_t *it;
-    uint32_t pm2_lpa_value = LPA_PM2_SLEEP_RET_TIME;
+    uint32_t i;
+    uint32_t slot;
+    uint32_t pm2_lpa_value;
+    uint32_t start = OLM_LATENCY_NOW();
+    uint32_t ol_start;
+    olm_latency_id_t lat_id = (st == OL_PM_ST_GOING_TO_SLEEP) ? OLM_LATENCY_SLEEP : OLM_LATENCY_WAKE;
 
     if (olm == NULL)
     {
@@ -329,10 +573,37 @@ void cylpa_olm_dispatch_pm_notification(olm_t *olm, ol_pm_st_t st)
         return;
     }
 
+    /* An offload is not unregistered, deinitialized or reconfigured while it is notified */
+    cylpa_olm_reg_lock();
+
+    pm2_lpa_value = cylpa_olm_get_wlan_profile(olm)->pm2_sleep_ret;
+
+    /* Collect the IOVARs of all offloads and issue them together */
+    cylpa_olm_txn_begin(&olm->txn, olm->ol_info.whd);
+    olm->ol_info.txn = &olm->txn;
+
     if ( st == OL_PM_ST_GOING_TO_SLEEP )
     {
+        /* Work deferred from initialization */
+        if (cy_olm_defer_mutex_init)
+        {
+            cy_rtos_get_mutex(&cy_olm_defer_mutex, CY_RTOS_NEVER_TIMEOUT);
+        }
+        for (i = 0; i < olm->deferred_count; i++)
+        {
+            cylpa_olm_txn_call(olm->ol_info.txn, olm->ol_info.whd, olm->deferred[i].fn, olm->deferred[i].arg,
+                               olm->deferred[i].param, NULL, NULL);
+        }
+        olm->deferred_count = 0;
+        olm->deferred_base = 0;
+        if (cy_olm_defer_mutex_init)
+        {
+            cy_rtos_set_mutex(&cy_olm_defer_mutex);
+        }
+
         /* set PM2 sleep return value configured for WLAN Lowest Power */
-        cylpa_olm_configure_wlan_pmode(olm->ol_info.whd, pm2_lpa_value, true);
+        cylpa_olm_txn_call(olm->ol_info.txn, olm->ol_info.whd, cylpa_olm_txn_configure_wlan_pmode,
+                           olm, pm2_lpa_value, NULL, NULL);
     }
     else
     {
@@ -340,19 +611,340 @@ void cylpa_olm_dispatch_pm_notification(olm_t *olm, ol_pm_st_t st)
          * set PM2 sleep return value to default value
          * (i.e value before going to sleep/deep-sleep)
          */
-        cylpa_olm_configure_wlan_pmode(olm->ol_info.whd, cy_pm2_sleep_ret_value, false);
+        cylpa_olm_txn_call(olm->ol_info.txn, olm->ol_info.whd, cylpa_olm_txn_configure_wlan_pmode,
+                           NULL, olm->pm2_sleep_ret, NULL, NULL);
     }
 
     OL_LOG_OLM(LOG_OLA_LVL_INFO, "%s st:%d\n", __func__, st);
 
-    for (it = olm->ol_list; it->fns; it++)
+    view = &olm->reg.views[olm->reg.view];
+    for (i = 0; i < view->pm_count; i++)
     {
-        if (it->fns->pm != NULL)
+        slot = view->pm[i];
+        if (!olm->reg.entries[slot].active)
         {
+            /* Not initialized, or its init failed */
+            continue;
+        }
+        it = olm->reg.entries[slot].desc;
+        if (it->fns->flags & OL_FNS_F_TXN)
+        {
+            ol_start = OLM_LATENCY_NOW();
             (*it->fns->pm)(it->ol, st);
+            OLM_LATENCY_RECORD(olm, slot, lat_id, ol_start);
+        }
+        else
+        {
+            /* Keep the handler's IOVARs in list order relative to the queued ones */
+            cylpa_olm_txn_call(olm->ol_info.txn, olm->ol_info.whd, cylpa_olm_txn_pm, olm,
+                               OLM_TXN_PM_PARAM(slot, st), NULL, NULL);
+        }
+    }
+
+    olm->ol_info.txn = NULL;
+    cylpa_olm_txn_flush(&olm->txn);
+
+    cylpa_olm_reg_unlock();
+
+    OLM_LATENCY_RECORD(olm, OLM_MAX_OFFLOADS, lat_id, start);
+
+#if (OLM_EXEC_THREAD == 0)
+    /* No executor thread: run the work that is due here, with no OLM lock held */
+    if (olm->ol_info.worker != NULL)
+    {
+        (void)cylpa_olm_exec_run();
+    }
+#endif
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_configure_wlan_pmode
+****************************************************************************//**
+*
+* Transaction wrapper of cylpa_olm_configure_wlan_pmode(). Going to sleep reads
+* the default PM2 value and the PM mode is set by an ioctl, so it has to stay a
+* call rather than a plain IOVAR.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param arg
+* The pointer to the olm structure \ref olm_t, whose PM2 value is saved, when
+* going to sleep; NULL when waking.
+*
+* \param value
+* The iovar value to be set ( in ms)
+*
+*******************************************************************************/
+static uint32_t cylpa_olm_txn_configure_wlan_pmode(void *whd, void *arg, uint32_t value)
+{
+    olm_t *olm = (olm_t *)arg;
+
+    cylpa_olm_set_wlan_pmode(whd, value, (olm != NULL) ? &olm->pm2_sleep_ret : NULL);
+    return WHD_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_pm
+****************************************************************************//**
+*
+* Run the pm handler of an offload that issues its IOVARs directly.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param arg
+* The pointer to the olm structure \ref olm_t.
+*
+* \param param
+* Offload index and new Power State, see OLM_TXN_PM_PARAM()
+*
+*******************************************************************************/
+static uint32_t cylpa_olm_txn_pm(void *whd, void *arg, uint32_t param)
+{
+    olm_t *olm = (olm_t *)arg;
+    const ol_desc_t *it = olm->reg.entries[OLM_TXN_PM_PARAM_IDX(param)].desc;
+    ol_pm_st_t st = OLM_TXN_PM_PARAM_ST(param);
+    uint32_t start = OLM_LATENCY_NOW();
+
+    (*it->fns->pm)(it->ol, st);
+    OLM_LATENCY_RECORD(olm, OLM_TXN_PM_PARAM_IDX(param), (st == OL_PM_ST_GOING_TO_SLEEP) ? OLM_LATENCY_SLEEP :
+                       OLM_LATENCY_WAKE, start);
+    return WHD_SUCCESS;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_init_job_ready
+****************************************************************************//**
+*
+* Whether all offloads an offload depends on are initialized.
+*
+* \param count
+* Number of init jobs.
+*
+* \param idx
+* Index of the job to check.
+*
+*******************************************************************************/
+static bool cylpa_olm_init_job_ready(uint32_t count, uint32_t idx)
+{
+    const struct ol_fns * const *dep;
+    uint32_t i;
+
+    if (cy_olm_init_jobs[idx].desc->fns->deps == NULL)
+    {
+        return true;
+    }
+    for (dep = cy_olm_init_jobs[idx].desc->fns->deps; *dep != NULL; dep++)
+    {
+        /* A dependency that is not registered is satisfied */
+        for (i = 0; i < count; i++)
+        {
+            if ( (i != idx) && (cy_olm_init_jobs[i].desc->fns == *dep) &&
+                 (cy_olm_init_jobs[i].state != OLM_INIT_ST_DONE) )
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_init_job_run
+****************************************************************************//**
+*
+* Initialize one offload. Signals the job's semaphore when run on the executor
+* thread.
+*
+* \param arg
+* The job \ref olm_init_job_t.
+*
+*******************************************************************************/
+static void cylpa_olm_init_job_run(void *arg)
+{
+    olm_init_job_t *job = (olm_init_job_t *)arg;
+    cy_semaphore_t *done = job->done;
+    uint32_t start = OLM_LATENCY_NOW();
+
+    job->result = RESULT_OK;
+    if (job->desc->fns->init != NULL)
+    {
+        job->result = (*job->desc->fns->init)(job->desc->ol, job->info, job->desc->cfg);
+    }
+    /* Each job owns the histogram of its offload, so this is safe from the executor thread */
+    OLM_LATENCY_RECORD(job->olm, job->slot, OLM_LATENCY_INIT, start);
+    job->state = (job->result == RESULT_OK) ? OLM_INIT_ST_DONE : OLM_INIT_ST_FAILED;
+
+    if (done != NULL)
+    {
+        cy_rtos_set_semaphore(done, false);
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_defer
+****************************************************************************//**
+*
+* Defer a non-critical operation to the next sleep transition, where it runs in
+* the OLM transaction before the offloads are notified.
+*
+* \param ol_info
+* The ol_info of the Offload Manager (\ref olm_t::ol_info).
+*
+* \param fn
+* The operation.
+*
+* \param arg
+* First argument of fn.
+*
+* \param param
+* Second argument of fn.
+*
+*******************************************************************************/
+void cylpa_olm_defer(ol_info_t *ol_info, olm_txn_fn_t *fn, void *arg, uint32_t param)
+{
+    /* ol_info is always the one embedded in the Offload Manager */
+    olm_t *olm = (olm_t *)( (uint8_t *)ol_info - offsetof(olm_t, ol_info) );
+    bool deferred = false;
+
+    if (cy_olm_defer_mutex_init)
+    {
+        cy_rtos_get_mutex(&cy_olm_defer_mutex, CY_RTOS_NEVER_TIMEOUT);
+    }
+    if (olm->deferred_count < OLM_MAX_DEFERRED)
+    {
+        olm->deferred[olm->deferred_count].fn = fn;
+        olm->deferred[olm->deferred_count].arg = arg;
+        olm->deferred[olm->deferred_count].param = param;
+        olm->deferred_count++;
+        deferred = true;
+    }
+    if (cy_olm_defer_mutex_init)
+    {
+        cy_rtos_set_mutex(&cy_olm_defer_mutex);
+    }
+
+    if (!deferred)
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_WARNING, "%s: deferred list full, running now\n", __func__);
+        (void)fn(ol_info->whd, arg, param);
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_defer_cancel
+****************************************************************************//**
+*
+* Drop the deferred operations of an offload that is going away, identified by
+* their arg.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+* \param arg
+* The arg given to cylpa_olm_defer(), usually the offload instance.
+*
+*******************************************************************************/
+void cylpa_olm_defer_cancel(olm_t *olm, void *arg)
+{
+    uint32_t i;
+    uint32_t n;
+
+    if (cy_olm_defer_mutex_init)
+    {
+        cy_rtos_get_mutex(&cy_olm_defer_mutex, CY_RTOS_NEVER_TIMEOUT);
+    }
+    for (i = olm->deferred_base, n = olm->deferred_base; i < olm->deferred_count; i++)
+    {
+        if (olm->deferred[i].arg != arg)
+        {
+            olm->deferred[n++] = olm->deferred[i];
         }
     }
+    olm->deferred_count = n;
+    if (cy_olm_defer_mutex_init)
+    {
+        cy_rtos_set_mutex(&cy_olm_defer_mutex);
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_config_wlan
+****************************************************************************//**
+*
+* Apply the WLAN low power configuration, at the first sleep transition unless
+* OLM_DEFER_WLAN_CONFIG is 0. Nothing in it is needed to connect, so it stays off
+* the connect-to-first-sleep path.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+*******************************************************************************/
+static void cylpa_olm_config_wlan(olm_t *olm)
+{
+#if (OLM_DEFER_WLAN_CONFIG != 0)
+    cylpa_olm_defer(&olm->ol_info, cylpa_olm_txn_init_wlan_config, olm, 0);
+#else
+    cylpa_olm_apply_wlan_profile(olm->ol_info.whd, cylpa_olm_get_wlan_profile(olm));
+#endif
+#if defined(OLM_LOG_ENABLED)
+    cylpa_olm_defer(&olm->ol_info, cylpa_olm_txn_verify_wlan_config, NULL, 0);
+#endif
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_init_wlan_config
+****************************************************************************//**
+*
+* Deferred cylpa_olm_init_wlan_config() with the profile in effect at the time
+* it runs.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param arg
+* The pointer to the olm structure \ref olm_t.
+*
+*******************************************************************************/
+static uint32_t cylpa_olm_txn_init_wlan_config(void *whd, void *arg, uint32_t param)
+{
+    return cylpa_olm_apply_wlan_profile(whd, cylpa_olm_get_wlan_profile( (olm_t *)arg) );
+}
+
+#if defined(OLM_LOG_ENABLED)
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_verify_wlan_config
+****************************************************************************//**
+*
+* Read back and log the WLAN low power configuration. Debug only; deferred to
+* the first sleep transition.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+*******************************************************************************/
+static uint32_t cylpa_olm_txn_verify_wlan_config(void *whd, void *arg, uint32_t param)
+{
+    whd_interface_t ifp = (whd_interface_t)whd;
+    uint32_t bcntrim_value = 0;
+    uint32_t bcn_wait_period = 0;
+    uint32_t bcn_reacquire_start = 0;
+    uint32_t roam_time_threshold = 0;
+
+    whd_wifi_get_iovar_value (ifp, OLM_IOVAR_BCNTRIM, &bcntrim_value);
+    whd_wifi_get_iovar_value (ifp, OLM_IOVAR_BCN_WAIT_PRD, &bcn_wait_period);
+    whd_wifi_get_iovar_value (ifp, OLM_IOVAR_BCN_REACQUIRE_START, &bcn_reacquire_start);
+    whd_wifi_get_iovar_value (ifp, OLM_IOVAR_ROAM_TIME_THRESH, &roam_time_threshold);
+
+    OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "\n\n********************************************************************\n");
+    OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "             WLAN Low Power IOVAR firmware values                  \n");
+    OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "bcntrim:%d bcn_wait_period:%d bcn_reacquire_start:%d roam_time_thresh:%d\n",
+               bcntrim_value, bcn_wait_period, bcn_reacquire_start, roam_time_threshold );
+    OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "********************************************************************\n\n");
+    return WHD_SUCCESS;
 }
+#endif
 
 /*******************************************************************************
 * Function Name: cylpa_olm_init_wlan_config
@@ -361,11 +953,7 @@ void cylpa_olm_dispatch_pm_notification(olm_t *olm, ol_pm_st_t st)
 * This function configures WLAN to operate at lowest possible power
 * this function is called once after cylpa_olm_init
 *
-* This includes following steps:
-* 1.  set the bcntrim iovar value ( LPA_BCNTRIM)
-* 2.  set the bcn_wait_prd iovar value ( LPA_BCN_WAIT_PERIOD)
-* 3.  set the bcn_reacquire_start iovar value ( LPA_BCN_REACQUIRE_START)
-* 4.  set the roam_time_thresh iovar value ( LPA_ROAM_TIME_THRESHOLD )
+* Applies the default WLAN power profile (the LPA_* values).
 *
 * \param whd
 * The pointer to the whd interface.
@@ -373,39 +961,177 @@ void cylpa_olm_dispatch_pm_notification(olm_t *olm, ol_pm_st_t st)
 *******************************************************************************/
 void cylpa_olm_init_wlan_config ( void *whd )
 {
-    uint32_t bcntrim_value = LPA_BCNTRIM;
-    uint32_t bcn_wait_period = 0;
-    uint32_t bcn_reacquire_start = LPA_BCN_REACQUIRE_START;
-    uint32_t roam_time_threshold = LPA_ROAM_TIME_THRESHOLD;
+    (void)cylpa_olm_apply_wlan_profile(whd, &cy_olm_wlan_profiles[OLM_WLAN_PROFILE_DEFAULT]);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_apply_wlan_profile
+****************************************************************************//**
+*
+* This includes following steps:
+* 1.  set the bcntrim iovar value
+* 2.  set the bcn_wait_prd iovar value
+* 3.  set the bcn_reacquire_start iovar value
+* 4.  set the roam_time_thresh iovar value
+*
+* Values the firmware is already known to hold are not written again, so moving
+* between profiles only sends the IOVARs that differ. The PM2 return to sleep
+* time is applied by the sleep transition.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param profile
+* The profile to apply.
+*
+* \return WHD_SUCCESS, or the first failure
+*
+*******************************************************************************/
+static uint32_t cylpa_olm_apply_wlan_profile(void *whd, const olm_wlan_profile_t *profile)
+{
     whd_interface_t ifp  = (whd_interface_t )whd;
+    uint32_t result;
+    uint32_t res;
 
     /* set bcntrim */
-    whd_wifi_set_iovar_value ( ifp, "bcntrim ", bcntrim_value );
+    result = cylpa_olm_shadow_set_iovar_value ( ifp, OLM_IOVAR_BCNTRIM, profile->bcntrim );
 
-    /* get bcn_wait_period in ms */
-    whd_wifi_get_iovar_value ( ifp, "bcn_wait_prd", &bcn_wait_period);
-
-    if ( bcn_wait_period != LPA_BCN_WAIT_PERIOD )
-    {
-        /* set beacon wait period */
-        whd_wifi_set_iovar_value ( ifp, "bcn_wait_prd", LPA_BCN_WAIT_PERIOD);
-    }
+    /* set beacon wait period in ms */
+    res = cylpa_olm_shadow_set_iovar_value ( ifp, OLM_IOVAR_BCN_WAIT_PRD, profile->bcn_wait_period );
+    result = (result != WHD_SUCCESS) ? result : res;
 
     /* set beacon re-acquire time in seconds */
-    whd_wifi_set_iovar_value ( ifp, "bcn_reacquire_start", bcn_reacquire_start);
+    res = cylpa_olm_shadow_set_iovar_value ( ifp, OLM_IOVAR_BCN_REACQUIRE_START, profile->bcn_reacquire_start );
+    result = (result != WHD_SUCCESS) ? result : res;
 
     /* set the roam_time_threshold */
-    whd_wifi_set_iovar_value ( ifp, "roam_time_thresh", roam_time_threshold );
+    res = cylpa_olm_shadow_set_iovar_value ( ifp, OLM_IOVAR_ROAM_TIME_THRESH, profile->roam_time_threshold );
+    result = (result != WHD_SUCCESS) ? result : res;
 
-    whd_wifi_get_iovar_value (ifp, "bcntrim", &bcntrim_value);
-    whd_wifi_get_iovar_value (ifp, "bcn_reacquire_start", &bcn_reacquire_start);
-    whd_wifi_get_iovar_value (ifp, "roam_time_thresh", &roam_time_threshold);
+    /* Read back by cylpa_olm_txn_verify_wlan_config() in debug builds */
 
     OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "\n\n********************************************************************\n");
-    OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "             WLAN Low Power IOVAR config values                    \n");
-    OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "bcntrim:%d bcn_wait_period:%d bcn_reacquire_start:%d roam_time_thresh:%d\n",
-               bcntrim_value, bcn_wait_period, bcn_reacquire_start, roam_time_threshold );
+    OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "             WLAN Low Power IOVAR config values (%s)              \n", profile->name);
+    OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "bcntrim:%d bcn_wait_period:%d bcn_reacquire_start:%d roam_time_thresh:%d result:%d\n",
+               profile->bcntrim, profile->bcn_wait_period, profile->bcn_reacquire_start,
+               profile->roam_time_threshold, result );
     OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "********************************************************************\n\n");
+
+    return result;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_set_wlan_profile
+****************************************************************************//**
+*
+* Switch the WLAN power profile. The beacon and roam IOVARs are applied now, or
+* by the deferred WLAN configuration if it has not run yet; PM2 return to sleep
+* time at the next sleep transition.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+* \param profile
+* The profile to apply.
+*
+* \return RESULT_OK, RESULT_BADARGS or RESULT_ERROR
+*
+*******************************************************************************/
+int cylpa_olm_set_wlan_profile(olm_t *olm, const olm_wlan_profile_t *profile)
+{
+    bool deferred = false;
+    uint32_t i;
+
+    if ( (olm == NULL) || (profile == NULL) )
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s Bad Arg\n", __func__);
+        return RESULT_BADARGS;
+    }
+
+    if ( (profile->bcntrim > OLM_BCNTRIM_MAX) ||
+         (profile->roam_time_threshold <= profile->bcn_reacquire_start) ||
+         (profile->pm2_sleep_ret < OLM_PM2_SLEEP_RET_MIN) || (profile->pm2_sleep_ret > OLM_PM2_SLEEP_RET_MAX) )
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s: profile %s out of range\n", __func__, profile->name ? profile->name : "");
+        return RESULT_BADARGS;
+    }
+
+    OL_LOG_OLM(LOG_OLA_LVL_INFO, "%s: %s -> %s\n", __func__, cylpa_olm_get_wlan_profile(olm)->name,
+               profile->name ? profile->name : "");
+
+    if (cy_olm_defer_mutex_init)
+    {
+        cy_rtos_get_mutex(&cy_olm_defer_mutex, CY_RTOS_NEVER_TIMEOUT);
+    }
+    olm->wlan_profile = profile;
+    for (i = 0; i < olm->deferred_count; i++)
+    {
+        if (olm->deferred[i].fn == cylpa_olm_txn_init_wlan_config)
+        {
+            deferred = true;
+        }
+    }
+    if (cy_olm_defer_mutex_init)
+    {
+        cy_rtos_set_mutex(&cy_olm_defer_mutex);
+    }
+
+    /* Not associated yet, or the initial configuration is still pending; it picks up the new profile */
+    if ( (olm->ol_info.whd == NULL) || deferred )
+    {
+        return RESULT_OK;
+    }
+
+    return (cylpa_olm_apply_wlan_profile(olm->ol_info.whd, profile) == WHD_SUCCESS) ? RESULT_OK : RESULT_ERROR;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_get_wlan_profile
+****************************************************************************//**
+*
+* Return the WLAN power profile in effect.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+*******************************************************************************/
+const olm_wlan_profile_t *cylpa_olm_get_wlan_profile(const olm_t *olm)
+{
+    if ( (olm == NULL) || (olm->wlan_profile == NULL) )
+    {
+        return &cy_olm_wlan_profiles[OLM_WLAN_PROFILE_DEFAULT];
+    }
+    return olm->wlan_profile;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_find_wlan_profile
+****************************************************************************//**
+*
+* Look up a built-in WLAN power profile by name.
+*
+* \param name
+* Profile name.
+*
+* \return The profile, or NULL if there is none with that name
+*
+*******************************************************************************/
+const olm_wlan_profile_t *cylpa_olm_find_wlan_profile(const char *name)
+{
+    uint32_t i;
+
+    if (name == NULL)
+    {
+        return NULL;
+    }
+    for (i = 0; i < OLM_WLAN_PROFILE_MAX; i++)
+    {
+        if (strcmp(cy_olm_wlan_profiles[i].name, name) == 0)
+        {
+            return &cy_olm_wlan_profiles[i];
+        }
+    }
+    return NULL;
 }
 
 /*******************************************************************************
@@ -426,29 +1152,62 @@ void cylpa_olm_init_wlan_config ( void *whd )
 *
 *******************************************************************************/
 void cylpa_olm_configure_wlan_pmode ( void *whd , uint32_t value, bool min_power )
+{
+    cylpa_olm_set_wlan_pmode(whd, value, min_power ? &cy_pm2_sleep_ret_value : NULL);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_set_wlan_pmode
+****************************************************************************//**
+*
+* Set the PM2 sleep return value of an interface.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param value
+* The iovar value to be set ( in ms)
+*
+* \param saved
+* When going to minimum power, receives the value in effect before; NULL when
+* restoring it.
+*
+*******************************************************************************/
+static void cylpa_olm_set_wlan_pmode(void *whd, uint32_t value, uint32_t *saved)
 {
     whd_interface_t ifp = whd;
-    uint32_t lpa_pm2_value = 0;
+    whd_result_t result;
 
     if ( whd != NULL )
     {
-        if ( min_power )
+        if ( saved != NULL )
         {
-            /* get PM2 Global sleep return value */
-            whd_wifi_get_iovar_value(ifp, "pm2_sleep_ret", (uint32_t *) &cy_pm2_sleep_ret_value);
-            OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "\nGet     default pm2_sleep_ret:%d(ms)\n", cy_pm2_sleep_ret_value);
+            /* get PM2 Global sleep return value; always from the firmware, as the application may
+             * have changed it with whd_wifi_enable_powersave_with_throughput() since the last wake-up */
+            if (whd_wifi_get_iovar_value(ifp, OLM_IOVAR_PM2_SLEEP_RET, saved) == WHD_SUCCESS)
+            {
+                cylpa_olm_shadow_store(ifp, OLM_IOVAR_PM2_SLEEP_RET, 0, saved, sizeof(*saved) );
+            }
+            OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "\nGet     default pm2_sleep_ret:%d(ms)\n", *saved);
 
             /* set PM2 sleep return value for WLAN Lowest Power */
-            whd_wifi_enable_powersave_with_throughput(ifp, value);
-
-            whd_wifi_get_iovar_value(ifp, "pm2_sleep_ret", (uint32_t *) &lpa_pm2_value);
-            OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "Set     LPA     pm2_sleep_ret:%d(ms)\n\n", lpa_pm2_value);
+            result = whd_wifi_enable_powersave_with_throughput(ifp, value);
+            OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "Set     LPA     pm2_sleep_ret:%d(ms)\n\n", value);
         }
         else
         {
             /* set PM2 sleep return value to default value */
-            whd_wifi_enable_powersave_with_throughput(ifp, value );
-            OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "\nRestore default pm2_sleep_ret:%d(ms)\n", cy_pm2_sleep_ret_value);
+            result = whd_wifi_enable_powersave_with_throughput(ifp, value );
+            OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "\nRestore default pm2_sleep_ret:%d(ms)\n", value);
+        }
+
+        if ( result == WHD_SUCCESS )
+        {
+            cylpa_olm_shadow_store(ifp, OLM_IOVAR_PM2_SLEEP_RET, 0, &value, sizeof(value) );
+        }
+        else
+        {
+            cylpa_olm_shadow_forget(ifp, OLM_IOVAR_PM2_SLEEP_RET, 0);
         }
     }
     else
@@ -507,14 +1266,17 @@ int ol_log_set_level(LOG_OFFLOAD_ASSIST_T assist, LOG_OFFLOAD_ASSIST_LEVEL_T lev
 }
 
 /*******************************************************************************
-* This function tests log level and prints if settings are correct
+* This function tests log level and facility mask and logs if settings are correct
+*
+* Printed at once, unless OLM_LOG_RING is defined: the record then goes to the
+* trace ring and is printed by ol_log_drain(). Errors are always printed at once.
 *
 * @param assist : Offload Assistant type @ref LOG_OFFLOAD_ASSIST_T
 * @param level  : Offload assist logging level @ref LOG_OFFLOAD_ASSIST_LEVEL_T
 * @param fmt    : Format string like printf()
 * @param ...    : variable argument list for printf
 *
-* @return       : # characters printed
+* @return       : # characters printed; 1 if recorded to the trace ring
 *
 *******************************************************************************/
 int ol_logging(LOG_OFFLOAD_ASSIST_T assist, LOG_OFFLOAD_ASSIST_LEVEL_T level, const char *fmt, ...)
@@ -527,13 +1289,23 @@ int ol_logging(LOG_OFFLOAD_ASSIST_T assist, LOG_OFFLOAD_ASSIST_LEVEL_T level, co
         return 0;
     }
 
-    if (level > ol_log_level[assist])
+    if ( (level > ol_log_level[assist]) || ( (ol_log_get_mask() & OL_LOG_MASK(assist) ) == 0 ) )
     {
         return 0;
     }
 
     va_start(args, fmt);
-    count = vprintf(fmt, args);
+#if defined(OLM_LOG_RING)
+    /* Errors are neither delayed nor lost to a full ring */
+    if (level > LOG_OLA_LVL_ERR)
+    {
+        count = ol_log_trace(assist, level, fmt, args);
+    }
+    else
+#endif
+    {
+        count = vprintf(fmt, args);
+    }
     va_end(args);
     return count;
 }
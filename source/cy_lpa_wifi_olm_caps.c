@@ -0,0 +1,293 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ *
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+
+/**
+* @file cy_lpa_wifi_olm_caps.c
+* @brief Offload Manager firmware capability cache.
+*
+* The firmware is asked once per load what it supports: the offload
+* infrastructure, ARP, TCP keepalive and its connection count, and the WOWL
+* flags. Offloads consult the cache before issuing an IOVAR the firmware would
+* reject. The firmware does not report how many packet filters or WOWL patterns
+* it holds; the count is learned from the first add that fails for lack of
+* resources, and later adds are refused on the host until a slot is released.
+*/
+
+#include <string.h>
+#include <stdbool.h>
+#include "cy_lpa_wifi_ol_debug.h"
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_olm.h"
+#include "cy_lpa_wifi_ol_priv.h"
+#include "whd_int.h"
+#include "whd_wifi_api.h"
+#include "whd_wlioctl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern whd_result_t whd_get_wowl_cap(whd_interface_t ifp, uint32_t *value);
+
+/*******************************************************************************
+* Function Name: cylpa_olm_caps_probe
+****************************************************************************//**
+*
+* Probe the firmware behind ol_info->whd. Without an interface the cache is left
+* invalid and every capability is assumed present. Sets ol_info->fw_new_infra
+* when the capability bits could be read.
+*
+* \param ol_info
+* The pointer to the ol_info_t structure \ref ol_info_t.
+*
+*******************************************************************************/
+void cylpa_olm_caps_probe(ol_info_t *ol_info)
+{
+    ol_caps_t *caps = &ol_info->caps;
+    uint32_t value;
+    uint8_t max;
+
+    memset(caps, 0, sizeof(*caps) );
+    memset(caps->slots_max, OL_CAPS_SLOTS_UNKNOWN, sizeof(caps->slots_max) );
+
+    if (ol_info->whd == NULL)
+    {
+        return;
+    }
+
+    if (whd_wifi_get_fwcap(ol_info->whd, &value) == WHD_SUCCESS)
+    {
+        caps->fwcap = value;
+        ol_info->fw_new_infra = ( (value & (1 << WHD_FWCAP_OFFLOADS) ) != 0 ) ? 1 : 0;
+    }
+    if (ol_info->fw_new_infra != 0)
+    {
+        caps->features |= OL_CAP_OFFLOADS;
+    }
+
+    /* Packet filters are part of every firmware the offloads run on */
+    caps->features |= OL_CAP_PF;
+
+    /* Read through the shadow; the ARP offload reads it again at init */
+    if (cylpa_olm_shadow_get_iovar_value(ol_info->whd, IOVAR_STR_ARPOE, &value) == WHD_SUCCESS)
+    {
+        caps->features |= OL_CAP_ARP;
+    }
+
+    if ( (whd_tko_max_assoc(ol_info->whd, &max) == WHD_SUCCESS) && (max != 0) )
+    {
+        caps->features |= OL_CAP_TKO;
+        caps->tko_max_assoc = max;
+    }
+
+    /* WOWL net patterns are only offered with the offload infrastructure */
+    if ( (ol_info->fw_new_infra != 0) && (whd_get_wowl_cap(ol_info->whd, &value) == WHD_SUCCESS) )
+    {
+        caps->features |= OL_CAP_WOWL;
+        caps->wowl = value;
+    }
+
+    caps->valid = true;
+    OL_LOG_OLM(LOG_OLA_LVL_INFO, "%s: fwcap 0x%lx features 0x%lx tko %u wowl 0x%lx\n", __func__,
+               (unsigned long)caps->fwcap, (unsigned long)caps->features, caps->tko_max_assoc,
+               (unsigned long)caps->wowl);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_caps_has
+****************************************************************************//**
+*
+* Whether the firmware supports a feature.
+*
+* \param ol_info
+* The pointer to the ol_info_t structure \ref ol_info_t.
+*
+* \param cap
+* OL_CAP_* bits, all of which must be supported.
+*
+* \return true if supported, or if the firmware has not been probed
+*
+*******************************************************************************/
+bool cylpa_olm_caps_has(const ol_info_t *ol_info, uint32_t cap)
+{
+    if ( (ol_info == NULL) || !ol_info->caps.valid )
+    {
+        return true;
+    }
+    return ( (ol_info->caps.features & cap) == cap );
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_caps_slot_available
+****************************************************************************//**
+*
+* Whether an add of a firmware resource may succeed.
+*
+* \param ol_info
+* The pointer to the ol_info_t structure \ref ol_info_t.
+*
+* \param slot
+* The resource.
+*
+* \return false if all slots of the resource are known to be in use
+*
+*******************************************************************************/
+bool cylpa_olm_caps_slot_available(const ol_info_t *ol_info, ol_caps_slot_t slot)
+{
+    const ol_caps_t *caps;
+
+    if ( (ol_info == NULL) || (slot >= OL_CAPS_SLOT_MAX) || !ol_info->caps.valid )
+    {
+        return true;
+    }
+    caps = &ol_info->caps;
+    return (caps->slots_max[slot] == OL_CAPS_SLOTS_UNKNOWN) || (caps->slots_used[slot] < caps->slots_max[slot]);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_caps_slot_added
+****************************************************************************//**
+*
+* Account for an add of a firmware resource. A successful add takes a slot; an
+* add refused for lack of resources sets the slot count to the slots in use.
+*
+* \param ol_info
+* The pointer to the ol_info_t structure \ref ol_info_t.
+*
+* \param slot
+* The resource.
+*
+* \param whd_result
+* whd_result_t of the add.
+*
+*******************************************************************************/
+void cylpa_olm_caps_slot_added(ol_info_t *ol_info, ol_caps_slot_t slot, uint32_t whd_result)
+{
+    ol_caps_t *caps;
+
+    if ( (ol_info == NULL) || (slot >= OL_CAPS_SLOT_MAX) || !ol_info->caps.valid )
+    {
+        return;
+    }
+    caps = &ol_info->caps;
+
+    if (whd_result == WHD_SUCCESS)
+    {
+        if (caps->slots_used[slot] < (OL_CAPS_SLOTS_UNKNOWN - 1) )
+        {
+            caps->slots_used[slot]++;
+        }
+        if ( (caps->slots_max[slot] != OL_CAPS_SLOTS_UNKNOWN) && (caps->slots_used[slot] > caps->slots_max[slot]) )
+        {
+            /* A slot was freed behind our back; the learned count was too low */
+            caps->slots_max[slot] = OL_CAPS_SLOTS_UNKNOWN;
+        }
+    }
+    else if ( (whd_result == WHD_WLAN_NORESOURCE) && (caps->slots_max[slot] == OL_CAPS_SLOTS_UNKNOWN) )
+    {
+        caps->slots_max[slot] = caps->slots_used[slot];
+        OL_LOG_OLM(LOG_OLA_LVL_WARNING, "%s: firmware holds %u of resource %d\n", __func__,
+                   caps->slots_max[slot], slot);
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_caps_slot_removed
+****************************************************************************//**
+*
+* Give back a slot of a firmware resource after a successful remove.
+*
+* \param ol_info
+* The pointer to the ol_info_t structure \ref ol_info_t.
+*
+* \param slot
+* The resource.
+*
+*******************************************************************************/
+void cylpa_olm_caps_slot_removed(ol_info_t *ol_info, ol_caps_slot_t slot)
+{
+    if ( (ol_info == NULL) || (slot >= OL_CAPS_SLOT_MAX) || !ol_info->caps.valid )
+    {
+        return;
+    }
+    if (ol_info->caps.slots_used[slot] > 0)
+    {
+        ol_info->caps.slots_used[slot]--;
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_caps_slots_reset
+****************************************************************************//**
+*
+* Give back every slot of a firmware resource, e.g. after the firmware list was
+* cleared as a whole.
+*
+* \param ol_info
+* The pointer to the ol_info_t structure \ref ol_info_t.
+*
+* \param slot
+* The resource.
+*
+*******************************************************************************/
+void cylpa_olm_caps_slots_reset(ol_info_t *ol_info, ol_caps_slot_t slot)
+{
+    if ( (ol_info == NULL) || (slot >= OL_CAPS_SLOT_MAX) )
+    {
+        return;
+    }
+    ol_info->caps.slots_used[slot] = 0;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_get_caps
+****************************************************************************//**
+*
+* Firmware capabilities probed by the Offload Manager.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+* \return The capabilities, NULL if olm is NULL
+*
+*******************************************************************************/
+const ol_caps_t *cylpa_olm_get_caps(const olm_t *olm)
+{
+    if (olm == NULL)
+    {
+        return NULL;
+    }
+    return &olm->ol_info.caps;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,620 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+
+/**
+* @file cy_lpa_wifi_olm_exec.c
+* @brief Offload Manager deferred-work executor.
+*
+* Offloads hand work that must not run in a network stack or WHD callback to
+* the executor as caller-owned items (\ref olm_exec_item_t). Pending items are
+* kept in one list ordered by due time, so a delayed item needs no RTOS timer
+* of its own, and an item is never queued twice: a burst of events that submit
+* the same item results in one run. Among the items that are due, the one with
+* the highest priority runs first.
+*
+* The items are run by a thread the executor owns only if OLM_EXEC_THREAD is
+* set. By default they are run on the callers instead, which saves the stack of
+* a dedicated thread: the power-mode dispatch runs what is due once it has
+* released the OLM locks, and an application thread may call
+* cylpa_olm_exec_run() to have the work run sooner. So that an item is not left
+* waiting for the next power-mode transition, one RTOS timer shared by all items
+* is armed for the first one due, and runs what is due when it expires.
+*/
+
+#include <string.h>
+#include <stdbool.h>
+#include "cy_lpa_compat.h"
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_olm.h"
+#include "cy_lpa_wifi_ol_priv.h"
+#include "cyabs_rtos.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* Local definition
+*******************************************************************************/
+
+/* Executor shared by all Offload Managers */
+typedef struct olm_exec
+{
+    olm_exec_item_t *head;              /* Pending items by due time, submission order among equals */
+    uint32_t        users;              /* Offload Managers started and not stopped */
+    olm_exec_stats_t stats;
+    cy_mutex_t      mutex;
+    bool            locked;             /* mutex is initialized */
+#if (OLM_EXEC_THREAD != 0)
+    cy_semaphore_t  wake;               /* Set when an item is due earlier than the thread waits for */
+    cy_thread_t     thread;
+    volatile bool   stop;
+#else
+    cy_timer_t      timer;              /* Expires when the first pending item is due */
+    bool            timed;              /* timer is initialized */
+#endif
+} olm_exec_t;
+
+static olm_exec_t cylpa_olm_exec;
+
+#if (OLM_EXEC_THREAD != 0)
+/* Define a stack buffer so we don't require a malloc when creating the thread Aligned on 8-byte boundary! */
+__attribute__((aligned(CY_RTOS_ALIGNMENT))) static uint8_t cylpa_olm_exec_stack[OLM_EXEC_STACK_SIZE];
+#endif
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static void cylpa_olm_exec_lock(void);
+static void cylpa_olm_exec_unlock(void);
+static void cylpa_olm_exec_unlink(olm_exec_item_t *item);
+static void cylpa_olm_exec_wake(void);
+#if (OLM_EXEC_THREAD != 0)
+static void cylpa_olm_exec_thread(cy_thread_arg_t arg);
+#else
+static void cylpa_olm_exec_arm(uint32_t now);
+static void cylpa_olm_exec_timer(cy_timer_callback_arg_t arg);
+#endif
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_lock
+****************************************************************************//**
+*
+* Take the executor mutex, if created.
+*
+*******************************************************************************/
+static void cylpa_olm_exec_lock(void)
+{
+    if (cylpa_olm_exec.locked)
+    {
+        cy_rtos_get_mutex(&cylpa_olm_exec.mutex, CY_RTOS_NEVER_TIMEOUT);
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_unlock
+****************************************************************************//**
+*
+* Release the executor mutex, if created.
+*
+*******************************************************************************/
+static void cylpa_olm_exec_unlock(void)
+{
+    if (cylpa_olm_exec.locked)
+    {
+        cy_rtos_set_mutex(&cylpa_olm_exec.mutex);
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_unlink
+****************************************************************************//**
+*
+* Remove a pending item from the list. Called with the mutex held.
+*
+* \param item
+* The item.
+*
+*******************************************************************************/
+static void cylpa_olm_exec_unlink(olm_exec_item_t *item)
+{
+    olm_exec_item_t **link;
+
+    for (link = &cylpa_olm_exec.head; *link != NULL; link = &(*link)->next)
+    {
+        if (*link == item)
+        {
+            *link = item->next;
+            break;
+        }
+    }
+    item->next = NULL;
+    item->pending = false;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_wake
+****************************************************************************//**
+*
+* Tell whoever runs the items that the first due time moved earlier.
+*
+*******************************************************************************/
+static void cylpa_olm_exec_wake(void)
+{
+#if (OLM_EXEC_THREAD != 0)
+    if (cylpa_olm_exec.users > 0)
+    {
+        cy_rtos_set_semaphore(&cylpa_olm_exec.wake, false);
+    }
+#endif
+    cylpa_olm_exec_notify();
+}
+
+#if (OLM_EXEC_THREAD != 0)
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_thread
+****************************************************************************//**
+*
+* Executor thread: run what is due, then sleep until the next item is due or
+* an earlier one is submitted.
+*
+*******************************************************************************/
+static void cylpa_olm_exec_thread(cy_thread_arg_t arg)
+{
+    uint32_t wait;
+
+    (void)arg;
+    while (!cylpa_olm_exec.stop)
+    {
+        wait = cylpa_olm_exec_run();
+        if (!cylpa_olm_exec.stop)
+        {
+            cy_rtos_get_semaphore(&cylpa_olm_exec.wake, wait, false);
+        }
+    }
+    cy_rtos_exit_thread();
+}
+#else
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_arm
+****************************************************************************//**
+*
+* Set the timer to expire when the first pending item is due. Called with the
+* mutex held, so the timer always follows the head of the list.
+*
+* \param now
+* The current time.
+*
+*******************************************************************************/
+static void cylpa_olm_exec_arm(uint32_t now)
+{
+    int32_t left;
+
+    if (!cylpa_olm_exec.timed || (cylpa_olm_exec.head == NULL) )
+    {
+        return;
+    }
+    left = (int32_t)(cylpa_olm_exec.head->due - now);
+    cy_rtos_start_timer(&cylpa_olm_exec.timer, (left > 0) ? (cy_time_t)left : 1);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_timer
+****************************************************************************//**
+*
+* Timer expiry: run what is due, on the RTOS timer service. The run sets the
+* timer again for what is left.
+*
+*******************************************************************************/
+static void cylpa_olm_exec_timer(cy_timer_callback_arg_t arg)
+{
+    (void)arg;
+    (void)cylpa_olm_exec_run();
+}
+#endif
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_notify
+****************************************************************************//**
+*
+* Deferred work was submitted that is due before anything pending. Weak; an
+* application running the executor from its own thread may override this.
+*
+*******************************************************************************/
+CYPRESS_WEAK void cylpa_olm_exec_notify(void)
+{
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_start
+****************************************************************************//**
+*
+* Count an Offload Manager as a user of the executor and create the executor
+* thread for the first one.
+*
+* \param worker
+* The current ol_info_t::worker of the Offload Manager.
+*
+* \return The executor, to be stored in ol_info_t::worker; NULL on failure.
+*
+*******************************************************************************/
+void *cylpa_olm_exec_start(void *worker)
+{
+    if (worker == &cylpa_olm_exec)
+    {
+        return worker;
+    }
+
+    if (!cylpa_olm_exec.locked && (cy_rtos_init_mutex(&cylpa_olm_exec.mutex) == CY_RSLT_SUCCESS) )
+    {
+        cylpa_olm_exec.locked = true;
+    }
+
+#if (OLM_EXEC_THREAD != 0)
+    if (cylpa_olm_exec.users == 0)
+    {
+        if (cy_rtos_init_semaphore(&cylpa_olm_exec.wake, 1, 0) != CY_RSLT_SUCCESS)
+        {
+            return NULL;
+        }
+        cylpa_olm_exec.stop = false;
+        if (cy_rtos_create_thread(&cylpa_olm_exec.thread, cylpa_olm_exec_thread, "OLM Worker",
+                                  cylpa_olm_exec_stack, sizeof(cylpa_olm_exec_stack),
+                                  CY_RTOS_PRIORITY_NORMAL, NULL) != CY_RSLT_SUCCESS)
+        {
+            cy_rtos_deinit_semaphore(&cylpa_olm_exec.wake);
+            return NULL;
+        }
+    }
+#else
+    if ( (cylpa_olm_exec.users == 0) &&
+         (cy_rtos_init_timer(&cylpa_olm_exec.timer, CY_TIMER_TYPE_ONCE, cylpa_olm_exec_timer,
+                             (cy_timer_callback_arg_t)0) == CY_RSLT_SUCCESS) )
+    {
+        cylpa_olm_exec.timed = true;
+    }
+#endif
+    cylpa_olm_exec.users++;
+
+    return &cylpa_olm_exec;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_stop
+****************************************************************************//**
+*
+* Undo cylpa_olm_exec_start(). With the last user gone the executor thread is
+* deleted and anything still pending is dropped.
+*
+* \param worker
+* The ol_info_t::worker of the Offload Manager.
+*
+* \return NULL, for ol_info_t::worker.
+*
+*******************************************************************************/
+void *cylpa_olm_exec_stop(void *worker)
+{
+    if ( (worker != &cylpa_olm_exec) || (cylpa_olm_exec.users == 0) )
+    {
+        return NULL;
+    }
+
+    if (--cylpa_olm_exec.users > 0)
+    {
+        return NULL;
+    }
+
+#if (OLM_EXEC_THREAD != 0)
+    cylpa_olm_exec.stop = true;
+    cy_rtos_set_semaphore(&cylpa_olm_exec.wake, false);
+    cy_rtos_join_thread(&cylpa_olm_exec.thread);
+    cy_rtos_deinit_semaphore(&cylpa_olm_exec.wake);
+#else
+    if (cylpa_olm_exec.timed)
+    {
+        cylpa_olm_exec.timed = false;
+        cy_rtos_stop_timer(&cylpa_olm_exec.timer);
+        cy_rtos_deinit_timer(&cylpa_olm_exec.timer);
+    }
+#endif
+
+    cylpa_olm_exec_lock();
+    while (cylpa_olm_exec.head != NULL)
+    {
+        cylpa_olm_exec_unlink(cylpa_olm_exec.head);
+    }
+    cylpa_olm_exec_unlock();
+
+    return NULL;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_item_init
+****************************************************************************//**
+*
+* Prepare a work item.
+*
+* \param item
+* The item.
+*
+* \param fn
+* Function run by the executor.
+*
+* \param arg
+* Argument of fn.
+*
+* \param priority
+* Priority among the items due at the same time.
+*
+*******************************************************************************/
+void cylpa_olm_exec_item_init(olm_exec_item_t *item, olm_exec_fn_t *fn, void *arg, olm_exec_prio_t priority)
+{
+    memset(item, 0, sizeof(*item) );
+    item->fn = fn;
+    item->arg = arg;
+    item->priority = (uint8_t)priority;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_submit
+****************************************************************************//**
+*
+* Queue an item to run after delay_ms. An item that is already pending is not
+* queued again; it is only moved if delay_ms makes it due earlier.
+*
+* \param item
+* The item, prepared by cylpa_olm_exec_item_init().
+*
+* \param delay_ms
+* Time before the item may run, 0 to run it as soon as possible.
+*
+* \return RESULT_OK, RESULT_BADARGS if the item has no function.
+*
+*******************************************************************************/
+int cylpa_olm_exec_submit(olm_exec_item_t *item, uint32_t delay_ms)
+{
+    olm_exec_item_t **link;
+    cy_time_t now = 0;
+    uint32_t due;
+    bool first;
+
+    if (item == NULL)
+    {
+        return RESULT_BADARGS;
+    }
+
+    cy_rtos_get_time(&now);
+    due = (uint32_t)now + delay_ms;
+
+    cylpa_olm_exec_lock();
+    if (item->fn == NULL)
+    {
+        /* Not prepared, or disabled by cylpa_olm_exec_cancel_wait() */
+        cylpa_olm_exec_unlock();
+        return RESULT_BADARGS;
+    }
+    cylpa_olm_exec.stats.submitted++;
+    if (item->pending)
+    {
+        cylpa_olm_exec.stats.coalesced++;
+        if ( (int32_t)(due - item->due) >= 0 )
+        {
+            cylpa_olm_exec_unlock();
+            return RESULT_OK;
+        }
+        cylpa_olm_exec_unlink(item);
+    }
+
+    /* After the items due at the same time, so equal items run in submission order */
+    item->due = due;
+    for (link = &cylpa_olm_exec.head; *link != NULL; link = &(*link)->next)
+    {
+        if ( (int32_t)( (*link)->due - due ) > 0 )
+        {
+            break;
+        }
+    }
+    item->next = *link;
+    *link = item;
+    item->pending = true;
+    first = (cylpa_olm_exec.head == item);
+#if (OLM_EXEC_THREAD == 0)
+    if (first)
+    {
+        cylpa_olm_exec_arm( (uint32_t)now );
+    }
+#endif
+    cylpa_olm_exec_unlock();
+
+    if (first)
+    {
+        cylpa_olm_exec_wake();
+    }
+
+    return RESULT_OK;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_cancel
+****************************************************************************//**
+*
+* Remove a pending item. A run of the item already in progress is not waited for.
+*
+* \param item
+* The item.
+*
+*******************************************************************************/
+void cylpa_olm_exec_cancel(olm_exec_item_t *item)
+{
+    if (item == NULL)
+    {
+        return;
+    }
+
+    cylpa_olm_exec_lock();
+    if (item->pending)
+    {
+        cylpa_olm_exec_unlink(item);
+        cylpa_olm_exec.stats.cancelled++;
+    }
+    cylpa_olm_exec_unlock();
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_cancel_wait
+****************************************************************************//**
+*
+* Remove a pending item and wait until a run of the item in progress has
+* returned, so the caller may clear or reuse it. The item cannot be submitted
+* again until it is prepared with cylpa_olm_exec_item_init(). Must not be called
+* from the item's function or with a lock held that the function takes.
+*
+* \param item
+* The item.
+*
+*******************************************************************************/
+void cylpa_olm_exec_cancel_wait(olm_exec_item_t *item)
+{
+    if (item == NULL)
+    {
+        return;
+    }
+
+    cylpa_olm_exec_lock();
+    item->fn = NULL;
+    for ( ; ; )
+    {
+        if (item->pending)
+        {
+            cylpa_olm_exec_unlink(item);
+            cylpa_olm_exec.stats.cancelled++;
+        }
+        if (!item->running)
+        {
+            break;
+        }
+        cylpa_olm_exec_unlock();
+        cy_rtos_delay_milliseconds(1);
+        cylpa_olm_exec_lock();
+    }
+    cylpa_olm_exec_unlock();
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_run
+****************************************************************************//**
+*
+* Run the items that are due, highest priority first.
+*
+* \return Milliseconds until the next pending item is due, CY_RTOS_NEVER_TIMEOUT
+* if nothing is pending.
+*
+*******************************************************************************/
+uint32_t cylpa_olm_exec_run(void)
+{
+    olm_exec_item_t **link, **best;
+    olm_exec_item_t *item;
+    olm_exec_fn_t *fn;
+    void *arg;
+    cy_time_t now = 0;
+    uint32_t left;
+
+    for ( ; ; )
+    {
+        cylpa_olm_exec_lock();
+        cy_rtos_get_time(&now);
+
+        /* The due items are at the front of the list */
+        best = NULL;
+        for (link = &cylpa_olm_exec.head;
+             (*link != NULL) && ( (int32_t)( (*link)->due - (uint32_t)now ) <= 0 );
+             link = &(*link)->next)
+        {
+            if ( (best == NULL) || ( (*link)->priority > (*best)->priority ) )
+            {
+                best = link;
+            }
+        }
+
+        if (best == NULL)
+        {
+            left = (cylpa_olm_exec.head != NULL) ? (cylpa_olm_exec.head->due - (uint32_t)now) : CY_RTOS_NEVER_TIMEOUT;
+#if (OLM_EXEC_THREAD == 0)
+            cylpa_olm_exec_arm( (uint32_t)now );
+#endif
+            cylpa_olm_exec_unlock();
+            return left;
+        }
+
+        item = *best;
+        *best = item->next;
+        item->next = NULL;
+        item->pending = false;
+        item->running = true;
+        fn = item->fn;
+        arg = item->arg;
+        cylpa_olm_exec.stats.runs++;
+        cylpa_olm_exec_unlock();
+
+        /* Unlocked, so fn may submit work, including its own item */
+        (*fn)(arg);
+
+        cylpa_olm_exec_lock();
+        item->running = false;
+        cylpa_olm_exec_unlock();
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_exec_get_stats
+****************************************************************************//**
+*
+* Read the executor counters.
+*
+* \param stats
+* Filled in with a copy of the counters.
+*
+*******************************************************************************/
+void cylpa_olm_exec_get_stats(olm_exec_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+
+    cylpa_olm_exec_lock();
+    *stats = cylpa_olm_exec.stats;
+    cylpa_olm_exec_unlock();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,196 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+
+/**
+* @file cy_lpa_wifi_olm_latency.c
+* @brief Offload Manager init and power-mode transition latency histograms.
+*
+* Each offload's init function and power-mode handlers are timestamped by the
+* Offload Manager. Samples go into fixed-size log2 histograms with min, max and
+* last value, one per offload and operation, plus one for the whole OLM. A
+* sample costs two timestamps and a few compares, so the histograms can stay
+* enabled in production builds; set OLM_LATENCY_STATS to 0 to compile them out.
+*/
+
+#include <string.h>
+#include <stdbool.h>
+#include "cy_lpa_compat.h"
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_olm.h"
+#include "cy_lpa_wifi_ol_priv.h"
+#include "cyabs_rtos.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* Function Name: cylpa_olm_latency_now_us
+****************************************************************************//**
+*
+* Microsecond timestamp; wraps. The default has the resolution of the RTOS tick.
+*
+*******************************************************************************/
+CYPRESS_WEAK uint32_t cylpa_olm_latency_now_us(void)
+{
+    cy_time_t now = 0;
+
+    (void)cy_rtos_get_time(&now);
+    return (uint32_t)now * 1000;
+}
+
+#if (OLM_LATENCY_STATS != 0)
+
+/*******************************************************************************
+* Function Name: cylpa_olm_latency_record
+****************************************************************************//**
+*
+* Add a sample to a histogram.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+* \param idx
+* Registry slot of the offload, OLM_MAX_OFFLOADS for the whole OLM.
+*
+* \param id
+* The timed operation.
+*
+* \param elapsed_us
+* The sample.
+*
+*******************************************************************************/
+void cylpa_olm_latency_record(olm_t *olm, uint32_t idx, olm_latency_id_t id, uint32_t elapsed_us)
+{
+    olm_latency_t *lat;
+    uint32_t bucket = 0;
+    uint32_t v;
+
+    if ( (idx > OLM_MAX_OFFLOADS) || (id >= OLM_LATENCY_MAX) )
+    {
+        return;
+    }
+    lat = &olm->latency[idx][id];
+
+    if ( (lat->count == 0) || (elapsed_us < lat->min_us) )
+    {
+        lat->min_us = elapsed_us;
+    }
+    if (elapsed_us > lat->max_us)
+    {
+        lat->max_us = elapsed_us;
+    }
+    lat->last_us = elapsed_us;
+    lat->count++;
+
+    /* bucket = number of significant bits of the sample */
+    for (v = elapsed_us; (v != 0) && (bucket < (OLM_LATENCY_BUCKETS - 1) ); v >>= 1)
+    {
+        bucket++;
+    }
+    if (lat->buckets[bucket] != UINT16_MAX)
+    {
+        lat->buckets[bucket]++;
+    }
+}
+
+#endif /* OLM_LATENCY_STATS */
+
+/*******************************************************************************
+* Function Name: cylpa_olm_get_latency
+****************************************************************************//**
+*
+* Read the latency histogram of an offload, or of the whole OLM.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+* \param name
+* Offload name, NULL for the whole OLM.
+*
+* \param id
+* The timed operation.
+*
+* \param latency
+* Filled in with a copy of the histogram.
+*
+* \return RESULT_OK, RESULT_BADARGS or RESULT_UNSUPPORTED
+*
+*******************************************************************************/
+int cylpa_olm_get_latency(const olm_t *olm, const char *name, olm_latency_id_t id, olm_latency_t *latency)
+{
+#if (OLM_LATENCY_STATS != 0)
+    uint32_t idx = OLM_MAX_OFFLOADS;
+
+    if ( (olm == NULL) || (latency == NULL) || (id >= OLM_LATENCY_MAX) )
+    {
+        return RESULT_BADARGS;
+    }
+
+    if (name != NULL)
+    {
+        idx = cylpa_olm_reg_slot(olm, cylpa_olm_find(olm, name) );
+        if (idx == OLM_MAX_OFFLOADS)
+        {
+            return RESULT_BADARGS;
+        }
+    }
+
+    memcpy(latency, &olm->latency[idx][id], sizeof(*latency) );
+    return RESULT_OK;
+#else
+    return RESULT_UNSUPPORTED;
+#endif
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reset_latency
+****************************************************************************//**
+*
+* Clear all latency histograms.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+*******************************************************************************/
+void cylpa_olm_reset_latency(olm_t *olm)
+{
+#if (OLM_LATENCY_STATS != 0)
+    if (olm != NULL)
+    {
+        memset(olm->latency, 0, sizeof(olm->latency) );
+    }
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,752 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+
+/**
+* @file cy_lpa_wifi_olm_reg.c
+* @brief Offload Manager registry of offloads.
+*
+* The offloads of an Offload Manager live in a fixed-size table of slots. A
+* handle names a slot and the generation it was registered in, so a handle kept
+* across an unregister cannot reach the offload that reuses the slot. Name and
+* type lookups go through small open-addressed hashes, and the power-mode and
+* deinit paths walk precomputed arrays of the offloads that have the hook. The
+* hashes and arrays (the view) are rebuilt when an offload is registered or
+* unregistered, which is rare, into the view not in use, then published.
+*
+* Changes, lookups and the power-mode dispatch all hold the registry lock, so a
+* view is never rebuilt while it is read and an offload is never deinitialized
+* while it is notified. The lock is recursive; offload APIs that take it may be
+* called from a pm handler.
+*/
+
+#include <string.h>
+#include <stdbool.h>
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_olm.h"
+#include "cy_lpa_wifi_ol_priv.h"
+#include "cyabs_rtos.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* Local definition
+*******************************************************************************/
+#if (OLM_MAX_OFFLOADS > 254)
+#error "OLM_MAX_OFFLOADS must be at most 254"
+#endif
+
+#define OLM_REG_HANDLE(gen, slot)       ( ( (uint32_t)(gen) << 8 ) | ( (uint32_t)(slot) + 1 ) )
+#define OLM_REG_HANDLE_SLOT(handle)     ( ( (handle) & 0xFF ) - 1 )
+#define OLM_REG_HANDLE_GEN(handle)      ( (uint16_t)( (handle) >> 8 ) )
+
+/* Serializes cylpa_olm_register(), cylpa_olm_unregister() and cylpa_olm_reconfigure() with
+ * the lookups and the power-mode dispatch */
+static cy_mutex_t cy_olm_reg_mutex;
+static bool cy_olm_reg_mutex_init = false;
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_hash_name
+****************************************************************************//**
+*
+* FNV-1a hash of an offload name.
+*
+*******************************************************************************/
+static uint32_t cylpa_olm_reg_hash_name(const char *name)
+{
+    uint32_t hash = 2166136261UL;
+
+    while (*name != '\0')
+    {
+        hash = (hash ^ (uint8_t)*name++) * 16777619UL;
+    }
+    return hash % OLM_REG_HASH_SIZE;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_hash_type
+****************************************************************************//**
+*
+* Hash of an offload type (its function table address).
+*
+*******************************************************************************/
+static uint32_t cylpa_olm_reg_hash_type(const struct ol_fns *fns)
+{
+    uint32_t hash = (uint32_t)( (uintptr_t)fns >> 2 );
+
+    return (hash ^ (hash >> 7) ) % OLM_REG_HASH_SIZE;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_insert
+****************************************************************************//**
+*
+* Add a slot to an open-addressed hash. The hash has twice as many buckets as
+* there are slots, so there is always a free one.
+*
+*******************************************************************************/
+static void cylpa_olm_reg_insert(uint8_t *table, uint32_t hash, uint32_t slot)
+{
+    while (table[hash] != 0)
+    {
+        hash = (hash + 1) % OLM_REG_HASH_SIZE;
+    }
+    table[hash] = (uint8_t)(slot + 1);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_publish
+****************************************************************************//**
+*
+* Rebuild the lookup and dispatch arrays into the spare view and publish it.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+*******************************************************************************/
+static void cylpa_olm_reg_publish(olm_t *olm)
+{
+    olm_reg_view_t *view = &olm->reg.views[olm->reg.view ^ 1];
+    const ol_desc_t *desc;
+    uint32_t slot;
+    uint32_t i;
+
+    memset(view, 0, sizeof(*view) );
+    for (i = 0; i < olm->reg.count; i++)
+    {
+        slot = olm->reg.order[i];
+        desc = olm->reg.entries[slot].desc;
+        if (desc->fns->pm != NULL)
+        {
+            view->pm[view->pm_count++] = (uint8_t)slot;
+        }
+        if (desc->fns->deinit != NULL)
+        {
+            view->deinit[view->deinit_count++] = (uint8_t)slot;
+        }
+        if (desc->name != NULL)
+        {
+            cylpa_olm_reg_insert(view->by_name, cylpa_olm_reg_hash_name(desc->name), slot);
+        }
+        cylpa_olm_reg_insert(view->by_type, cylpa_olm_reg_hash_type(desc->fns), slot);
+    }
+
+    olm->reg.view ^= 1;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_alloc
+****************************************************************************//**
+*
+* Take a free slot for desc; it is not visible until cylpa_olm_reg_link().
+*
+* \return The slot, or OLM_MAX_OFFLOADS if the registry is full
+*
+*******************************************************************************/
+static uint32_t cylpa_olm_reg_alloc(olm_t *olm, const ol_desc_t *desc)
+{
+    uint32_t slot;
+
+    for (slot = 0; slot < OLM_MAX_OFFLOADS; slot++)
+    {
+        if (olm->reg.entries[slot].desc == NULL)
+        {
+            olm->reg.entries[slot].desc = desc;
+            olm->reg.entries[slot].active = false;
+            break;
+        }
+    }
+    return slot;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_link
+****************************************************************************//**
+*
+* Append an allocated slot to the registration order and publish it.
+*
+*******************************************************************************/
+static void cylpa_olm_reg_link(olm_t *olm, uint32_t slot)
+{
+    olm->reg.order[olm->reg.count++] = (uint8_t)slot;
+    cylpa_olm_reg_publish(olm);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_free
+****************************************************************************//**
+*
+* Return a slot to the free list; handles to it become stale.
+*
+*******************************************************************************/
+static void cylpa_olm_reg_free(olm_t *olm, uint32_t slot)
+{
+    olm->reg.entries[slot].desc = NULL;
+    olm->reg.entries[slot].active = false;
+    olm->reg.entries[slot].gen++;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_reset
+****************************************************************************//**
+*
+* Empty the registry. Called by cylpa_olm_init().
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+*******************************************************************************/
+void cylpa_olm_reg_reset(olm_t *olm)
+{
+    uint32_t i;
+
+    if (!cy_olm_reg_mutex_init)
+    {
+        cy_olm_reg_mutex_init = (cy_rtos_init_mutex(&cy_olm_reg_mutex) == CY_RSLT_SUCCESS);
+    }
+
+    for (i = 0; i < OLM_MAX_OFFLOADS; i++)
+    {
+        if (olm->reg.entries[i].desc != NULL)
+        {
+            cylpa_olm_reg_free(olm, i);
+        }
+    }
+    olm->reg.count = 0;
+    olm->reg.overflow = false;
+    cylpa_olm_reg_publish(olm);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_lock
+****************************************************************************//**
+*
+* Serialize with register, unregister and reconfigure of any Offload Manager,
+* and with the power-mode dispatch. Offloads take it in their own APIs that read
+* or change their configuration.
+*
+*******************************************************************************/
+void cylpa_olm_reg_lock(void)
+{
+    if (cy_olm_reg_mutex_init)
+    {
+        cy_rtos_get_mutex(&cy_olm_reg_mutex, CY_RTOS_NEVER_TIMEOUT);
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_unlock
+****************************************************************************//**
+*
+* Undo cylpa_olm_reg_lock().
+*
+*******************************************************************************/
+void cylpa_olm_reg_unlock(void)
+{
+    if (cy_olm_reg_mutex_init)
+    {
+        cy_rtos_set_mutex(&cy_olm_reg_mutex);
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_add
+****************************************************************************//**
+*
+* Register an offload without initializing it.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+* \param desc
+* The offload.
+*
+* \return The handle, or OLM_HANDLE_INVALID if the registry is full
+*
+*******************************************************************************/
+olm_handle_t cylpa_olm_reg_add(olm_t *olm, const ol_desc_t *desc)
+{
+    uint32_t slot = cylpa_olm_reg_alloc(olm, desc);
+
+    if (slot == OLM_MAX_OFFLOADS)
+    {
+        return OLM_HANDLE_INVALID;
+    }
+    cylpa_olm_reg_link(olm, slot);
+    return OLM_REG_HANDLE(olm->reg.entries[slot].gen, slot);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_slot
+****************************************************************************//**
+*
+* Slot of a handle.
+*
+* \return The slot, or OLM_MAX_OFFLOADS if the handle is stale
+*
+*******************************************************************************/
+uint32_t cylpa_olm_reg_slot(const olm_t *olm, olm_handle_t handle)
+{
+    uint32_t slot = OLM_REG_HANDLE_SLOT(handle);
+
+    if ( (handle == OLM_HANDLE_INVALID) || (slot >= OLM_MAX_OFFLOADS) ||
+         (olm->reg.entries[slot].desc == NULL) || (olm->reg.entries[slot].gen != OLM_REG_HANDLE_GEN(handle) ) )
+    {
+        return OLM_MAX_OFFLOADS;
+    }
+    return slot;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_deps_active
+****************************************************************************//**
+*
+* Whether every registered offload that desc depends on is initialized.
+*
+*******************************************************************************/
+static bool cylpa_olm_reg_deps_active(const olm_t *olm, const ol_desc_t *desc)
+{
+    const struct ol_fns * const *dep;
+    const olm_reg_entry_t *entry;
+    uint32_t i;
+
+    for (dep = desc->fns->deps; (dep != NULL) && (*dep != NULL); dep++)
+    {
+        /* A dependency that is not registered is satisfied */
+        for (i = 0; i < olm->reg.count; i++)
+        {
+            entry = &olm->reg.entries[olm->reg.order[i]];
+            if ( (entry->desc->fns == *dep) && !entry->active )
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reg_needed
+****************************************************************************//**
+*
+* Whether an initialized offload other than slot depends on the type of slot.
+*
+*******************************************************************************/
+static bool cylpa_olm_reg_needed(const olm_t *olm, uint32_t slot)
+{
+    const struct ol_fns *fns = olm->reg.entries[slot].desc->fns;
+    const struct ol_fns * const *dep;
+    const olm_reg_entry_t *entry;
+    uint32_t i;
+
+    for (i = 0; i < olm->reg.count; i++)
+    {
+        entry = &olm->reg.entries[olm->reg.order[i]];
+        if ( (olm->reg.order[i] == slot) || !entry->active )
+        {
+            continue;
+        }
+        for (dep = entry->desc->fns->deps; (dep != NULL) && (*dep != NULL); dep++)
+        {
+            if (*dep == fns)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_register
+****************************************************************************//**
+*
+* Register an offload, initializing it now if the offloads are up.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+* \param desc
+* The offload.
+*
+* \param handle
+* Filled in with the handle, may be NULL.
+*
+* \return RESULT_OK, RESULT_BADARGS, or the result of the offload init function
+*
+*******************************************************************************/
+int cylpa_olm_register(olm_t *olm, const ol_desc_t *desc, olm_handle_t *handle)
+{
+    uint32_t slot;
+    int result = RESULT_OK;
+
+    if ( (olm == NULL) || (desc == NULL) || (desc->fns == NULL) )
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s Bad Arg\n", __func__);
+        return RESULT_BADARGS;
+    }
+
+    cylpa_olm_reg_lock();
+
+    slot = cylpa_olm_reg_alloc(olm, desc);
+    if (slot == OLM_MAX_OFFLOADS)
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s %s: more than OLM_MAX_OFFLOADS (%d) offloads\n", __func__, desc->name,
+                   OLM_MAX_OFFLOADS);
+        result = RESULT_BADARGS;
+    }
+    else if (olm->ols_up)
+    {
+        /* Initialize before it is published, so it is never notified uninitialized */
+        if (!cylpa_olm_reg_deps_active(olm, desc) )
+        {
+            OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s %s: dependency not initialized\n", __func__, desc->name);
+            result = RESULT_BADARGS;
+        }
+        else if (desc->fns->init != NULL)
+        {
+            result = (*desc->fns->init)(desc->ol, &olm->ol_info, desc->cfg);
+        }
+
+        if (result == RESULT_OK)
+        {
+            olm->reg.entries[slot].active = true;
+        }
+        else
+        {
+            OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s %s: init failed %d\n", __func__, desc->name, result);
+            cylpa_olm_reg_free(olm, slot);
+        }
+    }
+
+    if (result == RESULT_OK)
+    {
+        cylpa_olm_reg_link(olm, slot);
+        if (handle != NULL)
+        {
+            *handle = OLM_REG_HANDLE(olm->reg.entries[slot].gen, slot);
+        }
+        OL_LOG_OLM(LOG_OLA_LVL_INFO, "%s %s slot:%lu\n", __func__, desc->name, (unsigned long)slot);
+    }
+
+    cylpa_olm_reg_unlock();
+    return result;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_unregister
+****************************************************************************//**
+*
+* Unregister an offload, deinitializing it if it is initialized.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+* \param handle
+* The offload.
+*
+* \return RESULT_OK or RESULT_BADARGS
+*
+*******************************************************************************/
+int cylpa_olm_unregister(olm_t *olm, olm_handle_t handle)
+{
+    const ol_desc_t *desc;
+    uint32_t slot;
+    uint32_t i;
+    int result = RESULT_OK;
+
+    if (olm == NULL)
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s Bad Arg\n", __func__);
+        return RESULT_BADARGS;
+    }
+
+    cylpa_olm_reg_lock();
+
+    slot = cylpa_olm_reg_slot(olm, handle);
+    if (slot == OLM_MAX_OFFLOADS)
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s stale handle 0x%lx\n", __func__, (unsigned long)handle);
+        result = RESULT_BADARGS;
+    }
+    else if (olm->reg.entries[slot].active && cylpa_olm_reg_needed(olm, slot) )
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s %s: needed by another offload\n", __func__,
+                   olm->reg.entries[slot].desc->name);
+        result = RESULT_BADARGS;
+    }
+    else
+    {
+        desc = olm->reg.entries[slot].desc;
+
+        /* Stop dispatching to it first */
+        for (i = 0; olm->reg.order[i] != slot; i++)
+        {
+        }
+        memmove(&olm->reg.order[i], &olm->reg.order[i + 1], olm->reg.count - i - 1);
+        olm->reg.count--;
+        cylpa_olm_reg_publish(olm);
+
+        if (olm->reg.entries[slot].active)
+        {
+            cylpa_olm_defer_cancel(olm, desc->ol);
+            if (desc->fns->deinit != NULL)
+            {
+                (*desc->fns->deinit)(desc->ol);
+            }
+        }
+        cylpa_olm_reg_free(olm, slot);
+        OL_LOG_OLM(LOG_OLA_LVL_INFO, "%s %s slot:%lu\n", __func__, desc->name, (unsigned long)slot);
+    }
+
+    cylpa_olm_reg_unlock();
+    return result;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_reconfigure
+****************************************************************************//**
+*
+* Change the configuration of a registered offload, in place if the offload
+* supports it, else by deinitializing and initializing it again.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+* \param handle
+* The offload.
+*
+* \param desc
+* The new descriptor, for the same offload type and instance.
+*
+* \return RESULT_OK, RESULT_BADARGS, RESULT_UNSUPPORTED, or the result of the
+* offload function
+*
+*******************************************************************************/
+int cylpa_olm_reconfigure(olm_t *olm, olm_handle_t handle, const ol_desc_t *desc)
+{
+    olm_reg_entry_t *entry;
+    uint32_t slot;
+    int result = RESULT_OK;
+
+    if ( (olm == NULL) || (desc == NULL) || (desc->fns == NULL) )
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s Bad Arg\n", __func__);
+        return RESULT_BADARGS;
+    }
+
+    cylpa_olm_reg_lock();
+
+    slot = cylpa_olm_reg_slot(olm, handle);
+    entry = &olm->reg.entries[(slot == OLM_MAX_OFFLOADS) ? 0 : slot];
+    if ( (slot == OLM_MAX_OFFLOADS) || (entry->desc->fns != desc->fns) || (entry->desc->ol != desc->ol) )
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s stale handle 0x%lx or other offload\n", __func__, (unsigned long)handle);
+        result = RESULT_BADARGS;
+    }
+    else if (!entry->active)
+    {
+        /* Picked up by the next cylpa_olm_init_ols() */
+        entry->desc = desc;
+    }
+    else
+    {
+        if (desc->fns->reconfig != NULL)
+        {
+            result = (*desc->fns->reconfig)(desc->ol, desc->cfg);
+        }
+        else
+        {
+            result = RESULT_UNSUPPORTED;
+        }
+
+        if (result == RESULT_UNSUPPORTED)
+        {
+            if (cylpa_olm_reg_needed(olm, slot) )
+            {
+                OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s %s: needed by another offload\n", __func__, desc->name);
+            }
+            else
+            {
+                cylpa_olm_defer_cancel(olm, desc->ol);
+                if (desc->fns->deinit != NULL)
+                {
+                    (*desc->fns->deinit)(desc->ol);
+                }
+                result = (desc->fns->init != NULL) ? (*desc->fns->init)(desc->ol, &olm->ol_info, desc->cfg) :
+                         RESULT_OK;
+                entry->active = (result == RESULT_OK);
+                entry->desc = desc;
+                if (!entry->active)
+                {
+                    /* Stays registered but is neither notified nor deinitialized; a later
+                     * reconfiguration or cylpa_olm_init_ols() initializes it again */
+                    OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s %s: init failed %d, offload inactive\n", __func__,
+                               desc->name, result);
+                }
+            }
+        }
+        else
+        {
+            entry->desc = desc;
+        }
+    }
+
+    if (entry->desc == desc)
+    {
+        /* The name may have changed */
+        cylpa_olm_reg_publish(olm);
+        OL_LOG_OLM(LOG_OLA_LVL_INFO, "%s %s slot:%lu result:%d\n", __func__, desc->name, (unsigned long)slot, result);
+    }
+
+    cylpa_olm_reg_unlock();
+    return result;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_find
+****************************************************************************//**
+*
+* Find a registered offload by name.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+* \param name
+* Offload name.
+*
+* \return The handle, or OLM_HANDLE_INVALID
+*
+*******************************************************************************/
+olm_handle_t cylpa_olm_find(const olm_t *olm, const char *name)
+{
+    const olm_reg_view_t *view;
+    const ol_desc_t *desc;
+    uint32_t hash;
+    uint32_t slot;
+    olm_handle_t handle = OLM_HANDLE_INVALID;
+
+    if ( (olm == NULL) || (name == NULL) )
+    {
+        return OLM_HANDLE_INVALID;
+    }
+
+    cylpa_olm_reg_lock();
+    view = &olm->reg.views[olm->reg.view];
+    for (hash = cylpa_olm_reg_hash_name(name); view->by_name[hash] != 0; hash = (hash + 1) % OLM_REG_HASH_SIZE)
+    {
+        slot = view->by_name[hash] - 1U;
+        desc = olm->reg.entries[slot].desc;
+        if ( (desc != NULL) && (strcmp(desc->name, name) == 0) )
+        {
+            handle = OLM_REG_HANDLE(olm->reg.entries[slot].gen, slot);
+            break;
+        }
+    }
+    cylpa_olm_reg_unlock();
+    return handle;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_find_type
+****************************************************************************//**
+*
+* Find the first registered offload of a type.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+* \param fns
+* The offload type.
+*
+* \return The handle, or OLM_HANDLE_INVALID
+*
+*******************************************************************************/
+olm_handle_t cylpa_olm_find_type(const olm_t *olm, const struct ol_fns *fns)
+{
+    const olm_reg_view_t *view;
+    const ol_desc_t *desc;
+    uint32_t hash;
+    uint32_t slot;
+    olm_handle_t handle = OLM_HANDLE_INVALID;
+
+    if ( (olm == NULL) || (fns == NULL) )
+    {
+        return OLM_HANDLE_INVALID;
+    }
+
+    cylpa_olm_reg_lock();
+    view = &olm->reg.views[olm->reg.view];
+    for (hash = cylpa_olm_reg_hash_type(fns); view->by_type[hash] != 0; hash = (hash + 1) % OLM_REG_HASH_SIZE)
+    {
+        slot = view->by_type[hash] - 1U;
+        desc = olm->reg.entries[slot].desc;
+        if ( (desc != NULL) && (desc->fns == fns) )
+        {
+            handle = OLM_REG_HANDLE(olm->reg.entries[slot].gen, slot);
+            break;
+        }
+    }
+    cylpa_olm_reg_unlock();
+    return handle;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_get_desc
+****************************************************************************//**
+*
+* Return the descriptor of a registered offload.
+*
+* \param olm
+* The pointer to the olm structure \ref olm_t.
+*
+* \param handle
+* The offload.
+*
+* \return The descriptor, or NULL if the handle is stale
+*
+*******************************************************************************/
+const ol_desc_t *cylpa_olm_get_desc(const olm_t *olm, olm_handle_t handle)
+{
+    uint32_t slot;
+
+    if (olm == NULL)
+    {
+        return NULL;
+    }
+    slot = cylpa_olm_reg_slot(olm, handle);
+    return (slot < OLM_MAX_OFFLOADS) ? olm->reg.entries[slot].desc : NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
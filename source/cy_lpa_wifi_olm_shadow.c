@@ -0,0 +1,569 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+
+/**
+* @file cy_lpa_wifi_olm_shadow.c
+* @brief Offload Manager shadow of the firmware state.
+*
+* Remembers the values written to (or read from) the WLAN firmware, keyed by
+* interface, IOVAR name and an index (e.g. the packet filter id), so that
+* offloads only issue the IOVARs whose value actually changes. The shadow is
+* dropped whenever the firmware may have lost its state: on Offload Manager
+* initialization (firmware load) and on disassociation or link change.
+*/
+
+#include <string.h>
+#include <stdbool.h>
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_olm.h"
+#include "cy_lpa_wifi_ol_priv.h"
+#include "whd_wifi_api.h"
+#include "cyabs_rtos.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* Local definition
+*******************************************************************************/
+#define OLM_SHADOW_NO_EVENT_ENTRY   (0xFF)
+
+/* One known firmware value */
+typedef struct olm_shadow_entry
+{
+    void        *whd;                           /* NULL if unused */
+    const char  *iovar;
+    uint32_t    index;
+    uint32_t    generation;                     /* valid only while equal to cylpa_olm_shadow.generation */
+    uint8_t     len;
+    uint8_t     data[OLM_SHADOW_DATA_SIZE];
+} olm_shadow_entry_t;
+
+/* Link event registration on one interface */
+typedef struct olm_shadow_events
+{
+    void        *whd;                           /* NULL if unused */
+    uint16_t    entry;                          /* OLM_SHADOW_NO_EVENT_ENTRY if registration failed */
+} olm_shadow_events_t;
+
+static struct
+{
+    /* Bumped to drop every entry at once; the only field written from the WHD event thread */
+    volatile uint32_t   generation;
+    olm_shadow_events_t events[OLM_MAX_INSTANCES];
+    bool                disabled;       /* set while link events cannot be received on an interface */
+    bool                locked;         /* mutex initialized */
+    cy_mutex_t          mutex;          /* offload inits may run concurrently */
+    olm_shadow_stats_t  stats;
+    olm_shadow_entry_t  entries[OLM_SHADOW_MAX_ENTRIES];
+} cylpa_olm_shadow;
+
+/* Events after which the firmware no longer holds the association state we configured */
+static const whd_event_num_t cylpa_olm_shadow_events[] =
+{
+    WLC_E_LINK, WLC_E_DEAUTH_IND, WLC_E_DISASSOC_IND, WLC_E_NONE
+};
+
+#define OLM_SHADOW_LOCK()       do { if (cylpa_olm_shadow.locked) { cy_rtos_get_mutex(&cylpa_olm_shadow.mutex, CY_RTOS_NEVER_TIMEOUT); } } while (0)
+#define OLM_SHADOW_UNLOCK()     do { if (cylpa_olm_shadow.locked) { cy_rtos_set_mutex(&cylpa_olm_shadow.mutex); } } while (0)
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_find
+****************************************************************************//**
+*
+* Find the valid entry for (whd, iovar, index).
+*
+*******************************************************************************/
+static olm_shadow_entry_t *cylpa_olm_shadow_find(void *whd, const char *iovar, uint32_t index)
+{
+    olm_shadow_entry_t *e;
+    uint32_t i;
+
+    if (cylpa_olm_shadow.disabled)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < OLM_SHADOW_MAX_ENTRIES; i++)
+    {
+        e = &cylpa_olm_shadow.entries[i];
+        if ( (e->whd == whd) && (e->index == index) && (e->generation == cylpa_olm_shadow.generation) &&
+             ( (e->iovar == iovar) || (strcmp(e->iovar, iovar) == 0) ) )
+        {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_event_handler
+****************************************************************************//**
+*
+* WHD event handler; the firmware state is no longer known after the link
+* changed.
+*
+*******************************************************************************/
+static void *cylpa_olm_shadow_event_handler(whd_interface_t ifp, const whd_event_header_t *event_header,
+                                            const uint8_t *event_data, void *handler_user_data)
+{
+    if (event_header != NULL)
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "%s: event %d, dropping firmware shadow\n", __func__,
+                   (int)event_header->event_type);
+        cylpa_olm_shadow_invalidate();
+    }
+    return handler_user_data;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_init
+****************************************************************************//**
+*
+* Create the mutex guarding the shadow. Called once from cylpa_olm_init(),
+* before offloads can be initialized concurrently.
+*
+*******************************************************************************/
+void cylpa_olm_shadow_init(void)
+{
+    if (!cylpa_olm_shadow.locked && (cy_rtos_init_mutex(&cylpa_olm_shadow.mutex) == CY_RSLT_SUCCESS) )
+    {
+        cylpa_olm_shadow.locked = true;
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_invalidate
+****************************************************************************//**
+*
+* Forget everything known about the firmware state of all interfaces.
+*
+*******************************************************************************/
+void cylpa_olm_shadow_invalidate(void)
+{
+    cylpa_olm_shadow.generation++;
+    cylpa_olm_shadow.stats.invalidations++;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_forget
+****************************************************************************//**
+*
+* Forget the value of one IOVAR.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param iovar
+* IOVAR name.
+*
+* \param index
+* Instance of the IOVAR (e.g. packet filter id), 0 if there is only one.
+*
+*******************************************************************************/
+void cylpa_olm_shadow_forget(void *whd, const char *iovar, uint32_t index)
+{
+    olm_shadow_entry_t *e;
+
+    OLM_SHADOW_LOCK();
+    e = cylpa_olm_shadow_find(whd, iovar, index);
+    if (e != NULL)
+    {
+        e->whd = NULL;
+    }
+    OLM_SHADOW_UNLOCK();
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_match
+****************************************************************************//**
+*
+* Check whether the firmware already holds a value.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param iovar
+* IOVAR name.
+*
+* \param index
+* Instance of the IOVAR, 0 if there is only one.
+*
+* \param data
+* Value about to be written.
+*
+* \param len
+* Length of data.
+*
+* \return
+* true if the IOVAR write can be skipped.
+*
+*******************************************************************************/
+bool cylpa_olm_shadow_match(void *whd, const char *iovar, uint32_t index, const void *data, uint8_t len)
+{
+    olm_shadow_entry_t *e;
+    bool hit;
+
+    OLM_SHADOW_LOCK();
+    e = cylpa_olm_shadow_find(whd, iovar, index);
+    hit = (e != NULL) && (e->len == len) && (memcmp(e->data, data, len) == 0);
+    if (hit)
+    {
+        cylpa_olm_shadow.stats.hits++;
+    }
+    else
+    {
+        cylpa_olm_shadow.stats.misses++;
+    }
+    OLM_SHADOW_UNLOCK();
+    return hit;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_read
+****************************************************************************//**
+*
+* Read a value known to be held by the firmware.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param iovar
+* IOVAR name.
+*
+* \param index
+* Instance of the IOVAR, 0 if there is only one.
+*
+* \param data
+* Receives the value.
+*
+* \param len
+* Length of data.
+*
+* \return
+* true if the value is known and data was filled in.
+*
+*******************************************************************************/
+bool cylpa_olm_shadow_read(void *whd, const char *iovar, uint32_t index, void *data, uint8_t len)
+{
+    olm_shadow_entry_t *e;
+    bool hit;
+
+    OLM_SHADOW_LOCK();
+    e = cylpa_olm_shadow_find(whd, iovar, index);
+    hit = (e != NULL) && (e->len == len);
+    if (hit)
+    {
+        memcpy(data, e->data, len);
+        cylpa_olm_shadow.stats.hits++;
+    }
+    else
+    {
+        cylpa_olm_shadow.stats.misses++;
+    }
+    OLM_SHADOW_UNLOCK();
+    return hit;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_store
+****************************************************************************//**
+*
+* Record a value the firmware accepted or reported. Values larger than
+* OLM_SHADOW_DATA_SIZE, or a full shadow, leave the IOVAR unknown.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param iovar
+* IOVAR name; must outlive the entry.
+*
+* \param index
+* Instance of the IOVAR, 0 if there is only one.
+*
+* \param data
+* The value.
+*
+* \param len
+* Length of data.
+*
+*******************************************************************************/
+void cylpa_olm_shadow_store(void *whd, const char *iovar, uint32_t index, const void *data, uint8_t len)
+{
+    olm_shadow_entry_t *e;
+    uint32_t i;
+
+    OLM_SHADOW_LOCK();
+    e = cylpa_olm_shadow_find(whd, iovar, index);
+    if ( (len > OLM_SHADOW_DATA_SIZE) || cylpa_olm_shadow.disabled )
+    {
+        if (e != NULL)
+        {
+            e->whd = NULL;
+        }
+        OLM_SHADOW_UNLOCK();
+        return;
+    }
+
+    for (i = 0; (e == NULL) && (i < OLM_SHADOW_MAX_ENTRIES); i++)
+    {
+        if ( (cylpa_olm_shadow.entries[i].whd == NULL) ||
+             (cylpa_olm_shadow.entries[i].generation != cylpa_olm_shadow.generation) )
+        {
+            e = &cylpa_olm_shadow.entries[i];
+        }
+    }
+    if (e == NULL)
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "%s: shadow full, %s not cached\n", __func__, iovar);
+        OLM_SHADOW_UNLOCK();
+        return;
+    }
+
+    e->whd = whd;
+    e->iovar = iovar;
+    e->index = index;
+    e->generation = cylpa_olm_shadow.generation;
+    e->len = len;
+    memcpy(e->data, data, len);
+    OLM_SHADOW_UNLOCK();
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_set_iovar_value
+****************************************************************************//**
+*
+* Set a uint32_t IOVAR unless the firmware already holds the value.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param iovar
+* IOVAR name; must outlive the shadow entry.
+*
+* \param value
+* The value to set.
+*
+* \return
+* whd_result_t of the IOVAR, WHD_SUCCESS if it was skipped.
+*
+*******************************************************************************/
+uint32_t cylpa_olm_shadow_set_iovar_value(void *whd, const char *iovar, uint32_t value)
+{
+    uint32_t result;
+
+    if (cylpa_olm_shadow_match(whd, iovar, 0, &value, sizeof(value) ) )
+    {
+        return WHD_SUCCESS;
+    }
+
+    result = whd_wifi_set_iovar_value( (whd_interface_t)whd, iovar, value );
+    if (result == WHD_SUCCESS)
+    {
+        cylpa_olm_shadow_store(whd, iovar, 0, &value, sizeof(value) );
+    }
+    else
+    {
+        cylpa_olm_shadow_forget(whd, iovar, 0);
+    }
+    return result;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_get_iovar_value
+****************************************************************************//**
+*
+* Get a uint32_t IOVAR, from the shadow when the value is known.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param iovar
+* IOVAR name; must outlive the shadow entry.
+*
+* \param value
+* Receives the value.
+*
+* \return
+* whd_result_t of the IOVAR, WHD_SUCCESS if answered from the shadow.
+*
+*******************************************************************************/
+uint32_t cylpa_olm_shadow_get_iovar_value(void *whd, const char *iovar, uint32_t *value)
+{
+    uint32_t result;
+
+    if (cylpa_olm_shadow_read(whd, iovar, 0, value, sizeof(*value) ) )
+    {
+        return WHD_SUCCESS;
+    }
+
+    result = whd_wifi_get_iovar_value( (whd_interface_t)whd, iovar, value );
+    if (result == WHD_SUCCESS)
+    {
+        cylpa_olm_shadow_store(whd, iovar, 0, value, sizeof(*value) );
+    }
+    return result;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_update_disabled
+****************************************************************************//**
+*
+* The shadow is not used while an attached interface has no link events, since
+* its entries could outlive an association.
+*
+*******************************************************************************/
+static void cylpa_olm_shadow_update_disabled(void)
+{
+    uint32_t i;
+
+    cylpa_olm_shadow.disabled = false;
+    for (i = 0; i < OLM_MAX_INSTANCES; i++)
+    {
+        if ( (cylpa_olm_shadow.events[i].whd != NULL) &&
+             (cylpa_olm_shadow.events[i].entry == OLM_SHADOW_NO_EVENT_ENTRY) )
+        {
+            cylpa_olm_shadow.disabled = true;
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_attach
+****************************************************************************//**
+*
+* Register for the WHD events that invalidate the shadow. Registering again
+* for the same interface does nothing; each interface of an Offload Manager
+* has its own registration.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+*******************************************************************************/
+void cylpa_olm_shadow_attach(void *whd)
+{
+    olm_shadow_events_t *ev = NULL;
+    uint32_t i;
+
+    if (whd == NULL)
+    {
+        return;
+    }
+    for (i = 0; i < OLM_MAX_INSTANCES; i++)
+    {
+        if (cylpa_olm_shadow.events[i].whd == whd)
+        {
+            ev = &cylpa_olm_shadow.events[i];
+            break;
+        }
+        if ( (ev == NULL) && (cylpa_olm_shadow.events[i].whd == NULL) )
+        {
+            ev = &cylpa_olm_shadow.events[i];
+        }
+    }
+    if (ev == NULL)
+    {
+        /* More interfaces than OLM_MAX_INSTANCES; this one cannot be tracked */
+        OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s: more than OLM_MAX_INSTANCES (%d) interfaces\n", __func__,
+                   OLM_MAX_INSTANCES);
+        cylpa_olm_shadow.disabled = true;
+        return;
+    }
+    if ( (ev->whd == whd) && (ev->entry != OLM_SHADOW_NO_EVENT_ENTRY) )
+    {
+        return;
+    }
+
+    ev->whd = whd;
+    if (whd_management_set_event_handler( (whd_interface_t)whd, cylpa_olm_shadow_events,
+                                          cylpa_olm_shadow_event_handler, NULL, &ev->entry ) != WHD_SUCCESS)
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s: event registration failed\n", __func__);
+        ev->entry = OLM_SHADOW_NO_EVENT_ENTRY;
+    }
+    cylpa_olm_shadow_update_disabled();
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_detach
+****************************************************************************//**
+*
+* Unregister the WHD event handler of an interface and drop the shadow.
+*
+* \param whd
+* The pointer to the whd interface, or NULL for all interfaces.
+*
+*******************************************************************************/
+void cylpa_olm_shadow_detach(void *whd)
+{
+    olm_shadow_events_t *ev;
+    uint32_t i;
+
+    for (i = 0; i < OLM_MAX_INSTANCES; i++)
+    {
+        ev = &cylpa_olm_shadow.events[i];
+        if ( (ev->whd == NULL) || ( (whd != NULL) && (ev->whd != whd) ) )
+        {
+            continue;
+        }
+        if (ev->entry != OLM_SHADOW_NO_EVENT_ENTRY)
+        {
+            whd_wifi_deregister_event_handler( (whd_interface_t)ev->whd, ev->entry );
+        }
+        ev->whd = NULL;
+        ev->entry = OLM_SHADOW_NO_EVENT_ENTRY;
+    }
+    cylpa_olm_shadow_update_disabled();
+    cylpa_olm_shadow_invalidate();
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_shadow_get_stats
+****************************************************************************//**
+*
+* Read the shadow counters.
+*
+* \param stats
+* Receives the counters.
+*
+*******************************************************************************/
+void cylpa_olm_shadow_get_stats(olm_shadow_stats_t *stats)
+{
+    if (stats != NULL)
+    {
+        *stats = cylpa_olm_shadow.stats;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,593 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+
+/**
+* @file cy_lpa_wifi_olm_trace.c
+* @brief Offload Assist binary trace ring.
+*
+* With OLM_LOG_RING, ol_logging() stores the format string pointer, a timestamp
+* and the raw arguments of all but error records in a fixed-size lock-free ring
+* instead of printing, so that logging from a power-mode transition costs a few
+* hundred cycles rather than UART time.
+* Records are formatted later by ol_log_drain(), from a low-priority task, or
+* read raw with ol_log_read() and decoded on a host against the image.
+*
+* The ring is a bounded multi-producer multi-consumer queue with a sequence
+* number per slot. A full ring drops the new record and counts it.
+*/
+
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_olm.h"
+#include "cy_lpa_wifi_ol_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(OLM_LOG_ENABLED)
+
+/*******************************************************************************
+* Local definition
+*******************************************************************************/
+#if ( (OL_LOG_RING_SIZE & (OL_LOG_RING_SIZE - 1) ) != 0 )
+#error "OL_LOG_RING_SIZE must be a power of 2"
+#endif
+
+#define OL_LOG_RING_MASK        (OL_LOG_RING_SIZE - 1)
+#define OL_LOG_WORDS(size)      ( ( (size) + sizeof(uint32_t) - 1 ) / sizeof(uint32_t) )
+#define OL_LOG_SPEC_SIZE        (24)
+
+/* C type of one format conversion */
+typedef enum ol_log_arg
+{
+    OL_LOG_ARG_NONE = 0,        /* %% */
+    OL_LOG_ARG_INT,
+    OL_LOG_ARG_LONG,
+    OL_LOG_ARG_LLONG,
+    OL_LOG_ARG_SIZE,
+    OL_LOG_ARG_PTR,
+    OL_LOG_ARG_DOUBLE,
+    OL_LOG_ARG_STR,
+    OL_LOG_ARG_BAD,             /* not supported; formatting stops here */
+} ol_log_arg_t;
+
+/* One parsed conversion */
+typedef struct ol_log_spec
+{
+    ol_log_arg_t    arg;
+    uint8_t         stars;      /* '*' width / precision, each an int argument before the value */
+} ol_log_spec_t;
+
+/* Ring slot; seq is stored relative to the slot index so that a zeroed ring is empty */
+typedef struct ol_log_slot
+{
+    atomic_uint     seq;
+    ol_log_record_t rec;
+} ol_log_slot_t;
+
+static ol_log_slot_t ol_log_ring[OL_LOG_RING_SIZE];
+static atomic_uint ol_log_head;
+static atomic_uint ol_log_tail;
+static atomic_uint ol_log_mask = OL_LOG_MASK_ALL;
+
+static atomic_uint ol_log_recorded;
+static atomic_uint ol_log_dropped;
+static atomic_uint ol_log_truncated;
+static atomic_uint ol_log_dropped_assist[LOG_OLA_MAX_INDEX];
+
+/*******************************************************************************
+* Function Name: ol_log_parse
+****************************************************************************//**
+*
+* Parse the conversion after a '%'.
+*
+* \param p
+* The character after the '%'.
+*
+* \param spec
+* Filled in with the conversion.
+*
+* \return The character after the conversion
+*
+*******************************************************************************/
+static const char *ol_log_parse(const char *p, ol_log_spec_t *spec)
+{
+    int len = 0;    /* 'h' -1 per, 'l' +1 per, 'z' / 't' 3, 'j' 2, 'L' 4 */
+
+    spec->stars = 0;
+    while ( (*p != '\0') && (strchr("-+ #0", *p) != NULL) )
+    {
+        p++;
+    }
+    while ( ( (*p >= '0') && (*p <= '9') ) || (*p == '.') || (*p == '*') )
+    {
+        spec->stars += (*p == '*') ? 1 : 0;
+        p++;
+    }
+    for ( ; (*p != '\0') && (strchr("hlzjtL", *p) != NULL); p++)
+    {
+        switch (*p)
+        {
+            case 'h': len--; break;
+            case 'l': len++; break;
+            case 'j': len = 2; break;
+            case 'z':
+            case 't': len = 3; break;
+            default:  len = 4; break;
+        }
+    }
+
+    switch (*p)
+    {
+        case '%':
+            spec->arg = OL_LOG_ARG_NONE;
+            break;
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            spec->arg = (len <= 0) ? OL_LOG_ARG_INT : (len == 1) ? OL_LOG_ARG_LONG :
+                        (len == 3) ? OL_LOG_ARG_SIZE : (len == 4) ? OL_LOG_ARG_BAD : OL_LOG_ARG_LLONG;
+            break;
+        case 'p':
+            spec->arg = OL_LOG_ARG_PTR;
+            break;
+        case 's':
+            spec->arg = (len == 0) ? OL_LOG_ARG_STR : OL_LOG_ARG_BAD;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec->arg = (len == 4) ? OL_LOG_ARG_BAD : OL_LOG_ARG_DOUBLE;
+            break;
+        default:
+            spec->arg = OL_LOG_ARG_BAD;
+            break;
+    }
+    return (*p != '\0') ? p + 1 : p;
+}
+
+/*******************************************************************************
+* Function Name: ol_log_arg_size
+****************************************************************************//**
+*
+* Size in bytes of a non-string argument.
+*
+*******************************************************************************/
+static uint32_t ol_log_arg_size(ol_log_arg_t arg)
+{
+    switch (arg)
+    {
+        case OL_LOG_ARG_INT:    return sizeof(int);
+        case OL_LOG_ARG_LONG:   return sizeof(long);
+        case OL_LOG_ARG_LLONG:  return sizeof(long long);
+        case OL_LOG_ARG_SIZE:   return sizeof(size_t);
+        case OL_LOG_ARG_PTR:    return sizeof(void *);
+        case OL_LOG_ARG_DOUBLE: return sizeof(double);
+        default:                return 0;
+    }
+}
+
+/*******************************************************************************
+* Function Name: ol_log_capture
+****************************************************************************//**
+*
+* Copy the arguments of fmt into rec->args.
+*
+*******************************************************************************/
+static void ol_log_capture(ol_log_record_t *rec, const char *fmt, va_list args)
+{
+    uint8_t *dst = (uint8_t *)rec->args;
+    uint32_t used = 0;
+    uint32_t size;
+    ol_log_spec_t spec;
+    const char *str;
+    union
+    {
+        int i;
+        long l;
+        long long ll;
+        size_t z;
+        void *p;
+        double d;
+    } v;
+
+    while (*fmt != '\0')
+    {
+        if (*fmt++ != '%')
+        {
+            continue;
+        }
+        fmt = ol_log_parse(fmt, &spec);
+        for ( ; spec.stars > 0; spec.stars--)
+        {
+            v.i = va_arg(args, int);
+            if ( (used + sizeof(int) ) > sizeof(rec->args) )
+            {
+                goto truncated;
+            }
+            memcpy(&dst[used], &v.i, sizeof(int) );
+            used += OL_LOG_WORDS(sizeof(int) ) * sizeof(uint32_t);
+        }
+
+        switch (spec.arg)
+        {
+            case OL_LOG_ARG_NONE:
+                continue;
+            case OL_LOG_ARG_INT:    v.i = va_arg(args, int); break;
+            case OL_LOG_ARG_LONG:   v.l = va_arg(args, long); break;
+            case OL_LOG_ARG_LLONG:  v.ll = va_arg(args, long long); break;
+            case OL_LOG_ARG_SIZE:   v.z = va_arg(args, size_t); break;
+            case OL_LOG_ARG_PTR:    v.p = va_arg(args, void *); break;
+            case OL_LOG_ARG_DOUBLE: v.d = va_arg(args, double); break;
+            case OL_LOG_ARG_STR:
+                str = va_arg(args, const char *);
+                str = (str != NULL) ? str : "(null)";
+                if (used >= sizeof(rec->args) )
+                {
+                    goto truncated;
+                }
+                size = strlen(str);
+                if ( (used + size + 1) > sizeof(rec->args) )
+                {
+                    size = sizeof(rec->args) - used - 1;
+                    rec->flags |= OL_LOG_REC_F_TRUNCATED;
+                }
+                memcpy(&dst[used], str, size);
+                dst[used + size] = '\0';
+                used += OL_LOG_WORDS(size + 1) * sizeof(uint32_t);
+                continue;
+            default:
+                rec->nwords = (uint8_t)(used / sizeof(uint32_t) );
+                return;
+        }
+
+        size = ol_log_arg_size(spec.arg);
+        if ( (used + size) > sizeof(rec->args) )
+        {
+            goto truncated;
+        }
+        memcpy(&dst[used], &v, size);
+        used += OL_LOG_WORDS(size) * sizeof(uint32_t);
+    }
+    rec->nwords = (uint8_t)(used / sizeof(uint32_t) );
+    return;
+
+truncated:
+    rec->flags |= OL_LOG_REC_F_TRUNCATED;
+    rec->nwords = (uint8_t)(used / sizeof(uint32_t) );
+}
+
+/*******************************************************************************
+* Function Name: ol_log_trace
+****************************************************************************//**
+*
+* Store one record in the trace ring. Lock-free; callable from any thread.
+*
+* \param assist
+* Offload Assistant type \ref LOG_OFFLOAD_ASSIST_T
+*
+* \param level
+* Offload assist logging level \ref LOG_OFFLOAD_ASSIST_LEVEL_T
+*
+* \param fmt
+* Format string like printf(); must stay valid (a literal).
+*
+* \param args
+* Arguments of fmt.
+*
+* \return 1 if stored, 0 if dropped
+*
+*******************************************************************************/
+int ol_log_trace(LOG_OFFLOAD_ASSIST_T assist, LOG_OFFLOAD_ASSIST_LEVEL_T level, const char *fmt, va_list args)
+{
+    ol_log_slot_t *slot;
+    unsigned int pos = atomic_load_explicit(&ol_log_tail, memory_order_relaxed);
+    int diff;
+
+    for (;;)
+    {
+        slot = &ol_log_ring[pos & OL_LOG_RING_MASK];
+        diff = (int)(atomic_load_explicit(&slot->seq, memory_order_acquire) + (pos & OL_LOG_RING_MASK) - pos);
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&ol_log_tail, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed) )
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            /* Full; keep what is there, it is older and already paid for */
+            atomic_fetch_add_explicit(&ol_log_dropped, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&ol_log_dropped_assist[assist], 1, memory_order_relaxed);
+            return 0;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&ol_log_tail, memory_order_relaxed);
+        }
+    }
+
+    slot->rec.fmt = fmt;
+    slot->rec.timestamp_us = cylpa_olm_latency_now_us();
+    slot->rec.assist = (uint8_t)assist;
+    slot->rec.level = (uint8_t)level;
+    slot->rec.flags = 0;
+    ol_log_capture(&slot->rec, fmt, args);
+    if ( (slot->rec.flags & OL_LOG_REC_F_TRUNCATED) != 0 )
+    {
+        atomic_fetch_add_explicit(&ol_log_truncated, 1, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&ol_log_recorded, 1, memory_order_relaxed);
+
+    /* Publish to the readers */
+    atomic_store_explicit(&slot->seq, pos + 1 - (pos & OL_LOG_RING_MASK), memory_order_release);
+    return 1;
+}
+
+/*******************************************************************************
+* This function takes the oldest record out of the trace ring, unformatted
+*
+* @param rec    : Filled in with the record
+*
+* @return       : true if a record was read, false if the ring is empty
+*
+*******************************************************************************/
+bool ol_log_read(ol_log_record_t *rec)
+{
+    ol_log_slot_t *slot;
+    unsigned int pos = atomic_load_explicit(&ol_log_head, memory_order_relaxed);
+    int diff;
+
+    if (rec == NULL)
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        slot = &ol_log_ring[pos & OL_LOG_RING_MASK];
+        diff = (int)(atomic_load_explicit(&slot->seq, memory_order_acquire) + (pos & OL_LOG_RING_MASK) - (pos + 1) );
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&ol_log_head, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed) )
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&ol_log_head, memory_order_relaxed);
+        }
+    }
+
+    memcpy(rec, &slot->rec, sizeof(*rec) );
+
+    /* Hand the slot back to the writers for the next lap */
+    atomic_store_explicit(&slot->seq, pos + OL_LOG_RING_SIZE - (pos & OL_LOG_RING_MASK), memory_order_release);
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: ol_log_format
+****************************************************************************//**
+*
+* Format one record into line the way vprintf() would have.
+*
+*******************************************************************************/
+static void ol_log_format(const ol_log_record_t *rec, char *line, uint32_t size)
+{
+    const uint8_t *src = (const uint8_t *)rec->args;
+    uint32_t avail = rec->nwords * sizeof(uint32_t);
+    uint32_t used = 0;
+    uint32_t len;
+    uint32_t n;
+    const char *fmt = rec->fmt;
+    const char *start;
+    const char *p;
+    char spec[OL_LOG_SPEC_SIZE];
+    ol_log_spec_t conv;
+    int star;
+    int r = 0;
+    union
+    {
+        int i;
+        long l;
+        long long ll;
+        size_t z;
+        void *p;
+        double d;
+    } v;
+
+    len = (uint32_t)snprintf(line, size, "[%10lu] ", (unsigned long)rec->timestamp_us);
+
+    while ( (*fmt != '\0') && (len < size - 1) )
+    {
+        if (*fmt != '%')
+        {
+            line[len++] = *fmt++;
+            continue;
+        }
+
+        start = fmt;
+        fmt = ol_log_parse(fmt + 1, &conv);
+        if (conv.arg == OL_LOG_ARG_NONE)
+        {
+            line[len++] = '%';
+            continue;
+        }
+        if (conv.arg == OL_LOG_ARG_BAD)
+        {
+            break;
+        }
+
+        /* Rebuild the conversion with '*' replaced by the recorded values */
+        for (n = 0, p = start; (p < fmt) && (n < sizeof(spec) - 12); p++)
+        {
+            if (*p != '*')
+            {
+                spec[n++] = *p;
+                continue;
+            }
+            if ( (used + sizeof(int) ) > avail )
+            {
+                goto out;
+            }
+            memcpy(&star, &src[used], sizeof(int) );
+            used += OL_LOG_WORDS(sizeof(int) ) * sizeof(uint32_t);
+            n += (uint32_t)snprintf(&spec[n], sizeof(spec) - n, "%d", star);
+        }
+        if (p < fmt)
+        {
+            break;
+        }
+        spec[n] = '\0';
+
+        if (conv.arg == OL_LOG_ARG_STR)
+        {
+            if (used >= avail)
+            {
+                goto out;
+            }
+            r = snprintf(&line[len], size - len, spec, (const char *)&src[used]);
+            used += OL_LOG_WORDS(strlen( (const char *)&src[used] ) + 1) * sizeof(uint32_t);
+        }
+        else
+        {
+            if ( (used + ol_log_arg_size(conv.arg) ) > avail )
+            {
+                goto out;
+            }
+            memcpy(&v, &src[used], ol_log_arg_size(conv.arg) );
+            used += OL_LOG_WORDS(ol_log_arg_size(conv.arg) ) * sizeof(uint32_t);
+            switch (conv.arg)
+            {
+                case OL_LOG_ARG_INT:    r = snprintf(&line[len], size - len, spec, v.i); break;
+                case OL_LOG_ARG_LONG:   r = snprintf(&line[len], size - len, spec, v.l); break;
+                case OL_LOG_ARG_LLONG:  r = snprintf(&line[len], size - len, spec, v.ll); break;
+                case OL_LOG_ARG_SIZE:   r = snprintf(&line[len], size - len, spec, v.z); break;
+                case OL_LOG_ARG_PTR:    r = snprintf(&line[len], size - len, spec, v.p); break;
+                default:                r = snprintf(&line[len], size - len, spec, v.d); break;
+            }
+        }
+        len = ( (r < 0) || ( (uint32_t)r >= size - len) ) ? size - 1 : len + (uint32_t)r;
+    }
+
+out:
+    if ( (rec->flags & OL_LOG_REC_F_TRUNCATED) && (len < size - 5) )
+    {
+        memcpy(&line[len], "...\n", 4);
+        len += 4;
+    }
+    line[(len < size) ? len : size - 1] = '\0';
+}
+
+/*******************************************************************************
+* This function formats and prints records from the trace ring.
+*
+* @param max    : Maximum number of records to print, 0 for all
+*
+* @return       : # records printed
+*
+*******************************************************************************/
+uint32_t ol_log_drain(uint32_t max)
+{
+    ol_log_record_t rec;
+    char line[OL_LOG_LINE_SIZE];
+    uint32_t count = 0;
+
+    while ( ( (max == 0) || (count < max) ) && ol_log_read(&rec) )
+    {
+        ol_log_format(&rec, line, sizeof(line) );
+        printf("%s", line);
+        count++;
+    }
+    return count;
+}
+
+/*******************************************************************************
+* This function selects the facilities that are logged
+*
+* @param mask   : OR of OL_LOG_MASK(assist)
+*
+*******************************************************************************/
+void ol_log_set_mask(uint32_t mask)
+{
+    atomic_store_explicit(&ol_log_mask, mask & OL_LOG_MASK_ALL, memory_order_relaxed);
+}
+
+/*******************************************************************************
+* This function gets the facility mask
+*
+* @return       : OR of OL_LOG_MASK(assist)
+*
+*******************************************************************************/
+uint32_t ol_log_get_mask(void)
+{
+    return atomic_load_explicit(&ol_log_mask, memory_order_relaxed);
+}
+
+/*******************************************************************************
+* This function gets the trace ring counters
+*
+* @param stats  : Filled in with the counters
+*
+*******************************************************************************/
+void ol_log_get_stats(ol_log_stats_t *stats)
+{
+    uint32_t i;
+
+    if (stats == NULL)
+    {
+        return;
+    }
+    stats->recorded = atomic_load_explicit(&ol_log_recorded, memory_order_relaxed);
+    stats->dropped = atomic_load_explicit(&ol_log_dropped, memory_order_relaxed);
+    stats->truncated = atomic_load_explicit(&ol_log_truncated, memory_order_relaxed);
+    for (i = 0; i < LOG_OLA_MAX_INDEX; i++)
+    {
+        stats->dropped_assist[i] = atomic_load_explicit(&ol_log_dropped_assist[i], memory_order_relaxed);
+    }
+}
+
+#endif /* OLM_LOG_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,679 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ * 
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+/**
+* @file cy_lpa_wifi_olm_txn.c
+* @brief Offload Manager IOVAR transactions.
+*
+* During a power-mode transition every offload queues its IOVARs on the
+* transaction owned by the Offload Manager instead of issuing them one by one.
+* When all offloads have been notified the transaction is flushed:
+*  - operations that are overwritten by a later operation on the same IOVAR
+*    (or the same packet filter) are dropped,
+*  - values the firmware already holds (see cy_lpa_wifi_olm_shadow.c) are
+*    not sent again,
+*  - consecutive batchable operations are handed to cylpa_olm_txn_submit_batch()
+*    so a platform that supports a firmware batch command needs one bus
+*    transaction for the whole run. No current firmware has one: the default
+*    refuses the batch and each IOVAR that is left is issued on its own, so
+*    a target build saves only the dropped and already held IOVARs,
+*  - CALL operations run in queue order and delimit the batches, so the
+*    relative order of everything an offload queued is preserved.
+*/
+
+#include <string.h>
+#include <stdbool.h>
+#include "cy_lpa_compat.h"
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_olm.h"
+#include "cy_lpa_wifi_ol_priv.h"
+#include "whd_wifi_api.h"
+#include "whd_endian.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_submit_batch
+****************************************************************************//**
+*
+* Submit several IOVAR sets in one bus transaction. This default implementation
+* does not support batching; the caller then issues each IOVAR on its own.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param iovars
+* IOVARs to set, in order.
+*
+* \param count
+* Number of entries in iovars.
+*
+* \param results
+* Per-entry whd_result_t, filled in on RESULT_OK.
+*
+* \return
+* RESULT_OK if submitted, RESULT_UNSUPPORTED otherwise.
+*
+*******************************************************************************/
+CYPRESS_WEAK int cylpa_olm_txn_submit_batch(void *whd, const olm_txn_iovar_t *iovars, uint32_t count,
+                                            uint32_t *results)
+{
+    (void)whd;
+    (void)iovars;
+    (void)count;
+    (void)results;
+    return RESULT_UNSUPPORTED;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_issue
+****************************************************************************//**
+*
+* Issue a single operation on the bus.
+*
+*******************************************************************************/
+static uint32_t cylpa_olm_txn_issue(olm_txn_t *txn, void *whd, const olm_txn_entry_t *entry)
+{
+    switch (entry->op)
+    {
+        case OLM_TXN_OP_SET_VALUE:
+            return whd_wifi_set_iovar_value( (whd_interface_t)whd, entry->iovar, entry->u.value );
+
+        case OLM_TXN_OP_SET_BUFFER:
+            return whd_wifi_set_iovar_buffer( (whd_interface_t)whd, entry->iovar, &txn->buf[entry->u.buf.offset],
+                                              entry->u.buf.len );
+
+        case OLM_TXN_OP_PF_ENABLE:
+            return entry->u.pf.enable ? whd_pf_enable_packet_filter( (whd_interface_t)whd, entry->u.pf.id ) :
+                   whd_pf_disable_packet_filter( (whd_interface_t)whd, entry->u.pf.id );
+
+        case OLM_TXN_OP_CALL:
+            return entry->u.call.fn(whd, entry->u.call.arg, entry->u.call.param);
+
+        default:
+            return WHD_BADARG;
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_same_target
+****************************************************************************//**
+*
+* Whether two batchable operations write the same firmware state, so only the
+* later one needs to reach the firmware.
+*
+*******************************************************************************/
+static bool cylpa_olm_txn_same_target(const olm_txn_entry_t *a, const olm_txn_entry_t *b)
+{
+    if (a->op != b->op)
+    {
+        return false;
+    }
+    switch (a->op)
+    {
+        case OLM_TXN_OP_SET_VALUE:
+            return (strcmp(a->iovar, b->iovar) == 0);
+
+        case OLM_TXN_OP_PF_ENABLE:
+            return (a->u.pf.id == b->u.pf.id);
+
+        default:
+            /* Buffer IOVARs usually carry sub-commands; never merge them */
+            return false;
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_shadow_key
+****************************************************************************//**
+*
+* Firmware shadow key and value written by an operation. Returns false for
+* operations the shadow does not track.
+*
+*******************************************************************************/
+static bool cylpa_olm_txn_shadow_key(const olm_txn_entry_t *e, const char **iovar, uint32_t *index,
+                                     uint32_t *value)
+{
+    switch (e->op)
+    {
+        case OLM_TXN_OP_SET_VALUE:
+            *iovar = e->iovar;
+            *index = 0;
+            *value = e->u.value;
+            return true;
+
+        case OLM_TXN_OP_PF_ENABLE:
+            *iovar = OLM_TXN_IOVAR_PKT_FILTER_ENABLE;
+            *index = e->u.pf.id;
+            *value = e->u.pf.enable ? 1 : 0;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_shadow_hit
+****************************************************************************//**
+*
+* Whether the firmware already holds the value an operation writes.
+*
+*******************************************************************************/
+static bool cylpa_olm_txn_shadow_hit(void *whd, const olm_txn_entry_t *e)
+{
+    const char *iovar;
+    uint32_t index, value;
+
+    return cylpa_olm_txn_shadow_key(e, &iovar, &index, &value) &&
+           cylpa_olm_shadow_match(whd, iovar, index, &value, sizeof(value) );
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_shadow_update
+****************************************************************************//**
+*
+* Record the outcome of an issued operation in the firmware shadow.
+*
+*******************************************************************************/
+static void cylpa_olm_txn_shadow_update(void *whd, const olm_txn_entry_t *e, uint32_t result)
+{
+    const char *iovar;
+    uint32_t index, value;
+
+    if (!cylpa_olm_txn_shadow_key(e, &iovar, &index, &value) )
+    {
+        return;
+    }
+    if (result == WHD_SUCCESS)
+    {
+        cylpa_olm_shadow_store(whd, iovar, index, &value, sizeof(value) );
+    }
+    else
+    {
+        cylpa_olm_shadow_forget(whd, iovar, index);
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_fits
+****************************************************************************//**
+*
+* Whether an operation on whd can be appended to the transaction.
+*
+*******************************************************************************/
+static bool cylpa_olm_txn_fits(const olm_txn_t *txn, void *whd, const olm_txn_entry_t *entry)
+{
+    return (txn->whd == whd) && (txn->count < OLM_TXN_MAX_ENTRIES) &&
+           ( (entry->op != OLM_TXN_OP_SET_BUFFER) || (txn->buf_used + entry->u.buf.len <= OLM_TXN_BUF_SIZE) );
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_queue
+****************************************************************************//**
+*
+* Append an operation, or issue it immediately when there is no open
+* transaction. When the operation does not fit, the queued entries are flushed
+* first so the firmware sees everything in queue order.
+*
+*******************************************************************************/
+static int cylpa_olm_txn_queue(olm_txn_t *txn, void *whd, olm_txn_entry_t *entry, const void *data)
+{
+    olm_txn_entry_t *slot;
+    uint32_t result;
+
+    if ( (txn != NULL) && !cylpa_olm_txn_fits(txn, whd, entry) && (txn->count > 0) )
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_WARNING, "%s: transaction full, flushing before %s\n", __func__,
+                   entry->iovar ? entry->iovar : "call");
+        cylpa_olm_txn_flush(txn);
+    }
+
+    if ( (txn != NULL) && cylpa_olm_txn_fits(txn, whd, entry) )
+    {
+        slot = &txn->entries[txn->count++];
+        *slot = *entry;
+        if (entry->op == OLM_TXN_OP_SET_BUFFER)
+        {
+            slot->u.buf.offset = (uint16_t)txn->buf_used;
+            memcpy(&txn->buf[txn->buf_used], data, entry->u.buf.len);
+            txn->buf_used += entry->u.buf.len;
+        }
+        txn->queued++;
+        return RESULT_OK;
+    }
+
+    if (txn != NULL)
+    {
+        /* Another interface, or a payload larger than the buffer: nothing is queued ahead of it */
+        txn->submits++;
+    }
+
+    /* No transaction: behave like a direct WHD call */
+    if (entry->op == OLM_TXN_OP_SET_BUFFER)
+    {
+        result = whd_wifi_set_iovar_buffer( (whd_interface_t)whd, entry->iovar, (void *)data, entry->u.buf.len );
+    }
+    else if (cylpa_olm_txn_shadow_hit(whd, entry) )
+    {
+        result = WHD_SUCCESS;
+    }
+    else
+    {
+        result = cylpa_olm_txn_issue(txn, whd, entry);
+        cylpa_olm_txn_shadow_update(whd, entry, result);
+    }
+    if (entry->cb != NULL)
+    {
+        entry->cb(entry->cb_arg, result);
+    }
+    return (result == WHD_SUCCESS) ? RESULT_OK : RESULT_ERROR;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_flush_run
+****************************************************************************//**
+*
+* Issue the batchable entries [first, last) of the transaction.
+*
+*******************************************************************************/
+static void cylpa_olm_txn_flush_run(olm_txn_t *txn, uint32_t first, uint32_t last)
+{
+    /* Scratch lives in the transaction, off the dispatch stack and apart for each OLM */
+    olm_txn_iovar_t *iovars = txn->iovars;
+    olm_txn_payload_t *payload = txn->payload;
+    uint32_t *results = txn->results;
+    uint16_t *index = txn->index;
+    olm_txn_entry_t *e;
+    uint32_t i, j, n = 0;
+
+    /* Drop entries whose state is overwritten later in the same run */
+    for (i = first; i < last; i++)
+    {
+        for (j = i + 1; j < last; j++)
+        {
+            if (cylpa_olm_txn_same_target(&txn->entries[i], &txn->entries[j]) )
+            {
+                txn->entries[i].superseded = 1;
+                txn->dropped++;
+                break;
+            }
+        }
+    }
+
+    for (i = first; i < last; i++)
+    {
+        e = &txn->entries[i];
+        if (e->superseded)
+        {
+            continue;
+        }
+        if (cylpa_olm_txn_shadow_hit(txn->whd, e) )
+        {
+            /* Firmware already holds the value */
+            e->result = WHD_SUCCESS;
+            e->done = 1;
+            continue;
+        }
+        switch (e->op)
+        {
+            case OLM_TXN_OP_SET_VALUE:
+                payload[n].value = htod32(e->u.value);
+                iovars[n].name = e->iovar;
+                iovars[n].data = &payload[n].value;
+                iovars[n].len = sizeof(payload[n].value);
+                break;
+
+            case OLM_TXN_OP_SET_BUFFER:
+                iovars[n].name = e->iovar;
+                iovars[n].data = &txn->buf[e->u.buf.offset];
+                iovars[n].len = e->u.buf.len;
+                break;
+
+            case OLM_TXN_OP_PF_ENABLE:
+                payload[n].pf.id = htod32(e->u.pf.id);
+                payload[n].pf.enable = htod32(e->u.pf.enable);
+                iovars[n].name = OLM_TXN_IOVAR_PKT_FILTER_ENABLE;
+                iovars[n].data = &payload[n].pf;
+                iovars[n].len = sizeof(payload[n].pf);
+                break;
+
+            default:
+                break;
+        }
+        index[n++] = (uint16_t)i;
+    }
+
+    if ( (n > 1) && (cylpa_olm_txn_submit_batch(txn->whd, iovars, n, results) == RESULT_OK) )
+    {
+        OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "%s: %lu IOVARs in one batch\n", __func__, (unsigned long)n);
+        txn->submits++;
+        for (i = 0; i < n; i++)
+        {
+            e = &txn->entries[index[i]];
+            e->result = results[i];
+            e->done = 1;
+            cylpa_olm_txn_shadow_update(txn->whd, e, e->result);
+        }
+    }
+    else
+    {
+        for (i = 0; i < n; i++)
+        {
+            e = &txn->entries[index[i]];
+            e->result = cylpa_olm_txn_issue(txn, txn->whd, e);
+            e->done = 1;
+            cylpa_olm_txn_shadow_update(txn->whd, e, e->result);
+            txn->submits++;
+        }
+    }
+
+    /* A superseded entry shares the result of the entry that replaced it */
+    for (i = last; i > first; i--)
+    {
+        e = &txn->entries[i - 1];
+        if (!e->superseded)
+        {
+            continue;
+        }
+        for (j = i; j < last; j++)
+        {
+            if (cylpa_olm_txn_same_target(e, &txn->entries[j]) && txn->entries[j].done)
+            {
+                e->result = txn->entries[j].result;
+                e->done = 1;
+                break;
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_begin
+****************************************************************************//**
+*
+* Open a transaction on an interface. Operations queued afterwards are held
+* until cylpa_olm_txn_flush() is called.
+*
+* \param txn
+* The pointer to the transaction.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+*******************************************************************************/
+void cylpa_olm_txn_begin(olm_txn_t *txn, void *whd)
+{
+    txn->whd = whd;
+    txn->count = 0;
+    txn->buf_used = 0;
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_flush
+****************************************************************************//**
+*
+* Issue all queued operations with as few bus transactions as possible, then
+* call each entry's completion callback in queue order and reset the transaction.
+*
+* \param txn
+* The pointer to the transaction.
+*
+*******************************************************************************/
+void cylpa_olm_txn_flush(olm_txn_t *txn)
+{
+    olm_txn_entry_t *e;
+    uint32_t i, run;
+
+    if ( (txn == NULL) || (txn->count == 0) )
+    {
+        return;
+    }
+
+    for (i = 0; i < txn->count; )
+    {
+        e = &txn->entries[i];
+        if (e->op == OLM_TXN_OP_CALL)
+        {
+            e->result = cylpa_olm_txn_issue(txn, txn->whd, e);
+            e->done = 1;
+            i++;
+            continue;
+        }
+        for (run = i; (run < txn->count) && (txn->entries[run].op != OLM_TXN_OP_CALL); run++)
+        {
+        }
+        cylpa_olm_txn_flush_run(txn, i, run);
+        i = run;
+    }
+
+    for (i = 0; i < txn->count; i++)
+    {
+        e = &txn->entries[i];
+        if ( (e->result != WHD_SUCCESS) && (e->op != OLM_TXN_OP_CALL) )
+        {
+            OL_LOG_OLM(LOG_OLA_LVL_ERR, "%s: %s failed %lu\n", __func__,
+                       (e->op == OLM_TXN_OP_PF_ENABLE) ? OLM_TXN_IOVAR_PKT_FILTER_ENABLE : e->iovar,
+                       (unsigned long)e->result);
+        }
+        if (e->cb != NULL)
+        {
+            e->cb(e->cb_arg, e->result);
+        }
+    }
+
+    OL_LOG_OLM(LOG_OLA_LVL_DEBUG, "%s: %lu ops, %lu dropped, %lu submits total\n", __func__,
+               (unsigned long)txn->count, (unsigned long)txn->dropped, (unsigned long)txn->submits);
+    cylpa_olm_txn_begin(txn, txn->whd);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_set_iovar_value
+****************************************************************************//**
+*
+* Queue a uint32_t IOVAR set. Without an open transaction the IOVAR is issued
+* immediately.
+*
+* \param txn
+* Open transaction or NULL.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param iovar
+* IOVAR name; must stay valid until the transaction is flushed.
+*
+* \param value
+* Value to write.
+*
+* \param cb
+* Completion callback, may be NULL.
+*
+* \param cb_arg
+* Argument passed to cb.
+*
+* \return
+* RESULT_OK when queued or issued successfully, RESULT_ERROR otherwise.
+*
+*******************************************************************************/
+int cylpa_olm_txn_set_iovar_value(olm_txn_t *txn, void *whd, const char *iovar, uint32_t value,
+                                  olm_txn_cb_t *cb, void *cb_arg)
+{
+    olm_txn_entry_t entry;
+
+    memset(&entry, 0, sizeof(entry) );
+    entry.op = OLM_TXN_OP_SET_VALUE;
+    entry.iovar = iovar;
+    entry.u.value = value;
+    entry.cb = cb;
+    entry.cb_arg = cb_arg;
+    return cylpa_olm_txn_queue(txn, whd, &entry, NULL);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_set_iovar_buffer
+****************************************************************************//**
+*
+* Queue an IOVAR set with a byte buffer. The payload is copied into the
+* transaction.
+*
+* \param txn
+* Open transaction or NULL.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param iovar
+* IOVAR name; must stay valid until the transaction is flushed.
+*
+* \param data
+* Payload.
+*
+* \param len
+* Payload length.
+*
+* \param cb
+* Completion callback, may be NULL.
+*
+* \param cb_arg
+* Argument passed to cb.
+*
+* \return
+* RESULT_OK when queued or issued successfully, RESULT_ERROR otherwise.
+*
+*******************************************************************************/
+int cylpa_olm_txn_set_iovar_buffer(olm_txn_t *txn, void *whd, const char *iovar, const void *data, uint16_t len,
+                                   olm_txn_cb_t *cb, void *cb_arg)
+{
+    olm_txn_entry_t entry;
+
+    memset(&entry, 0, sizeof(entry) );
+    entry.op = OLM_TXN_OP_SET_BUFFER;
+    entry.iovar = iovar;
+    entry.u.buf.len = len;
+    entry.cb = cb;
+    entry.cb_arg = cb_arg;
+    return cylpa_olm_txn_queue(txn, whd, &entry, data);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_pf_enable
+****************************************************************************//**
+*
+* Queue a packet filter enable or disable.
+*
+* \param txn
+* Open transaction or NULL.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param id
+* Filter id.
+*
+* \param enable
+* true to enable, false to disable.
+*
+* \param cb
+* Completion callback, may be NULL.
+*
+* \param cb_arg
+* Argument passed to cb.
+*
+* \return
+* RESULT_OK when queued or issued successfully, RESULT_ERROR otherwise.
+*
+*******************************************************************************/
+int cylpa_olm_txn_pf_enable(olm_txn_t *txn, void *whd, uint8_t id, bool enable, olm_txn_cb_t *cb, void *cb_arg)
+{
+    olm_txn_entry_t entry;
+
+    memset(&entry, 0, sizeof(entry) );
+    entry.op = OLM_TXN_OP_PF_ENABLE;
+    entry.u.pf.id = id;
+    entry.u.pf.enable = enable ? 1 : 0;
+    entry.cb = cb;
+    entry.cb_arg = cb_arg;
+    return cylpa_olm_txn_queue(txn, whd, &entry, NULL);
+}
+
+/*******************************************************************************
+* Function Name: cylpa_olm_txn_call
+****************************************************************************//**
+*
+* Queue a WHD sequence that cannot be expressed as a single IOVAR set, e.g. one
+* that has to read firmware state or branch on intermediate results. It runs at
+* its place in the queue and is never batched.
+*
+* \param txn
+* Open transaction or NULL.
+*
+* \param whd
+* The pointer to the whd interface.
+*
+* \param fn
+* Function to run; called as fn(whd, arg, param).
+*
+* \param arg
+* First argument of fn.
+*
+* \param param
+* Second argument of fn.
+*
+* \param cb
+* Completion callback, may be NULL.
+*
+* \param cb_arg
+* Argument passed to cb.
+*
+* \return
+* RESULT_OK when queued or run successfully, RESULT_ERROR otherwise.
+*
+*******************************************************************************/
+int cylpa_olm_txn_call(olm_txn_t *txn, void *whd, olm_txn_fn_t *fn, void *arg, uint32_t param,
+                       olm_txn_cb_t *cb, void *cb_arg)
+{
+    olm_txn_entry_t entry;
+
+    memset(&entry, 0, sizeof(entry) );
+    entry.op = OLM_TXN_OP_CALL;
+    entry.u.call.fn = fn;
+    entry.u.call.arg = arg;
+    entry.u.call.param = param;
+    entry.cb = cb;
+    entry.cb_arg = cb_arg;
+    return cylpa_olm_txn_queue(txn, whd, &entry, NULL);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,419 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ *
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+
+/**
+* @file cy_lpa_wifi_pf_adapt.c
+* @brief Adaptive sleep filters.
+*
+* Classifies the frames the host receives after a wake and scores the classes
+* that wake it for nothing. The packet filter offload turns the worst ones into
+* temporary sleep discard filters; see cylpa_pf_ol_adapt().
+*
+* Like the compiler, this calls no WHD or RTOS function; the offload passes the
+* time in and serializes the calls.
+*/
+
+#include <string.h>
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_ol_common.h"
+#include "cy_lpa_wifi_ol_priv.h"
+#include "cy_lpa_wifi_pf_ol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* Local definition
+*******************************************************************************/
+#define PF_OFFSET_ETHTYPE           (12)        /* Ethernet header: EtherType */
+#define PF_OFFSET_IP                (14)        /* IP header, no VLAN tag */
+#define PF_IPV4_HDR_LEN             (20)        /* IPv4 header without options */
+#define PF_IPV6_HDR_LEN             (40)        /* IPv6 header */
+
+#define PF_ETHTYPE_IPV4             (0x0800)
+#define PF_ETHTYPE_IPV6             (0x86DD)
+#define PF_IP_PROTO_TCP             (6)
+#define PF_IP_PROTO_UDP             (17)
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static uint16_t cylpa_pf_get16(const uint8_t *p);
+static bool cylpa_pf_adapt_allowed(const cy_pf_ol_adapt_cfg_t *cfg, const cy_pf_ol_class_t *cls);
+static cy_pf_ol_adapt_class_t *cylpa_pf_adapt_find(cy_pf_ol_adapt_t *ad, const cy_pf_ol_class_t *cls);
+static cy_pf_ol_adapt_class_t *cylpa_pf_adapt_slot(cy_pf_ol_adapt_t *ad);
+
+/* Network order */
+static uint16_t cylpa_pf_get16(const uint8_t *p)
+{
+    return (uint16_t)( (p[0] << 8) | p[1] );
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_classify
+ ****************************************************************************//**
+ *
+ * Classify a received frame.
+ *
+ * \param frame
+ * Frame, from the start of the Ethernet header.
+ *
+ * \param len
+ * Bytes in frame.
+ *
+ * \param cls
+ * Class of the frame.
+ *
+ * \return
+ * RESULT_OK, or RESULT_BADARGS
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_classify(const uint8_t *frame, uint32_t len, cy_pf_ol_class_t *cls)
+{
+    const uint8_t *ip = frame + PF_OFFSET_IP;
+    uint32_t l4 = 0;
+
+    if ( (frame == NULL) || (cls == NULL) || (len < PF_OFFSET_IP) )
+    {
+        return RESULT_BADARGS;
+    }
+
+    memset(cls, 0, sizeof(*cls) );
+    cls->eth_type = cylpa_pf_get16(frame + PF_OFFSET_ETHTYPE);
+
+    if ( (cls->eth_type == PF_ETHTYPE_IPV4) && (len >= PF_OFFSET_IP + PF_IPV4_HDR_LEN) )
+    {
+        cls->ip_type = ip[9];
+        /* Ports at a fixed offset: no options, first fragment */
+        if ( ( (ip[0] & 0x0f) * 4 == PF_IPV4_HDR_LEN ) && ( (cylpa_pf_get16(ip + 6) & 0x1fff) == 0 ) )
+        {
+            l4 = PF_OFFSET_IP + PF_IPV4_HDR_LEN;
+        }
+    }
+    else if ( (cls->eth_type == PF_ETHTYPE_IPV6) && (len >= PF_OFFSET_IP + PF_IPV6_HDR_LEN) )
+    {
+        cls->ip_type = ip[6];
+        l4 = PF_OFFSET_IP + PF_IPV6_HDR_LEN;
+    }
+
+    if ( (l4 != 0) && (len >= l4 + 4) &&
+         ( (cls->ip_type == PF_IP_PROTO_TCP) || (cls->ip_type == PF_IP_PROTO_UDP) ) )
+    {
+        cls->port = cylpa_pf_get16(frame + l4 + 2);
+    }
+    return RESULT_OK;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_class_cfg
+ ****************************************************************************//**
+ *
+ * Describe the sleep discard filter of a class as a configuration entry.
+ *
+ * \param cls
+ * The class.
+ *
+ * \param id
+ * Id of the entry.
+ *
+ * \param cfg
+ * The entry.
+ *
+ * \return
+ * RESULT_OK, RESULT_BADARGS, or RESULT_UNSUPPORTED
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_class_cfg(const cy_pf_ol_class_t *cls, uint8_t id, cy_pf_ol_cfg_t *cfg)
+{
+    bool ip;
+
+    if ( (cls == NULL) || (cfg == NULL) )
+    {
+        return RESULT_BADARGS;
+    }
+
+    ip = (cls->eth_type == PF_ETHTYPE_IPV4) || (cls->eth_type == PF_ETHTYPE_IPV6);
+    memset(cfg, 0, sizeof(*cfg) );
+    cfg->id = id;
+    cfg->bits = CY_PF_ACTIVE_SLEEP | CY_PF_ACTION_DISCARD;
+    if (cls->eth_type == PF_ETHTYPE_IPV6)
+    {
+        cfg->bits |= CY_PF_IPV6;
+    }
+
+    if (ip && (cls->port != 0) && ( (cls->ip_type == PF_IP_PROTO_TCP) || (cls->ip_type == PF_IP_PROTO_UDP) ) )
+    {
+        cfg->feature = CY_PF_OL_FEAT_PORTNUM;
+        cfg->u.pf.portnum.portnum = cls->port;
+        cfg->u.pf.portnum.direction = PF_PN_PORT_DEST;
+        cfg->u.pf.proto = (cls->ip_type == PF_IP_PROTO_TCP) ? CY_PF_PROTOCOL_TCP : CY_PF_PROTOCOL_UDP;
+    }
+    else if (ip && (cls->ip_type != 0) )
+    {
+        cfg->feature = CY_PF_OL_FEAT_IPTYPE;
+        cfg->u.ip.ip_type = cls->ip_type;
+    }
+    else if (!ip && (cls->eth_type != 0) )
+    {
+        cfg->feature = CY_PF_OL_FEAT_ETHTYPE;
+        cfg->u.eth.eth_type = cls->eth_type;
+    }
+    else
+    {
+        /* Would discard a whole IP family */
+        return RESULT_UNSUPPORTED;
+    }
+    return RESULT_OK;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_adapt_allowed
+ ****************************************************************************//**
+ *
+ * Check a class against the allow-list.
+ *
+ * \param cfg
+ * The settings \ref cy_pf_ol_adapt_cfg_t.
+ *
+ * \param cls
+ * The class.
+ *
+ * \return
+ * true if an allow-list entry matches the class
+ *
+ ********************************************************************************/
+static bool cylpa_pf_adapt_allowed(const cy_pf_ol_adapt_cfg_t *cfg, const cy_pf_ol_class_t *cls)
+{
+    const cy_pf_ol_class_t *a;
+
+    for (a = cfg->allow; (a != NULL) && (a < &cfg->allow[cfg->allow_count]); a++)
+    {
+        if ( ( (a->eth_type == 0) || (a->eth_type == cls->eth_type) ) &&
+             ( (a->ip_type == 0) || (a->ip_type == cls->ip_type) ) &&
+             ( (a->port == 0) || (a->port == cls->port) ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* The tracked entry of a class */
+static cy_pf_ol_adapt_class_t *cylpa_pf_adapt_find(cy_pf_ol_adapt_t *ad, const cy_pf_ol_class_t *cls)
+{
+    cy_pf_ol_adapt_class_t *c;
+
+    for (c = ad->classes; c < &ad->classes[ad->class_count]; c++)
+    {
+        if ( (c->cls.eth_type == cls->eth_type) && (c->cls.ip_type == cls->ip_type) && (c->cls.port == cls->port) )
+        {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_adapt_slot
+ ****************************************************************************//**
+ *
+ * An entry for a new class: a free one, else the unfiltered entry with the
+ * lowest score, the one charged longest ago on a tie.
+ *
+ * \param ad
+ * The adaptive state \ref cy_pf_ol_adapt_t.
+ *
+ * \return
+ * The entry, or NULL if every entry is filtered
+ *
+ ********************************************************************************/
+static cy_pf_ol_adapt_class_t *cylpa_pf_adapt_slot(cy_pf_ol_adapt_t *ad)
+{
+    cy_pf_ol_adapt_class_t *c;
+    cy_pf_ol_adapt_class_t *victim = NULL;
+
+    if (ad->class_count < CY_PF_OL_ADAPT_MAX_CLASSES)
+    {
+        return &ad->classes[ad->class_count++];
+    }
+
+    for (c = ad->classes; c < &ad->classes[ad->class_count]; c++)
+    {
+        if (c->filtered)
+        {
+            continue;
+        }
+        if ( (victim == NULL) || (c->score < victim->score) ||
+             ( (c->score == victim->score) && (ad->wake - c->last_wake > ad->wake - victim->last_wake) ) )
+        {
+            victim = c;
+        }
+    }
+    return victim;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_adapt_charge
+ ****************************************************************************//**
+ *
+ * Charge a frame received by the host to its class. An unconsumed frame adds
+ * one to the score of its class, once per wake; a consumed one clears the score
+ * and makes the filter of the class lapse.
+ *
+ * \param ad
+ * The adaptive state \ref cy_pf_ol_adapt_t.
+ *
+ * \param cls
+ * Class of the frame.
+ *
+ * \param consumed
+ * The application used the frame.
+ *
+ * \param now_ms
+ * Current time.
+ *
+ ********************************************************************************/
+void cylpa_pf_adapt_charge(cy_pf_ol_adapt_t *ad, const cy_pf_ol_class_t *cls, bool consumed, uint32_t now_ms)
+{
+    cy_pf_ol_adapt_class_t *c = cylpa_pf_adapt_find(ad, cls);
+
+    if (consumed)
+    {
+        if (c != NULL)
+        {
+            c->score = 0;
+            if (c->filtered)
+            {
+                c->expires = now_ms;
+            }
+        }
+        return;
+    }
+
+    if (cylpa_pf_adapt_allowed(&ad->cfg, cls) )
+    {
+        return;
+    }
+
+    if (c == NULL)
+    {
+        c = cylpa_pf_adapt_slot(ad);
+        if (c == NULL)
+        {
+            return;
+        }
+        memset(c, 0, sizeof(*c) );
+        c->cls = *cls;
+        c->last_wake = ad->wake - 1;
+    }
+
+    if (c->last_wake != ad->wake)
+    {
+        c->last_wake = ad->wake;
+        c->score++;
+        c->wakes++;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_adapt_worst
+ ****************************************************************************//**
+ *
+ * The class to discard next.
+ *
+ * \param ad
+ * The adaptive state \ref cy_pf_ol_adapt_t.
+ *
+ * \return
+ * The class with the highest score at or above the threshold, most wakes on a
+ * tie, that is not allowed, filtered or blocked; NULL if there is none
+ *
+ ********************************************************************************/
+cy_pf_ol_adapt_class_t *cylpa_pf_adapt_worst(cy_pf_ol_adapt_t *ad)
+{
+    cy_pf_ol_adapt_class_t *c;
+    cy_pf_ol_adapt_class_t *worst = NULL;
+
+    for (c = ad->classes; c < &ad->classes[ad->class_count]; c++)
+    {
+        if (c->filtered || c->blocked || (c->score < ad->cfg.threshold) ||
+            cylpa_pf_adapt_allowed(&ad->cfg, &c->cls) )
+        {
+            continue;
+        }
+        if ( (worst == NULL) || (c->score > worst->score) ||
+             ( (c->score == worst->score) && (c->wakes > worst->wakes) ) )
+        {
+            worst = c;
+        }
+    }
+    return worst;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_adapt_overlaps
+ ****************************************************************************//**
+ *
+ * Check whether some frame matches both filters: no byte both filters match
+ * has bits that must differ.
+ *
+ * \param a
+ * A filter \ref cy_pf_ol_filter_t.
+ *
+ * \param b
+ * Another filter.
+ *
+ * \return
+ * true if the filters overlap
+ *
+ ********************************************************************************/
+bool cylpa_pf_adapt_overlaps(const cy_pf_ol_filter_t *a, const cy_pf_ol_filter_t *b)
+{
+    uint32_t start = (a->offset > b->offset) ? a->offset : b->offset;
+    uint32_t end_a = a->offset + a->len;
+    uint32_t end_b = b->offset + b->len;
+    uint32_t end = (end_a < end_b) ? end_a : end_b;
+    uint32_t o;
+
+    for (o = start; o < end; o++)
+    {
+        if ( (a->pattern[o - a->offset] ^ b->pattern[o - b->offset]) & a->mask[o - a->offset] & b->mask[o - b->offset] )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
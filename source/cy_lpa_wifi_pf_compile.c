@@ -0,0 +1,1100 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ *
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+
+/**
+* @file cy_lpa_wifi_pf_compile.c
+* @brief Packet filter compiler.
+*
+* Turns a cy_pf_ol_cfg_t list into the pattern/mask filters the firmware is
+* programmed with. Every entry is first built as a byte window over the frame;
+* the windows are then optimized so the configuration costs as few firmware
+* slots and per-packet compares as possible.
+*
+* The optimizations keep the result of the filter set for every packet, as the
+* firmware applies it: with no filter active everything is forwarded; a packet
+* matching an active discard filter is dropped; otherwise, if keep filters are
+* active, only a packet matching one of them is forwarded. Under that model
+* - a filter equal to another one is dropped;
+* - a filter whose packets are all matched by another filter with the same
+*   action, active whenever it is, is dropped;
+* - a keep filter whose packets are all dropped by a discard filter is dropped,
+*   unless it is the only keep filter active in some power state;
+* - two filters with the same action, activity and mask whose patterns differ
+*   in a single bit are replaced by one filter ignoring that bit.
+* The order of the filters does not change the result; they are programmed
+* with the ones expected to match most traffic first.
+*
+* Frames are expected without a VLAN tag. TCP/UDP ports are matched where they
+* follow an IPv4 header without options, or an IPv6 header without extension
+* headers; other packets do not match a port filter.
+*
+* The compiler calls no WHD or RTOS function, so it may run on any thread, on
+* a configuration prepared ahead of time, or on a host.
+*/
+
+#include <string.h>
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_ol_common.h"
+#include "cy_lpa_wifi_pf_ol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* Local definition
+*******************************************************************************/
+#define PF_OFFSET_DST_MAC           (0)         /* Ethernet header: destination address */
+#define PF_OFFSET_ETHTYPE           (12)        /* Ethernet header: EtherType */
+#define PF_OFFSET_IP                (14)        /* IP header, no VLAN tag */
+
+#define PF_ETHTYPE_IPV4             (0x0800)
+#define PF_ETHTYPE_IPV6             (0x86DD)
+#define PF_IP_PROTO_TCP             (6)
+#define PF_IP_PROTO_UDP             (17)
+
+#define PF_BITS_ACTIVE              (CY_PF_ACTIVE_SLEEP | CY_PF_ACTIVE_WAKE)
+#define PF_BITS_ALL                 (PF_BITS_ACTIVE | CY_PF_ACTION_DISCARD)
+#define PF_MAX_PORT_BLOCKS          (32)        /* Blocks covering any range of 16 bit ports */
+
+/* alias[] value of a filter still in the program */
+#define PF_ALIVE(alias, i)          ( (alias)[i] == (i) )
+
+/* Where an IP family puts its fields; TCP/UDP follow a header without options or extension headers */
+typedef struct cylpa_pf_family
+{
+    uint16_t ethtype;                   /* EtherType */
+    uint16_t proto;                     /* IPv4 Protocol, IPv6 Next Header */
+    uint16_t src;                       /* Source address */
+    uint16_t dst;                       /* Destination address */
+    uint16_t src_port;                  /* TCP/UDP source port */
+    uint16_t dst_port;                  /* TCP/UDP destination port */
+    uint8_t  addr_len;                  /* Bytes in an address */
+} cylpa_pf_family_t;
+
+static const cylpa_pf_family_t cylpa_pf_ipv4 =
+{
+    PF_ETHTYPE_IPV4, PF_OFFSET_IP + 9, PF_OFFSET_IP + 12, PF_OFFSET_IP + 16,
+    PF_OFFSET_IP + 20, PF_OFFSET_IP + 22, CY_PF_OL_IPV4_ADDR_LEN
+};
+
+static const cylpa_pf_family_t cylpa_pf_ipv6 =
+{
+    PF_ETHTYPE_IPV6, PF_OFFSET_IP + 6, PF_OFFSET_IP + 8, PF_OFFSET_IP + 24,
+    PF_OFFSET_IP + 40, PF_OFFSET_IP + 42, CY_PF_OL_IPV6_ADDR_LEN
+};
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static bool cylpa_pf_field(cy_pf_ol_filter_t *f, uint16_t offset, const uint8_t *value, const uint8_t *mask, uint8_t len);
+static bool cylpa_pf_field8(cy_pf_ol_filter_t *f, uint16_t offset, uint8_t value, uint8_t mask);
+static bool cylpa_pf_field16(cy_pf_ol_filter_t *f, uint16_t offset, uint16_t value, uint16_t mask);
+static bool cylpa_pf_field_prefix(cy_pf_ol_filter_t *f, uint16_t offset, const uint8_t *value, uint8_t len, uint32_t prefix_len);
+static void cylpa_pf_trim(cy_pf_ol_filter_t *f);
+static const cy_pf_port_t *cylpa_pf_port(const cy_pf_ol_cfg_t *cfg);
+static uint32_t cylpa_pf_port_blocks(const cy_pf_port_t *port, uint16_t *pattern, uint16_t *mask);
+static uint32_t cylpa_pf_families(const cy_pf_ol_cfg_t *cfg, const cylpa_pf_family_t **family);
+static bool cylpa_pf_build(const cy_pf_ol_cfg_t *cfg, const cylpa_pf_family_t *family, cy_pf_ol_filter_t *f);
+static bool cylpa_pf_alloc_id(uint32_t *used, uint8_t *id);
+static bool cylpa_pf_push(cy_pf_ol_program_t *prog, uint8_t *alias, const cy_pf_ol_filter_t *f, uint8_t cfg_id);
+static bool cylpa_pf_emit(cy_pf_ol_program_t *prog, uint8_t *alias, const cy_pf_ol_cfg_t *cfg, uint32_t *used);
+static bool cylpa_pf_same(const cy_pf_ol_filter_t *a, const cy_pf_ol_filter_t *b);
+static bool cylpa_pf_covers(const cy_pf_ol_filter_t *a, const cy_pf_ol_filter_t *b);
+static int cylpa_pf_one_bit(const cy_pf_ol_filter_t *a, const cy_pf_ol_filter_t *b);
+static bool cylpa_pf_keep_remains(const cy_pf_ol_program_t *prog, const uint8_t *alias, uint32_t skip, uint32_t states);
+static void cylpa_pf_drop(cy_pf_ol_program_t *prog, uint8_t *alias, uint32_t from, uint32_t to, uint8_t kind);
+static bool cylpa_pf_pass(cy_pf_ol_program_t *prog, uint8_t *alias);
+static uint32_t cylpa_pf_weight(const cy_pf_ol_filter_t *f);
+static void cylpa_pf_finish(cy_pf_ol_program_t *prog, uint8_t *alias);
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_field
+ ****************************************************************************//**
+ *
+ * Add bytes to match to a filter, growing its window.
+ *
+ * \param f
+ * The filter.
+ *
+ * \param offset
+ * Offset of value[0] from the start of the Ethernet header.
+ *
+ * \param value
+ * Bytes to match.
+ *
+ * \param mask
+ * Bits of value to match.
+ *
+ * \param len
+ * Bytes in value and mask.
+ *
+ * \return
+ * false if the window would exceed CY_PF_OL_MAX_PATTERN_LEN
+ *
+ ********************************************************************************/
+static bool cylpa_pf_field(cy_pf_ol_filter_t *f, uint16_t offset, const uint8_t *value, const uint8_t *mask, uint8_t len)
+{
+    uint32_t start = offset;
+    uint32_t end = (uint32_t)offset + len;
+    uint32_t shift;
+    uint32_t i;
+
+    if (f->len != 0)
+    {
+        start = (f->offset < start) ? f->offset : start;
+        end = ( ( (uint32_t)f->offset + f->len ) > end ) ? ( (uint32_t)f->offset + f->len ) : end;
+    }
+    if ( (end - start) > CY_PF_OL_MAX_PATTERN_LEN )
+    {
+        return false;
+    }
+
+    /* Keep the bytes already there at their frame offset */
+    if ( (f->len != 0) && (start < f->offset) )
+    {
+        shift = f->offset - start;
+        memmove(&f->pattern[shift], f->pattern, f->len);
+        memmove(&f->mask[shift], f->mask, f->len);
+        memset(f->pattern, 0, shift);
+        memset(f->mask, 0, shift);
+    }
+    if (f->len == 0)
+    {
+        memset(f->pattern, 0, sizeof(f->pattern) );
+        memset(f->mask, 0, sizeof(f->mask) );
+    }
+    f->offset = (uint16_t)start;
+    f->len = (uint8_t)(end - start);
+
+    for (i = 0; i < len; i++)
+    {
+        f->mask[offset - start + i] |= mask[i];
+        f->pattern[offset - start + i] |= (value[i] & mask[i]);
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_field8
+ ****************************************************************************//**
+ *
+ * Add a byte to match to a filter.
+ *
+ ********************************************************************************/
+static bool cylpa_pf_field8(cy_pf_ol_filter_t *f, uint16_t offset, uint8_t value, uint8_t mask)
+{
+    return cylpa_pf_field(f, offset, &value, &mask, 1);
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_field16
+ ****************************************************************************//**
+ *
+ * Add a 16 bit field in network order to match to a filter.
+ *
+ ********************************************************************************/
+static bool cylpa_pf_field16(cy_pf_ol_filter_t *f, uint16_t offset, uint16_t value, uint16_t mask)
+{
+    uint8_t v[2] = { (uint8_t)(value >> 8), (uint8_t)value };
+    uint8_t m[2] = { (uint8_t)(mask >> 8), (uint8_t)mask };
+
+    return cylpa_pf_field(f, offset, v, m, sizeof(v) );
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_field_prefix
+ ****************************************************************************//**
+ *
+ * Add the leading bits of a field in network order to match to a filter, e.g.
+ * the subnet part of an address.
+ *
+ * \param f
+ * The filter.
+ *
+ * \param offset
+ * Offset of value[0] from the start of the Ethernet header.
+ *
+ * \param value
+ * The field.
+ *
+ * \param len
+ * Bytes in value.
+ *
+ * \param prefix_len
+ * Leading bits to match, at most len * 8.
+ *
+ * \return
+ * false if the window would exceed CY_PF_OL_MAX_PATTERN_LEN
+ *
+ ********************************************************************************/
+static bool cylpa_pf_field_prefix(cy_pf_ol_filter_t *f, uint16_t offset, const uint8_t *value, uint8_t len, uint32_t prefix_len)
+{
+    uint8_t mask[CY_PF_OL_MAX_PATTERN_LEN];
+    uint32_t i;
+
+    if (prefix_len == 0)
+    {
+        return true;
+    }
+    for (i = 0; i < len; i++)
+    {
+        if (prefix_len >= 8)
+        {
+            mask[i] = 0xff;
+            prefix_len -= 8;
+        }
+        else
+        {
+            mask[i] = (uint8_t)(0xff << (8 - prefix_len) );
+            prefix_len = 0;
+        }
+    }
+    return cylpa_pf_field(f, offset, value, mask, len);
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_trim
+ ****************************************************************************//**
+ *
+ * Drop the bytes without any bit to match from both ends of the window, so
+ * equal filters have equal windows and the firmware compares fewer bytes.
+ *
+ * \param f
+ * The filter.
+ *
+ ********************************************************************************/
+static void cylpa_pf_trim(cy_pf_ol_filter_t *f)
+{
+    uint32_t lead = 0;
+
+    while ( (f->len > 0) && (f->mask[f->len - 1] == 0) )
+    {
+        f->len--;
+    }
+    while ( (lead < f->len) && (f->mask[lead] == 0) )
+    {
+        lead++;
+    }
+    if (lead != 0)
+    {
+        memmove(f->pattern, &f->pattern[lead], f->len - lead);
+        memmove(f->mask, &f->mask[lead], f->len - lead);
+        memset(&f->pattern[f->len - lead], 0, lead);
+        memset(&f->mask[f->len - lead], 0, lead);
+        f->offset += lead;
+        f->len -= lead;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_port
+ ****************************************************************************//**
+ *
+ * The ports a configuration entry matches.
+ *
+ * \param cfg
+ * The entry.
+ *
+ * \return
+ * The ports, NULL if the entry matches any port
+ *
+ ********************************************************************************/
+static const cy_pf_port_t *cylpa_pf_port(const cy_pf_ol_cfg_t *cfg)
+{
+    switch (cfg->feature)
+    {
+        case CY_PF_OL_FEAT_PORTNUM:
+            return &cfg->u.pf.portnum;
+        case CY_PF_OL_FEAT_IPADDR:
+            if ( (cfg->u.addr.port.portnum != 0) || (cfg->u.addr.port.range != 0) )
+            {
+                return &cfg->u.addr.port;
+            }
+            return NULL;
+        default:
+            return NULL;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_port_blocks
+ ****************************************************************************//**
+ *
+ * Split the ports portnum thru portnum + range into the fewest blocks of 2^n
+ * ports starting on a multiple of 2^n; each block is one pattern/mask pair.
+ *
+ * Say using ports 1000 thru 1100: 1000-1023 are 1000-1007 (pattern 1000, mask
+ * 0xfff8) and 1008-1023 (1008, 0xfff0), then 1024-1087 (1024, 0xffc0),
+ * 1088-1095 (1088, 0xfff8), 1096-1099 (1096, 0xfffc) and 1100 (1100, 0xffff).
+ *
+ * \param port
+ * The ports.
+ *
+ * \param pattern
+ * Block patterns, PF_MAX_PORT_BLOCKS entries.
+ *
+ * \param mask
+ * Block masks, PF_MAX_PORT_BLOCKS entries.
+ *
+ * \return
+ * Number of blocks
+ *
+ ********************************************************************************/
+static uint32_t cylpa_pf_port_blocks(const cy_pf_port_t *port, uint16_t *pattern, uint16_t *mask)
+{
+    uint32_t lo = port->portnum;
+    uint32_t hi = lo + port->range;
+    uint32_t size;
+    uint32_t count = 0;
+
+    if (hi > 0xffff)
+    {
+        hi = 0xffff;
+    }
+
+    while (lo <= hi)
+    {
+        /* Largest aligned block starting at lo that ends by hi */
+        for (size = 1; ( (lo & size) == 0 ) && (size < 0x10000) && ( (lo + (size << 1) - 1) <= hi ); size <<= 1)
+        {
+        }
+        pattern[count] = (uint16_t)lo;
+        mask[count] = (uint16_t)~(size - 1);
+        count++;
+        lo += size;
+    }
+    return count;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_families
+ ****************************************************************************//**
+ *
+ * The IP families a configuration entry matches; one filter is built for each.
+ *
+ * \param cfg
+ * The entry.
+ *
+ * \param family
+ * Filled in with up to two families.
+ *
+ * \return
+ * Number of families
+ *
+ ********************************************************************************/
+static uint32_t cylpa_pf_families(const cy_pf_ol_cfg_t *cfg, const cylpa_pf_family_t **family)
+{
+    /* Only port, IP type and address filters have an IP family */
+    if ( ( (cfg->feature != CY_PF_OL_FEAT_PORTNUM) && (cfg->feature != CY_PF_OL_FEAT_IPTYPE) &&
+           (cfg->feature != CY_PF_OL_FEAT_IPADDR) ) || ( (cfg->bits & (CY_PF_IPV6 | CY_PF_IPV4_IPV6) ) == 0 ) )
+    {
+        family[0] = &cylpa_pf_ipv4;
+        return 1;
+    }
+    if ( (cfg->bits & CY_PF_IPV4_IPV6) == 0 )
+    {
+        family[0] = &cylpa_pf_ipv6;
+        return 1;
+    }
+    family[0] = &cylpa_pf_ipv4;
+    family[1] = &cylpa_pf_ipv6;
+    return 2;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_build
+ ****************************************************************************//**
+ *
+ * Build the filter of one configuration entry for one IP family. When the
+ * entry matches ports they are left out; they are added per block.
+ *
+ * \param cfg
+ * The entry.
+ *
+ * \param family
+ * The IP family.
+ *
+ * \param f
+ * The filter.
+ *
+ * \return
+ * false if the feature is unknown or does not fit a filter
+ *
+ ********************************************************************************/
+static bool cylpa_pf_build(const cy_pf_ol_cfg_t *cfg, const cylpa_pf_family_t *family, cy_pf_ol_filter_t *f)
+{
+    const uint8_t *addr;
+    uint32_t prefix_len;
+    bool ok = true;
+
+    memset(f, 0, sizeof(*f) );
+    f->id = cfg->id;
+    f->bits = cfg->bits & PF_BITS_ALL;
+
+    switch (cfg->feature)
+    {
+        case CY_PF_OL_FEAT_ETHTYPE:
+            ok = cylpa_pf_field16(f, PF_OFFSET_ETHTYPE, cfg->u.eth.eth_type, 0xffff);
+            break;
+        case CY_PF_OL_FEAT_IPTYPE:
+            ok = cylpa_pf_field16(f, PF_OFFSET_ETHTYPE, family->ethtype, 0xffff) &&
+                 cylpa_pf_field8(f, family->proto, cfg->u.ip.ip_type, 0xff);
+            break;
+        case CY_PF_OL_FEAT_PORTNUM:
+            ok = cylpa_pf_field16(f, PF_OFFSET_ETHTYPE, family->ethtype, 0xffff) &&
+                 cylpa_pf_field8(f, family->proto,
+                                 (cfg->u.pf.proto == CY_PF_PROTOCOL_UDP) ? PF_IP_PROTO_UDP : PF_IP_PROTO_TCP, 0xff);
+            break;
+        case CY_PF_OL_FEAT_IPADDR:
+            addr = (family == &cylpa_pf_ipv6) ? cfg->u.addr.ip6_addr : cfg->u.addr.ip_addr;
+            prefix_len = (family == &cylpa_pf_ipv6) ? cfg->u.addr.prefix6_len : cfg->u.addr.prefix_len;
+
+            /* Ports are only where TCP and UDP put them */
+            if ( (prefix_len > (uint32_t)family->addr_len * 8) ||
+                 ( (cylpa_pf_port(cfg) != NULL) && (cfg->u.addr.ip_type != PF_IP_PROTO_TCP) &&
+                   (cfg->u.addr.ip_type != PF_IP_PROTO_UDP) ) )
+            {
+                ok = false;
+                break;
+            }
+            ok = cylpa_pf_field16(f, PF_OFFSET_ETHTYPE, family->ethtype, 0xffff);
+            if (ok && (cfg->u.addr.ip_type != 0) )
+            {
+                ok = cylpa_pf_field8(f, family->proto, cfg->u.addr.ip_type, 0xff);
+            }
+            if (ok && (cfg->u.addr.direction != PF_PN_PORT_DEST) )
+            {
+                ok = cylpa_pf_field_prefix(f, family->src, addr, family->addr_len, prefix_len);
+            }
+            if (ok && (cfg->u.addr.direction != PF_PN_PORT_SOURCE) )
+            {
+                ok = cylpa_pf_field_prefix(f, family->dst, addr, family->addr_len, prefix_len);
+            }
+            break;
+        case CY_PF_OL_FEAT_MAC:
+            ok = cylpa_pf_field(f, PF_OFFSET_DST_MAC, cfg->u.mac.mac, cfg->u.mac.mac_mask, CY_PF_OL_MAC_ADDR_LEN);
+            if (ok && (cfg->u.mac.eth_type != 0) )
+            {
+                ok = cylpa_pf_field16(f, PF_OFFSET_ETHTYPE, cfg->u.mac.eth_type, 0xffff);
+            }
+            break;
+        case CY_PF_OL_FEAT_PATTERN:
+            if ( (cfg->u.pat.pattern == NULL) || (cfg->u.pat.len == 0) || (cfg->u.pat.len > CY_PF_OL_MAX_PATTERN_LEN) )
+            {
+                ok = false;
+                break;
+            }
+            if (cfg->u.pat.mask != NULL)
+            {
+                ok = cylpa_pf_field(f, cfg->u.pat.offset, cfg->u.pat.pattern, cfg->u.pat.mask, cfg->u.pat.len);
+            }
+            else
+            {
+                ok = cylpa_pf_field_prefix(f, cfg->u.pat.offset, cfg->u.pat.pattern, cfg->u.pat.len,
+                                           (uint32_t)cfg->u.pat.len * 8);
+            }
+            break;
+        default:
+            ok = false;
+            break;
+    }
+
+    /* An empty mask would match every frame */
+    cylpa_pf_trim(f);
+    return ok && (f->len != 0);
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_alloc_id
+ ****************************************************************************//**
+ *
+ * Take a filter id no configuration entry uses, counting down from 255.
+ *
+ * \param used
+ * Ids in use, one bit each.
+ *
+ * \param id
+ * The id.
+ *
+ * \return
+ * false if every id is in use
+ *
+ ********************************************************************************/
+static bool cylpa_pf_alloc_id(uint32_t *used, uint8_t *id)
+{
+    int i;
+
+    for (i = 0xff; i >= 0; i--)
+    {
+        if ( (used[i / 32] & (1UL << (i % 32) ) ) == 0 )
+        {
+            used[i / 32] |= (1UL << (i % 32) );
+            *id = (uint8_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_push
+ ****************************************************************************//**
+ *
+ * Append a filter implementing a configuration entry to the program.
+ *
+ ********************************************************************************/
+static bool cylpa_pf_push(cy_pf_ol_program_t *prog, uint8_t *alias, const cy_pf_ol_filter_t *f, uint8_t cfg_id)
+{
+    cy_pf_ol_map_t *map;
+
+    if ( (prog->count == CY_PF_OL_MAX_FILTERS) || (prog->map_count == CY_PF_OL_MAX_MAP) )
+    {
+        return false;
+    }
+    memcpy(&prog->filters[prog->count], f, sizeof(*f) );
+    alias[prog->count] = prog->count;
+
+    map = &prog->map[prog->map_count++];
+    map->cfg_id = cfg_id;
+    map->filter_id = prog->count++;
+    map->kind = CY_PF_OL_MAP_EMITTED;
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_emit
+ ****************************************************************************//**
+ *
+ * Append the filters of one active configuration entry to the program. A port
+ * range takes a filter per block, or per pair of blocks when both ports are
+ * matched, and each IP family its own set; the first filter has the entry id,
+ * the others allocated ones.
+ *
+ * \param prog
+ * The program.
+ *
+ * \param alias
+ * Survivor of each filter.
+ *
+ * \param cfg
+ * The entry.
+ *
+ * \param used
+ * Ids in use, one bit each.
+ *
+ * \return
+ * false if the entry could not be implemented
+ *
+ ********************************************************************************/
+static bool cylpa_pf_emit(cy_pf_ol_program_t *prog, uint8_t *alias, const cy_pf_ol_cfg_t *cfg, uint32_t *used)
+{
+    uint16_t pattern[PF_MAX_PORT_BLOCKS];
+    uint16_t mask[PF_MAX_PORT_BLOCKS];
+    const cy_pf_port_t *port = cylpa_pf_port(cfg);
+    const cylpa_pf_family_t *family[2];
+    cy_pf_ol_filter_t base;
+    cy_pf_ol_filter_t f;
+    uint32_t families;
+    uint32_t blocks = 1;
+    uint32_t src_count = 1;
+    uint32_t dst_count = 1;
+    uint32_t i, s, d;
+    bool first = true;
+
+    families = cylpa_pf_families(cfg, family);
+    if (port != NULL)
+    {
+        blocks = cylpa_pf_port_blocks(port, pattern, mask);
+        src_count = (port->direction != PF_PN_PORT_DEST) ? blocks : 1;
+        dst_count = (port->direction != PF_PN_PORT_SOURCE) ? blocks : 1;
+    }
+
+    for (i = 0; i < families; i++)
+    {
+        if (!cylpa_pf_build(cfg, family[i], &base) )
+        {
+            return false;
+        }
+        for (s = 0; s < src_count; s++)
+        {
+            for (d = 0; d < dst_count; d++)
+            {
+                memcpy(&f, &base, sizeof(f) );
+                if ( (port != NULL) &&
+                     ( ( (port->direction != PF_PN_PORT_DEST) &&
+                         !cylpa_pf_field16(&f, family[i]->src_port, pattern[s], mask[s]) ) ||
+                       ( (port->direction != PF_PN_PORT_SOURCE) &&
+                         !cylpa_pf_field16(&f, family[i]->dst_port, pattern[d], mask[d]) ) ) )
+                {
+                    return false;
+                }
+                cylpa_pf_trim(&f);
+                if ( (!first && !cylpa_pf_alloc_id(used, &f.id) ) || !cylpa_pf_push(prog, alias, &f, cfg->id) )
+                {
+                    return false;
+                }
+                first = false;
+            }
+        }
+    }
+    prog->split += (uint8_t)( (src_count * dst_count * families) - 1 );
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_same
+ ****************************************************************************//**
+ *
+ * Whether two filters are programmed the same way, apart from their id.
+ *
+ ********************************************************************************/
+static bool cylpa_pf_same(const cy_pf_ol_filter_t *a, const cy_pf_ol_filter_t *b)
+{
+    return (a->bits == b->bits) && (a->offset == b->offset) && (a->len == b->len) &&
+           (memcmp(a->mask, b->mask, a->len) == 0) && (memcmp(a->pattern, b->pattern, a->len) == 0);
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_covers
+ ****************************************************************************//**
+ *
+ * Whether every packet b matches is matched by a as well: a matches a subset of
+ * the bits b matches, with the same values.
+ *
+ ********************************************************************************/
+static bool cylpa_pf_covers(const cy_pf_ol_filter_t *a, const cy_pf_ol_filter_t *b)
+{
+    uint32_t i;
+    uint32_t pos;
+    uint8_t mb;
+
+    for (i = 0; i < a->len; i++)
+    {
+        if (a->mask[i] == 0)
+        {
+            continue;
+        }
+        pos = (uint32_t)a->offset + i;
+        if ( (pos < b->offset) || (pos >= ( (uint32_t)b->offset + b->len ) ) )
+        {
+            return false;
+        }
+        mb = b->mask[pos - b->offset];
+        if ( ( (a->mask[i] & ~mb) != 0 ) || ( (a->pattern[i] ^ b->pattern[pos - b->offset]) & a->mask[i] ) != 0 )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_one_bit
+ ****************************************************************************//**
+ *
+ * Whether two filters with the same window and mask differ in one pattern bit.
+ *
+ * \return
+ * The bit, as byte * 8 + bit, or -1
+ *
+ ********************************************************************************/
+static int cylpa_pf_one_bit(const cy_pf_ol_filter_t *a, const cy_pf_ol_filter_t *b)
+{
+    int found = -1;
+    uint32_t i;
+    uint8_t diff;
+
+    if ( (a->bits != b->bits) || (a->offset != b->offset) || (a->len != b->len) ||
+         (memcmp(a->mask, b->mask, a->len) != 0) )
+    {
+        return -1;
+    }
+    for (i = 0; i < a->len; i++)
+    {
+        diff = (uint8_t)( (a->pattern[i] ^ b->pattern[i]) & a->mask[i] );
+        if (diff == 0)
+        {
+            continue;
+        }
+        if ( (found >= 0) || ( (diff & (diff - 1) ) != 0 ) )
+        {
+            return -1;
+        }
+        for (found = (int)i * 8; (diff & 1) == 0; diff >>= 1)
+        {
+            found++;
+        }
+    }
+    return found;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_keep_remains
+ ****************************************************************************//**
+ *
+ * Whether, without filter skip, a keep filter is still active in each of states.
+ *
+ ********************************************************************************/
+static bool cylpa_pf_keep_remains(const cy_pf_ol_program_t *prog, const uint8_t *alias, uint32_t skip, uint32_t states)
+{
+    uint32_t covered = 0;
+    uint32_t i;
+
+    for (i = 0; i < prog->count; i++)
+    {
+        if ( (i != skip) && PF_ALIVE(alias, i) && ( (prog->filters[i].bits & CY_PF_ACTION_DISCARD) == 0 ) )
+        {
+            covered |= prog->filters[i].bits & PF_BITS_ACTIVE;
+        }
+    }
+    return ( (covered & states) == states );
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_drop
+ ****************************************************************************//**
+ *
+ * Take filter from out of the program; its entries are implemented by filter to.
+ *
+ ********************************************************************************/
+static void cylpa_pf_drop(cy_pf_ol_program_t *prog, uint8_t *alias, uint32_t from, uint32_t to, uint8_t kind)
+{
+    uint32_t i;
+
+    alias[from] = (uint8_t)to;
+    for (i = 0; i < prog->map_count; i++)
+    {
+        if ( (prog->map[i].kind != CY_PF_OL_MAP_INACTIVE) && (prog->map[i].filter_id == from) )
+        {
+            prog->map[i].filter_id = (uint8_t)to;
+            prog->map[i].kind = kind;
+        }
+        else if ( (kind == CY_PF_OL_MAP_MERGED) && (prog->map[i].kind == CY_PF_OL_MAP_EMITTED) &&
+                  (prog->map[i].filter_id == to) )
+        {
+            prog->map[i].kind = CY_PF_OL_MAP_MERGED;
+        }
+    }
+    if (kind == CY_PF_OL_MAP_DUPLICATE)
+    {
+        prog->duplicates++;
+    }
+    else if (kind == CY_PF_OL_MAP_SHADOWED)
+    {
+        prog->shadowed++;
+    }
+    else
+    {
+        prog->merged++;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_pass
+ ****************************************************************************//**
+ *
+ * One round of duplicate removal, shadow removal and merging.
+ *
+ * \return
+ * true if the program changed
+ *
+ ********************************************************************************/
+static bool cylpa_pf_pass(cy_pf_ol_program_t *prog, uint8_t *alias)
+{
+    cy_pf_ol_filter_t *a;
+    cy_pf_ol_filter_t *b;
+    bool changed = false;
+    uint32_t i, j;
+    uint32_t states;
+    int bit;
+
+    for (i = 0; i < prog->count; i++)
+    {
+        for (j = 0; (j < prog->count) && PF_ALIVE(alias, i); j++)
+        {
+            if ( (i == j) || !PF_ALIVE(alias, j) )
+            {
+                continue;
+            }
+            a = &prog->filters[i];
+            b = &prog->filters[j];
+            states = b->bits & PF_BITS_ACTIVE;
+
+            if ( (i < j) && cylpa_pf_same(a, b) )
+            {
+                cylpa_pf_drop(prog, alias, j, i, CY_PF_OL_MAP_DUPLICATE);
+                changed = true;
+            }
+            else if ( ( (a->bits & states) != states ) || !cylpa_pf_covers(a, b) )
+            {
+                /* a is not active whenever b is, or misses some of b's packets */
+            }
+            else if ( ( (a->bits ^ b->bits) & CY_PF_ACTION_DISCARD ) == 0 )
+            {
+                cylpa_pf_drop(prog, alias, j, i, CY_PF_OL_MAP_SHADOWED);
+                changed = true;
+            }
+            else if ( ( (a->bits & CY_PF_ACTION_DISCARD) != 0 ) && cylpa_pf_keep_remains(prog, alias, j, states) )
+            {
+                /* b keeps packets a always drops */
+                cylpa_pf_drop(prog, alias, j, i, CY_PF_OL_MAP_SHADOWED);
+                changed = true;
+            }
+        }
+    }
+
+    for (i = 0; i < prog->count; i++)
+    {
+        for (j = i + 1; (j < prog->count) && PF_ALIVE(alias, i); j++)
+        {
+            if (!PF_ALIVE(alias, j) )
+            {
+                continue;
+            }
+            bit = cylpa_pf_one_bit(&prog->filters[i], &prog->filters[j]);
+            if (bit < 0)
+            {
+                continue;
+            }
+            a = &prog->filters[i];
+            a->mask[bit / 8] &= (uint8_t)~(1U << (bit % 8) );
+            a->pattern[bit / 8] &= (uint8_t)~(1U << (bit % 8) );
+            cylpa_pf_drop(prog, alias, j, i, CY_PF_OL_MAP_MERGED);
+            cylpa_pf_trim(a);
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_weight
+ ****************************************************************************//**
+ *
+ * Expected hit rate of a filter: the fewer bits it matches, the more packets.
+ *
+ ********************************************************************************/
+static uint32_t cylpa_pf_weight(const cy_pf_ol_filter_t *f)
+{
+    uint32_t bits = 0;
+    uint32_t i;
+    uint8_t m;
+
+    for (i = 0; i < f->len; i++)
+    {
+        for (m = f->mask[i]; m != 0; m &= (uint8_t)(m - 1) )
+        {
+            bits++;
+        }
+    }
+    return (CY_PF_OL_MAX_PATTERN_LEN * 8) - bits;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_finish
+ ****************************************************************************//**
+ *
+ * Name the implementing filter of each map entry by id, then keep only the
+ * filters still in the program, highest weight first.
+ *
+ ********************************************************************************/
+static void cylpa_pf_finish(cy_pf_ol_program_t *prog, uint8_t *alias)
+{
+    cy_pf_ol_filter_t tmp;
+    uint32_t i, j, n;
+
+    for (i = 0; i < prog->map_count; i++)
+    {
+        if (prog->map[i].kind != CY_PF_OL_MAP_INACTIVE)
+        {
+            prog->map[i].filter_id = prog->filters[prog->map[i].filter_id].id;
+        }
+    }
+
+    for (i = 0, n = 0; i < prog->count; i++)
+    {
+        if (PF_ALIVE(alias, i) )
+        {
+            if (n != i)
+            {
+                memcpy(&prog->filters[n], &prog->filters[i], sizeof(prog->filters[n]) );
+            }
+            prog->filters[n].weight = cylpa_pf_weight(&prog->filters[n]);
+            n++;
+        }
+    }
+    memset(&prog->filters[n], 0, (prog->count - n) * sizeof(prog->filters[0]) );
+    prog->count = (uint8_t)n;
+
+    /* Stable insertion sort; the programs are short */
+    for (i = 1; i < n; i++)
+    {
+        memcpy(&tmp, &prog->filters[i], sizeof(tmp) );
+        for (j = i; (j > 0) && (prog->filters[j - 1].weight < tmp.weight); j--)
+        {
+            memcpy(&prog->filters[j], &prog->filters[j - 1], sizeof(tmp) );
+        }
+        if (j != i)
+        {
+            memcpy(&prog->filters[j], &tmp, sizeof(tmp) );
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_compile
+ ****************************************************************************//**
+ *
+ * Compile a packet filter configuration into firmware filters.
+ *
+ * \param cfg
+ * Configuration, terminated by CY_PF_OL_FEAT_LAST.
+ *
+ * \param prog
+ * Compiled filters.
+ *
+ * \return
+ * RESULT_OK, RESULT_BADARGS, or RESULT_ERROR if some entries could not be
+ * implemented (prog->overflow)
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_compile(const cy_pf_ol_cfg_t *cfg, cy_pf_ol_program_t *prog)
+{
+    uint8_t alias[CY_PF_OL_MAX_FILTERS];
+    uint32_t used[256 / 32];
+    const cy_pf_ol_cfg_t *entry;
+    cy_pf_ol_map_t *map;
+    uint8_t count;
+    uint8_t map_count;
+
+    if ( (cfg == NULL) || (prog == NULL) )
+    {
+        return RESULT_BADARGS;
+    }
+    memset(prog, 0, sizeof(*prog) );
+
+    /* Allocated ids must not clash with any entry, active or not */
+    memset(used, 0, sizeof(used) );
+    for (entry = cfg; entry->feature != CY_PF_OL_FEAT_LAST; entry++)
+    {
+        used[entry->id / 32] |= (1UL << (entry->id % 32) );
+    }
+
+    for (entry = cfg; entry->feature != CY_PF_OL_FEAT_LAST; entry++)
+    {
+        if (prog->map_count == CY_PF_OL_MAX_MAP)
+        {
+            prog->overflow = true;
+            break;
+        }
+
+        /* Never enabled; it would only take a slot */
+        if ( (entry->bits & PF_BITS_ACTIVE) == 0 )
+        {
+            map = &prog->map[prog->map_count++];
+            map->cfg_id = entry->id;
+            map->filter_id = entry->id;
+            map->kind = CY_PF_OL_MAP_INACTIVE;
+            continue;
+        }
+
+        /* An entry is implemented whole or not at all */
+        count = prog->count;
+        map_count = prog->map_count;
+        if (!cylpa_pf_emit(prog, alias, entry, used) )
+        {
+            memset(&prog->filters[count], 0, (prog->count - count) * sizeof(prog->filters[0]) );
+            prog->count = count;
+            prog->map_count = map_count;
+            prog->overflow = true;
+        }
+    }
+
+    while (cylpa_pf_pass(prog, alias) )
+    {
+    }
+    cylpa_pf_finish(prog, alias);
+
+    return prog->overflow ? RESULT_ERROR : RESULT_OK;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_lookup
+ ****************************************************************************//**
+ *
+ * Find the firmware filters that implement a configuration entry.
+ *
+ * \param prog
+ * Compiled filters.
+ *
+ * \param cfg_id
+ * Id of the entry.
+ *
+ * \param filter_ids
+ * Filled in with up to max filter ids, may be NULL.
+ *
+ * \param max
+ * Entries in filter_ids.
+ *
+ * \return
+ * Number of filters implementing the entry
+ *
+ ********************************************************************************/
+uint32_t cylpa_pf_ol_lookup(const cy_pf_ol_program_t *prog, uint8_t cfg_id, uint8_t *filter_ids, uint32_t max)
+{
+    uint32_t count = 0;
+    uint32_t i;
+
+    if (prog == NULL)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < prog->map_count; i++)
+    {
+        if ( (prog->map[i].cfg_id != cfg_id) || (prog->map[i].kind == CY_PF_OL_MAP_INACTIVE) )
+        {
+            continue;
+        }
+        if ( (filter_ids != NULL) && (count < max) )
+        {
+            filter_ids[count] = prog->map[i].filter_id;
+        }
+        count++;
+    }
+    return count;
+}
+
+#ifdef __cplusplus
+}
+#endif
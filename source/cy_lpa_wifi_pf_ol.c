@@ -43,48 +43,119 @@
 
 #ifdef COMPONENT_LWIP
 #include "lwip/ip.h"
+#include "lwip/udp.h"
+#include "lwip/priv/tcp_priv.h"
+#endif
+#ifdef COMPONENT_NETXDUO
+#include "nx_api.h"
 #endif
 #include "whd_sdpcm.h"
 #include "whd_wifi_api.h"
 #include "whd_wlioctl.h"
 #include "whd_endian.h"
+#include "cyabs_rtos.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#define MAX_BITS_IN_PORTNUM 16  /* Portnum is 16 bits */
+/*******************************************************************************
+* Local definition
+*******************************************************************************/
+#define PF_ETHTYPE_IPV4             (0x0800)
+#define PF_ETHTYPE_IPV6             (0x86DD)
+#define PF_IP_PROTO_TCP             (6)
+#define PF_IP_PROTO_UDP             (17)
+
+/* Some filters may be added on top of the configured ones */
+#define PF_OL_EXTRAS                ( (CY_PF_OL_ADAPT != 0) || (CY_PF_OL_SOCK != 0) || (CY_PF_OL_PRESETS != 0) || \
+                                      (CY_PF_OL_RULES != 0) || (CY_PF_OL_POLICY != 0) )
 
 static ol_init_t cylpa_pf_ol_init;
 static ol_deinit_t cylpa_pf_ol_deinit;
 static ol_pm_t cylpa_pf_ol_pm;
+static ol_reconfig_t cylpa_pf_ol_reconfig;
+static olm_txn_cb_t cylpa_pf_ol_pm_done;
 
 const ol_fns_t pf_ol_fns =
 {
     .init = cylpa_pf_ol_init,
     .deinit = cylpa_pf_ol_deinit,
     .pm = cylpa_pf_ol_pm,
+    .flags = OL_FNS_F_TXN,
+    .reconfig = cylpa_pf_ol_reconfig,
 };
 
+/*
+ * Filters added on top of the configured ones change from the application and the OLM
+ * executor while the power-mode dispatch walks them. The mutex guards pf_ol_t::adapt,
+ * pf_ol_t::sock, pf_ol_t::presets, pf_ol_t::rules, pf_ol_t::policy and pf_ol_t::scratch, and
+ * is held whenever a spare id is picked so that no two filters get the same one; it is taken
+ * after the OLM registry lock.
+ */
+static cy_mutex_t cylpa_pf_ol_rules_mutex;
+static bool cylpa_pf_ol_rules_mutex_init = false;
+
 
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
 
-static int cylpa_create_portnum_range_mask(cy_pf_ol_cfg_t *pf_cfg, uint16_t *pattern, uint16_t *mask);
-static int cylpa_create_single_portnum_mask(cy_pf_ol_cfg_t *pf_cfg, uint16_t *pattern, uint16_t *mask);
-static int cylpa_create_port_filter(whd_t *whd, cy_pf_ol_cfg_t *pf_cfg, uint16_t pattern, uint16_t mask);
-static int cylpa_create_ethtype_filter(whd_t *whd, cy_pf_ol_cfg_t *pf_cfg);
-static int cylpa_create_ip_filter(whd_t *whd, cy_pf_ol_cfg_t *pf_cfg);
-
-static int cylpa_sign_extend(int val, unsigned width);
-static int cylpa_bitwidth(int val);
-static int cylpa_dump_filters_stats(whd_t *whd, cy_pf_ol_cfg_t *pf_cfg);
-#ifdef TESTING
-static void cylpa_run_pf_test(unsigned int pattern, unsigned int mask);
+static void cylpa_pf_ol_extras_remove(pf_ol_t *ctxt);
+static bool cylpa_pf_ol_cfg_fits(const cy_pf_ol_cfg_t *cfg);
+static void cylpa_pf_ol_compile_cfg(pf_ol_t *ctxt, const cy_pf_ol_cfg_t *cfg, cy_pf_ol_program_t *prog);
+static int cylpa_pf_ol_add_filter(pf_ol_t *ctxt, cy_pf_ol_filter_t *f);
+static void cylpa_pf_ol_remove_filter(pf_ol_t *ctxt, uint8_t id);
+static void cylpa_pf_ol_pm_filter(pf_ol_t *ctxt, struct olm_txn *txn, ol_pm_st_t st, cy_pf_ol_filter_t *f);
+
+static pf_ol_t *cylpa_pf_ol_find(olm_t *olm);
+static void cylpa_pf_ol_stats_reset(pf_ol_t *ctxt, uint32_t index);
+static int cylpa_pf_ol_snapshot(pf_ol_t *ctxt);
+static olm_exec_fn_t cylpa_pf_ol_stats_work;
+static void cylpa_dump_filters_stats(const pf_ol_t *ctxt);
+static void cylpa_pf_ol_stats_remap(pf_ol_t *ctxt, const cy_pf_ol_program_t *prev);
+static void cylpa_pf_ol_rules_lock(void);
+static void cylpa_pf_ol_rules_unlock(void);
+#if PF_OL_EXTRAS
+static bool cylpa_pf_ol_spare_id(const pf_ol_t *ctxt, uint8_t *id);
+#endif
+#if (CY_PF_OL_ADAPT != 0)
+static int cylpa_pf_ol_adapt_install(pf_ol_t *ctxt, cy_pf_ol_adapt_class_t *c, uint32_t now);
+static void cylpa_pf_ol_adapt_expire(pf_ol_t *ctxt, uint32_t now, bool all);
+static olm_exec_fn_t cylpa_pf_ol_adapt_work;
+#endif
+#if (CY_PF_OL_SOCK != 0)
+static bool cylpa_pf_ol_sock_port(const cy_pf_ol_sock_cfg_t *cfg, cy_pf_ol_class_t *cls, uint32_t *n, uint32_t max,
+                                  uint8_t ip_type, uint16_t port);
+static uint32_t cylpa_pf_ol_sock_ports(void *ip, const cy_pf_ol_sock_cfg_t *cfg, cy_pf_ol_class_t *cls,
+                                       uint32_t max, bool *overflow);
+static olm_txn_fn_t cylpa_pf_ol_sock_txn_add;
+static olm_txn_fn_t cylpa_pf_ol_sock_txn_remove;
+static olm_txn_fn_t cylpa_pf_ol_sock_txn_commit;
+static void cylpa_pf_ol_sock_clear(pf_ol_t *ctxt, struct olm_txn *txn);
+static void cylpa_pf_ol_sock_sleep(pf_ol_t *ctxt, struct olm_txn *txn);
+#endif
+#if (CY_PF_OL_PRESETS != 0)
+static void cylpa_pf_ol_preset_remove(pf_ol_t *ctxt, uint32_t index);
+static int cylpa_pf_ol_preset_install(pf_ol_t *ctxt, uint32_t index, uint32_t bits, uint32_t *slots);
+#endif
+#if (CY_PF_OL_RULES != 0)
+static cy_pf_ol_rule_t *cylpa_pf_ol_rule_find(pf_ol_t *ctxt, uint8_t id);
+static void cylpa_pf_ol_rule_uninstall(pf_ol_t *ctxt, uint32_t index);
+static int cylpa_pf_ol_rule_install(pf_ol_t *ctxt, uint32_t index);
+static int cylpa_pf_ol_rule_stage(pf_ol_t *ctxt, uint32_t index);
+#endif
+#if (CY_PF_OL_POLICY != 0)
+static void cylpa_pf_ol_policy_remove(pf_ol_t *ctxt);
+static int cylpa_pf_ol_policy_stage(pf_ol_t *ctxt, const cy_pf_ol_flow_t *flows, uint32_t count,
+                                    cy_pf_ol_policy_report_t *report);
+static void cylpa_pf_ol_policy_view_add(cylpa_pf_policy_view_t *view, const cy_pf_ol_filter_t *filters,
+                                        uint32_t count);
+static int cylpa_pf_ol_policy_check(pf_ol_t *ctxt, const cy_pf_ol_flow_t *flows, uint32_t count,
+                                    const cy_pf_ol_filter_t *filters, uint32_t filter_count, bool adapt,
+                                    cy_pf_ol_policy_report_t *report);
+static int cylpa_pf_ol_policy_install(pf_ol_t *ctxt);
 #endif
-
-static int cylpa_print_packet_filter_stats(whd_t *whd, uint8_t filter_id);
 #ifdef DEBUG
 static void cylpa_print_pat_and_mask(uint8_t id, int mask_len, uint8_t *mask, uint8_t *pat);
 #endif
@@ -112,74 +183,65 @@ static void cylpa_print_pat_and_mask(uint8_t id, int mask_len, uint8_t *mask, ui
 static int cylpa_pf_ol_init(void *ol, ol_info_t *info, const void *cfg)
 {
     pf_ol_t *ctxt = (pf_ol_t *)ol;
+
+    /* Work of a previous init may still be queued; the work takes the registry lock, so it
+     * cannot be waited for here */
+    cylpa_olm_exec_cancel(&ctxt->stats_work);
+#if (CY_PF_OL_ADAPT != 0)
+    cylpa_olm_exec_cancel(&ctxt->adapt_work);
+#endif
     memset(ctxt, 0, sizeof(pf_ol_t) );
 
+    /* Refused whole rather than matching IPv4 only */
+    if (!cylpa_pf_ol_cfg_fits( (const cy_pf_ol_cfg_t *)cfg) )
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: IPv6 port and address filters need CY_PF_OL_MAX_PATTERN_LEN %d\n",
+                  __func__, CY_PF_OL_IPV6_PATTERN_LEN);
+        return RESULT_BADARGS;
+    }
+
     ctxt->cfg  = (cy_pf_ol_cfg_t *)cfg;
     ctxt->whd  = info->whd;
+    ctxt->ol_info_ptr = info;
+    cylpa_olm_exec_item_init(&ctxt->stats_work, cylpa_pf_ol_stats_work, ctxt, OLM_EXEC_PRIO_LOW);
+#if (CY_PF_OL_ADAPT != 0)
+    cylpa_olm_exec_item_init(&ctxt->adapt_work, cylpa_pf_ol_adapt_work, ctxt, OLM_EXEC_PRIO_LOW);
+#endif
+    if (!cylpa_pf_ol_rules_mutex_init)
+    {
+        cylpa_pf_ol_rules_mutex_init = (cy_rtos_init_mutex(&cylpa_pf_ol_rules_mutex) == CY_RSLT_SUCCESS);
+    }
 
-    cy_pf_ol_cfg_t *pf_cfg;
+    cy_pf_ol_filter_t *f;
 
-    for (pf_cfg = ctxt->cfg; pf_cfg->feature != CY_PF_OL_FEAT_LAST; pf_cfg++)
+    cylpa_pf_ol_compile_cfg(ctxt, ctxt->cfg, &ctxt->prog);
+
+    for (f = ctxt->prog.filters; f < &ctxt->prog.filters[ctxt->prog.count]; f++)
     {
-        switch (pf_cfg->feature)
-        {
-            case CY_PF_OL_FEAT_PORTNUM:
-            {
-                uint16_t pattern;
-                uint16_t mask;
-                if ( (!IS_POWER(pf_cfg->u.pf.portnum.portnum) ) || (!IS_POWER( (pf_cfg->u.pf.portnum.range + 1) ) ) ||
-                     (pf_cfg->u.pf.portnum.range == 0) )
-                {
-                    cylpa_create_single_portnum_mask(pf_cfg, &pattern, &mask);
-                    OL_LOG_PF(LOG_OLA_LVL_DEBUG, "Creating Single Port filter ID: %d Port: %d ",
-                              pf_cfg->id, pf_cfg->u.pf.portnum.portnum);
-                }
-                else
-                {
-                    cylpa_create_portnum_range_mask(pf_cfg, &pattern, &mask);
-                    OL_LOG_PF(LOG_OLA_LVL_DEBUG, "Creating Port Range filter ID: %d, Range %d - %d ", pf_cfg->id,
-                              pf_cfg->u.pf.portnum.portnum, pf_cfg->u.pf.portnum.portnum + pf_cfg->u.pf.portnum.range);
-                }
-                cylpa_create_port_filter(ctxt->whd, pf_cfg, pattern, mask);
-#ifdef TESTING
-                cylpa_run_pf_test(pattern, mask);
-#endif
-                break;
-            }
-            case CY_PF_OL_FEAT_ETHTYPE:
-                cylpa_create_ethtype_filter(ctxt->whd, pf_cfg);
-                break;
-            case CY_PF_OL_FEAT_IPTYPE:
-                cylpa_create_ip_filter(ctxt->whd, pf_cfg);
-                break;
-            case CY_PF_OL_FEAT_LAST:
-                /* Satisfy compiler, never executed */
-                break;
-            default:
-                OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: Unknown Packet Filter feature: %d\n", __func__, pf_cfg->feature);
-                break;
-        }
+        cylpa_pf_ol_add_filter(ctxt, f);
+        cylpa_pf_ol_stats_reset(ctxt, f - ctxt->prog.filters);
     }
 
     /*
      * Enable any wake filters
      */
-    for (pf_cfg = ctxt->cfg; pf_cfg->feature != CY_PF_OL_FEAT_LAST; pf_cfg++)
+    for (f = ctxt->prog.filters; f < &ctxt->prog.filters[ctxt->prog.count]; f++)
     {
-        if (pf_cfg->bits & CY_PF_ACTIVE_WAKE)
+        if (f->bits & CY_PF_ACTIVE_WAKE)
         {
-            if (whd_pf_enable_packet_filter(ctxt->whd, pf_cfg->id) != WHD_SUCCESS)
+            if (cylpa_olm_txn_pf_enable(NULL, ctxt->whd, f->id, true, NULL, NULL) != RESULT_OK)
             {
-                OL_LOG_PF(LOG_OLA_LVL_ERR, "FAILED to enable id %d\n", pf_cfg->id);
+                OL_LOG_PF(LOG_OLA_LVL_ERR, "FAILED to enable id %d\n", f->id);
             }
             else
             {
-                OL_LOG_PF(LOG_OLA_LVL_INFO, "Activating id %d for WAKE operation\n", pf_cfg->id);
+                OL_LOG_PF(LOG_OLA_LVL_INFO, "Activating id %d for WAKE operation\n", f->id);
             }
         }
     }
 
-    cylpa_dump_filters_stats(ctxt->whd, ctxt->cfg);
+    cylpa_pf_ol_snapshot(ctxt);
+    cylpa_dump_filters_stats(ctxt);
 
     return RESULT_OK;
 }
@@ -197,525 +259,2966 @@ static int cylpa_pf_ol_init(void *ol, ol_info_t *info, const void *cfg)
 static void cylpa_pf_ol_deinit(void *ol)
 {
     pf_ol_t *ctxt = (pf_ol_t *)ol;
-    cy_pf_ol_cfg_t *pf_cfg;
+    cy_pf_ol_filter_t *f;
 
     if ((ctxt == NULL) || (ctxt->cfg == NULL) || (ctxt->whd == NULL))
     {
         return;
     }
 
-    for (pf_cfg = ctxt->cfg; pf_cfg->feature != CY_PF_OL_FEAT_LAST; pf_cfg++)
+    cylpa_olm_exec_cancel(&ctxt->stats_work);
+#if (CY_PF_OL_ADAPT != 0)
+    cylpa_olm_exec_cancel(&ctxt->adapt_work);
+#endif
+    cylpa_pf_ol_rules_lock();
+    cylpa_pf_ol_extras_remove(ctxt);
+#if (CY_PF_OL_RULES != 0)
+    memset(&ctxt->rules, 0, sizeof(ctxt->rules) );
+#endif
+#if (CY_PF_OL_POLICY != 0)
+    memset(&ctxt->policy, 0, sizeof(ctxt->policy) );
+#endif
+    cylpa_pf_ol_rules_unlock();
+    for (f = ctxt->prog.filters; f < &ctxt->prog.filters[ctxt->prog.count]; f++)
     {
-        OL_LOG_PF(LOG_OLA_LVL_INFO, "Removing filter %d\n", pf_cfg->id);
-        whd_result_t res = whd_pf_remove_packet_filter(ctxt->whd, pf_cfg->id);
-        if (res != WHD_SUCCESS)
-        {
-            OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: Unable to remove filter %d, result = %d\n", __func__, pf_cfg->id, res);
-        }
+        cylpa_pf_ol_remove_filter(ctxt, f->id);
     }
+    ctxt->prog.count = 0;
 }
 
 /*******************************************************************************
- * Function Name: cylpa_pf_ol_pm
+ * Function Name: cylpa_pf_ol_extras_remove
  ****************************************************************************//**
  *
- * Remove all filters. No need to disable prior to removal.
- *
- * \param ol
- * The pointer to the ol structure.
+ * Remove the filters added on top of the configured ones. The presets, rules
+ * and sleep policy are kept, to be installed again. Called with the rules
+ * mutex held.
  *
- * \param st
- * see \ref ol_pm_st_t.
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
  *
  ********************************************************************************/
-static void cylpa_pf_ol_pm(void *ol, ol_pm_st_t st)
+static void cylpa_pf_ol_extras_remove(pf_ol_t *ctxt)
 {
-    pf_ol_t *ctxt = (pf_ol_t *)ol;
-    cy_pf_ol_cfg_t *pf_cfg;
+#if (CY_PF_OL_PRESETS != 0) || (CY_PF_OL_RULES != 0)
+    uint32_t i;
+#endif
 
-    if ((ctxt == NULL) || (ctxt->cfg == NULL) || (ctxt->whd == NULL))
+#if (CY_PF_OL_ADAPT != 0)
+    cylpa_pf_ol_adapt_expire(ctxt, 0, true);
+#endif
+#if (CY_PF_OL_SOCK != 0)
+    cylpa_pf_ol_sock_clear(ctxt, NULL);
+#endif
+#if (CY_PF_OL_PRESETS != 0)
+    for (i = 0; i < CY_PF_OL_MAX_PRESETS; i++)
     {
-        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s : Bad Args!\n", __func__);
-        return;
+        cylpa_pf_ol_preset_remove(ctxt, i);
     }
-    switch (st)
+#endif
+#if (CY_PF_OL_RULES != 0)
+    for (i = 0; i < CY_PF_OL_MAX_RULES; i++)
     {
-        case OL_PM_ST_GOING_TO_SLEEP:
-            OL_LOG_PF(LOG_OLA_LVL_DEBUG, "%s: Entering sleep\n", __func__);
-            break;
-        case OL_PM_ST_AWAKE:
-            OL_LOG_PF(LOG_OLA_LVL_DEBUG, "%s: Entering wake\n", __func__);
-            break;
-        default:
-            OL_LOG_PF(LOG_OLA_LVL_DEBUG, "%s: Unknown state change\n", __func__);
-            break;
+        cylpa_pf_ol_rule_uninstall(ctxt, i);
     }
+#endif
+#if (CY_PF_OL_POLICY != 0)
+    cylpa_pf_ol_policy_remove(ctxt);
+#endif
+    (void)ctxt;
+}
 
-    for (pf_cfg = ctxt->cfg; pf_cfg->feature != CY_PF_OL_FEAT_LAST; pf_cfg++)
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_cfg_fits
+ ****************************************************************************//**
+ *
+ * Check that the filters of every IP family a configuration names fit in
+ * CY_PF_OL_MAX_PATTERN_LEN. Other entries that do not fit are left out when
+ * it is compiled.
+ *
+ * \param cfg
+ * The configuration, terminated by CY_PF_OL_FEAT_LAST.
+ *
+ * \return
+ * false if it has an IPv6 port or address entry and the pattern is too short
+ *
+ ********************************************************************************/
+static bool cylpa_pf_ol_cfg_fits(const cy_pf_ol_cfg_t *cfg)
+{
+#if (CY_PF_OL_MAX_PATTERN_LEN < CY_PF_OL_IPV6_PATTERN_LEN)
+    for ( ; (cfg != NULL) && (cfg->feature != CY_PF_OL_FEAT_LAST); cfg++)
     {
-        /* If always active, then nothing to do. */
-        if ( (pf_cfg->bits & (CY_PF_ACTIVE_SLEEP | CY_PF_ACTIVE_WAKE) ) == (CY_PF_ACTIVE_SLEEP | CY_PF_ACTIVE_WAKE) )
+        if ( ( (cfg->feature == CY_PF_OL_FEAT_PORTNUM) || (cfg->feature == CY_PF_OL_FEAT_IPADDR) ) &&
+             ( (cfg->bits & (CY_PF_IPV6 | CY_PF_IPV4_IPV6) ) != 0 ) )
         {
-            OL_LOG_PF(LOG_OLA_LVL_INFO, "%s: Filter %d is always on, nothing to do\n", __func__, pf_cfg->id);
+            return false;
         }
-        else
-        {
-            switch (st)
-            {
-                case OL_PM_ST_GOING_TO_SLEEP:
-                    if (pf_cfg->bits & CY_PF_ACTIVE_SLEEP)
-                    {
-                        OL_LOG_PF(LOG_OLA_LVL_DEBUG, "%s: Enabling sleep filter %d\n", __func__, pf_cfg->id);
-                        if (whd_pf_enable_packet_filter(ctxt->whd, pf_cfg->id) != WHD_SUCCESS)
-                        {
-                            OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: whd_pf_enable_packet_filter %d FAILED\n", __func__,
-                                      pf_cfg->id);
-                        }
-                    }
-                    else
-                    {
-                        OL_LOG_PF(LOG_OLA_LVL_DEBUG, "%s: Disabling wake filter %d\n", __func__, pf_cfg->id);
-                        if (whd_pf_disable_packet_filter(ctxt->whd, pf_cfg->id) != WHD_SUCCESS)
-                        {
-                            OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: whd_pf_disable_packet_filter %d FAILED\n", __func__,
-                                      pf_cfg->id);
-                        }
-                    }
-                    break;
-                case OL_PM_ST_AWAKE:
-                    if (pf_cfg->bits & CY_PF_ACTIVE_WAKE)
-                    {
-                        OL_LOG_PF(LOG_OLA_LVL_DEBUG, "%s: Enabling wake filter %d\n", __func__, pf_cfg->id);
-                        if (whd_pf_enable_packet_filter(ctxt->whd, pf_cfg->id) != WHD_SUCCESS)
-                        {
-                            OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: whd_pf_enable_packet_filter %d FAILED\n", __func__,
-                                      pf_cfg->id);
-                        }
-                    }
-                    else
-                    {
-                        OL_LOG_PF(LOG_OLA_LVL_DEBUG, "%s: Disabling sleep filter %d\n", __func__, pf_cfg->id);
-                        if (whd_pf_disable_packet_filter(ctxt->whd, pf_cfg->id) != WHD_SUCCESS)
-                        {
-                            OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: whd_pf_disable_packet_filter %d FAILED\n", __func__,
-                                      pf_cfg->id);
-                        }
-                    }
-                    break;
-                default:
-                    OL_LOG_PF(LOG_OLA_LVL_ERR, "Unknown PM state! %d\n", st);
-                    break;
-            }
-        }  /* if !(SLEEP && WAKE) */
-    }  /* for each configuration */
+    }
+#else
+    (void)cfg;
+#endif
+    return true;
 }
 
-/* The number of bytes between the start of the 'EtherType' of the ethernet
- * header, and the end of the 'Destination port' of the UDP header is 26 (PORT_FILTER_LEN). */
-
-/* The 'EtherType' field is 12 bytes from the start of the ethernet header. */
-#define ETHTYPE_OFFSET 12
-
-static uint8_t cylpa_glob_pat_buf[32];
-static uint8_t cylpa_glob_mask_buf[32];
-
 /*******************************************************************************
- * Function Name: common_filter_attrs
+ * Function Name: cylpa_pf_ol_compile_cfg
  ****************************************************************************//**
- * Handle common attributes of all filters
- * \param pf_cfg
- * The pointer to the cy_pf_ol_cfg_t structure \ref cy_pf_ol_cfg_t.
- * \param filter
- * Pointer to actual filter
- * \return
- * Returns the execution result
+ *
+ * Compile a configuration and log how each entry is implemented. Entries that
+ * do not fit are logged and left out; the others are still programmed. Warns
+ * when the filters, port ranges and IP families included, outnumber the
+ * firmware slots, or CY_PF_OL_MAX_FILTERS until the slot count is known.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param cfg
+ * The configuration, terminated by CY_PF_OL_FEAT_LAST.
+ *
+ * \param prog
+ * The compiled filters.
+ *
  ********************************************************************************/
-static void common_filter_attrs(cy_pf_ol_cfg_t *pf_cfg, whd_packet_filter_t *filter)
+static void cylpa_pf_ol_compile_cfg(pf_ol_t *ctxt, const cy_pf_ol_cfg_t *cfg, cy_pf_ol_program_t *prog)
 {
-    if ( (pf_cfg->bits & (CY_PF_ACTIVE_WAKE | CY_PF_ACTIVE_SLEEP) ) == 0 )
+    const ol_caps_t *caps = (ctxt->ol_info_ptr != NULL) ? &ctxt->ol_info_ptr->caps : NULL;
+    uint32_t budget = CY_PF_OL_MAX_FILTERS;
+
+    if (cylpa_pf_ol_compile(cfg, prog) != RESULT_OK)
     {
-        OL_LOG_PF(LOG_OLA_LVL_DEBUG, "ID %d: Neither Sleep nor Wake specified...will not be enabled\n", pf_cfg->id);
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: some filters do not fit or have an unknown feature\n", __func__);
     }
-    else
+
+#ifdef OLM_LOG_ENABLED
+    static const char *const kinds[] = { "emitted", "merged", "duplicate", "shadowed", "inactive" };
+    const cy_pf_ol_map_t *map;
+
+    for (map = prog->map; map < &prog->map[prog->map_count]; map++)
     {
-        OL_LOG_PF(LOG_OLA_LVL_DEBUG, " %s%s",
-                  pf_cfg->bits & CY_PF_ACTIVE_WAKE ? "Wake" : "",
-                  pf_cfg->bits & CY_PF_ACTIVE_SLEEP ? "Sleep" : "");
-        OL_LOG_PF(LOG_OLA_LVL_DEBUG, ", ");
+        OL_LOG_PF(LOG_OLA_LVL_DEBUG, "%s: id %d -> filter %d (%s)\n", __func__, map->cfg_id, map->filter_id,
+                  (map->kind < (sizeof(kinds) / sizeof(kinds[0]) ) ) ? kinds[map->kind] : "?");
     }
+#endif
+    OL_LOG_PF(LOG_OLA_LVL_INFO, "%s: %u entries in %u filters (%u duplicate, %u shadowed, %u merged, %u split)\n",
+              __func__, prog->map_count, prog->count, prog->duplicates, prog->shadowed, prog->merged, prog->split);
 
-    if (pf_cfg->bits & CY_PF_ACTION_DISCARD)
+    /* The slot count is only known once the firmware refused an add; until then the
+     * split is checked against what the program holds.
+     */
+    if ( (caps != NULL) && caps->valid && (caps->slots_max[OL_CAPS_SLOT_PF] != OL_CAPS_SLOTS_UNKNOWN) &&
+         (caps->slots_max[OL_CAPS_SLOT_PF] < budget) )
     {
-        filter->rule = WHD_PACKET_FILTER_RULE_NEGATIVE_MATCHING;
-        OL_LOG_PF(LOG_OLA_LVL_DEBUG, "Discard\n");
+        budget = caps->slots_max[OL_CAPS_SLOT_PF];
     }
-    else
+    if (prog->overflow || (prog->count > budget) )
     {
-        filter->rule = WHD_PACKET_FILTER_RULE_POSITIVE_MATCHING;
-        OL_LOG_PF(LOG_OLA_LVL_DEBUG, "Keep\n");
+        OL_LOG_PF(LOG_OLA_LVL_WARNING, "%s: %u filters (%u split from ranges and families)%s but %lu fit\n",
+                  __func__, prog->count, prog->split, prog->overflow ? " and more left out" : "",
+                  (unsigned long)budget);
     }
 }
 
 /*******************************************************************************
- * Function Name: cylpa_create_ip_filter
+ * Function Name: cylpa_pf_ol_find_id
  ****************************************************************************//**
  *
- * Remove all filters. No need to disable prior to removal.
+ * Find the filter with an id in a compiled program.
  *
- * \param whd
- * The pointer to the whd interface.
+ * \param prog
+ * The compiled filters.
  *
- * \param pf_cfg
- * The pointer to the cy_pf_ol_cfg_t structure \ref cy_pf_ol_cfg_t.
+ * \param id
+ * The filter id.
  *
  * \return
- * Returns the execution result
+ * The filter, or NULL if prog has none with that id
  *
  ********************************************************************************/
-static int cylpa_create_ip_filter(whd_t *whd, cy_pf_ol_cfg_t *pf_cfg)
+static cy_pf_ol_filter_t *cylpa_pf_ol_find_id(cy_pf_ol_program_t *prog, uint8_t id)
 {
-    whd_packet_filter_t filter;
-
-    struct ether_header ether_hdr_mask;
-    struct ether_header ether_hdr_pattern;
-    struct ipv4_hdr ip_hdr_mask;
-    struct ipv4_hdr ip_hdr_pattern;
-
-    uint8_t *pat_ptr = cylpa_glob_pat_buf;
-    uint8_t *mask_ptr = cylpa_glob_mask_buf;
-
-    memset(&ether_hdr_pattern, 0, sizeof(ether_hdr_pattern) );
-    memset(&ether_hdr_mask, 0, sizeof(ether_hdr_mask) );
-    memset(&ip_hdr_pattern, 0, sizeof(ip_hdr_pattern) );
-    memset(&ip_hdr_mask, 0, sizeof(ip_hdr_mask) );
-
-    ether_hdr_pattern.ether_type = hton16(ETHER_TYPE_IP);
-    ether_hdr_mask.ether_type = hton16(0xffff);
-
-    ip_hdr_mask.prot = 0xff;
-    ip_hdr_pattern.prot = pf_cfg->u.ip.ip_type;
-
-    filter.id = pf_cfg->id;
-    filter.offset = ETHTYPE_OFFSET;
-    filter.mask = (uint8_t *)cylpa_glob_mask_buf;
-    filter.pattern = (uint8_t *)cylpa_glob_pat_buf;
-    filter.mask_size = ETHER_TYPE_LEN + sizeof(ip_hdr_pattern);
-
-    memcpy(mask_ptr, &ether_hdr_mask.ether_type, ETHER_TYPE_LEN);
-    memcpy(mask_ptr + ETHER_TYPE_LEN, &ip_hdr_mask, sizeof(ip_hdr_mask) );
+    cy_pf_ol_filter_t *f;
 
-    memcpy(pat_ptr, &ether_hdr_pattern.ether_type, ETHER_TYPE_LEN);
-    memcpy(pat_ptr + ETHER_TYPE_LEN, &ip_hdr_pattern, sizeof(ip_hdr_pattern) );
-
-    OL_LOG_PF(LOG_OLA_LVL_DEBUG, "Creating IP filter %d: ", pf_cfg->id);
-    common_filter_attrs(pf_cfg, &filter);
-
-    if (whd_pf_add_packet_filter(whd, &filter) != WHD_SUCCESS)
+    for (f = prog->filters; f < &prog->filters[prog->count]; f++)
     {
-        OL_LOG_PF(LOG_OLA_LVL_ERR, "Add filter %ld Failed\n", filter.id);
+        if (f->id == id)
+        {
+            return f;
+        }
     }
-    return 0;
+    return NULL;
 }
 
 /*******************************************************************************
- * Function Name: cylpa_create_ethtype_filter
+ * Function Name: cylpa_pf_ol_same_filter
  ****************************************************************************//**
  *
- * Remove all filters. No need to disable prior to removal.
+ * Whether two filters install the same pattern in the firmware. When the
+ * sleep/wake activity differs, only the enable state has to change.
  *
- * \param whd
- * The pointer to the whd interface.
+ * \param a
+ * A filter.
+ *
+ * \param b
+ * Another filter.
+ *
+ * \return
+ * true if the installed filter can be kept
+ *
+ ********************************************************************************/
+static bool cylpa_pf_ol_same_filter(const cy_pf_ol_filter_t *a, const cy_pf_ol_filter_t *b)
+{
+    return (a->id == b->id) && ( (a->bits & CY_PF_ACTION_DISCARD) == (b->bits & CY_PF_ACTION_DISCARD) ) &&
+           (a->offset == b->offset) && (a->len == b->len) &&
+           (memcmp(a->mask, b->mask, a->len) == 0) && (memcmp(a->pattern, b->pattern, a->len) == 0);
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_reconfig
+ ****************************************************************************//**
+ *
+ * Move the firmware from the filters in use to those compiled from cfg. Only
+ * the filters whose id is gone or whose pattern changed are removed, only the
+ * new or changed ones are added, and a filter that only changed its wake
+ * activity is just enabled or disabled. The host is awake, so the wake filters
+ * are the enabled ones.
+ *
+ * \param ol
+ * The pointer to the ol structure.
  *
- * \param pf_cfg
- * The pointer to the cy_pf_ol_cfg_t structure \ref cy_pf_ol_cfg_t.
+ * \param cfg
+ * The pointer to the new configuration.
  *
  * \return
  * Returns the execution result
  *
  ********************************************************************************/
-static int cylpa_create_ethtype_filter(whd_t *whd, cy_pf_ol_cfg_t *pf_cfg)
+static int cylpa_pf_ol_reconfig(void *ol, const void *cfg)
 {
-    whd_packet_filter_t filter;
+    pf_ol_t *ctxt = (pf_ol_t *)ol;
+    cy_pf_ol_cfg_t *new_cfg = (cy_pf_ol_cfg_t *)cfg;
+    cy_pf_ol_program_t *prev = &ctxt->scratch;
+    cy_pf_ol_filter_t *f;
+    cy_pf_ol_filter_t *old;
+#if (CY_PF_OL_PRESETS != 0) || (CY_PF_OL_RULES != 0)
+    uint32_t i;
+#endif
+    bool wake;
+
+    if ( (ctxt == NULL) || (ctxt->cfg == NULL) || (ctxt->whd == NULL) || (new_cfg == NULL) ||
+         !cylpa_pf_ol_cfg_fits(new_cfg) )
+    {
+        return RESULT_BADARGS;
+    }
 
-    struct ether_header ether_hdr_mask;
-    struct ether_header ether_hdr_pattern;
+    /* Adaptive, socket, preset and rule filters may take ids of the new program; they are rebuilt */
+    cylpa_pf_ol_rules_lock();
+    cylpa_pf_ol_extras_remove(ctxt);
 
-    uint8_t *pat_ptr = cylpa_glob_pat_buf;
-    uint8_t *mask_ptr = cylpa_glob_mask_buf;
+    /* The new program goes in place; the enable completions point into it */
+    memcpy(prev, &ctxt->prog, sizeof(*prev) );
+    cylpa_pf_ol_compile_cfg(ctxt, new_cfg, &ctxt->prog);
+    cylpa_pf_ol_stats_remap(ctxt, prev);
 
-    uint16_t eth = pf_cfg->u.eth.eth_type;
+    for (f = prev->filters; f < &prev->filters[prev->count]; f++)
+    {
+        old = cylpa_pf_ol_find_id(&ctxt->prog, f->id);
+        if ( (old == NULL) || !cylpa_pf_ol_same_filter(f, old) )
+        {
+            cylpa_pf_ol_remove_filter(ctxt, f->id);
+        }
+    }
 
-    memset(&ether_hdr_pattern, 0, sizeof(ether_hdr_pattern) );
-    memset(&ether_hdr_mask, 0, sizeof(ether_hdr_mask) );
+    for (f = ctxt->prog.filters; f < &ctxt->prog.filters[ctxt->prog.count]; f++)
+    {
+        old = cylpa_pf_ol_find_id(prev, f->id);
+        wake = ( (f->bits & CY_PF_ACTIVE_WAKE) != 0 );
 
-    ether_hdr_pattern.ether_type = hton16(eth);
-    ether_hdr_mask.ether_type = hton16(0xffff);
+        /* The firmware counters of a kept filter run on */
+        if ( (old != NULL) && cylpa_pf_ol_same_filter(f, old) )
+        {
+            ctxt->stats[f - ctxt->prog.filters].bits = f->bits;
+        }
+        else
+        {
+            cylpa_pf_ol_stats_reset(ctxt, f - ctxt->prog.filters);
+        }
 
-    filter.id = pf_cfg->id;
-    filter.offset = ETHTYPE_OFFSET;
-    filter.mask = (uint8_t *)cylpa_glob_mask_buf;
-    filter.pattern = (uint8_t *)cylpa_glob_pat_buf;
-    filter.mask_size = ETHER_TYPE_LEN;
+        if ( (old == NULL) || !cylpa_pf_ol_same_filter(f, old) )
+        {
+            /* Added disabled */
+            cylpa_pf_ol_add_filter(ctxt, f);
+            if (!wake)
+            {
+                continue;
+            }
+        }
+        else if ( ( (old->bits ^ f->bits) & CY_PF_ACTIVE_WAKE ) == 0 )
+        {
+            continue;
+        }
 
-    OL_LOG_PF(LOG_OLA_LVL_DEBUG, "Creating EtherType filter: ID %d", pf_cfg->id);
-    common_filter_attrs(pf_cfg, &filter);
+        OL_LOG_PF(LOG_OLA_LVL_INFO, "%s id %d for WAKE operation\n", wake ? "Activating" : "Deactivating", f->id);
+        cylpa_olm_txn_pf_enable(NULL, ctxt->whd, f->id, wake, cylpa_pf_ol_pm_done, f);
+    }
 
-    memcpy(mask_ptr, &ether_hdr_mask.ether_type, ETHER_TYPE_LEN);
-    memcpy(pat_ptr, &ether_hdr_pattern.ether_type, ETHER_TYPE_LEN);
+    ctxt->cfg = new_cfg;
 
-    if (whd_pf_add_packet_filter(whd, &filter) != WHD_SUCCESS)
+    /* Once the ids of the new configuration are known */
+#if (CY_PF_OL_PRESETS != 0)
+    for (i = 0; i < CY_PF_OL_MAX_PRESETS; i++)
     {
-        OL_LOG_PF(LOG_OLA_LVL_ERR, "Add filter %ld Failed\n", filter.id);
+        if ( (ctxt->presets.bits[i] != 0) &&
+             (cylpa_pf_ol_preset_install(ctxt, i, ctxt->presets.bits[i], NULL) != RESULT_OK) )
+        {
+            OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: preset %lu dropped\n", __func__, (unsigned long)i);
+            ctxt->presets.bits[i] = 0;
+        }
     }
-    return 0;
+#endif
+#if (CY_PF_OL_RULES != 0)
+    for (i = 0; i < CY_PF_OL_MAX_RULES; i++)
+    {
+        if (ctxt->rules.rules[i].in_use && (cylpa_pf_ol_rule_stage(ctxt, i) != RESULT_OK) )
+        {
+            OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: rule %d retried at the next transition\n", __func__,
+                      ctxt->rules.rules[i].cfg.id);
+        }
+    }
+#endif
+
+#if (CY_PF_OL_POLICY != 0)
+    /* The new configuration may discard an allowed flow or keep more */
+    if (ctxt->policy.flow_count != 0)
+    {
+        cy_pf_ol_policy_report_t report;
+
+        if ( (cylpa_pf_ol_policy_stage(ctxt, ctxt->policy.flows, ctxt->policy.flow_count, &report) != RESULT_OK) ||
+             (cylpa_pf_ol_policy_install(ctxt) != RESULT_OK) )
+        {
+            OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: sleep policy dropped\n", __func__);
+            ctxt->policy.flow_count = 0;
+        }
+        else
+        {
+            cylpa_pf_ol_policy_check(ctxt, ctxt->policy.flows, ctxt->policy.flow_count, ctxt->policy.filters,
+                                     ctxt->policy.count, true, &report);
+        }
+        ctxt->policy.staged_count = 0;
+    }
+#endif
+    cylpa_pf_ol_rules_unlock();
+    return RESULT_OK;
 }
 
 /*******************************************************************************
- * Function Name: cylpa_create_port_filter
+ * Function Name: cylpa_pf_ol_pm
  ****************************************************************************//**
  *
  * Remove all filters. No need to disable prior to removal.
  *
- * \param whd
- * The pointer to the whd interface.
- *
- * \param pf_cfg
- * The pointer to the cy_pf_ol_cfg_t structure \ref cy_pf_ol_cfg_t.
- *
- * \param pattern
+ * \param ol
  * The pointer to the ol structure.
  *
- * \param mask
- * The pointer to the ol_info_t structure.
- *
- * \return
- * Returns the execution result
+ * \param st
+ * see \ref ol_pm_st_t.
  *
  ********************************************************************************/
-static int cylpa_create_port_filter(whd_t *whd, cy_pf_ol_cfg_t *pf_cfg, uint16_t pattern, uint16_t mask)
+static void cylpa_pf_ol_pm(void *ol, ol_pm_st_t st)
 {
-    whd_packet_filter_t filter;
-    struct ether_header ether_hdr_mask;
-    struct ether_header ether_hdr_pattern;
-    struct bcmudp_hdr udp_hdr_mask;
-    struct bcmudp_hdr udp_hdr_pattern;
-    struct ipv4_hdr ip_hdr_mask;
-    struct ipv4_hdr ip_hdr_pattern;
-    uint8_t *pat_ptr = cylpa_glob_pat_buf;
-    uint8_t *mask_ptr = cylpa_glob_mask_buf;
-
-    /* Configure pattern to match against received packets. */
-    memset(&ether_hdr_pattern, 0, sizeof(ether_hdr_pattern) );
-    memset(&udp_hdr_pattern, 0, sizeof(udp_hdr_pattern) );
-    memset(&ip_hdr_pattern, 0, sizeof(ip_hdr_pattern) );
-
-    /* Configure bitmask that indicates which bits of received packets to match * against specified pattern. */
-    memset(&ether_hdr_mask, 0, sizeof(ether_hdr_mask) );
-    memset(&udp_hdr_mask, 0, sizeof(udp_hdr_mask) );
-    memset(&ip_hdr_mask, 0, sizeof(ip_hdr_mask) );
-
-    /* Ethernet header. Validate that 'EtherType' is IP. */
-    ether_hdr_pattern.ether_type = hton16(ETHER_TYPE_IP);
-    ether_hdr_mask.ether_type = hton16(0xffff);
-
-    /* IP header. Validate that 'Protocol' is UDP. */
-    ip_hdr_mask.prot = 0xff;
-    ip_hdr_pattern.prot = pf_cfg->u.pf.proto;
-
-    switch (pf_cfg->u.pf.proto)
-    {
-        case CY_PF_PROTOCOL_UDP:
-            ip_hdr_pattern.prot = CYLPA_IP_PROTO_UDP;
+    pf_ol_t *ctxt = (pf_ol_t *)ol;
+    cy_pf_ol_filter_t *f;
+#if (CY_PF_OL_RULES != 0)
+    cy_pf_ol_rule_t *r;
+    uint32_t active;
+#endif
+    struct olm_txn *txn;
+
+    if ((ctxt == NULL) || (ctxt->cfg == NULL) || (ctxt->whd == NULL))
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s : Bad Args!\n", __func__);
+        return;
+    }
+    cylpa_pf_ol_rules_lock();
+    switch (st)
+    {
+        case OL_PM_ST_GOING_TO_SLEEP:
+            OL_LOG_PF(LOG_OLA_LVL_DEBUG, "%s: Entering sleep\n", __func__);
             break;
-        case CY_PF_PROTOCOL_TCP:
-            ip_hdr_pattern.prot = CYLPA_IP_PROTO_TCP;
+        case OL_PM_ST_AWAKE:
+            OL_LOG_PF(LOG_OLA_LVL_DEBUG, "%s: Entering wake\n", __func__);
+            if (ctxt->stats_on_wake)
+            {
+                cylpa_olm_exec_submit(&ctxt->stats_work, 0);
+            }
+#if (CY_PF_OL_ADAPT != 0)
+            if (ctxt->adapt.on)
+            {
+                /* Frames of the window are charged to this wake; the filters are updated after it */
+                cy_time_t woke = 0;
+                cy_rtos_get_time(&woke);
+                ctxt->adapt.wake_ms = (uint32_t)woke;
+                ctxt->adapt.wake++;
+                cylpa_olm_exec_submit(&ctxt->adapt_work, ctxt->adapt.cfg.window_ms);
+            }
+#endif
             break;
         default:
-            ip_hdr_pattern.prot = CYLPA_IP_PROTO_TCP;
-            break;
+            OL_LOG_PF(LOG_OLA_LVL_ERR, "Unknown PM state! %d\n", st);
+            cylpa_pf_ol_rules_unlock();
+            return;
     }
 
-    /* Set port number pattern and mask */
-    if (pf_cfg->u.pf.portnum.direction == PF_PN_PORT_SOURCE)
+    /* Queued on the OLM transaction when called from the dispatcher */
+    txn = (ctxt->ol_info_ptr != NULL) ? ctxt->ol_info_ptr->txn : NULL;
+
+    for (f = ctxt->prog.filters; f < &ctxt->prog.filters[ctxt->prog.count]; f++)
     {
-        OL_LOG_PF(LOG_OLA_LVL_DEBUG, "Source Port, ");
-        udp_hdr_pattern.src_port = hton16(pattern);
-        udp_hdr_mask.src_port = hton16(mask);
+        cylpa_pf_ol_pm_filter(ctxt, txn, st, f);
     }
-    else if(pf_cfg->u.pf.portnum.direction == PF_PN_PORT_DEST)
+#if (CY_PF_OL_ADAPT != 0)
+    for (f = ctxt->adapt.filters; f < &ctxt->adapt.filters[ctxt->adapt.filter_count]; f++)
     {
-        OL_LOG_PF(LOG_OLA_LVL_DEBUG, "Dest Port, ");
-        udp_hdr_pattern.dst_port = hton16(pattern);
-        udp_hdr_mask.dst_port = hton16(mask);
+        cylpa_pf_ol_pm_filter(ctxt, txn, st, f);
     }
-    else
+#endif
+#if (CY_PF_OL_PRESETS != 0)
+    for (f = ctxt->presets.filters; f < &ctxt->presets.filters[ctxt->presets.count]; f++)
     {
-        OL_LOG_PF(LOG_OLA_LVL_DEBUG, "Source and Dest Port, ");
-        udp_hdr_pattern.src_port = hton16(pattern);
-        udp_hdr_mask.src_port = hton16(mask);
-        udp_hdr_pattern.dst_port = hton16(pattern);
-        udp_hdr_mask.dst_port = hton16(mask);
+        cylpa_pf_ol_pm_filter(ctxt, txn, st, f);
     }
-
-    common_filter_attrs(pf_cfg, &filter);
-
-    filter.id = pf_cfg->id;
-    filter.offset = ETHTYPE_OFFSET;
-    filter.mask = (uint8_t *)cylpa_glob_mask_buf;
-    filter.pattern = (uint8_t *)cylpa_glob_pat_buf;
-    filter.mask_size = PORT_FILTER_LEN;
-
-    memcpy(mask_ptr, &ether_hdr_mask.ether_type, ETHER_TYPE_LEN);
-    memcpy(mask_ptr + ETHER_TYPE_LEN, &ip_hdr_mask, sizeof(ip_hdr_mask) );
-    memcpy(mask_ptr + ETHER_TYPE_LEN + sizeof(ip_hdr_mask), &udp_hdr_mask, sizeof(udp_hdr_mask) );
-
-
-    memcpy(pat_ptr, &ether_hdr_pattern.ether_type, ETHER_TYPE_LEN);
-    memcpy(pat_ptr + ETHER_TYPE_LEN, &ip_hdr_pattern, sizeof(ip_hdr_pattern) );
-    memcpy(pat_ptr + ETHER_TYPE_LEN + sizeof(ip_hdr_pattern), &udp_hdr_pattern, sizeof(udp_hdr_pattern) );
-
-#ifdef DEBUG
-    OL_LOG_PF(LOG_OLA_LVL_INFO, "Before add_packet_filter()\n");
-    cylpa_print_pat_and_mask(filter.id, PORT_FILTER_LEN, cylpa_glob_mask_buf, cylpa_glob_pat_buf);
 #endif
 
-    if (whd_pf_add_packet_filter(whd, &filter) != WHD_SUCCESS)
+#if (CY_PF_OL_RULES != 0)
+    /* Rules waiting for this state go in now, disabled, and are enabled with the others */
+    ctxt->rules.asleep = (st == OL_PM_ST_GOING_TO_SLEEP);
+    active = ctxt->rules.asleep ? CY_PF_ACTIVE_SLEEP : CY_PF_ACTIVE_WAKE;
+    for (r = ctxt->rules.rules; r < &ctxt->rules.rules[CY_PF_OL_MAX_RULES]; r++)
     {
-        OL_LOG_PF(LOG_OLA_LVL_ERR, "Add filter %ld Failed\n", filter.id);
+        if (r->in_use && r->pending && (r->cfg.bits & active) )
+        {
+            r->pending = (cylpa_pf_ol_rule_install(ctxt, r - ctxt->rules.rules) != RESULT_OK);
+        }
+    }
+    for (f = ctxt->rules.filters; f < &ctxt->rules.filters[ctxt->rules.count]; f++)
+    {
+        cylpa_pf_ol_pm_filter(ctxt, txn, st, f);
     }
+#endif
+#if (CY_PF_OL_POLICY != 0)
+    for (f = ctxt->policy.filters; f < &ctxt->policy.filters[ctxt->policy.count]; f++)
+    {
+        cylpa_pf_ol_pm_filter(ctxt, txn, st, f);
+    }
+#endif
 
-    return 0;
+#if (CY_PF_OL_SOCK != 0)
+    /* The socket filters are enabled once all of them are in */
+    if (st == OL_PM_ST_GOING_TO_SLEEP)
+    {
+        if (ctxt->sock.on)
+        {
+            cylpa_pf_ol_sock_sleep(ctxt, txn);
+        }
+    }
+    else
+    {
+        for (f = ctxt->sock.filters; f < &ctxt->sock.filters[CY_PF_OL_SOCK_MAX_SLOTS]; f++)
+        {
+            if (ctxt->sock.live[f - ctxt->sock.filters])
+            {
+                cylpa_pf_ol_pm_filter(ctxt, txn, st, f);
+            }
+        }
+    }
+#endif
+    cylpa_pf_ol_rules_unlock();
 }
 
 /*******************************************************************************
- * Function Name: cylpa_create_single_portnum_mask
+ * Function Name: cylpa_pf_ol_pm_filter
  ****************************************************************************//**
  *
- * Remove all filters. No need to disable prior to removal.
+ * Enable or disable one filter for a power state.
  *
- * \param pf_cfg
- * The pointer to the cy_pf_ol_cfg_t structure \ref cy_pf_ol_cfg_t.
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
  *
- * \param pattern
- * TBD.
+ * \param txn
+ * The OLM transaction, NULL to issue the IOVAR now.
  *
- * \param mask
- * TBD.
+ * \param st
+ * see \ref ol_pm_st_t.
  *
- * \return
- * Returns the execution result
+ * \param f
+ * The filter \ref cy_pf_ol_filter_t.
  *
  ********************************************************************************/
-static int cylpa_create_single_portnum_mask(cy_pf_ol_cfg_t *pf_cfg, uint16_t *pattern, uint16_t *mask)
+static void cylpa_pf_ol_pm_filter(pf_ol_t *ctxt, struct olm_txn *txn, ol_pm_st_t st, cy_pf_ol_filter_t *f)
 {
-    *pattern = pf_cfg->u.pf.portnum.portnum;
-    *mask = 0xffff;
-    return 0;
+    bool enable;
+
+    /* If always active, then nothing to do. */
+    if ( (f->bits & (CY_PF_ACTIVE_SLEEP | CY_PF_ACTIVE_WAKE) ) == (CY_PF_ACTIVE_SLEEP | CY_PF_ACTIVE_WAKE) )
+    {
+        OL_LOG_PF(LOG_OLA_LVL_INFO, "%s: Filter %d is always on, nothing to do\n", __func__, f->id);
+        return;
+    }
+
+    enable = (st == OL_PM_ST_GOING_TO_SLEEP) ? ( (f->bits & CY_PF_ACTIVE_SLEEP) != 0 ) :
+             ( (f->bits & CY_PF_ACTIVE_WAKE) != 0 );
+    OL_LOG_PF(LOG_OLA_LVL_DEBUG, "%s: %s %s filter %d\n", __func__, enable ? "Enabling" : "Disabling",
+              (f->bits & CY_PF_ACTIVE_SLEEP) ? "sleep" : "wake", f->id);
+    cylpa_olm_txn_pf_enable(txn, ctxt->whd, f->id, enable, cylpa_pf_ol_pm_done, f);
 }
 
 /*******************************************************************************
- * Function Name: cylpa_create_portnum_range_mask
+ * Function Name: cylpa_pf_ol_pm_done
  ****************************************************************************//**
  *
- * Remove all filters. No need to disable prior to removal.
- *
- * \param pf_cfg
- * The pointer to the cy_pf_ol_cfg_t structure \ref cy_pf_ol_cfg_t.
+ * Completion of a filter enable/disable queued by cylpa_pf_ol_pm().
  *
- * \param pattern
- * TBD.
+ * \param arg
+ * The filter \ref cy_pf_ol_filter_t.
  *
- * \param mask
- * TBD.
- *
- * \return
- * Returns the execution result
+ * \param result
+ * whd_result_t of the IOVAR.
  *
  ********************************************************************************/
-static int cylpa_create_portnum_range_mask(cy_pf_ol_cfg_t *pf_cfg, uint16_t *pattern, uint16_t *mask)
+static void cylpa_pf_ol_pm_done(void *arg, uint32_t result)
 {
-    uint16_t port = pf_cfg->u.pf.portnum.portnum;
-    uint16_t range = pf_cfg->u.pf.portnum.range;
-
-    /* initialize filter patterns */
-    *pattern = port;
+    (void)arg;
+    if (result != WHD_SUCCESS)
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: pkt_filter_enable %d FAILED\n", __func__, ( (cy_pf_ol_filter_t *)arg )->id);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_add_filter
+ ****************************************************************************//**
+ *
+ * Install one compiled filter in the firmware, disabled.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param f
+ * The filter \ref cy_pf_ol_filter_t.
+ *
+ * \return
+ * RESULT_OK, or RESULT_ERROR if the firmware did not take the filter
+ *
+ ********************************************************************************/
+static int cylpa_pf_ol_add_filter(pf_ol_t *ctxt, cy_pf_ol_filter_t *f)
+{
+    whd_packet_filter_t filter;
+    whd_result_t result;
+
+    /* Known to fail; the firmware filter list is full */
+    if (!cylpa_olm_caps_slot_available(ctxt->ol_info_ptr, OL_CAPS_SLOT_PF) )
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: no free filter in firmware for id %d\n", __func__, f->id);
+        return RESULT_ERROR;
+    }
+
+    /* A (re)added filter starts in a state the OLM shadow does not know */
+    cylpa_olm_shadow_forget(ctxt->whd, OLM_TXN_IOVAR_PKT_FILTER_ENABLE, f->id);
+
+    filter.id = f->id;
+    filter.offset = f->offset;
+    filter.mask_size = f->len;
+    filter.mask = f->mask;
+    filter.pattern = f->pattern;
+    filter.rule = (f->bits & CY_PF_ACTION_DISCARD) ? WHD_PACKET_FILTER_RULE_NEGATIVE_MATCHING :
+                  WHD_PACKET_FILTER_RULE_POSITIVE_MATCHING;
+
+    OL_LOG_PF(LOG_OLA_LVL_DEBUG, "Creating filter ID: %d offset %d len %d %s%s, %s\n", f->id, f->offset, f->len,
+              (f->bits & CY_PF_ACTIVE_WAKE) ? "Wake" : "", (f->bits & CY_PF_ACTIVE_SLEEP) ? "Sleep" : "",
+              (f->bits & CY_PF_ACTION_DISCARD) ? "Discard" : "Keep");
+#ifdef DEBUG
+    cylpa_print_pat_and_mask(f->id, f->len, f->mask, f->pattern);
+#endif
+
+    result = whd_pf_add_packet_filter(ctxt->whd, &filter);
+    if (result != WHD_SUCCESS)
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "Add filter %ld Failed\n", filter.id);
+    }
+
+    cylpa_olm_caps_slot_added(ctxt->ol_info_ptr, OL_CAPS_SLOT_PF, (uint32_t)result);
+    return (result == WHD_SUCCESS) ? RESULT_OK : RESULT_ERROR;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_remove_filter
+ ****************************************************************************//**
+ *
+ * Remove one filter from the firmware. No need to disable prior to removal.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param id
+ * Id of the filter.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_remove_filter(pf_ol_t *ctxt, uint8_t id)
+{
+    OL_LOG_PF(LOG_OLA_LVL_INFO, "Removing filter %d\n", id);
+    whd_result_t res = whd_pf_remove_packet_filter(ctxt->whd, id);
+    cylpa_olm_shadow_forget(ctxt->whd, OLM_TXN_IOVAR_PKT_FILTER_ENABLE, id);
+    if (res != WHD_SUCCESS)
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: Unable to remove filter %d, result = %d\n", __func__, id, res);
+    }
+    else
+    {
+        cylpa_olm_caps_slot_removed(ctxt->ol_info_ptr, OL_CAPS_SLOT_PF);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_stats_reset
+ ****************************************************************************//**
+ *
+ * Start the counters of a filter just added to the firmware.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param index
+ * Index of the filter in ctxt->prog.filters.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_stats_reset(pf_ol_t *ctxt, uint32_t index)
+{
+    const cy_pf_ol_filter_t *f = &ctxt->prog.filters[index];
+    cy_pf_ol_stats_t *st = &ctxt->stats[index];
+    uint32_t i;
+
+    memset(st, 0, sizeof(*st) );
+    st->filter_id = f->id;
+    st->cfg_id = f->id;
+    st->bits = f->bits;
+    for (i = 0; i < ctxt->prog.map_count; i++)
+    {
+        if ( (ctxt->prog.map[i].kind != CY_PF_OL_MAP_INACTIVE) && (ctxt->prog.map[i].filter_id == f->id) )
+        {
+            st->cfg_id = ctxt->prog.map[i].cfg_id;
+            break;
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_stats_remap
+ ****************************************************************************//**
+ *
+ * Move the counters of the filters a reconfiguration keeps to their index in
+ * the new program, in place. Those of the other filters are left anywhere and
+ * are reset by the caller.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure, with the new program.
+ *
+ * \param prev
+ * The program ctxt->stats are for.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_stats_remap(pf_ol_t *ctxt, const cy_pf_ol_program_t *prev)
+{
+    uint8_t at[CY_PF_OL_MAX_FILTERS];       /* Index in ctxt->stats of the counters of prev->filters[i] */
+    uint8_t held[CY_PF_OL_MAX_FILTERS];     /* Index in prev->filters of the counters in ctxt->stats[i] */
+    cy_pf_ol_stats_t tmp;
+    const cy_pf_ol_filter_t *f;
+    uint32_t i, j, k;
+
+    for (i = 0; i < CY_PF_OL_MAX_FILTERS; i++)
+    {
+        at[i] = (uint8_t)i;
+        held[i] = (uint8_t)i;
+    }
+
+    for (i = 0; i < ctxt->prog.count; i++)
+    {
+        f = cylpa_pf_ol_find_id( (cy_pf_ol_program_t *)prev, ctxt->prog.filters[i].id);
+        if ( (f == NULL) || !cylpa_pf_ol_same_filter(f, &ctxt->prog.filters[i]) )
+        {
+            continue;
+        }
+
+        /* Swap them in; whatever was at i is still found through at[] */
+        k = (uint32_t)(f - prev->filters);
+        j = at[k];
+        tmp = ctxt->stats[i];
+        ctxt->stats[i] = ctxt->stats[j];
+        ctxt->stats[j] = tmp;
+        at[held[i]] = (uint8_t)j;
+        held[j] = held[i];
+        at[k] = (uint8_t)i;
+        held[i] = (uint8_t)k;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_snapshot
+ ****************************************************************************//**
+ *
+ * Read the firmware counters of every programmed filter into ctxt->stats. A
+ * filter whose counters cannot be read keeps its previous totals and gets no
+ * delta.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \return
+ * RESULT_OK, or RESULT_ERROR if some counters could not be read
+ *
+ ********************************************************************************/
+static int cylpa_pf_ol_snapshot(pf_ol_t *ctxt)
+{
+    wl_pkt_filter_stats_t fw;
+    cy_pf_ol_stats_t *st;
+    whd_result_t res;
+    int result = RESULT_OK;
+    uint32_t i;
+
+    for (i = 0; i < ctxt->prog.count; i++)
+    {
+        st = &ctxt->stats[i];
+        res = whd_pf_get_packet_filter_stats(ctxt->whd, ctxt->prog.filters[i].id, &fw);
+        if (res != WHD_SUCCESS)
+        {
+            OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: Failure Getting Packet Filter Statistics of %d 0x%x\n", __func__,
+                      ctxt->prog.filters[i].id, (unsigned int)res);
+            st->valid = false;
+            st->matched_delta = 0;
+            st->forwarded_delta = 0;
+            st->discarded_delta = 0;
+            result = RESULT_ERROR;
+            continue;
+        }
+
+        /* Unsigned differences stay right across a counter wrap */
+        st->matched_delta = fw.num_pkts_matched - st->matched;
+        st->forwarded_delta = fw.num_pkts_forwarded - st->forwarded;
+        st->discarded_delta = fw.num_pkts_discarded - st->discarded;
+        st->matched = fw.num_pkts_matched;
+        st->forwarded = fw.num_pkts_forwarded;
+        st->discarded = fw.num_pkts_discarded;
+        st->valid = true;
+    }
+    ctxt->snapshots++;
+    return result;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_stats_work
+ ****************************************************************************//**
+ *
+ * Take the snapshot requested by a wake, from the OLM executor.
+ *
+ * \param arg
+ * The pointer to the pf_ol_t structure.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_stats_work(void *arg)
+{
+    pf_ol_t *ctxt = (pf_ol_t *)arg;
+
+    /* Not while a reconfiguration swaps the program */
+    cylpa_olm_reg_lock();
+    if (ctxt->whd != NULL)
+    {
+        cylpa_pf_ol_snapshot(ctxt);
+    }
+    cylpa_olm_reg_unlock();
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_find
+ ****************************************************************************//**
+ *
+ * The packet filter offload of an Offload Manager.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \return
+ * The offload, or NULL if olm has none or it is not initialized
+ *
+ ********************************************************************************/
+static pf_ol_t *cylpa_pf_ol_find(olm_t *olm)
+{
+    const ol_desc_t *desc = cylpa_olm_get_desc(olm, cylpa_olm_find_type(olm, &pf_ol_fns) );
+    pf_ol_t *ctxt;
+
+    if ( (desc == NULL) || (desc->ol == NULL) )
+    {
+        return NULL;
+    }
+    ctxt = (pf_ol_t *)desc->ol;
+    return ( (ctxt->whd != NULL) && (ctxt->cfg != NULL) ) ? ctxt : NULL;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_get_stats
+ ****************************************************************************//**
+ *
+ * Get the firmware counters of the packet filters of an Offload Manager.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param refresh
+ * Read the counters from the firmware; otherwise return the last snapshot.
+ *
+ * \param stats
+ * Counters, one entry per programmed filter.
+ *
+ * \param max
+ * Entries in stats.
+ *
+ * \param count
+ * Entries written to stats, may be NULL.
+ *
+ * \return
+ * RESULT_OK, RESULT_BADARGS, or RESULT_ERROR if some counters could not be read
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_get_stats(olm_t *olm, bool refresh, cy_pf_ol_stats_t *stats, uint32_t max, uint32_t *count)
+{
+    pf_ol_t *ctxt;
+    uint32_t n = 0;
+    int result = RESULT_OK;
+
+    if ( (stats == NULL) && (max != 0) )
+    {
+        return RESULT_BADARGS;
+    }
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if (ctxt == NULL)
+    {
+        result = RESULT_BADARGS;
+    }
+    else
+    {
+        if (refresh)
+        {
+            result = cylpa_pf_ol_snapshot(ctxt);
+        }
+        n = (ctxt->prog.count < max) ? ctxt->prog.count : max;
+        memcpy(stats, ctxt->stats, n * sizeof(stats[0]) );
+    }
+    cylpa_olm_reg_unlock();
+
+    if (count != NULL)
+    {
+        *count = n;
+    }
+    return result;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_stats_on_wake
+ ****************************************************************************//**
+ *
+ * Take a snapshot of the packet filter counters after every wake.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param enable
+ * Sample on wake.
+ *
+ * \return
+ * RESULT_OK, or RESULT_BADARGS
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_stats_on_wake(olm_t *olm, bool enable)
+{
+    pf_ol_t *ctxt;
+    int result = RESULT_OK;
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if (ctxt == NULL)
+    {
+        result = RESULT_BADARGS;
+    }
+    else
+    {
+        ctxt->stats_on_wake = enable;
+        if (!enable)
+        {
+            cylpa_olm_exec_cancel(&ctxt->stats_work);
+        }
+    }
+    cylpa_olm_reg_unlock();
+    return result;
+}
+
+#if PF_OL_EXTRAS
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_spare_id
+ ****************************************************************************//**
+ *
+ * Pick an id for an adaptive, allow-list, preset, rule or policy filter, or for
+ * a rule, counting down from 255: not a configured id, not a rule id, not the
+ * id of a filter in the firmware and not one given to a policy being checked.
+ * Called with the rules mutex held.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param id
+ * The id.
+ *
+ * \return
+ * false if every id is taken
+ *
+ ********************************************************************************/
+static bool cylpa_pf_ol_spare_id(const pf_ol_t *ctxt, uint8_t *id)
+{
+    uint32_t used[256 / 32] = { 0 };
+    const cy_pf_ol_cfg_t *cfg;
+    uint32_t i;
+    int n;
+
+    for (cfg = ctxt->cfg; (cfg != NULL) && (cfg->feature != CY_PF_OL_FEAT_LAST); cfg++)
+    {
+        used[cfg->id / 32] |= 1u << (cfg->id % 32);
+    }
+    for (i = 0; i < ctxt->prog.count; i++)
+    {
+        used[ctxt->prog.filters[i].id / 32] |= 1u << (ctxt->prog.filters[i].id % 32);
+    }
+#if (CY_PF_OL_ADAPT != 0)
+    for (i = 0; i < ctxt->adapt.filter_count; i++)
+    {
+        used[ctxt->adapt.filters[i].id / 32] |= 1u << (ctxt->adapt.filters[i].id % 32);
+    }
+#endif
+#if (CY_PF_OL_SOCK != 0)
+    for (i = 0; i < CY_PF_OL_SOCK_MAX_SLOTS; i++)
+    {
+        if (ctxt->sock.live[i])
+        {
+            used[ctxt->sock.filters[i].id / 32] |= 1u << (ctxt->sock.filters[i].id % 32);
+        }
+    }
+#endif
+#if (CY_PF_OL_PRESETS != 0)
+    for (i = 0; i < ctxt->presets.count; i++)
+    {
+        used[ctxt->presets.filters[i].id / 32] |= 1u << (ctxt->presets.filters[i].id % 32);
+    }
+#endif
+#if (CY_PF_OL_RULES != 0)
+    for (i = 0; i < CY_PF_OL_MAX_RULES; i++)
+    {
+        if (ctxt->rules.rules[i].in_use)
+        {
+            used[ctxt->rules.rules[i].cfg.id / 32] |= 1u << (ctxt->rules.rules[i].cfg.id % 32);
+        }
+    }
+    for (i = 0; i < ctxt->rules.count; i++)
+    {
+        used[ctxt->rules.filters[i].id / 32] |= 1u << (ctxt->rules.filters[i].id % 32);
+    }
+#endif
+#if (CY_PF_OL_POLICY != 0)
+    for (i = 0; i < ctxt->policy.count; i++)
+    {
+        used[ctxt->policy.filters[i].id / 32] |= 1u << (ctxt->policy.filters[i].id % 32);
+    }
+    for (i = 0; i < ctxt->policy.staged_count; i++)
+    {
+        used[ctxt->policy.staged[i].id / 32] |= 1u << (ctxt->policy.staged[i].id % 32);
+    }
+#endif
+
+    for (n = 255; n >= 0; n--)
+    {
+        if ( (used[n / 32] & (1u << (n % 32) ) ) == 0 )
+        {
+            *id = (uint8_t)n;
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+#if (CY_PF_OL_ADAPT != 0)
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_adapt_install
+ ****************************************************************************//**
+ *
+ * Add the sleep discard filter of a class, disabled; it is enabled with the
+ * other sleep filters at the next transition. A class whose frames a
+ * configured filter keeps asleep is blocked instead.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param c
+ * The class \ref cy_pf_ol_adapt_class_t.
+ *
+ * \param now
+ * Current time, ms.
+ *
+ * \return
+ * RESULT_OK, RESULT_UNSUPPORTED if the class is blocked, or RESULT_ERROR if no
+ * filter can be added
+ *
+ ********************************************************************************/
+static int cylpa_pf_ol_adapt_install(pf_ol_t *ctxt, cy_pf_ol_adapt_class_t *c, uint32_t now)
+{
+    cy_pf_ol_adapt_t *ad = &ctxt->adapt;
+    cy_pf_ol_program_t *scratch = &ctxt->scratch;
+    cy_pf_ol_cfg_t entry[2];
+    cy_pf_ol_filter_t *f;
+    const cy_pf_ol_filter_t *k;
+#if (CY_PF_OL_SOCK != 0)
+    uint32_t i;
+#endif
+    uint8_t id;
+
+    if (!cylpa_pf_ol_spare_id(ctxt, &id) )
+    {
+        return RESULT_ERROR;
+    }
+
+    memset(&entry[1], 0, sizeof(entry[1]) );
+    entry[1].feature = CY_PF_OL_FEAT_LAST;
+    if ( (cylpa_pf_ol_class_cfg(&c->cls, id, &entry[0]) != RESULT_OK) ||
+         (cylpa_pf_ol_compile(entry, scratch) != RESULT_OK) || (scratch->count != 1) )
+    {
+        c->blocked = true;
+        return RESULT_UNSUPPORTED;
+    }
+
+    /* A discard filter wins over a keep filter */
+    for (k = ctxt->prog.filters; k < &ctxt->prog.filters[ctxt->prog.count]; k++)
+    {
+        if ( ( (k->bits & (CY_PF_ACTIVE_SLEEP | CY_PF_ACTION_DISCARD) ) == CY_PF_ACTIVE_SLEEP ) &&
+             cylpa_pf_adapt_overlaps(k, &scratch->filters[0]) )
+        {
+            OL_LOG_PF(LOG_OLA_LVL_INFO, "%s: 0x%04x/%u/%u kept asleep by filter %d\n", __func__,
+                      c->cls.eth_type, c->cls.ip_type, c->cls.port, k->id);
+            c->blocked = true;
+            return RESULT_UNSUPPORTED;
+        }
+    }
+#if (CY_PF_OL_SOCK != 0)
+    for (i = 0; i < CY_PF_OL_SOCK_MAX_SLOTS; i++)
+    {
+        if (ctxt->sock.live[i] && cylpa_pf_adapt_overlaps(&ctxt->sock.filters[i], &scratch->filters[0]) )
+        {
+            OL_LOG_PF(LOG_OLA_LVL_INFO, "%s: 0x%04x/%u/%u kept asleep by socket filter %d\n", __func__,
+                      c->cls.eth_type, c->cls.ip_type, c->cls.port, ctxt->sock.filters[i].id);
+            c->blocked = true;
+            return RESULT_UNSUPPORTED;
+        }
+    }
+#endif
+#if (CY_PF_OL_POLICY != 0)
+    for (k = ctxt->policy.filters; k < &ctxt->policy.filters[ctxt->policy.count]; k++)
+    {
+        if (cylpa_pf_adapt_overlaps(k, &scratch->filters[0]) )
+        {
+            OL_LOG_PF(LOG_OLA_LVL_INFO, "%s: 0x%04x/%u/%u allowed asleep by policy filter %d\n", __func__,
+                      c->cls.eth_type, c->cls.ip_type, c->cls.port, k->id);
+            c->blocked = true;
+            return RESULT_UNSUPPORTED;
+        }
+    }
+#endif
+
+    f = &ad->filters[ad->filter_count];
+    *f = scratch->filters[0];
+    if (cylpa_pf_ol_add_filter(ctxt, f) != RESULT_OK)
+    {
+        return RESULT_ERROR;
+    }
+    ad->filter_count++;
+    ad->installed++;
+    c->filtered = true;
+    c->filter_id = f->id;
+    c->expires = now + ad->cfg.expiry_ms;
+    OL_LOG_PF(LOG_OLA_LVL_INFO, "%s: discarding 0x%04x/%u/%u asleep with filter %d, score %lu\n", __func__,
+              c->cls.eth_type, c->cls.ip_type, c->cls.port, f->id, (unsigned long)c->score);
+    return RESULT_OK;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_adapt_expire
+ ****************************************************************************//**
+ *
+ * Remove the adaptive filters that lapsed or whose class is now allowed. The
+ * class of a removed filter has to score again.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param now
+ * Current time, ms.
+ *
+ * \param all
+ * Remove every adaptive filter and forget which classes are blocked.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_adapt_expire(pf_ol_t *ctxt, uint32_t now, bool all)
+{
+    cy_pf_ol_adapt_t *ad = &ctxt->adapt;
+    cy_pf_ol_adapt_class_t *c;
+    uint32_t i = 0;
+
+    for (c = ad->classes; c < &ad->classes[ad->class_count]; c++)
+    {
+        c->blocked = c->blocked && !all;
+        if (!c->filtered || ( !all && ( (int32_t)(now - c->expires) < 0 ) ) )
+        {
+            continue;
+        }
+
+        for (i = 0; (i < ad->filter_count) && (ad->filters[i].id != c->filter_id); i++)
+        {
+        }
+        if (i < ad->filter_count)
+        {
+            cylpa_pf_ol_remove_filter(ctxt, ad->filters[i].id);
+            ad->filters[i] = ad->filters[--ad->filter_count];
+            ad->expired++;
+        }
+        c->filtered = false;
+        c->score = 0;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_adapt_work
+ ****************************************************************************//**
+ *
+ * Update the adaptive filters at the end of the window after a wake, from the
+ * OLM executor: drop the lapsed ones, then discard the worst classes while the
+ * slot budget and the firmware allow.
+ *
+ * \param arg
+ * The pointer to the pf_ol_t structure.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_adapt_work(void *arg)
+{
+    pf_ol_t *ctxt = (pf_ol_t *)arg;
+    cy_pf_ol_adapt_t *ad = &ctxt->adapt;
+    cy_pf_ol_adapt_class_t *c;
+    cy_time_t now = 0;
+    int result = RESULT_OK;
+
+    cylpa_olm_reg_lock();
+    cylpa_pf_ol_rules_lock();
+    if ( (ctxt->whd != NULL) && ad->on )
+    {
+        cy_rtos_get_time(&now);
+        cylpa_pf_ol_adapt_expire(ctxt, (uint32_t)now, false);
+
+        while ( (result != RESULT_ERROR) && (ad->filter_count < ad->cfg.slots) &&
+                cylpa_olm_caps_slot_available(ctxt->ol_info_ptr, OL_CAPS_SLOT_PF) )
+        {
+            c = cylpa_pf_adapt_worst(ad);
+            if (c == NULL)
+            {
+                break;
+            }
+            result = cylpa_pf_ol_adapt_install(ctxt, c, (uint32_t)now);
+        }
+    }
+    cylpa_pf_ol_rules_unlock();
+    cylpa_olm_reg_unlock();
+}
+#endif /* CY_PF_OL_ADAPT */
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_adapt
+ ****************************************************************************//**
+ *
+ * Enable adaptive sleep filters on top of the configured ones.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param cfg
+ * Settings \ref cy_pf_ol_adapt_cfg_t, NULL to disable.
+ *
+ * \return
+ * RESULT_OK, or RESULT_BADARGS
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_adapt(olm_t *olm, const cy_pf_ol_adapt_cfg_t *cfg)
+{
+#if (CY_PF_OL_ADAPT != 0)
+    pf_ol_t *ctxt;
+    int result = RESULT_OK;
+
+    if ( (cfg != NULL) && ( (cfg->slots == 0) || (cfg->slots > CY_PF_OL_ADAPT_MAX_SLOTS) ||
+                            (cfg->threshold == 0) || ( (cfg->allow == NULL) && (cfg->allow_count != 0) ) ) )
+    {
+        return RESULT_BADARGS;
+    }
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if (ctxt == NULL)
+    {
+        result = RESULT_BADARGS;
+    }
+    else
+    {
+        cylpa_olm_exec_cancel(&ctxt->adapt_work);
+        cylpa_pf_ol_rules_lock();
+        cylpa_pf_ol_adapt_expire(ctxt, 0, true);
+        memset(&ctxt->adapt, 0, sizeof(ctxt->adapt) );
+        if (cfg != NULL)
+        {
+            ctxt->adapt.cfg = *cfg;
+            ctxt->adapt.on = true;
+        }
+        cylpa_pf_ol_rules_unlock();
+    }
+    cylpa_olm_reg_unlock();
+    return result;
+#else
+    (void)olm;
+    (void)cfg;
+    return RESULT_UNSUPPORTED;
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_adapt_observe
+ ****************************************************************************//**
+ *
+ * Report a frame received by the host to the adaptive sleep filters. Frames
+ * outside the window after a wake count only when consumed.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param frame
+ * Frame, from the start of the Ethernet header.
+ *
+ * \param len
+ * Bytes in frame.
+ *
+ * \param consumed
+ * The application used the frame.
+ *
+ * \return
+ * RESULT_OK, or RESULT_BADARGS
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_adapt_observe(olm_t *olm, const uint8_t *frame, uint32_t len, bool consumed)
+{
+#if (CY_PF_OL_ADAPT != 0)
+    cy_pf_ol_class_t cls;
+    pf_ol_t *ctxt;
+    cy_time_t now = 0;
+    int result;
+
+    result = cylpa_pf_ol_classify(frame, len, &cls);
+    if (result != RESULT_OK)
+    {
+        return result;
+    }
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if (ctxt == NULL)
+    {
+        result = RESULT_BADARGS;
+    }
+    else
+    {
+        cylpa_pf_ol_rules_lock();
+        cy_rtos_get_time(&now);
+        if (ctxt->adapt.on &&
+            (consumed || ( (ctxt->adapt.wake != 0) && ( (uint32_t)now - ctxt->adapt.wake_ms <= ctxt->adapt.cfg.window_ms ) ) ) )
+        {
+            cylpa_pf_adapt_charge(&ctxt->adapt, &cls, consumed, (uint32_t)now);
+        }
+        cylpa_pf_ol_rules_unlock();
+    }
+    cylpa_olm_reg_unlock();
+    return result;
+#else
+    (void)olm;
+    (void)frame;
+    (void)len;
+    (void)consumed;
+    return RESULT_UNSUPPORTED;
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_adapt_get
+ ****************************************************************************//**
+ *
+ * Get the classes tracked by the adaptive sleep filters.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param classes
+ * Tracked classes.
+ *
+ * \param max
+ * Entries in classes.
+ *
+ * \param count
+ * Entries written to classes, may be NULL.
+ *
+ * \return
+ * RESULT_OK, or RESULT_BADARGS
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_adapt_get(olm_t *olm, cy_pf_ol_adapt_class_t *classes, uint32_t max, uint32_t *count)
+{
+#if (CY_PF_OL_ADAPT != 0)
+    pf_ol_t *ctxt;
+    uint32_t n = 0;
+    int result = RESULT_OK;
+
+    if ( (classes == NULL) && (max != 0) )
+    {
+        return RESULT_BADARGS;
+    }
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if (ctxt == NULL)
+    {
+        result = RESULT_BADARGS;
+    }
+    else
+    {
+        cylpa_pf_ol_rules_lock();
+        n = (ctxt->adapt.class_count < max) ? ctxt->adapt.class_count : max;
+        memcpy(classes, ctxt->adapt.classes, n * sizeof(classes[0]) );
+        cylpa_pf_ol_rules_unlock();
+    }
+    cylpa_olm_reg_unlock();
+
+    if (count != NULL)
+    {
+        *count = n;
+    }
+    return result;
+#else
+    (void)olm;
+    (void)classes;
+    (void)max;
+    (void)count;
+    return RESULT_UNSUPPORTED;
+#endif
+}
+
+#if (CY_PF_OL_SOCK != 0)
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_sock_port
+ ****************************************************************************//**
+ *
+ * Add the classes of a local port to the socket list, once.
+ *
+ * \param cfg
+ * The settings \ref cy_pf_ol_sock_cfg_t.
+ *
+ * \param cls
+ * The list.
+ *
+ * \param n
+ * Entries in the list.
+ *
+ * \param max
+ * Entries the list holds.
+ *
+ * \param ip_type
+ * PF_IP_PROTO_TCP or PF_IP_PROTO_UDP.
+ *
+ * \param port
+ * The local port.
+ *
+ * \return
+ * false if the list is full
+ *
+ ********************************************************************************/
+static bool cylpa_pf_ol_sock_port(const cy_pf_ol_sock_cfg_t *cfg, cy_pf_ol_class_t *cls, uint32_t *n, uint32_t max,
+                                  uint8_t ip_type, uint16_t port)
+{
+    uint16_t eth_type = PF_ETHTYPE_IPV4;
+    uint32_t i;
+
+    for ( ; ; )
+    {
+        for (i = 0; (i < *n) && !( (cls[i].eth_type == eth_type) && (cls[i].ip_type == ip_type) &&
+                                    (cls[i].port == port) ); i++)
+        {
+        }
+        if (i == *n)
+        {
+            if (*n == max)
+            {
+                return false;
+            }
+            cls[*n].eth_type = eth_type;
+            cls[*n].ip_type = ip_type;
+            cls[*n].port = port;
+            (*n)++;
+        }
+        if (!cfg->ipv6 || (eth_type == PF_ETHTYPE_IPV6) )
+        {
+            return true;
+        }
+        eth_type = PF_ETHTYPE_IPV6;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_sock_ports
+ ****************************************************************************//**
+ *
+ * List the local ports of the sockets of the network stack, as read-only walks
+ * of its lists like sock_stats() of the TCP keepalive offload. The caller of
+ * cylpa_pf_ol_sock_collect() holds the network stack locked.
+ *
+ * \param ip
+ * The IP network stack of the OLM, \ref ol_info_t::ip.
+ *
+ * \param cfg
+ * The settings \ref cy_pf_ol_sock_cfg_t.
+ *
+ * \param cls
+ * The ports, as classes.
+ *
+ * \param max
+ * Entries in cls.
+ *
+ * \param overflow
+ * Set if some ports did not fit.
+ *
+ * \return
+ * Entries written to cls
+ *
+ ********************************************************************************/
+static uint32_t cylpa_pf_ol_sock_ports(void *ip, const cy_pf_ol_sock_cfg_t *cfg, cy_pf_ol_class_t *cls,
+                                       uint32_t max, bool *overflow)
+{
+    uint32_t n = 0;
+    bool fit = true;
+
+#if defined(COMPONENT_LWIP)
+#if (LWIP_TCP == 1)
+    struct tcp_pcb *const *const tcp_lists[] = { &tcp_bound_pcbs, &tcp_active_pcbs };
+    struct tcp_pcb_listen *lpcb;
+    struct tcp_pcb *pcb;
+    uint32_t i;
+#endif
+#if (LWIP_UDP == 1)
+    struct udp_pcb *upcb;
+#endif
+
+    (void)ip;
+#if (LWIP_TCP == 1)
+    if (cfg->tcp)
+    {
+        for (lpcb = tcp_listen_pcbs.listen_pcbs; fit && (lpcb != NULL); lpcb = lpcb->next)
+        {
+            fit = cylpa_pf_ol_sock_port(cfg, cls, &n, max, PF_IP_PROTO_TCP, lpcb->local_port);
+        }
+        for (i = 0; i < sizeof(tcp_lists) / sizeof(tcp_lists[0]); i++)
+        {
+            for (pcb = *tcp_lists[i]; fit && (pcb != NULL); pcb = pcb->next)
+            {
+                fit = cylpa_pf_ol_sock_port(cfg, cls, &n, max, PF_IP_PROTO_TCP, pcb->local_port);
+            }
+        }
+    }
+#endif
+#if (LWIP_UDP == 1)
+    if (cfg->udp)
+    {
+        for (upcb = udp_pcbs; fit && (upcb != NULL); upcb = upcb->next)
+        {
+            if (upcb->local_port != 0)
+            {
+                fit = cylpa_pf_ol_sock_port(cfg, cls, &n, max, PF_IP_PROTO_UDP, upcb->local_port);
+            }
+        }
+    }
+#endif
+#elif defined(COMPONENT_NETXDUO)
+    NX_IP          *ip_ptr = (NX_IP *)ip;
+    NX_TCP_LISTEN  *listen_ptr;
+    NX_TCP_SOCKET  *tcp_ptr;
+    NX_UDP_SOCKET  *udp_ptr;
+    ULONG          count;
+
+    if (ip_ptr == NX_NULL)
+    {
+        *overflow = true;
+        return 0;
+    }
+
+    if (cfg->tcp)
+    {
+        /* The active listen requests form a circular list */
+        listen_ptr = ip_ptr->nx_ip_tcp_active_listen_requests;
+        if (listen_ptr != NX_NULL)
+        {
+            do
+            {
+                fit = cylpa_pf_ol_sock_port(cfg, cls, &n, max, PF_IP_PROTO_TCP, (uint16_t)listen_ptr->nx_tcp_listen_port);
+                listen_ptr = listen_ptr->nx_tcp_listen_next;
+            } while (fit && (listen_ptr != ip_ptr->nx_ip_tcp_active_listen_requests) );
+        }
+
+        count = ip_ptr->nx_ip_tcp_created_sockets_count;
+        for (tcp_ptr = ip_ptr->nx_ip_tcp_created_sockets_ptr; fit && count-- && (tcp_ptr != NX_NULL);
+             tcp_ptr = tcp_ptr->nx_tcp_socket_created_next)
+        {
+            if ( (tcp_ptr->nx_tcp_socket_state != NX_TCP_CLOSED) && (tcp_ptr->nx_tcp_socket_port != 0) )
+            {
+                fit = cylpa_pf_ol_sock_port(cfg, cls, &n, max, PF_IP_PROTO_TCP, (uint16_t)tcp_ptr->nx_tcp_socket_port);
+            }
+        }
+    }
+
+    if (cfg->udp)
+    {
+        count = ip_ptr->nx_ip_udp_created_sockets_count;
+        for (udp_ptr = ip_ptr->nx_ip_udp_created_sockets_ptr; fit && count-- && (udp_ptr != NX_NULL);
+             udp_ptr = udp_ptr->nx_udp_socket_created_next)
+        {
+            if (udp_ptr->nx_udp_socket_port != 0)
+            {
+                fit = cylpa_pf_ol_sock_port(cfg, cls, &n, max, PF_IP_PROTO_UDP, (uint16_t)udp_ptr->nx_udp_socket_port);
+            }
+        }
+    }
+#else
+    (void)ip;
+    (void)cfg;
+    (void)cls;
+    (void)max;
+#endif
+
+    *overflow = *overflow || !fit;
+    return n;
+}
+
+/* Queued by cylpa_pf_ol_sock_sleep(): add the filter of sock slot param */
+static uint32_t cylpa_pf_ol_sock_txn_add(void *whd, void *arg, uint32_t param)
+{
+    pf_ol_t *ctxt = (pf_ol_t *)arg;
+    uint32_t result = WHD_SUCCESS;
+
+    (void)whd;
+    cylpa_pf_ol_rules_lock();
+    if (cylpa_pf_ol_add_filter(ctxt, &ctxt->sock.filters[param]) != RESULT_OK)
+    {
+        ctxt->sock.live[param] = false;
+        ctxt->sock.failed = true;
+        result = WHD_WLAN_NORESOURCE;
+    }
+    else
+    {
+        ctxt->sock.added++;
+    }
+    cylpa_pf_ol_rules_unlock();
+    return result;
+}
+
+/* Queued by cylpa_pf_ol_sock_sleep(): remove the filter with id param */
+static uint32_t cylpa_pf_ol_sock_txn_remove(void *whd, void *arg, uint32_t param)
+{
+    pf_ol_t *ctxt = (pf_ol_t *)arg;
+
+    (void)whd;
+    cylpa_pf_ol_rules_lock();
+    cylpa_pf_ol_remove_filter(ctxt, (uint8_t)param);
+    ctxt->sock.removed++;
+    cylpa_pf_ol_rules_unlock();
+    return WHD_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_sock_txn_commit
+ ****************************************************************************//**
+ *
+ * Queued by cylpa_pf_ol_sock_sleep() after its adds and removes: enable the
+ * allow-list if every filter made it to the firmware, otherwise leave it off.
+ *
+ * \param whd
+ * The WHD interface.
+ *
+ * \param arg
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param param
+ * Unused.
+ *
+ * \return
+ * whd_result_t
+ *
+ ********************************************************************************/
+static uint32_t cylpa_pf_ol_sock_txn_commit(void *whd, void *arg, uint32_t param)
+{
+    pf_ol_t *ctxt = (pf_ol_t *)arg;
+    uint32_t i;
+
+    (void)param;
+    cylpa_pf_ol_rules_lock();
+    if (ctxt->sock.failed)
+    {
+        cylpa_pf_ol_rules_unlock();
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: socket filters incomplete, not enabled for this sleep\n", __func__);
+        return WHD_WLAN_NORESOURCE;
+    }
+
+    for (i = 0; i < CY_PF_OL_SOCK_MAX_SLOTS; i++)
+    {
+        if (ctxt->sock.live[i])
+        {
+            cylpa_olm_txn_pf_enable(NULL, whd, ctxt->sock.filters[i].id, true, cylpa_pf_ol_pm_done,
+                                    &ctxt->sock.filters[i]);
+        }
+    }
+    cylpa_pf_ol_rules_unlock();
+    return WHD_SUCCESS;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_sock_clear
+ ****************************************************************************//**
+ *
+ * Remove every allow-list filter.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param txn
+ * The OLM transaction, NULL to remove them now.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_sock_clear(pf_ol_t *ctxt, struct olm_txn *txn)
+{
+    uint32_t i;
+
+    for (i = 0; i < CY_PF_OL_SOCK_MAX_SLOTS; i++)
+    {
+        if (ctxt->sock.live[i])
+        {
+            ctxt->sock.live[i] = false;
+            cylpa_olm_txn_call(txn, ctxt->whd, cylpa_pf_ol_sock_txn_remove, ctxt, ctxt->sock.filters[i].id,
+                               NULL, NULL);
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_sock_sleep
+ ****************************************************************************//**
+ *
+ * Bring the allow-list in line with the sockets in use before a sleep. Filters
+ * are compared by what they match: unchanged ones stay, the others are removed
+ * and added on the transaction, followed by the enable of all of them.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param txn
+ * The OLM transaction, NULL to issue the IOVARs now.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_sock_sleep(pf_ol_t *ctxt, struct olm_txn *txn)
+{
+    cy_pf_ol_sock_t *sk = &ctxt->sock;
+    cy_pf_ol_program_t *want = &ctxt->scratch;
+    cy_pf_ol_class_t *cls = sk->classes;
+    cy_pf_ol_cfg_t *entry = sk->entries;
+    const ol_caps_t *caps = (ctxt->ol_info_ptr != NULL) ? &ctxt->ol_info_ptr->caps : NULL;
+    bool overflow = false;
+    uint32_t kept = 0;
+    uint32_t adds;
+    uint32_t removes = 0;
+    uint32_t n, m = 0;
+    uint32_t i, j;
+    uint8_t id;
+
+    sk->cycles++;
+    sk->failed = false;
+
+    /* The ports are read by cylpa_pf_ol_sock_collect(), not here: the network
+     * stack lock must not be taken with the OLM locks held.
+     */
+    if (!sk->collected)
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: socket ports not collected, allow-list off\n", __func__);
+        sk->missed++;
+        cylpa_pf_ol_sock_clear(ctxt, txn);
+        return;
+    }
+    sk->collected = false;
+    n = sk->class_count;
+    overflow = sk->truncated;
+    for (i = 0; i < sk->cfg.keep_count; i++)
+    {
+        if (n < CY_PF_OL_SOCK_MAX_PORTS)
+        {
+            cls[n++] = sk->cfg.keep[i];
+        }
+        else
+        {
+            overflow = true;
+        }
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        if (cylpa_pf_ol_class_cfg(&cls[i], (uint8_t)m, &entry[m]) == RESULT_OK)
+        {
+            entry[m++].bits &= ~CY_PF_ACTION_DISCARD;
+        }
+    }
+    memset(&entry[m], 0, sizeof(entry[m]) );
+    entry[m].feature = CY_PF_OL_FEAT_LAST;
+
+    if (overflow || (cylpa_pf_ol_compile(entry, want) != RESULT_OK) || (want->count > sk->cfg.slots) )
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: %lu socket ports do not fit in %u filters, allow-list off\n", __func__,
+                  (unsigned long)n, sk->cfg.slots);
+        sk->overflows++;
+        cylpa_pf_ol_sock_clear(ctxt, txn);
+        return;
+    }
+
+    /* Keep the live filters still wanted, under their id */
+    for (i = 0; i < CY_PF_OL_SOCK_MAX_SLOTS; i++)
+    {
+        if (!sk->live[i])
+        {
+            continue;
+        }
+        for (j = 0; j < want->count; j++)
+        {
+            want->filters[j].id = sk->filters[i].id;
+            if ( ( (kept & (1u << j) ) == 0 ) && cylpa_pf_ol_same_filter(&want->filters[j], &sk->filters[i]) )
+            {
+                kept |= 1u << j;
+                break;
+            }
+        }
+        if (j == want->count)
+        {
+            sk->live[i] = false;
+            cylpa_olm_txn_call(txn, ctxt->whd, cylpa_pf_ol_sock_txn_remove, ctxt, sk->filters[i].id, NULL, NULL);
+            removes++;
+        }
+    }
+
+    /* Known not to fit: leave the allow-list off rather than half built */
+    adds = want->count;
+    for (j = 0; j < want->count; j++)
+    {
+        adds -= (kept >> j) & 1u;
+    }
+    if ( (caps != NULL) && caps->valid && (caps->slots_max[OL_CAPS_SLOT_PF] != OL_CAPS_SLOTS_UNKNOWN) &&
+         (caps->slots_used[OL_CAPS_SLOT_PF] + adds > caps->slots_max[OL_CAPS_SLOT_PF] + removes) )
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: no room in firmware for %lu socket filters, allow-list off\n", __func__,
+                  (unsigned long)adds);
+        sk->overflows++;
+        cylpa_pf_ol_sock_clear(ctxt, txn);
+        return;
+    }
+
+    for (j = 0; j < want->count; j++)
+    {
+        if (kept & (1u << j) )
+        {
+            continue;
+        }
+        for (i = 0; (i < CY_PF_OL_SOCK_MAX_SLOTS) && sk->live[i]; i++)
+        {
+        }
+        if ( (i == CY_PF_OL_SOCK_MAX_SLOTS) || !cylpa_pf_ol_spare_id(ctxt, &id) )
+        {
+            sk->failed = true;
+            break;
+        }
+        sk->filters[i] = want->filters[j];
+        sk->filters[i].id = id;
+        sk->live[i] = true;
+        cylpa_olm_txn_call(txn, ctxt->whd, cylpa_pf_ol_sock_txn_add, ctxt, i, NULL, NULL);
+    }
+
+    OL_LOG_PF(LOG_OLA_LVL_INFO, "%s: %lu ports, %u filters: %lu kept, %lu removed, %lu added\n", __func__,
+              (unsigned long)n, want->count, (unsigned long)(want->count - adds), (unsigned long)removes,
+              (unsigned long)adds);
+    cylpa_olm_txn_call(txn, ctxt->whd, cylpa_pf_ol_sock_txn_commit, ctxt, 0, NULL, NULL);
+}
+#endif /* CY_PF_OL_SOCK */
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_sock_mode
+ ****************************************************************************//**
+ *
+ * Keep only the traffic of the sockets in use while asleep.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param cfg
+ * Settings \ref cy_pf_ol_sock_cfg_t, NULL to disable.
+ *
+ * \return
+ * RESULT_OK, or RESULT_BADARGS
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_sock_mode(olm_t *olm, const cy_pf_ol_sock_cfg_t *cfg)
+{
+#if (CY_PF_OL_SOCK != 0)
+    cy_pf_ol_cfg_t entry;
+    pf_ol_t *ctxt;
+    uint32_t i;
+    int result = RESULT_OK;
+
+    if (cfg != NULL)
+    {
+        if ( (cfg->slots == 0) || (cfg->slots > CY_PF_OL_SOCK_MAX_SLOTS) ||
+             ( (cfg->keep == NULL) && (cfg->keep_count != 0) ) )
+        {
+            return RESULT_BADARGS;
+        }
+        /* Each keep class must turn into a filter, or its traffic would be dropped */
+        for (i = 0; i < cfg->keep_count; i++)
+        {
+            if (cylpa_pf_ol_class_cfg(&cfg->keep[i], 0, &entry) != RESULT_OK)
+            {
+                return RESULT_BADARGS;
+            }
+        }
+    }
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+#if (CY_PF_OL_POLICY != 0)
+    if ( (ctxt == NULL) || ( (cfg != NULL) && (ctxt->policy.flow_count != 0) ) )
+#else
+    if (ctxt == NULL)
+#endif
+    {
+        result = RESULT_BADARGS;
+    }
+    else
+    {
+        cylpa_pf_ol_rules_lock();
+        cylpa_pf_ol_sock_clear(ctxt, NULL);
+        memset(&ctxt->sock, 0, sizeof(ctxt->sock) );
+        if (cfg != NULL)
+        {
+            ctxt->sock.cfg = *cfg;
+            ctxt->sock.on = true;
+        }
+        cylpa_pf_ol_rules_unlock();
+    }
+    cylpa_olm_reg_unlock();
+    return result;
+#else
+    (void)olm;
+    (void)cfg;
+    return RESULT_UNSUPPORTED;
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_sock_collect
+ ****************************************************************************//**
+ *
+ * List the sockets in use for the socket allow-list of the next sleep.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \return
+ * RESULT_OK, or RESULT_BADARGS
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_sock_collect(olm_t *olm)
+{
+#if (CY_PF_OL_SOCK != 0)
+    cy_pf_ol_sock_t *sk;
+    pf_ol_t *ctxt;
+    int result = RESULT_OK;
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if ( (ctxt == NULL) || !ctxt->sock.on)
+    {
+        result = RESULT_BADARGS;
+    }
+    else
+    {
+        cylpa_pf_ol_rules_lock();
+        sk = &ctxt->sock;
+        sk->truncated = false;
+        sk->class_count = cylpa_pf_ol_sock_ports( (ctxt->ol_info_ptr != NULL) ? ctxt->ol_info_ptr->ip : NULL,
+                                                  &sk->cfg, sk->classes, CY_PF_OL_SOCK_MAX_PORTS, &sk->truncated);
+        sk->collected = true;
+        cylpa_pf_ol_rules_unlock();
+    }
+    cylpa_olm_reg_unlock();
+    return result;
+#else
+    (void)olm;
+    return RESULT_UNSUPPORTED;
+#endif
+}
+
+#if (CY_PF_OL_PRESETS != 0)
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_preset_remove
+ ****************************************************************************//**
+ *
+ * Remove the filters of a preset.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param index
+ * Index of the preset.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_preset_remove(pf_ol_t *ctxt, uint32_t index)
+{
+    cy_pf_ol_presets_t *ps = &ctxt->presets;
+    uint32_t i = 0;
+
+    while (i < ps->count)
+    {
+        if (ps->owner[i] != index)
+        {
+            i++;
+            continue;
+        }
+        cylpa_pf_ol_remove_filter(ctxt, ps->filters[i].id);
+        ps->count--;
+        ps->filters[i] = ps->filters[ps->count];
+        ps->owner[i] = ps->owner[ps->count];
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_preset_install
+ ****************************************************************************//**
+ *
+ * Add the filters of a preset and enable its wake filters. Nothing is left in
+ * the firmware if some filter does not fit.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param index
+ * Index of the preset.
+ *
+ * \param bits
+ * CY_PF_ACTIVE_SLEEP and/or CY_PF_ACTIVE_WAKE.
+ *
+ * \param slots
+ * Firmware slots the preset takes, may be NULL.
+ *
+ * \return
+ * RESULT_OK, RESULT_BADARGS, or RESULT_ERROR
+ *
+ ********************************************************************************/
+static int cylpa_pf_ol_preset_install(pf_ol_t *ctxt, uint32_t index, uint32_t bits, uint32_t *slots)
+{
+    cy_pf_ol_presets_t *ps = &ctxt->presets;
+    cy_pf_ol_program_t *scratch = &ctxt->scratch;
+    cy_pf_ol_filter_t *f;
+    uint32_t i;
+    int result;
+
+    result = cylpa_pf_ol_preset_compile(cylpa_pf_ol_preset_get(index), bits, scratch);
+    if (result != RESULT_OK)
+    {
+        return result;
+    }
+    if (slots != NULL)
+    {
+        *slots = scratch->count;
+    }
+    if (ps->count + scratch->count > CY_PF_OL_PRESET_MAX_SLOTS)
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: preset %s takes %u filters, %u free\n", __func__,
+                  cylpa_pf_ol_preset_get(index)->name, scratch->count, CY_PF_OL_PRESET_MAX_SLOTS - ps->count);
+        return RESULT_ERROR;
+    }
+
+    for (i = 0; i < scratch->count; i++)
+    {
+        f = &ps->filters[ps->count];
+        *f = scratch->filters[i];
+        if (!cylpa_pf_ol_spare_id(ctxt, &f->id) || (cylpa_pf_ol_add_filter(ctxt, f) != RESULT_OK) )
+        {
+            cylpa_pf_ol_preset_remove(ctxt, index);
+            return RESULT_ERROR;
+        }
+        ps->owner[ps->count++] = (uint8_t)index;
+    }
+
+    for (i = 0; i < ps->count; i++)
+    {
+        f = &ps->filters[i];
+        if ( (ps->owner[i] == index) && (f->bits & CY_PF_ACTIVE_WAKE) )
+        {
+            cylpa_olm_txn_pf_enable(NULL, ctxt->whd, f->id, true, cylpa_pf_ol_pm_done, f);
+        }
+    }
+    OL_LOG_PF(LOG_OLA_LVL_INFO, "%s: preset %s v%u, %u filters\n", __func__, cylpa_pf_ol_preset_get(index)->name,
+              cylpa_pf_ol_preset_get(index)->version, scratch->count);
+    return RESULT_OK;
+}
+#endif /* CY_PF_OL_PRESETS */
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_preset_enable
+ ****************************************************************************//**
+ *
+ * Enable a preset on top of the configured filters.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param name
+ * Name of the preset.
+ *
+ * \param bits
+ * CY_PF_ACTIVE_SLEEP and/or CY_PF_ACTIVE_WAKE.
+ *
+ * \param slots
+ * Firmware slots the preset takes, may be NULL.
+ *
+ * \return
+ * RESULT_OK, RESULT_BADARGS, or RESULT_ERROR
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_preset_enable(olm_t *olm, const char *name, uint32_t bits, uint32_t *slots)
+{
+#if (CY_PF_OL_PRESETS != 0)
+    pf_ol_t *ctxt;
+    uint32_t index;
+    int result;
+
+    if (cylpa_pf_ol_preset_find(name, &index) == NULL)
+    {
+        return RESULT_BADARGS;
+    }
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if (ctxt == NULL)
+    {
+        result = RESULT_BADARGS;
+    }
+    else
+    {
+        cylpa_pf_ol_rules_lock();
+        cylpa_pf_ol_preset_remove(ctxt, index);
+        result = cylpa_pf_ol_preset_install(ctxt, index, bits, slots);
+        ctxt->presets.bits[index] = (result == RESULT_OK) ? (uint8_t)bits : 0;
+        cylpa_pf_ol_rules_unlock();
+    }
+    cylpa_olm_reg_unlock();
+    return result;
+#else
+    (void)olm;
+    (void)name;
+    (void)bits;
+    (void)slots;
+    return RESULT_UNSUPPORTED;
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_preset_disable
+ ****************************************************************************//**
+ *
+ * Disable a preset and remove its filters.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param name
+ * Name of the preset.
+ *
+ * \return
+ * RESULT_OK, or RESULT_BADARGS
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_preset_disable(olm_t *olm, const char *name)
+{
+#if (CY_PF_OL_PRESETS != 0)
+    pf_ol_t *ctxt;
+    uint32_t index;
+    int result = RESULT_OK;
+
+    if (cylpa_pf_ol_preset_find(name, &index) == NULL)
+    {
+        return RESULT_BADARGS;
+    }
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if (ctxt == NULL)
+    {
+        result = RESULT_BADARGS;
+    }
+    else
+    {
+        cylpa_pf_ol_rules_lock();
+        cylpa_pf_ol_preset_remove(ctxt, index);
+        ctxt->presets.bits[index] = 0;
+        cylpa_pf_ol_rules_unlock();
+    }
+    cylpa_olm_reg_unlock();
+    return result;
+#else
+    (void)olm;
+    (void)name;
+    return RESULT_UNSUPPORTED;
+#endif
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_rules_lock
+ ****************************************************************************//**
+ *
+ * Take the mutex of the rules.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_rules_lock(void)
+{
+    if (cylpa_pf_ol_rules_mutex_init)
+    {
+        cy_rtos_get_mutex(&cylpa_pf_ol_rules_mutex, CY_RTOS_NEVER_TIMEOUT);
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_rules_unlock
+ ****************************************************************************//**
+ *
+ * Release the mutex of the rules.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_rules_unlock(void)
+{
+    if (cylpa_pf_ol_rules_mutex_init)
+    {
+        cy_rtos_set_mutex(&cylpa_pf_ol_rules_mutex);
+    }
+}
+
+#if (CY_PF_OL_RULES != 0)
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_rule_find
+ ****************************************************************************//**
+ *
+ * Find a rule by id.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param id
+ * Id of the rule.
+ *
+ * \return
+ * The rule, or NULL if there is none with that id
+ *
+ ********************************************************************************/
+static cy_pf_ol_rule_t *cylpa_pf_ol_rule_find(pf_ol_t *ctxt, uint8_t id)
+{
+    cy_pf_ol_rule_t *r;
+
+    for (r = ctxt->rules.rules; r < &ctxt->rules.rules[CY_PF_OL_MAX_RULES]; r++)
+    {
+        if (r->in_use && (r->cfg.id == id) )
+        {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_rule_uninstall
+ ****************************************************************************//**
+ *
+ * Remove the filters of a rule; the rule is kept.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param index
+ * Index of the rule.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_rule_uninstall(pf_ol_t *ctxt, uint32_t index)
+{
+    cy_pf_ol_rules_t *rs = &ctxt->rules;
+    uint32_t i = 0;
+
+    while (i < rs->count)
+    {
+        if (rs->owner[i] != index)
+        {
+            i++;
+            continue;
+        }
+        cylpa_pf_ol_remove_filter(ctxt, rs->filters[i].id);
+        rs->count--;
+        rs->filters[i] = rs->filters[rs->count];
+        rs->owner[i] = rs->owner[rs->count];
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_rule_install
+ ****************************************************************************//**
+ *
+ * Add the filters of a rule, disabled. The first one takes the rule id unless
+ * the configuration took it since; the others take spare ids. Nothing is left
+ * in the firmware if some filter does not fit.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param index
+ * Index of the rule.
+ *
+ * \return
+ * RESULT_OK, or RESULT_ERROR
+ *
+ ********************************************************************************/
+static int cylpa_pf_ol_rule_install(pf_ol_t *ctxt, uint32_t index)
+{
+    cy_pf_ol_rules_t *rs = &ctxt->rules;
+    cy_pf_ol_rule_t *r = &rs->rules[index];
+    cy_pf_ol_program_t *scratch = &ctxt->scratch;
+    cy_pf_ol_cfg_t entries[2];
+    const cy_pf_ol_cfg_t *cfg;
+    cy_pf_ol_filter_t *f;
+    bool taken = (cylpa_pf_ol_find_id(&ctxt->prog, r->cfg.id) != NULL);
+    uint32_t i;
+
+    for (cfg = ctxt->cfg; !taken && (cfg->feature != CY_PF_OL_FEAT_LAST); cfg++)
+    {
+        taken = (cfg->id == r->cfg.id);
+    }
+
+    entries[0] = r->cfg;
+    memset(&entries[1], 0, sizeof(entries[1]) );
+    entries[1].feature = CY_PF_OL_FEAT_LAST;
+    if (cylpa_pf_ol_compile(entries, scratch) != RESULT_OK)
+    {
+        return RESULT_ERROR;
+    }
+    if (rs->count + scratch->count > CY_PF_OL_RULE_MAX_SLOTS)
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: rule %d takes %u filters, %u free\n", __func__, r->cfg.id,
+                  scratch->count, CY_PF_OL_RULE_MAX_SLOTS - rs->count);
+        return RESULT_ERROR;
+    }
+
+    for (i = 0; i < scratch->count; i++)
+    {
+        f = &rs->filters[rs->count];
+        *f = scratch->filters[i];
+        f->id = r->cfg.id;
+        if ( ( ( (i != 0) || taken ) && !cylpa_pf_ol_spare_id(ctxt, &f->id) ) ||
+             (cylpa_pf_ol_add_filter(ctxt, f) != RESULT_OK) )
+        {
+            cylpa_pf_ol_rule_uninstall(ctxt, index);
+            return RESULT_ERROR;
+        }
+        rs->owner[rs->count++] = (uint8_t)index;
+    }
+    OL_LOG_PF(LOG_OLA_LVL_INFO, "%s: rule %d, %u filters\n", __func__, r->cfg.id, scratch->count);
+    return RESULT_OK;
+}
 
-    /*
-     * Say using port = 64 and  range = 3. Translates into binary:  100 0000 thru 100 0011
-     *   Pattern: Use port number for pattern (100 0000)
-     *   Mask:    Need to invert low bits, and fill 0s between resulting 1s.
-     *             To invert low bits, subtract 1.
-     *             OR the port back in since it was removed by the -1.
-     *       Example mask: convert 100 0011 into 111 1100
-     */
-    *mask = ( ( (port - 1) ^ range ) | port );
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_rule_stage
+ ****************************************************************************//**
+ *
+ * Replace the filters of a rule. A rule active in the current host state is
+ * added and enabled now; any other active rule is left pending, and added at
+ * the next transition into a state it is active in.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param index
+ * Index of the rule.
+ *
+ * \return
+ * RESULT_OK, or RESULT_ERROR if the filters do not fit; the rule is then pending
+ *
+ ********************************************************************************/
+static int cylpa_pf_ol_rule_stage(pf_ol_t *ctxt, uint32_t index)
+{
+    cy_pf_ol_rules_t *rs = &ctxt->rules;
+    cy_pf_ol_rule_t *r = &rs->rules[index];
+    uint32_t active = rs->asleep ? CY_PF_ACTIVE_SLEEP : CY_PF_ACTIVE_WAKE;
+    uint32_t i;
 
-    /* Now sign extend all the way to the leftmost/highest bit
-     * to prevent false hits on high bits
-     */
-    *mask = cylpa_sign_extend(*mask, cylpa_bitwidth(*mask) );
+    cylpa_pf_ol_rule_uninstall(ctxt, index);
+    if ( (r->cfg.bits & active) == 0 )
+    {
+        r->pending = ( (r->cfg.bits & (CY_PF_ACTIVE_SLEEP | CY_PF_ACTIVE_WAKE) ) != 0 );
+        return RESULT_OK;
+    }
+
+    r->pending = (cylpa_pf_ol_rule_install(ctxt, index) != RESULT_OK);
+    if (r->pending)
+    {
+        return RESULT_ERROR;
+    }
+    for (i = 0; i < rs->count; i++)
+    {
+        if (rs->owner[i] == index)
+        {
+            cylpa_olm_txn_pf_enable(NULL, ctxt->whd, rs->filters[i].id, true, cylpa_pf_ol_pm_done, &rs->filters[i]);
+        }
+    }
+    return RESULT_OK;
+}
+#endif /* CY_PF_OL_RULES */
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_rule_add
+ ****************************************************************************//**
+ *
+ * Add a filter at run time and give it an id.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param cfg
+ * The rule; cfg->id is ignored.
+ *
+ * \param id
+ * Id of the rule.
+ *
+ * \return
+ * RESULT_OK, RESULT_BADARGS, or RESULT_ERROR
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_rule_add(olm_t *olm, const cy_pf_ol_cfg_t *cfg, uint8_t *id)
+{
+#if (CY_PF_OL_RULES != 0)
+    cy_pf_ol_cfg_t entries[2];
+    cy_pf_ol_rule_t *r = NULL;
+    pf_ol_t *ctxt;
+    uint32_t i;
+    int result;
+
+    if ( (cfg == NULL) || (id == NULL) || (cfg->feature >= CY_PF_OL_FEAT_LAST) )
+    {
+        return RESULT_BADARGS;
+    }
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if (ctxt == NULL)
+    {
+        cylpa_olm_reg_unlock();
+        return RESULT_BADARGS;
+    }
+    cylpa_pf_ol_rules_lock();
+
+    /* Checked as if active, so that a rule added inactive can be activated later */
+    entries[0] = *cfg;
+    entries[0].bits |= CY_PF_ACTIVE_WAKE;
+    memset(&entries[1], 0, sizeof(entries[1]) );
+    entries[1].feature = CY_PF_OL_FEAT_LAST;
+    for (i = 0; i < CY_PF_OL_MAX_RULES; i++)
+    {
+        if (!ctxt->rules.rules[i].in_use)
+        {
+            r = &ctxt->rules.rules[i];
+            break;
+        }
+    }
 
-    return 0;
+    if (cylpa_pf_ol_compile(entries, &ctxt->scratch) != RESULT_OK)
+    {
+        result = RESULT_BADARGS;
+    }
+    else if ( (r == NULL) || !cylpa_pf_ol_spare_id(ctxt, id) )
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: no free rule\n", __func__);
+        result = RESULT_ERROR;
+    }
+    else
+    {
+        r->cfg = *cfg;
+        r->cfg.id = *id;
+        r->in_use = true;
+        result = cylpa_pf_ol_rule_stage(ctxt, i);
+        if (result != RESULT_OK)
+        {
+            memset(r, 0, sizeof(*r) );
+        }
+    }
+
+    cylpa_pf_ol_rules_unlock();
+    cylpa_olm_reg_unlock();
+    return result;
+#else
+    (void)olm;
+    (void)cfg;
+    (void)id;
+    return RESULT_UNSUPPORTED;
+#endif
 }
 
-static int cylpa_sign_extend(int val, unsigned width)
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_rule_set_bits
+ ****************************************************************************//**
+ *
+ * Change when a rule is active and whether it discards.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param id
+ * Id of the rule.
+ *
+ * \param bits
+ * CY_PF_ACTIVE_SLEEP, CY_PF_ACTIVE_WAKE and/or CY_PF_ACTION_DISCARD.
+ *
+ * \return
+ * RESULT_OK, RESULT_BADARGS, or RESULT_ERROR
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_rule_set_bits(olm_t *olm, uint8_t id, uint32_t bits)
 {
-    int const mask = 1U << (width - 1);
+#if (CY_PF_OL_RULES != 0)
+    const uint32_t changeable = CY_PF_ACTIVE_SLEEP | CY_PF_ACTIVE_WAKE | CY_PF_ACTION_DISCARD;
+    cy_pf_ol_rule_t *r = NULL;
+    pf_ol_t *ctxt;
+    int result = RESULT_BADARGS;
+
+    if ( (bits & ~changeable) != 0 )
+    {
+        return RESULT_BADARGS;
+    }
 
-    val = val & ( (1U << width) - 1 );
-    return ( (val ^ mask) - mask );
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if (ctxt != NULL)
+    {
+        cylpa_pf_ol_rules_lock();
+        r = cylpa_pf_ol_rule_find(ctxt, id);
+        if (r != NULL)
+        {
+            r->cfg.bits = (r->cfg.bits & ~changeable) | bits;
+            result = cylpa_pf_ol_rule_stage(ctxt, r - ctxt->rules.rules);
+        }
+        cylpa_pf_ol_rules_unlock();
+    }
+    cylpa_olm_reg_unlock();
+    return result;
+#else
+    (void)olm;
+    (void)id;
+    (void)bits;
+    return RESULT_UNSUPPORTED;
+#endif
 }
 
-/* Return position of set bit using 1 based notation */
-static int cylpa_bitwidth(int val)
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_rule_remove
+ ****************************************************************************//**
+ *
+ * Remove a rule and its filters.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param id
+ * Id of the rule.
+ *
+ * \return
+ * RESULT_OK, or RESULT_BADARGS
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_rule_remove(olm_t *olm, uint8_t id)
 {
-    int pos;
-    for (pos = MAX_BITS_IN_PORTNUM - 1; pos >= 0; pos--)
+#if (CY_PF_OL_RULES != 0)
+    cy_pf_ol_rule_t *r = NULL;
+    pf_ol_t *ctxt;
+    int result = RESULT_BADARGS;
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if (ctxt != NULL)
     {
-        if (val & (1 << pos) )
+        cylpa_pf_ol_rules_lock();
+        r = cylpa_pf_ol_rule_find(ctxt, id);
+        if (r != NULL)
         {
-            return (pos + 1);
+            cylpa_pf_ol_rule_uninstall(ctxt, r - ctxt->rules.rules);
+            memset(r, 0, sizeof(*r) );
+            result = RESULT_OK;
         }
+        cylpa_pf_ol_rules_unlock();
     }
-    return -1;
+    cylpa_olm_reg_unlock();
+    return result;
+#else
+    (void)olm;
+    (void)id;
+    return RESULT_UNSUPPORTED;
+#endif
 }
 
-#ifdef TESTING
-/* Simulate FW using the pattern and mask */
-static void cylpa_run_pf_test(unsigned int pattern, unsigned int mask)
+#if (CY_PF_OL_POLICY != 0)
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_policy_remove
+ ****************************************************************************//**
+ *
+ * Remove the filters of the sleep policy; its flows are kept.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_policy_remove(pf_ol_t *ctxt)
 {
-    int i;
-    if (!pattern)
+    cy_pf_ol_filter_t *f;
+
+    for (f = ctxt->policy.filters; f < &ctxt->policy.filters[ctxt->policy.count]; f++)
     {
-        return;
+        cylpa_pf_ol_remove_filter(ctxt, f->id);
+    }
+    ctxt->policy.count = 0;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_policy_stage
+ ****************************************************************************//**
+ *
+ * Compile a sleep policy into pf_ol_t::policy.staged and give its filters ids
+ * no other filter has. The caller clears pf_ol_t::policy.staged_count once the
+ * filters are installed or dropped.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param flows
+ * Flows allowed asleep.
+ *
+ * \param count
+ * Entries in flows.
+ *
+ * \param report
+ * Result, cleared; the slots the policy takes are set.
+ *
+ * \return
+ * RESULT_OK, RESULT_BADARGS, or RESULT_ERROR if the policy does not fit
+ *
+ ********************************************************************************/
+static int cylpa_pf_ol_policy_stage(pf_ol_t *ctxt, const cy_pf_ol_flow_t *flows, uint32_t count,
+                                    cy_pf_ol_policy_report_t *report)
+{
+    cy_pf_ol_policy_t *pl = &ctxt->policy;
+    cy_pf_ol_program_t *prog = &ctxt->scratch;
+    uint32_t i;
+
+    memset(report, 0, sizeof(*report) );
+    pl->staged_count = 0;
+    if (cylpa_pf_ol_policy_build(flows, count, pl->entries) != RESULT_OK)
+    {
+        return RESULT_BADARGS;
+    }
+    if (cylpa_pf_ol_compile(pl->entries, prog) != RESULT_OK)
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: some flows do not fit in a filter\n", __func__);
+        return RESULT_ERROR;
+    }
+    report->slots = prog->count;
+    if (prog->count > CY_PF_OL_POLICY_MAX_SLOTS)
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: %lu flows take %u filters, %u allowed\n", __func__, (unsigned long)count,
+                  prog->count, CY_PF_OL_POLICY_MAX_SLOTS);
+        return RESULT_ERROR;
+    }
+
+    for (i = 0; i < prog->count; i++)
+    {
+        pl->staged[i] = prog->filters[i];
+        if (!cylpa_pf_ol_spare_id(ctxt, &pl->staged[i].id) )
+        {
+            return RESULT_ERROR;
+        }
+        pl->staged_count = (uint8_t)(i + 1);
+    }
+    return RESULT_OK;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_policy_view_add
+ ****************************************************************************//**
+ *
+ * Add the filters of a source to the view of the policy verifier.
+ *
+ * \param view
+ * The view \ref cylpa_pf_policy_view_t.
+ *
+ * \param filters
+ * Filters of the source.
+ *
+ * \param count
+ * Entries in filters.
+ *
+ ********************************************************************************/
+static void cylpa_pf_ol_policy_view_add(cylpa_pf_policy_view_t *view, const cy_pf_ol_filter_t *filters,
+                                        uint32_t count)
+{
+    if ( (count != 0) && (view->sets < CYLPA_PF_POLICY_MAX_SETS) )
+    {
+        view->filters[view->sets] = filters;
+        view->counts[view->sets++] = count;
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_policy_check
+ ****************************************************************************//**
+ *
+ * Check a sleep policy against every filter the firmware would hold asleep:
+ * configured, preset and rule filters, the sleep rules still pending, and the
+ * policy's own. Mismatches are logged.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \param flows
+ * Flows allowed asleep.
+ *
+ * \param count
+ * Entries in flows.
+ *
+ * \param filters
+ * Keep filters of the policy.
+ *
+ * \param filter_count
+ * Entries in filters.
+ *
+ * \param adapt
+ * Include the adaptive filters; a new policy drops them.
+ *
+ * \param report
+ * Result.
+ *
+ * \return
+ * RESULT_OK, or RESULT_ERROR on a mismatch
+ *
+ ********************************************************************************/
+static int cylpa_pf_ol_policy_check(pf_ol_t *ctxt, const cy_pf_ol_flow_t *flows, uint32_t count,
+                                    const cy_pf_ol_filter_t *filters, uint32_t filter_count, bool adapt,
+                                    cy_pf_ol_policy_report_t *report)
+{
+    cylpa_pf_policy_view_t view;
+#if (CY_PF_OL_RULES != 0)
+    cy_pf_ol_cfg_t *pending = ctxt->policy.pending;
+    const cy_pf_ol_rule_t *r;
+    uint32_t n = 0;
+#endif
+    uint32_t i;
+    int result;
+
+    memset(&view, 0, sizeof(view) );
+    cylpa_pf_ol_policy_view_add(&view, ctxt->prog.filters, ctxt->prog.count);
+#if (CY_PF_OL_PRESETS != 0)
+    cylpa_pf_ol_policy_view_add(&view, ctxt->presets.filters, ctxt->presets.count);
+#endif
+#if (CY_PF_OL_RULES != 0)
+    cylpa_pf_ol_policy_view_add(&view, ctxt->rules.filters, ctxt->rules.count);
+
+    /* Sleep rules not added yet are at the next sleep */
+    for (r = ctxt->rules.rules; r < &ctxt->rules.rules[CY_PF_OL_MAX_RULES]; r++)
+    {
+        if (r->in_use && r->pending && (r->cfg.bits & CY_PF_ACTIVE_SLEEP) )
+        {
+            pending[n++] = r->cfg;
+        }
+    }
+    memset(&pending[n], 0, sizeof(pending[n]) );
+    pending[n].feature = CY_PF_OL_FEAT_LAST;
+    if ( (n != 0) && (cylpa_pf_ol_compile(pending, &ctxt->scratch) == RESULT_OK) )
+    {
+        cylpa_pf_ol_policy_view_add(&view, ctxt->scratch.filters, ctxt->scratch.count);
+    }
+#endif
+
+#if (CY_PF_OL_ADAPT != 0)
+    if (adapt)
+    {
+        cylpa_pf_ol_policy_view_add(&view, ctxt->adapt.filters, ctxt->adapt.filter_count);
+    }
+#else
+    (void)adapt;
+#endif
+    cylpa_pf_ol_policy_view_add(&view, filters, filter_count);
+
+    result = cylpa_pf_policy_verify(flows, count, &view, report);
+    OL_LOG_PF( (result == RESULT_OK) ? LOG_OLA_LVL_INFO : LOG_OLA_LVL_ERR, "%s: %lu flows, %u filters, %lu probes, "
+               "%lu mismatches\n", __func__, (unsigned long)count, report->slots, (unsigned long)report->probes,
+               (unsigned long)report->mismatches);
+    for (i = 0; i < report->count; i++)
+    {
+        OL_LOG_PF(LOG_OLA_LVL_ERR, "%s: 0x%04x/%u/%u %s, filter %d\n", __func__, report->errors[i].cls.eth_type,
+                  report->errors[i].cls.ip_type, report->errors[i].cls.port,
+                  report->errors[i].allowed ? "allowed but dropped" : "denied but wakes", report->errors[i].filter_id);
+    }
+    return result;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_policy_install
+ ****************************************************************************//**
+ *
+ * Add the staged filters of a sleep policy, disabled; they are enabled with
+ * the other sleep filters. Nothing is left in the firmware if some filter does
+ * not fit.
+ *
+ * \param ctxt
+ * The pointer to the pf_ol_t structure.
+ *
+ * \return
+ * RESULT_OK, or RESULT_ERROR
+ *
+ ********************************************************************************/
+static int cylpa_pf_ol_policy_install(pf_ol_t *ctxt)
+{
+    cy_pf_ol_policy_t *pl = &ctxt->policy;
+    uint32_t i;
+
+    for (i = 0; i < pl->staged_count; i++)
+    {
+        pl->filters[pl->count] = pl->staged[i];
+        if (cylpa_pf_ol_add_filter(ctxt, &pl->filters[pl->count]) != RESULT_OK)
+        {
+            cylpa_pf_ol_policy_remove(ctxt);
+            return RESULT_ERROR;
+        }
+        pl->count++;
+    }
+    return RESULT_OK;
+}
+#endif /* CY_PF_OL_POLICY */
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_policy_verify
+ ****************************************************************************//**
+ *
+ * Check a sleep policy without applying it.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param flows
+ * Flows allowed asleep; NULL checks the policy in use.
+ *
+ * \param count
+ * Entries in flows.
+ *
+ * \param report
+ * Result, may be NULL.
+ *
+ * \return
+ * RESULT_OK, RESULT_BADARGS, or RESULT_ERROR
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_policy_verify(olm_t *olm, const cy_pf_ol_flow_t *flows, uint32_t count,
+                              cy_pf_ol_policy_report_t *report)
+{
+#if (CY_PF_OL_POLICY != 0)
+    cy_pf_ol_policy_report_t local;
+    pf_ol_t *ctxt;
+    int result;
+
+    report = (report != NULL) ? report : &local;
+    memset(report, 0, sizeof(*report) );
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if (ctxt == NULL)
+    {
+        cylpa_olm_reg_unlock();
+        return RESULT_BADARGS;
     }
+    cylpa_pf_ol_rules_lock();
 
-    for (i = 0; i < 65000; i++)
+#if (CY_PF_OL_SOCK != 0)
+    if (ctxt->sock.on || ( (flows == NULL) && (ctxt->policy.flow_count == 0) ) )
+#else
+    if ( (flows == NULL) && (ctxt->policy.flow_count == 0) )
+#endif
+    {
+        result = RESULT_BADARGS;
+    }
+    else if (flows == NULL)
     {
-        if ( (i & mask) == pattern )
+        report->slots = ctxt->policy.count;
+        result = cylpa_pf_ol_policy_check(ctxt, ctxt->policy.flows, ctxt->policy.flow_count, ctxt->policy.filters,
+                                          ctxt->policy.count, true, report);
+    }
+    else
+    {
+        result = cylpa_pf_ol_policy_stage(ctxt, flows, count, report);
+        if (result == RESULT_OK)
         {
-            OL_LOG_PF(LOG_OLA_LVL_INFO, "%d\n", i);
+            result = cylpa_pf_ol_policy_check(ctxt, flows, count, ctxt->policy.staged,
+                                              ctxt->policy.staged_count, false, report);
         }
+        ctxt->policy.staged_count = 0;
     }
+
+    cylpa_pf_ol_rules_unlock();
+    cylpa_olm_reg_unlock();
+    return result;
+#else
+    (void)olm;
+    (void)flows;
+    (void)count;
+    (void)report;
+    return RESULT_UNSUPPORTED;
+#endif
 }
 
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_policy
+ ****************************************************************************//**
+ *
+ * Check a sleep policy and apply it if it passes.
+ *
+ * \param olm
+ * The pointer to the olm structure \ref olm_t.
+ *
+ * \param flows
+ * Flows allowed asleep; NULL removes the policy.
+ *
+ * \param count
+ * Entries in flows.
+ *
+ * \param report
+ * Result of the check, may be NULL.
+ *
+ * \return
+ * RESULT_OK, RESULT_BADARGS, or RESULT_ERROR
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_policy(olm_t *olm, const cy_pf_ol_flow_t *flows, uint32_t count, cy_pf_ol_policy_report_t *report)
+{
+#if (CY_PF_OL_POLICY != 0)
+    cy_pf_ol_policy_report_t local;
+    pf_ol_t *ctxt;
+    int result;
+
+    report = (report != NULL) ? report : &local;
+    memset(report, 0, sizeof(*report) );
+
+    cylpa_olm_reg_lock();
+    ctxt = cylpa_pf_ol_find(olm);
+    if (ctxt == NULL)
+    {
+        cylpa_olm_reg_unlock();
+        return RESULT_BADARGS;
+    }
+    cylpa_pf_ol_rules_lock();
+
+    if (flows == NULL)
+    {
+        cylpa_pf_ol_policy_remove(ctxt);
+        memset(&ctxt->policy, 0, sizeof(ctxt->policy) );
+        result = RESULT_OK;
+    }
+#if (CY_PF_OL_SOCK != 0)
+    else if (ctxt->sock.on)
+    {
+        result = RESULT_BADARGS;
+    }
+#endif
+    else
+    {
+        result = cylpa_pf_ol_policy_stage(ctxt, flows, count, report);
+        if (result == RESULT_OK)
+        {
+            result = cylpa_pf_ol_policy_check(ctxt, flows, count, ctxt->policy.staged,
+                                              ctxt->policy.staged_count, false, report);
+        }
+        if (result == RESULT_OK)
+        {
+#if (CY_PF_OL_ADAPT != 0)
+            /* They come back as their classes score again, never for an allowed flow */
+            cylpa_pf_ol_adapt_expire(ctxt, 0, true);
+#endif
+            cylpa_pf_ol_policy_remove(ctxt);
+            memcpy(ctxt->policy.flows, flows, count * sizeof(flows[0]) );
+            ctxt->policy.flow_count = (uint8_t)count;
+            result = cylpa_pf_ol_policy_install(ctxt);
+            if (result != RESULT_OK)
+            {
+                ctxt->policy.flow_count = 0;
+            }
+        }
+        ctxt->policy.staged_count = 0;
+    }
+
+    cylpa_pf_ol_rules_unlock();
+    cylpa_olm_reg_unlock();
+    return result;
+#else
+    (void)olm;
+    (void)flows;
+    (void)count;
+    (void)report;
+    return RESULT_UNSUPPORTED;
 #endif
+}
 
-/* Bug in FW? doesn't allow us to retrieve filter patterns after enabling.
- * dump_patterns controls this.
- */
-static int cylpa_dump_filters_stats(whd_t *whd, cy_pf_ol_cfg_t *base_pf_cfg)
+/* Log the last snapshot */
+static void cylpa_dump_filters_stats(const pf_ol_t *ctxt)
 {
-    cy_pf_ol_cfg_t *pf_cfg;
+    const cy_pf_ol_stats_t *st;
     OL_LOG_PF(LOG_OLA_LVL_ERR, "\n");
     OL_LOG_PF(LOG_OLA_LVL_ERR, "               \t Total    Total\n");
     OL_LOG_PF(LOG_OLA_LVL_ERR, "ID:   Matched  \tSent Up  Dropped\n");
 
-    for (pf_cfg = base_pf_cfg; pf_cfg->feature != CY_PF_OL_FEAT_LAST; pf_cfg++)
+    for (st = ctxt->stats; st < &ctxt->stats[ctxt->prog.count]; st++)
     {
-        cylpa_print_packet_filter_stats(whd, pf_cfg->id);
+        OL_LOG_PF(LOG_OLA_LVL_ERR, " %u:   %u \t%u \t%u\n",
+                  (unsigned int)st->filter_id, (unsigned int)st->matched,
+                  (unsigned int)st->forwarded, (unsigned int)st->discarded);
     }
-    return 0;
 }
 
 #ifdef DEBUG
@@ -746,26 +3249,6 @@ static void cylpa_print_pat_and_mask(uint8_t id, int mask_len, uint8_t *mask, ui
 
 #endif /* DEBUG */
 
-/* Query and print stats from each filter */
-static int cylpa_print_packet_filter_stats(whd_t *whd, uint8_t filter_id)
-{
-    whd_result_t status;
-    wl_pkt_filter_stats_t stats;
-
-    status = whd_pf_get_packet_filter_stats(whd, filter_id, &stats);
-    if (status != WHD_SUCCESS)
-    {
-        OL_LOG_PF(LOG_OLA_LVL_ERR, "Failure Getting Packet Filter Statistics 0x%x\n", status);
-        return status;
-    }
-
-    OL_LOG_PF(LOG_OLA_LVL_ERR, " %u:   %u \t%u \t%u\n",
-              (unsigned int)filter_id, (unsigned int)stats.num_pkts_matched,
-              (unsigned int)stats.num_pkts_forwarded, (unsigned int)stats.num_pkts_discarded);
-
-    return status;
-}
-
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,623 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ *
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+
+/**
+* @file cy_lpa_wifi_pf_policy.c
+* @brief Default-deny sleep policy.
+*
+* Turns a list of allowed flows into sleep keep entries, and checks the filters
+* the firmware would hold asleep against the flows before the packet filter
+* offload applies them; see cylpa_pf_ol_policy().
+*
+* The check is differential. Probe frames are built for the edges of every
+* flow, for every filter active asleep and for common traffic. Each one is
+* classified and looked up in the flows, the reference, and run through a model
+* of the firmware: a frame is dropped if an active discard filter matches it,
+* else forwarded if no keep filter is active or one matches it. Any probe the
+* two disagree on is a mismatch. IPv4 frames with options or that are not a
+* first fragment are not probed: the firmware filters match fixed offsets, so
+* a port filter cannot tell where their ports are.
+*
+* Like the compiler, this calls no WHD or RTOS function.
+*/
+
+#include <string.h>
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_ol_common.h"
+#include "cy_lpa_wifi_ol_priv.h"
+#include "cy_lpa_wifi_pf_ol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* Local definition
+*******************************************************************************/
+#define PF_OFFSET_ETHTYPE           (12)        /* Ethernet header: EtherType */
+#define PF_OFFSET_IP                (14)        /* IP header, no VLAN tag */
+#define PF_IPV4_HDR_LEN             (20)        /* IPv4 header without options */
+#define PF_IPV6_HDR_LEN             (40)        /* IPv6 header */
+
+#define PF_ETHTYPE_IPV4             (0x0800)
+#define PF_ETHTYPE_IPV6             (0x86DD)
+#define PF_IP_PROTO_ICMP            (1)
+#define PF_IP_PROTO_TCP             (6)
+#define PF_IP_PROTO_UDP             (17)
+#define PF_IP_PROTO_ICMPV6          (58)
+
+#define PF_POLICY_FRAME_LEN         (128)       /* Bytes of a probe frame; filters past it are not probed */
+#define PF_POLICY_PORT_ANY          (9)         /* Port of a probe whose flow names none (discard) */
+
+/* A probe run and its outcome */
+typedef struct
+{
+    const cy_pf_ol_flow_t *flows;
+    uint32_t count;
+    const cylpa_pf_policy_view_t *view;
+    cy_pf_ol_policy_report_t *report;
+    uint8_t frame[PF_POLICY_FRAME_LEN];
+} cylpa_pf_policy_run_t;
+
+/* Traffic every network carries, probed whatever the flows */
+static const cy_pf_ol_class_t cylpa_pf_policy_common[] =
+{
+    { 0x0806, 0, 0 },                                       /* ARP */
+    { 0x888E, 0, 0 },                                       /* EAPOL */
+    { PF_ETHTYPE_IPV4, PF_IP_PROTO_ICMP, 0 },
+    { PF_ETHTYPE_IPV4, PF_IP_PROTO_UDP, 68 },               /* DHCP client */
+    { PF_ETHTYPE_IPV4, PF_IP_PROTO_UDP, 5353 },             /* mDNS */
+    { PF_ETHTYPE_IPV4, PF_IP_PROTO_UDP, 1900 },             /* SSDP */
+    { PF_ETHTYPE_IPV4, PF_IP_PROTO_TCP, 80 },
+    { PF_ETHTYPE_IPV4, PF_IP_PROTO_TCP, 443 },
+    { PF_ETHTYPE_IPV6, PF_IP_PROTO_ICMPV6, 0 },
+    { PF_ETHTYPE_IPV6, PF_IP_PROTO_UDP, 5353 },
+    { PF_ETHTYPE_IPV6, PF_IP_PROTO_TCP, 443 },
+};
+
+/* Frames the filters active asleep are laid over */
+static const cy_pf_ol_class_t cylpa_pf_policy_templates[] =
+{
+    { PF_ETHTYPE_IPV4, PF_IP_PROTO_UDP, PF_POLICY_PORT_ANY },
+    { PF_ETHTYPE_IPV4, PF_IP_PROTO_TCP, PF_POLICY_PORT_ANY },
+    { PF_ETHTYPE_IPV6, PF_IP_PROTO_UDP, PF_POLICY_PORT_ANY },
+    { 0x0806, 0, 0 },
+};
+
+/*******************************************************************************
+* Function Prototypes
+*******************************************************************************/
+static void cylpa_pf_put16(uint8_t *p, uint16_t v);
+static bool cylpa_pf_policy_allows(const cy_pf_ol_flow_t *flows, uint32_t count, const cy_pf_ol_class_t *cls);
+static void cylpa_pf_policy_frame(const cy_pf_ol_class_t *cls, uint8_t *frame);
+static bool cylpa_pf_policy_match(const cy_pf_ol_filter_t *f, const uint8_t *frame);
+static bool cylpa_pf_policy_forwards(const cylpa_pf_policy_view_t *view, const uint8_t *frame, int16_t *filter_id);
+static void cylpa_pf_policy_probe(cylpa_pf_policy_run_t *run);
+static void cylpa_pf_policy_probe_class(cylpa_pf_policy_run_t *run, uint16_t eth_type, uint8_t ip_type, uint16_t port);
+static void cylpa_pf_policy_probe_flow(cylpa_pf_policy_run_t *run, const cy_pf_ol_flow_t *fl);
+
+/* Network order */
+static void cylpa_pf_put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_policy_build
+ ****************************************************************************//**
+ *
+ * Build the configuration entries of a default-deny sleep policy.
+ *
+ * \param flows
+ * Flows allowed asleep.
+ *
+ * \param count
+ * Entries in flows.
+ *
+ * \param cfg
+ * count + 1 entries, terminated by CY_PF_OL_FEAT_LAST.
+ *
+ * \return
+ * RESULT_OK, or RESULT_BADARGS
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_policy_build(const cy_pf_ol_flow_t *flows, uint32_t count, cy_pf_ol_cfg_t *cfg)
+{
+    const cy_pf_ol_flow_t *fl;
+    cy_pf_ol_cfg_t *entry;
+    bool ip;
+    bool ports;
+    uint32_t i;
+
+    if ( (flows == NULL) || (cfg == NULL) || (count == 0) || (count > CY_PF_OL_POLICY_MAX_FLOWS) )
+    {
+        return RESULT_BADARGS;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        fl = &flows[i];
+        entry = &cfg[i];
+        ip = (fl->eth_type == 0) || (fl->eth_type == PF_ETHTYPE_IPV4) || (fl->eth_type == PF_ETHTYPE_IPV6);
+        ports = (fl->ip_type == PF_IP_PROTO_TCP) || (fl->ip_type == PF_IP_PROTO_UDP);
+
+        if ( (!ip && ( (fl->ip_type != 0) || (fl->port != 0) ) ) ||
+             ( (fl->port != 0) && !ports ) || ( (fl->port_end != 0) && (fl->port_end < fl->port) ) ||
+             ( (fl->port == 0) && (fl->port_end != 0) ) )
+        {
+            return RESULT_BADARGS;
+        }
+        /* Would let all IP traffic through; not a policy */
+        if ( (fl->eth_type == 0) && (fl->ip_type == 0) )
+        {
+            return RESULT_BADARGS;
+        }
+
+        memset(entry, 0, sizeof(*entry) );
+        entry->id = (uint8_t)i;
+        entry->bits = CY_PF_ACTIVE_SLEEP;
+        if (fl->eth_type == 0)
+        {
+            entry->bits |= CY_PF_IPV4_IPV6;
+        }
+        else if (fl->eth_type == PF_ETHTYPE_IPV6)
+        {
+            entry->bits |= CY_PF_IPV6;
+        }
+
+        if (fl->port != 0)
+        {
+            entry->feature = CY_PF_OL_FEAT_PORTNUM;
+            entry->u.pf.portnum.portnum = fl->port;
+            entry->u.pf.portnum.range = (fl->port_end != 0) ? (uint16_t)(fl->port_end - fl->port) : 0;
+            entry->u.pf.portnum.direction = PF_PN_PORT_DEST;
+            entry->u.pf.proto = (fl->ip_type == PF_IP_PROTO_TCP) ? CY_PF_PROTOCOL_TCP : CY_PF_PROTOCOL_UDP;
+        }
+        else if (fl->ip_type != 0)
+        {
+            entry->feature = CY_PF_OL_FEAT_IPTYPE;
+            entry->u.ip.ip_type = fl->ip_type;
+        }
+        else
+        {
+            entry->feature = CY_PF_OL_FEAT_ETHTYPE;
+            entry->u.eth.eth_type = fl->eth_type;
+        }
+    }
+
+    memset(&cfg[count], 0, sizeof(cfg[count]) );
+    cfg[count].feature = CY_PF_OL_FEAT_LAST;
+    return RESULT_OK;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_policy_allows
+ ****************************************************************************//**
+ *
+ * The reference: whether some flow lets a class of frame through.
+ *
+ * \param flows
+ * Flows allowed asleep.
+ *
+ * \param count
+ * Entries in flows.
+ *
+ * \param cls
+ * The class, see \ref cylpa_pf_ol_classify.
+ *
+ * \return
+ * true if the frame may wake the host
+ *
+ ********************************************************************************/
+static bool cylpa_pf_policy_allows(const cy_pf_ol_flow_t *flows, uint32_t count, const cy_pf_ol_class_t *cls)
+{
+    bool ip = (cls->eth_type == PF_ETHTYPE_IPV4) || (cls->eth_type == PF_ETHTYPE_IPV6);
+    const cy_pf_ol_flow_t *fl;
+    uint16_t end;
+
+    for (fl = flows; fl < &flows[count]; fl++)
+    {
+        end = (fl->port_end != 0) ? fl->port_end : fl->port;
+        if ( ( (fl->eth_type != 0) ? (fl->eth_type == cls->eth_type) : ip ) &&
+             ( (fl->ip_type == 0) || (fl->ip_type == cls->ip_type) ) &&
+             ( (fl->port == 0) || ( (cls->port >= fl->port) && (cls->port <= end) ) ) )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_policy_frame
+ ****************************************************************************//**
+ *
+ * Build a unicast probe frame of a class: an IPv4 header without options or an
+ * IPv6 header, then the TCP or UDP header, padded to PF_POLICY_FRAME_LEN.
+ *
+ * \param cls
+ * The class.
+ *
+ * \param frame
+ * PF_POLICY_FRAME_LEN bytes.
+ *
+ ********************************************************************************/
+static void cylpa_pf_policy_frame(const cy_pf_ol_class_t *cls, uint8_t *frame)
+{
+    static const uint8_t dst[] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+    static const uint8_t src[] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 };
+    uint8_t *ip = frame + PF_OFFSET_IP;
+    uint8_t *l4 = NULL;
+
+    memset(frame, 0, PF_POLICY_FRAME_LEN);
+    memcpy(frame, dst, sizeof(dst) );
+    memcpy(frame + sizeof(dst), src, sizeof(src) );
+    cylpa_pf_put16(frame + PF_OFFSET_ETHTYPE, cls->eth_type);
+
+    if (cls->eth_type == PF_ETHTYPE_IPV4)
+    {
+        ip[0] = 0x45;
+        cylpa_pf_put16(ip + 2, PF_POLICY_FRAME_LEN - PF_OFFSET_IP);
+        cylpa_pf_put16(ip + 6, 0x4000);                     /* Don't fragment */
+        ip[8] = 64;
+        ip[9] = cls->ip_type;
+        ip[12] = 192; ip[13] = 168; ip[14] = 1; ip[15] = 2;
+        ip[16] = 192; ip[17] = 168; ip[18] = 1; ip[19] = 10;
+        l4 = ip + PF_IPV4_HDR_LEN;
+    }
+    else if (cls->eth_type == PF_ETHTYPE_IPV6)
+    {
+        ip[0] = 0x60;
+        cylpa_pf_put16(ip + 4, PF_POLICY_FRAME_LEN - PF_OFFSET_IP - PF_IPV6_HDR_LEN);
+        ip[6] = cls->ip_type;
+        ip[7] = 64;
+        ip[8] = 0xfe; ip[9] = 0x80; ip[23] = 2;
+        ip[24] = 0xfe; ip[25] = 0x80; ip[39] = 10;
+        l4 = ip + PF_IPV6_HDR_LEN;
+    }
+
+    if ( (l4 != NULL) && ( (cls->ip_type == PF_IP_PROTO_TCP) || (cls->ip_type == PF_IP_PROTO_UDP) ) )
+    {
+        cylpa_pf_put16(l4, 49152);
+        cylpa_pf_put16(l4 + 2, cls->port);
+        if (cls->ip_type == PF_IP_PROTO_TCP)
+        {
+            l4[12] = 0x50;
+            l4[13] = 0x02;                                  /* SYN */
+        }
+        else
+        {
+            cylpa_pf_put16(l4 + 4, (uint16_t)(frame + PF_POLICY_FRAME_LEN - l4) );
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_policy_match
+ ****************************************************************************//**
+ *
+ * Match a firmware filter against a probe frame.
+ *
+ * \param f
+ * The filter \ref cy_pf_ol_filter_t.
+ *
+ * \param frame
+ * PF_POLICY_FRAME_LEN bytes.
+ *
+ * \return
+ * true if the filter matches the frame
+ *
+ ********************************************************************************/
+static bool cylpa_pf_policy_match(const cy_pf_ol_filter_t *f, const uint8_t *frame)
+{
+    uint32_t i;
+
+    if ( (uint32_t)f->offset + f->len > PF_POLICY_FRAME_LEN )
+    {
+        return false;
+    }
+    for (i = 0; i < f->len; i++)
+    {
+        if ( (frame[f->offset + i] ^ f->pattern[i]) & f->mask[i] )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_policy_forwards
+ ****************************************************************************//**
+ *
+ * The model of the firmware: whether the filters active asleep let a frame
+ * through.
+ *
+ * \param view
+ * The filters \ref cylpa_pf_policy_view_t.
+ *
+ * \param frame
+ * PF_POLICY_FRAME_LEN bytes.
+ *
+ * \param filter_id
+ * The discard filter that drops the frame or the keep filter that lets it
+ * through, -1 for none.
+ *
+ * \return
+ * true if the frame wakes the host
+ *
+ ********************************************************************************/
+static bool cylpa_pf_policy_forwards(const cylpa_pf_policy_view_t *view, const uint8_t *frame, int16_t *filter_id)
+{
+    const cy_pf_ol_filter_t *f;
+    int16_t dropped = -1;
+    int16_t kept = -1;
+    bool keeping = false;
+    uint32_t s;
+
+    for (s = 0; s < view->sets; s++)
+    {
+        for (f = view->filters[s]; f < &view->filters[s][view->counts[s]]; f++)
+        {
+            if ( (f->bits & CY_PF_ACTIVE_SLEEP) == 0 )
+            {
+                continue;
+            }
+            keeping = keeping || ( (f->bits & CY_PF_ACTION_DISCARD) == 0 );
+            if (!cylpa_pf_policy_match(f, frame) )
+            {
+                continue;
+            }
+            if (f->bits & CY_PF_ACTION_DISCARD)
+            {
+                dropped = (dropped < 0) ? f->id : dropped;
+            }
+            else
+            {
+                kept = (kept < 0) ? f->id : kept;
+            }
+        }
+    }
+
+    *filter_id = (dropped >= 0) ? dropped : kept;
+    return (dropped < 0) && (!keeping || (kept >= 0) );
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_policy_probe
+ ****************************************************************************//**
+ *
+ * Check the frame of a run against the reference and the model, unless it is
+ * an IPv4 frame with options or not a first fragment.
+ *
+ * \param run
+ * The run; run->frame holds the probe.
+ *
+ ********************************************************************************/
+static void cylpa_pf_policy_probe(cylpa_pf_policy_run_t *run)
+{
+    cy_pf_ol_policy_report_t *rp = run->report;
+    cy_pf_ol_policy_error_t *err;
+    const uint8_t *ip = run->frame + PF_OFFSET_IP;
+    cy_pf_ol_class_t cls;
+    int16_t filter_id;
+    bool allowed;
+
+    cylpa_pf_ol_classify(run->frame, PF_POLICY_FRAME_LEN, &cls);
+    if ( (cls.eth_type == PF_ETHTYPE_IPV4) && ( (ip[0] != 0x45) || ( ( ( (ip[6] << 8) | ip[7] ) & 0x1fff ) != 0 ) ) )
+    {
+        return;
+    }
+    allowed = cylpa_pf_policy_allows(run->flows, run->count, &cls);
+    rp->probes++;
+    if (cylpa_pf_policy_forwards(run->view, run->frame, &filter_id) == allowed)
+    {
+        return;
+    }
+
+    rp->mismatches++;
+
+    /* Report each class once */
+    for (err = rp->errors; err < &rp->errors[rp->count]; err++)
+    {
+        if ( (err->cls.eth_type == cls.eth_type) && (err->cls.ip_type == cls.ip_type) &&
+             (err->cls.port == cls.port) && (err->allowed == allowed) )
+        {
+            return;
+        }
+    }
+    if (rp->count < CY_PF_OL_POLICY_MAX_ERRORS)
+    {
+        err->cls = cls;
+        err->allowed = allowed;
+        err->filter_id = filter_id;
+        rp->count++;
+    }
+}
+
+/* Probe the frame of a class */
+static void cylpa_pf_policy_probe_class(cylpa_pf_policy_run_t *run, uint16_t eth_type, uint8_t ip_type, uint16_t port)
+{
+    cy_pf_ol_class_t cls = { eth_type, ip_type, port };
+
+    cylpa_pf_policy_frame(&cls, run->frame);
+    cylpa_pf_policy_probe(run);
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_policy_probe_flow
+ ****************************************************************************//**
+ *
+ * Probe the edges of a flow in both IP families: its ports, the ports just
+ * outside them and the same ports of the other of TCP and UDP; its protocol; or
+ * its EtherType.
+ *
+ * \param run
+ * The run.
+ *
+ * \param fl
+ * The flow \ref cy_pf_ol_flow_t.
+ *
+ ********************************************************************************/
+static void cylpa_pf_policy_probe_flow(cylpa_pf_policy_run_t *run, const cy_pf_ol_flow_t *fl)
+{
+    static const uint16_t families[] = { PF_ETHTYPE_IPV4, PF_ETHTYPE_IPV6 };
+    uint16_t end = (fl->port_end != 0) ? fl->port_end : fl->port;
+    uint16_t ports[5];
+    uint8_t other;
+    uint32_t n = 0;
+    uint32_t i, j;
+
+    if ( (fl->eth_type != 0) && (fl->eth_type != PF_ETHTYPE_IPV4) && (fl->eth_type != PF_ETHTYPE_IPV6) )
+    {
+        cylpa_pf_policy_probe_class(run, fl->eth_type, 0, 0);
+        return;
+    }
+
+    if (fl->port != 0)
+    {
+        ports[n++] = fl->port;
+        ports[n++] = end;
+        ports[n++] = (uint16_t)(fl->port + (end - fl->port) / 2);
+        if (fl->port > 1)
+        {
+            ports[n++] = (uint16_t)(fl->port - 1);
+        }
+        if (end < 0xffff)
+        {
+            ports[n++] = (uint16_t)(end + 1);
+        }
+    }
+    else
+    {
+        ports[n++] = PF_POLICY_PORT_ANY;
+    }
+    other = (fl->ip_type == PF_IP_PROTO_TCP) ? PF_IP_PROTO_UDP : PF_IP_PROTO_TCP;
+
+    for (i = 0; i < sizeof(families) / sizeof(families[0]); i++)
+    {
+        if ( (fl->ip_type != PF_IP_PROTO_TCP) && (fl->ip_type != PF_IP_PROTO_UDP) )
+        {
+            cylpa_pf_policy_probe_class(run, families[i], fl->ip_type, 0);
+        }
+        for (j = 0; j < n; j++)
+        {
+            if ( (fl->ip_type == PF_IP_PROTO_TCP) || (fl->ip_type == PF_IP_PROTO_UDP) || (fl->ip_type == 0) )
+            {
+                cylpa_pf_policy_probe_class(run, families[i], (fl->ip_type != 0) ? fl->ip_type : PF_IP_PROTO_UDP,
+                                            ports[j]);
+            }
+            cylpa_pf_policy_probe_class(run, families[i], other, ports[j]);
+        }
+    }
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_policy_verify
+ ****************************************************************************//**
+ *
+ * Check the filters active asleep against the flows of a sleep policy.
+ *
+ * \param flows
+ * Flows allowed asleep.
+ *
+ * \param count
+ * Entries in flows.
+ *
+ * \param view
+ * The filters the firmware would hold asleep \ref cylpa_pf_policy_view_t.
+ *
+ * \param report
+ * Result; probes and mismatches are added to, the errors filled in after those
+ * already there.
+ *
+ * \return
+ * RESULT_OK, RESULT_BADARGS, or RESULT_ERROR on a mismatch
+ *
+ ********************************************************************************/
+int cylpa_pf_policy_verify(const cy_pf_ol_flow_t *flows, uint32_t count, const cylpa_pf_policy_view_t *view,
+                           cy_pf_ol_policy_report_t *report)
+{
+    /* Off the stack; the offload serializes the calls */
+    static cylpa_pf_policy_run_t run;
+    const cy_pf_ol_filter_t *f;
+    uint32_t mismatches;
+    uint32_t i, s, b;
+
+    if ( (flows == NULL) || (view == NULL) || (report == NULL) || (view->sets > CYLPA_PF_POLICY_MAX_SETS) )
+    {
+        return RESULT_BADARGS;
+    }
+    mismatches = report->mismatches;
+    run.flows = flows;
+    run.count = count;
+    run.view = view;
+    run.report = report;
+
+    for (i = 0; i < count; i++)
+    {
+        cylpa_pf_policy_probe_flow(&run, &flows[i]);
+    }
+    for (i = 0; i < sizeof(cylpa_pf_policy_common) / sizeof(cylpa_pf_policy_common[0]); i++)
+    {
+        cylpa_pf_policy_probe_class(&run, cylpa_pf_policy_common[i].eth_type, cylpa_pf_policy_common[i].ip_type,
+                                    cylpa_pf_policy_common[i].port);
+    }
+
+    /* Frames each filter matches, whatever the flows: a keep filter wider than its flow shows up here */
+    for (s = 0; s < view->sets; s++)
+    {
+        for (f = view->filters[s]; f < &view->filters[s][view->counts[s]]; f++)
+        {
+            if ( ( (f->bits & CY_PF_ACTIVE_SLEEP) == 0 ) || ( (uint32_t)f->offset + f->len > PF_POLICY_FRAME_LEN ) )
+            {
+                continue;
+            }
+            for (i = 0; i < sizeof(cylpa_pf_policy_templates) / sizeof(cylpa_pf_policy_templates[0]); i++)
+            {
+                cylpa_pf_policy_frame(&cylpa_pf_policy_templates[i], run.frame);
+                for (b = 0; b < f->len; b++)
+                {
+                    run.frame[f->offset + b] = (uint8_t)( (run.frame[f->offset + b] & ~f->mask[b]) |
+                                                          (f->pattern[b] & f->mask[b]) );
+                }
+                cylpa_pf_policy_probe(&run);
+            }
+        }
+    }
+
+    return (report->mismatches == mismatches) ? RESULT_OK : RESULT_ERROR;
+}
+
+#ifdef __cplusplus
+}
+#endif
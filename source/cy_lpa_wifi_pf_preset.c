@@ -0,0 +1,237 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ *
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+
+/**
+* @file cy_lpa_wifi_pf_preset.c
+* @brief Packet filter presets.
+*
+* Ready-made discard filters for the protocol noise most networks carry. Each
+* preset is a configuration of its own; the packet filter offload compiles and
+* adds it on top of the configured filters when enabled by name, see
+* cylpa_pf_ol_preset_enable().
+*
+* A preset's version changes whenever the traffic it matches changes, and
+* CY_PF_OL_PRESETS_VERSION whenever a preset is added or changed.
+*/
+
+#include <string.h>
+#include "cy_lpa_wifi_result.h"
+#include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_ol_common.h"
+#include "cy_lpa_wifi_pf_ol.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*******************************************************************************
+* Local definition
+*******************************************************************************/
+#define PF_BITS_ACTIVE              (CY_PF_ACTIVE_SLEEP | CY_PF_ACTIVE_WAKE)
+
+/* Discard UDP to a destination port; family is 0 (IPv4), CY_PF_IPV6 or CY_PF_IPV4_IPV6 */
+#define PF_PRESET_UDP(entry_id, port, family)                                   \
+    { .feature = CY_PF_OL_FEAT_PORTNUM,                                         \
+      .bits = CY_PF_ACTIVE_SLEEP | CY_PF_ACTION_DISCARD | (family),             \
+      .id = (entry_id),                                                         \
+      .u.pf = { .portnum = { (port), 0, PF_PN_PORT_DEST }, .proto = CY_PF_PROTOCOL_UDP } }
+
+#define PF_PRESET_END               { .feature = CY_PF_OL_FEAT_LAST }
+
+#define PF_PORT_NETBIOS_NS          (137)
+#define PF_PORT_NETBIOS_DGM         (138)
+#define PF_PORT_DHCPV6_SERVER       (547)
+#define PF_PORT_SSDP                (1900)
+#define PF_PORT_WSD                 (3702)
+#define PF_PORT_MDNS                (5353)
+#define PF_PORT_LLMNR               (5355)
+
+/* The entries are active asleep; cylpa_pf_ol_preset_compile() sets the activity asked for */
+static const cy_pf_ol_cfg_t cylpa_pf_preset_mdns[] =
+{
+    PF_PRESET_UDP(0, PF_PORT_MDNS, CY_PF_IPV4_IPV6),
+    PF_PRESET_END
+};
+
+static const cy_pf_ol_cfg_t cylpa_pf_preset_ssdp[] =
+{
+    PF_PRESET_UDP(0, PF_PORT_SSDP, CY_PF_IPV4_IPV6),
+    PF_PRESET_END
+};
+
+static const cy_pf_ol_cfg_t cylpa_pf_preset_llmnr[] =
+{
+    PF_PRESET_UDP(0, PF_PORT_LLMNR, CY_PF_IPV4_IPV6),
+    PF_PRESET_END
+};
+
+static const cy_pf_ol_cfg_t cylpa_pf_preset_netbios[] =
+{
+    PF_PRESET_UDP(0, PF_PORT_NETBIOS_NS, 0),
+    PF_PRESET_UDP(1, PF_PORT_NETBIOS_DGM, 0),
+    PF_PRESET_END
+};
+
+static const cy_pf_ol_cfg_t cylpa_pf_preset_dhcpv6[] =
+{
+    PF_PRESET_UDP(0, PF_PORT_DHCPV6_SERVER, CY_PF_IPV6),
+    PF_PRESET_END
+};
+
+static const cy_pf_ol_cfg_t cylpa_pf_preset_wsd[] =
+{
+    PF_PRESET_UDP(0, PF_PORT_WSD, CY_PF_IPV4_IPV6),
+    PF_PRESET_END
+};
+
+static const cy_pf_ol_cfg_t cylpa_pf_preset_noise[] =
+{
+    PF_PRESET_UDP(0, PF_PORT_MDNS, CY_PF_IPV4_IPV6),
+    PF_PRESET_UDP(1, PF_PORT_SSDP, CY_PF_IPV4_IPV6),
+    PF_PRESET_UDP(2, PF_PORT_LLMNR, CY_PF_IPV4_IPV6),
+    PF_PRESET_UDP(3, PF_PORT_NETBIOS_NS, 0),
+    PF_PRESET_UDP(4, PF_PORT_NETBIOS_DGM, 0),
+    PF_PRESET_UDP(5, PF_PORT_DHCPV6_SERVER, CY_PF_IPV6),
+    PF_PRESET_UDP(6, PF_PORT_WSD, CY_PF_IPV4_IPV6),
+    PF_PRESET_END
+};
+
+static const cy_pf_ol_preset_t cylpa_pf_presets[] =
+{
+    { "mdns",    1, "Multicast DNS, UDP 5353",                    cylpa_pf_preset_mdns    },
+    { "ssdp",    1, "SSDP / UPnP discovery, UDP 1900",            cylpa_pf_preset_ssdp    },
+    { "llmnr",   1, "Link-local multicast name resolution, UDP 5355", cylpa_pf_preset_llmnr },
+    { "netbios", 1, "NetBIOS name and datagram services, UDP 137-138", cylpa_pf_preset_netbios },
+    { "dhcpv6",  1, "DHCPv6 to servers and relays, UDP 547",      cylpa_pf_preset_dhcpv6  },
+    { "wsd",     1, "WS-Discovery, UDP 3702",                     cylpa_pf_preset_wsd     },
+    { "noise",   1, "All of the above",                           cylpa_pf_preset_noise   },
+};
+
+#define PF_PRESET_COUNT             (sizeof(cylpa_pf_presets) / sizeof(cylpa_pf_presets[0]) )
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_preset_get
+ ****************************************************************************//**
+ *
+ * Get a preset of the library.
+ *
+ * \param index
+ * Index of the preset.
+ *
+ * \return
+ * The preset, or NULL past the last one
+ *
+ ********************************************************************************/
+const cy_pf_ol_preset_t *cylpa_pf_ol_preset_get(uint32_t index)
+{
+    /* Offloads track presets by index */
+    if ( (index >= PF_PRESET_COUNT) || (index >= CY_PF_OL_MAX_PRESETS) )
+    {
+        return NULL;
+    }
+    return &cylpa_pf_presets[index];
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_preset_find
+ ****************************************************************************//**
+ *
+ * Find a preset by name.
+ *
+ * \param name
+ * Name of the preset.
+ *
+ * \param index
+ * Index of the preset, may be NULL.
+ *
+ * \return
+ * The preset, or NULL if there is none by that name
+ *
+ ********************************************************************************/
+const cy_pf_ol_preset_t *cylpa_pf_ol_preset_find(const char *name, uint32_t *index)
+{
+    const cy_pf_ol_preset_t *preset;
+    uint32_t i;
+
+    for (i = 0; (name != NULL) && ( (preset = cylpa_pf_ol_preset_get(i) ) != NULL ); i++)
+    {
+        if (strcmp(preset->name, name) == 0)
+        {
+            if (index != NULL)
+            {
+                *index = i;
+            }
+            return preset;
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_pf_ol_preset_compile
+ ****************************************************************************//**
+ *
+ * Compile a preset into the filters it takes.
+ *
+ * \param preset
+ * The preset.
+ *
+ * \param bits
+ * CY_PF_ACTIVE_SLEEP and/or CY_PF_ACTIVE_WAKE.
+ *
+ * \param prog
+ * Compiled filters.
+ *
+ * \return
+ * RESULT_OK, RESULT_BADARGS, or RESULT_ERROR
+ *
+ ********************************************************************************/
+int cylpa_pf_ol_preset_compile(const cy_pf_ol_preset_t *preset, uint32_t bits, cy_pf_ol_program_t *prog)
+{
+    uint32_t i;
+    int result;
+
+    if ( (preset == NULL) || (prog == NULL) || ( (bits & PF_BITS_ACTIVE) == 0 ) || ( (bits & ~PF_BITS_ACTIVE) != 0 ) )
+    {
+        return RESULT_BADARGS;
+    }
+
+    /* All entries share their activity, so it does not change what the compiler does */
+    result = cylpa_pf_ol_compile(preset->entries, prog);
+    for (i = 0; i < prog->count; i++)
+    {
+        prog->filters[i].bits = (prog->filters[i].bits & ~PF_BITS_ACTIVE) | bits;
+    }
+    return result;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -54,15 +54,20 @@
 extern "C" {
 #endif
 
+/* Keys of the TKO firmware values held in the OLM shadow */
+#define TKO_OL_SHADOW_PARAM         "tko_param"
+
 static ol_init_t cylpa_tko_ol_init;
 static ol_deinit_t cylpa_tko_ol_deinit;
 static ol_pm_t cylpa_tko_ol_pm;
+static ol_reconfig_t cylpa_tko_ol_reconfig;
 
 const ol_fns_t tko_ol_fns =
 {
     .init = cylpa_tko_ol_init,
     .deinit = cylpa_tko_ol_deinit,
     .pm = cylpa_tko_ol_pm,
+    .reconfig = cylpa_tko_ol_reconfig,
 };
 
 
@@ -92,6 +97,7 @@ uint8_t cy_tko_ol_cfg_index = 0;
 * Function Prototypes
 *******************************************************************************/
 
+static void cylpa_tko_ol_set_param(tko_ol_t *ctxt, const cy_tko_ol_cfg_t *tko_cfg);
 
 /*******************************************************************************
  * Function Name: cylpa_tko_ol_init
@@ -119,7 +125,6 @@ static int cylpa_tko_ol_init(void *ol, ol_info_t *info, const void *cfg)
     int i;
     whd_result_t result;
     uint8_t max;
-    whd_tko_retry_t retry;
 
     OL_LOG_TKO(LOG_OLA_LVL_DEBUG, "%s\n", __func__);
 
@@ -145,12 +150,25 @@ static int cylpa_tko_ol_init(void *ol, ol_info_t *info, const void *cfg)
         OL_LOG_TKO(LOG_OLA_LVL_DEBUG, "   IP %s\n", tko_cfg->ports[i].remote_ip);
     }
 
-    result = whd_tko_max_assoc(ctxt->whd, &max);
-    if (result != WHD_SUCCESS)
+    /* Firmware capability; probed once per firmware load by the OLM */
+    if (!cylpa_olm_caps_has(info, OL_CAP_TKO) )
     {
-        OL_LOG_TKO(LOG_OLA_LVL_ERR, "tko_max_assoc returned failure\n");
+        OL_LOG_TKO(LOG_OLA_LVL_INFO, "TCP Keep Alive offload is not supported\n");
         return RESULT_OK;
     }
+    if (info->caps.valid)
+    {
+        max = info->caps.tko_max_assoc;
+    }
+    else
+    {
+        result = whd_tko_max_assoc(ctxt->whd, &max);
+        if (result != WHD_SUCCESS)
+        {
+            OL_LOG_TKO(LOG_OLA_LVL_ERR, "tko_max_assoc returned failure\n");
+            return RESULT_OK;
+        }
+    }
     OL_LOG_TKO(LOG_OLA_LVL_INFO, "Max connection: %d\n", max);
     if (max != MAX_TKO)
     {
@@ -158,30 +176,98 @@ static int cylpa_tko_ol_init(void *ol, ol_info_t *info, const void *cfg)
                    __func__, max, MAX_TKO);
     }
 
+    cylpa_tko_ol_set_param(ctxt, tko_cfg);
+
+    return RESULT_OK;
+}
+
+/*******************************************************************************
+ * Function Name: cylpa_tko_ol_set_param
+ ****************************************************************************//**
+ *
+ * Set the keep-alive interval and retries, unless the firmware already has them.
+ *
+ * \param ctxt
+ * The pointer to the tko_ol_t structure.
+ *
+ * \param tko_cfg
+ * The configuration in use.
+ *
+ ********************************************************************************/
+static void cylpa_tko_ol_set_param(tko_ol_t *ctxt, const cy_tko_ol_cfg_t *tko_cfg)
+{
+    whd_tko_retry_t retry;
+
     /* Do not configure TKO parameters for new infra */
-    if( ctxt->ol_info_ptr->fw_new_infra == 0 )
+    if( (ctxt->ol_info_ptr->fw_new_infra != 0) || !cylpa_olm_caps_has(ctxt->ol_info_ptr, OL_CAP_TKO) )
     {
-        retry.tko_interval = tko_cfg->interval;
-        retry.tko_retry_interval = tko_cfg->retry_interval;
-        retry.tko_retry_count = tko_cfg->retry_count;
+        return;
+    }
 
-        /* Set params */
-        result = whd_tko_param(ctxt->whd, &retry, 1);
-        if (result != WHD_SUCCESS)
+    memset(&retry, 0, sizeof(retry) );
+    retry.tko_interval = tko_cfg->interval;
+    retry.tko_retry_interval = tko_cfg->retry_interval;
+    retry.tko_retry_count = tko_cfg->retry_count;
+
+    if (!cylpa_olm_shadow_match(ctxt->whd, TKO_OL_SHADOW_PARAM, 0, &retry, sizeof(retry) ) )
+    {
+        if (whd_tko_param(ctxt->whd, &retry, 1) != WHD_SUCCESS)
         {
             OL_LOG_TKO(LOG_OLA_LVL_ERR, "Set whd_tko_param returned failure\n");
-            return RESULT_OK;
+            cylpa_olm_shadow_forget(ctxt->whd, TKO_OL_SHADOW_PARAM, 0);
+            return;
         }
+        cylpa_olm_shadow_store(ctxt->whd, TKO_OL_SHADOW_PARAM, 0, &retry, sizeof(retry) );
+    }
+}
 
-        memset(&retry, 0, sizeof(retry) );
-        /* Get params */
-        result = whd_tko_param(ctxt->whd, &retry, 0);
-        if (result != WHD_SUCCESS)
+/*******************************************************************************
+ * Function Name: cylpa_tko_ol_reconfig
+ ****************************************************************************//**
+ *
+ * Move to a new TCP keep-alive configuration. The connections are activated at
+ * each sleep transition, which reads their current sequence numbers, so only
+ * the slots whose connection changed in the configuration are replaced; a slot
+ * set by cylpa_tko_ol_update_config() and left alone by the configuration keeps
+ * its connection. The parameters are set only if they changed.
+ *
+ * \param ol
+ * The pointer to the ol structure.
+ *
+ * \param cfg
+ * The pointer to the new configuration.
+ *
+ * \return
+ * Returns the execution result
+ *
+ ********************************************************************************/
+static int cylpa_tko_ol_reconfig(void *ol, const void *cfg)
+{
+    tko_ol_t *ctxt = (tko_ol_t *)ol;
+    const cy_tko_ol_cfg_t *new_cfg = (const cy_tko_ol_cfg_t *)cfg;
+    int i;
+
+    if ( (ctxt == NULL) || (ctxt->whd == NULL) || (new_cfg == NULL) )
+    {
+        /* Never configured; initialize instead */
+        return RESULT_UNSUPPORTED;
+    }
+
+    for (i = 0; i < MAX_TKO; i++)
+    {
+        if (memcmp(&ctxt->cfg->ports[i], &new_cfg->ports[i], sizeof(new_cfg->ports[i]) ) != 0)
         {
-            OL_LOG_TKO(LOG_OLA_LVL_ERR, "Get whd_tko_param returned failure\n");
-            return RESULT_OK;
+            OL_LOG_TKO(LOG_OLA_LVL_INFO, "%s: slot %d local %d remote %d IP %s\n", __func__, i,
+                       new_cfg->ports[i].local_port, new_cfg->ports[i].remote_port, new_cfg->ports[i].remote_ip);
+            memcpy(&cy_tko_ol_cfg.ports[i], &new_cfg->ports[i], sizeof(cy_tko_ol_cfg.ports[i]) );
         }
     }
+    cy_tko_ol_cfg.interval = new_cfg->interval;
+    cy_tko_ol_cfg.retry_interval = new_cfg->retry_interval;
+    cy_tko_ol_cfg.retry_count = new_cfg->retry_count;
+    ctxt->cfg = (cy_tko_ol_cfg_t *)new_cfg;
+
+    cylpa_tko_ol_set_param(ctxt, &cy_tko_ol_cfg);
 
     return RESULT_OK;
 }
@@ -199,7 +285,7 @@ static int cylpa_tko_ol_init(void *ol, ol_info_t *info, const void *cfg)
 static void cylpa_tko_ol_deinit(void *ol)
 {
     tko_ol_t *ctxt = (tko_ol_t *)ol;
-    if ((ctxt == NULL) || (ctxt->whd == NULL))
+    if ((ctxt == NULL) || (ctxt->whd == NULL) || !cylpa_olm_caps_has(ctxt->ol_info_ptr, OL_CAP_TKO))
     {
         return;
     }
@@ -236,6 +322,11 @@ static void cylpa_tko_ol_pm(void *ol, ol_pm_st_t st)
         return;
     }
 
+    if (!cylpa_olm_caps_has(ctxt->ol_info_ptr, OL_CAP_TKO) )
+    {
+        return;
+    }
+
     if (st == OL_PM_ST_GOING_TO_SLEEP)
     {
         /* Sleeping case */
@@ -246,6 +337,11 @@ static void cylpa_tko_ol_pm(void *ol, ol_pm_st_t st)
         {
             for (int i = 0; i < MAX_TKO; i++)
             {
+                /* Slots beyond what the firmware holds would only fail */
+                if (ctxt->ol_info_ptr->caps.valid && (i >= ctxt->ol_info_ptr->caps.tko_max_assoc) )
+                {
+                    break;
+                }
                 result = whd_tko_activate(ctxt->whd, i, tko_cfg->ports[i].local_port, tko_cfg->ports[i].remote_port,
                                           tko_cfg->ports[i].remote_ip);
                 if (result != WHD_SUCCESS)
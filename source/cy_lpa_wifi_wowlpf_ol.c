@@ -76,7 +76,7 @@ const ol_fns_t wowlpf_ol_fns =
 /*******************************************************************************
 * Function Prototypes
 *******************************************************************************/
-static int cylpa_set_wowl_pattern( whd_t *whd, bool mode, uint8_t* patt, uint16_t pattern_offset, uint8_t *mask );
+static int cylpa_set_wowl_pattern( wowlpf_ol_t *ctxt, bool mode, uint8_t* patt, uint16_t pattern_offset, uint8_t *mask );
 static whd_result_t whd_wowl_set_pattern( whd_t *whd, uint8_t* pattern, uint16_t pattern_offset, uint8_t* mask, bool set_pattern );
 
 extern whd_result_t whd_set_wowl_pattern(whd_interface_t ifp, char* opt, uint32_t offset, uint8_t mask_size,
@@ -124,7 +124,7 @@ static int cylpa_wowlpf_ol_init(void *ol, ol_info_t *info, const void *cfg)
     ctxt->whd  = info->whd;
     ctxt->ol_info_ptr = info;
 
-    if ( ctxt->ol_info_ptr->fw_new_infra == 0 )
+    if ( ( ctxt->ol_info_ptr->fw_new_infra == 0 ) || !cylpa_olm_caps_has( ctxt->ol_info_ptr, OL_CAP_WOWL ) )
     {
         OL_LOG_WOWLPF(LOG_OLA_LVL_INFO, "WOWL offload is not supported\n");
         return RESULT_OK;
@@ -157,7 +157,7 @@ static void cylpa_wowlpf_ol_deinit(void *ol)
         return;
     }
 
-    if ( ctxt->ol_info_ptr->fw_new_infra == 0 )
+    if ( ( ctxt->ol_info_ptr->fw_new_infra == 0 ) || !cylpa_olm_caps_has( ctxt->ol_info_ptr, OL_CAP_WOWL ) )
     {
         OL_LOG_WOWLPF(LOG_OLA_LVL_INFO, "NULL offload is not supported\n");
         return;
@@ -168,6 +168,10 @@ static void cylpa_wowlpf_ol_deinit(void *ol)
     {
         OL_LOG_WOWLPF(LOG_OLA_LVL_ERR, "wowl clear failed. result = %d\n", result);
     }
+    else
+    {
+        cylpa_olm_caps_slots_reset( ctxt->ol_info_ptr, OL_CAPS_SLOT_WOWL_PATTERN );
+    }
 
     memset( &cylpa_wowl_ol, 0, sizeof( wowlpf_ol_t ) );
 }
@@ -200,7 +204,7 @@ static void cylpa_wowlpf_ol_pm(void *ol, ol_pm_st_t st)
         return;
     }
 
-    if ( ctxt->ol_info_ptr->fw_new_infra == 0 )
+    if ( ( ctxt->ol_info_ptr->fw_new_infra == 0 ) || !cylpa_olm_caps_has( ctxt->ol_info_ptr, OL_CAP_WOWL ) )
     {
         OL_LOG_WOWLPF(LOG_OLA_LVL_INFO, "WOWL offload is not supported\n");
         return;
@@ -230,11 +234,15 @@ static void cylpa_wowlpf_ol_pm(void *ol, ol_pm_st_t st)
             OL_LOG_WOWLPF(LOG_OLA_LVL_ERR, "whd_configure_wowl failed. result = %d\n", __func__, result);
             return;
         }
+        if ( ctxt->ol_info_ptr->caps.valid )
+        {
+            ctxt->ol_info_ptr->caps.wowl = set_wowl;
+        }
 
         for (wowlpf_cfg = ctxt->cfg; wowlpf_cfg->feature != CY_WOWLPF_OL_FEAT_LAST; wowlpf_cfg++)
         {
             OL_LOG_WOWLPF(LOG_OLA_LVL_DEBUG, "%s: Enabling wowl filter %d\n", __func__, wowlpf_cfg->id);
-            if ( cylpa_set_wowl_pattern( ctxt->whd, true, (uint8_t *)wowlpf_cfg->pattern, wowlpf_cfg->offset, (uint8_t *)wowlpf_cfg->mask ) != WHD_SUCCESS )
+            if ( cylpa_set_wowl_pattern( ctxt, true, (uint8_t *)wowlpf_cfg->pattern, wowlpf_cfg->offset, (uint8_t *)wowlpf_cfg->mask ) != WHD_SUCCESS )
             {
                 OL_LOG_WOWLPF(LOG_OLA_LVL_ERR, "%s: whd_pf_enable_packet_filter %d FAILED\n", __func__,
                         wowlpf_cfg->id);
@@ -246,7 +254,7 @@ static void cylpa_wowlpf_ol_pm(void *ol, ol_pm_st_t st)
         if ( result != WHD_SUCCESS )
         {
             /* Remove pattern set in to the WLAN */
-            cylpa_set_wowl_pattern( ctxt->whd, false, (uint8_t *)wowlpf_cfg->pattern, wowlpf_cfg->offset, (uint8_t *)wowlpf_cfg->mask );
+            cylpa_set_wowl_pattern( ctxt, false, (uint8_t *)wowlpf_cfg->pattern, wowlpf_cfg->offset, (uint8_t *)wowlpf_cfg->mask );
             OL_LOG_WOWLPF(LOG_OLA_LVL_ERR, "whd_wowl_activate failed. result = %d\n", __func__, result);
             return;
         }
@@ -274,7 +282,7 @@ static void cylpa_wowlpf_ol_pm(void *ol, ol_pm_st_t st)
         for (wowlpf_cfg = ctxt->cfg; wowlpf_cfg->feature != CY_WOWLPF_OL_FEAT_LAST; wowlpf_cfg++)
         {
             OL_LOG_WOWLPF(LOG_OLA_LVL_DEBUG, "%s: Enabling wowl filter %d\n", __func__, wowlpf_cfg->id);
-            if ( cylpa_set_wowl_pattern( ctxt->whd, false, (uint8_t *)wowlpf_cfg->pattern, wowlpf_cfg->offset, (uint8_t *)wowlpf_cfg->mask ) != WHD_SUCCESS )
+            if ( cylpa_set_wowl_pattern( ctxt, false, (uint8_t *)wowlpf_cfg->pattern, wowlpf_cfg->offset, (uint8_t *)wowlpf_cfg->mask ) != WHD_SUCCESS )
             {
                 OL_LOG_WOWLPF(LOG_OLA_LVL_ERR, "%s: whd_pf_enable_packet_filter %d FAILED\n", __func__,
                         wowlpf_cfg->id);
@@ -282,14 +290,20 @@ static void cylpa_wowlpf_ol_pm(void *ol, ol_pm_st_t st)
         }
 
         result = whd_wowl_clear( ctxt->whd );
+        if ( result == WHD_SUCCESS )
+        {
+            cylpa_olm_caps_slots_reset( ctxt->ol_info_ptr, OL_CAPS_SLOT_WOWL_PATTERN );
+        }
 
     }  /* for each configuration */
     return;
 }
 
-static int cylpa_set_wowl_pattern( whd_t *whd, bool mode, uint8_t* pattern, uint16_t pattern_offset, uint8_t* mask )
+static int cylpa_set_wowl_pattern( wowlpf_ol_t *ctxt, bool mode, uint8_t* pattern, uint16_t pattern_offset, uint8_t* mask )
 {
+    ol_info_t *info = ctxt->ol_info_ptr;
     whd_result_t result = WHD_SUCCESS;
+    whd_result_t patt_result;
     uint32_t wowl;
 
     /* If pattern present, then only set it to WLAN */
@@ -297,19 +311,43 @@ static int cylpa_set_wowl_pattern( whd_t *whd, bool mode, uint8_t* pattern, uint
     {
         if  (mode)
         {
-           whd_get_wowl_cap( whd, &wowl );
+           if ( !cylpa_olm_caps_slot_available( info, OL_CAPS_SLOT_WOWL_PATTERN ) )
+           {
+               OL_LOG_WOWLPF(LOG_OLA_LVL_ERR, "%s: no free WOWL pattern in firmware\n", __func__);
+               return WHD_WLAN_NORESOURCE;
+           }
+
+           /* The WOWL flags held by the firmware are known to the OLM */
+           if ( info->caps.valid )
+           {
+               wowl = info->caps.wowl;
+           }
+           else
+           {
+               whd_get_wowl_cap( ctxt->whd, &wowl );
+           }
 
            wowl &= WL_WOWL_NET;
            if( wowl != WL_WOWL_NET )
            {
                wowl |= WL_WOWL_NET;
-               result = whd_set_wowl_cap( whd, wowl );
+               result = whd_set_wowl_cap( ctxt->whd, wowl );
+               if ( ( result == WHD_SUCCESS ) && info->caps.valid )
+               {
+                   info->caps.wowl = wowl;
+               }
             }
-            result |= whd_wowl_set_pattern( whd, pattern, pattern_offset, mask, 1 );
+            patt_result = whd_wowl_set_pattern( ctxt->whd, pattern, pattern_offset, mask, 1 );
+            cylpa_olm_caps_slot_added( info, OL_CAPS_SLOT_WOWL_PATTERN, patt_result );
+            result |= patt_result;
         }
         else
         {
-            result = whd_wowl_set_pattern( whd, pattern, pattern_offset, mask, 0 );
+            result = whd_wowl_set_pattern( ctxt->whd, pattern, pattern_offset, mask, 0 );
+            if ( result == WHD_SUCCESS )
+            {
+                cylpa_olm_caps_slot_removed( info, OL_CAPS_SLOT_WOWL_PATTERN );
+            }
         }
     }
 
@@ -417,7 +455,7 @@ whd_wowl_set_pattern( whd_t *whd, uint8_t* pattern, uint16_t pattern_offset, uin
     if ( result !=  WHD_SUCCESS)
     {
         OL_LOG_WOWLPF(LOG_OLA_LVL_ERR, "%s: add pattern failed \n", __func__);
-        return 1;
+        return result;
     }
     OL_LOG_WOWLPF(LOG_OLA_LVL_INFO, "whd_set_wowl_pattern:%d \n",result);
 
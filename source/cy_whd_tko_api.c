@@ -39,6 +39,7 @@
 #include "cy_lpa_common_priv.h"
 #include "cy_lpa_wifi_ol_common.h"
 #include "cy_lpa_wifi_ol.h"
+#include "cy_lpa_wifi_olm.h"
 #include "cy_lpa_wifi_tko_ol.h"
 #include "cy_whd_tko_api.h"
 #include "whd_cdc_bdc.h"
@@ -98,8 +99,16 @@ extern "C" {
  *
  *********************************************************************/
 static const whd_event_num_t tko_events[]   = { WLC_E_TKO, WLC_E_NONE };
-static uint16_t tko_offload_update_entry = 0xFF;
-static uint16_t tko_state_enabled = false;
+
+/* TKO state of one interface; an Offload Manager runs per interface */
+typedef struct tko_iface
+{
+    whd_t *whd;                         /* NULL if unused */
+    uint16_t offload_update_entry;      /* WLC_E_TKO event registration */
+    uint16_t state_enabled;
+} tko_iface_t;
+
+static tko_iface_t tko_ifaces[OLM_MAX_INSTANCES];
 void cylpa_on_emac_activity(bool is_tx_activity);    //RX_EVENT_FLAG
 extern cy_mutex_t cy_lp_mutex;
 
@@ -114,33 +123,73 @@ ssize_t etharp_find_addr(struct netif *netif, const ip4_addr_t *ipaddr, wl_ether
                          const ip4_addr_t **ip_ret);
 #endif
 static int prep_packet(sock_seq_t *seq, int index, uint8_t *buf);
+static tko_iface_t *tko_iface_get(whd_t *whd, bool add);
 
 void *whd_callback_handler(whd_interface_t ifp, const whd_event_header_t *event_header, const uint8_t *event_data,
                            /*@null@*/ void *handler_user_data);
 
+/* Returns the TKO state of whd, taking a free entry if add is set; NULL if there is none */
+static tko_iface_t *tko_iface_get(whd_t *whd, bool add)
+{
+    tko_iface_t *free_iface = NULL;
+    int i;
+
+    for (i = 0; i < OLM_MAX_INSTANCES; i++)
+    {
+        if (tko_ifaces[i].whd == whd)
+        {
+            return &tko_ifaces[i];
+        }
+        if ( (free_iface == NULL) && (tko_ifaces[i].whd == NULL) )
+        {
+            free_iface = &tko_ifaces[i];
+        }
+    }
+    if (!add || (free_iface == NULL) )
+    {
+        return NULL;
+    }
+    free_iface->whd = whd;
+    free_iface->offload_update_entry = 0xFF;
+    free_iface->state_enabled = WHD_FALSE;
+    return free_iface;
+}
+
 whd_result_t
 whd_tko_enable(whd_t *whd)
 {
     whd_result_t ret = WHD_SUCCESS;
     whd_event_handler_t handler = whd_callback_handler;
+    tko_iface_t *iface;
 
     ret =  whd_tko_toggle(whd, WHD_TRUE);
 
     /* Enable WLE_E_KTO Event */
-    whd_management_set_event_handler(whd, tko_events, handler, (void *)whd, &tko_offload_update_entry);
-    tko_state_enabled = WHD_TRUE;
+    iface = tko_iface_get(whd, true);
+    if (iface == NULL)
+    {
+        TKO_ERROR_PRINTF( ("%s: more than OLM_MAX_INSTANCES interfaces\n", __func__) );
+        return ret;
+    }
+    if (!iface->state_enabled)
+    {
+        whd_management_set_event_handler(whd, tko_events, handler, (void *)whd, &iface->offload_update_entry);
+    }
+    iface->state_enabled = WHD_TRUE;
     return ret;
 }
 
 whd_result_t
 whd_tko_disable(whd_t *whd)
 {
-    if (tko_state_enabled)
+    tko_iface_t *iface = tko_iface_get(whd, false);
+
+    if ( (iface != NULL) && iface->state_enabled )
     {
-        tko_state_enabled = WHD_FALSE;
+        iface->state_enabled = WHD_FALSE;
 
         /* Disable WLC_E_TKO Event */
-        whd_wifi_deregister_event_handler(whd, tko_offload_update_entry);
+        whd_wifi_deregister_event_handler(whd, iface->offload_update_entry);
     }
 
     return whd_tko_toggle(whd, WHD_FALSE);
@@ -436,7 +485,11 @@ void *whd_callback_handler(whd_interface_t ifp, const whd_event_header_t *event_
             case WLC_E_TKO:
                 if (event_data != NULL)
                 {
-                    tko_state_enabled = WHD_FALSE;
+                    tko_iface_t *iface = tko_iface_get( (whd_t *)handler_user_data, false );
+                    if (iface != NULL)
+                    {
+                        iface->state_enabled = WHD_FALSE;
+                    }
                     cylpa_on_emac_activity(false);
                 }
                 break;
@@ -44,12 +44,19 @@
 #include "cy_lpa_wifi_ol_common.h"
 #include "cy_lpa_wifi_pf_ol.h"
 #include "cy_lpa_wifi_olm.h"
+#include "cy_lpa_wifi_result.h"
 #include "cy_lpa_wifi_arp_ol.h"
 #include "cy_result_mw.h"
 #include "network_activity_handler.h"
 
-olm_t cy_olm;
-whd_interface_t cylpa_iface = NULL;
+/* One Offload Manager per WHD interface (STA, softAP, P2P); the first one created is the default */
+typedef struct cy_olm_instance
+{
+    olm_t olm;                      /* olm.ol_info.whd is the interface */
+    bool used;
+} cy_olm_instance_t;
+
+static cy_olm_instance_t cy_olm_instances[OLM_MAX_INSTANCES];
 
 CYPRESS_WEAK const struct ol_desc *cycfg_get_default_ol_list()
 {
@@ -61,16 +68,60 @@ CYPRESS_WEAK const struct ol_desc *get_default_ol_list()
     return cycfg_get_default_ol_list();
 }
 
-
+/* Deprecated: creation slot 0 only, whichever interface it is; see cy_olm_get_instance() */
 void *cy_get_olm_instance()
 {
-    return &cy_olm;
+    return &cy_olm_instances[0].olm;
+}
+
+void *cy_olm_get_instance(void *ifp)
+{
+    uint32_t i;
+
+    for (i = 0; i < OLM_MAX_INSTANCES; i++)
+    {
+        if (cy_olm_instances[i].used && (cy_olm_instances[i].olm.ol_info.whd == ifp) )
+        {
+            return &cy_olm_instances[i].olm;
+        }
+    }
+    return NULL;
+}
+
+void *cy_olm_get_instance_by_index(uint32_t index)
+{
+    if ( (index >= OLM_MAX_INSTANCES) || !cy_olm_instances[index].used )
+    {
+        return NULL;
+    }
+    return &cy_olm_instances[index].olm;
 }
 
 cy_rslt_t cy_olm_create(void *ifp, ol_desc_t *oflds_list)
 {
     ol_desc_t *olm_desc;
+    cy_olm_instance_t *inst = NULL;
     cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t i;
+
+    /* Same interface again re-creates its Offload Manager, else take a free one */
+    for (i = 0; i < OLM_MAX_INSTANCES; i++)
+    {
+        if (cy_olm_instances[i].used && (cy_olm_instances[i].olm.ol_info.whd == ifp) )
+        {
+            inst = &cy_olm_instances[i];
+            break;
+        }
+        if ( (inst == NULL) && !cy_olm_instances[i].used )
+        {
+            inst = &cy_olm_instances[i];
+        }
+    }
+    if (inst == NULL)
+    {
+        printf("More than OLM_MAX_INSTANCES (%d) interfaces \n", OLM_MAX_INSTANCES);
+        return (cy_rslt_t)RESULT_BADARGS;
+    }
 
     // Get Offload configuration from device configurator
     olm_desc = (ol_desc_t *)get_default_ol_list();
@@ -81,13 +132,32 @@ cy_rslt_t cy_olm_create(void *ifp, ol_desc_t *oflds_list)
     }
 
     /* Offload Manager init */
-    cy_olm.ol_info.whd = ifp;
-    cylpa_iface = ifp;
-    cylpa_olm_init(&cy_olm, olm_desc);
+    inst->olm.ol_info.whd = ifp;
+    inst->used = true;
+    cylpa_olm_init(&inst->olm, olm_desc);
 
     return result;
 }
 
+void cy_olm_destroy(void *ifp)
+{
+    olm_t *olm = (olm_t *)cy_olm_get_instance(ifp);
+    uint32_t i;
+
+    if (olm == NULL)
+    {
+        return;
+    }
+    cylpa_olm_deinit(olm);
+    for (i = 0; i < OLM_MAX_INSTANCES; i++)
+    {
+        if (&cy_olm_instances[i].olm == olm)
+        {
+            cy_olm_instances[i].used = false;
+        }
+    }
+}
+
 cy_rslt_t cy_olm_init_ols(olm_t *olm, void *whd, void *ip)
 {
     return cylpa_olm_init_ols(olm, whd, ip);
@@ -103,7 +173,8 @@ void cy_olm_pm_notification_callback(olm_t *olm, ol_pm_st_t st)
     cylpa_olm_dispatch_pm_notification(olm, st);
 }
 
+/* Deprecated: interface of creation slot 0 only; see cy_olm_get_instance_by_index() */
 whd_interface_t cy_olm_get_whd_interface ( void )
 {
-	return cylpa_iface;
+	return (whd_interface_t)cy_olm_instances[0].olm.ol_info.whd;
 }
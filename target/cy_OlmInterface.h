@@ -63,6 +63,10 @@ extern const struct ol_desc *get_default_ol_list();
 *********************************************************************************************/
 
 /** Offload Manager Configuration 
+ *
+ * Creates the Offload Manager of an interface; calling it again for the same
+ * interface re-creates it. Up to OLM_MAX_INSTANCES interfaces (e.g. STA and
+ * softAP) each have their own, sharing one deferred-work executor.
  *
  * @param[in]    ifp            : interface to whd
  * @param[in]    oflds_list     : Pointer to offload list
@@ -73,6 +77,28 @@ extern const struct ol_desc *get_default_ol_list();
  */
 extern cy_rslt_t cy_olm_create(void *ifp, ol_desc_t *oflds_list);
 
+/** Offload Manager of an interface
+ *
+ * @param[in]    ifp            : interface to whd given to cy_olm_create()
+ *
+ * @return olm_t pointer, or NULL if no Offload Manager was created for ifp
+ */
+extern void *cy_olm_get_instance(void *ifp);
+
+/** Offload Manager by creation slot, to visit all of them
+ *
+ * @param[in]    index          : 0 to OLM_MAX_INSTANCES - 1; 0 is the default instance
+ *
+ * @return olm_t pointer, or NULL if the slot is not in use
+ */
+extern void *cy_olm_get_instance_by_index(uint32_t index);
+
+/** Offload Manager of an interface de-init
+ *
+ * @param[in]    ifp            : interface to whd given to cy_olm_create()
+ */
+extern void cy_olm_destroy(void *ifp);
+
 /** Offload Manager init 
  *
  * @param[in]    olm            : OLM instance pointer